@@ -5,25 +5,161 @@
 #include <algorithm>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 using namespace std;
 static vector<GpiImplInterface *> registered_impls;
 
-#define CHECK_AND_STORE(_x) _x
+gpi_stats_t gpi_stats;
+gpi_live_objects_t gpi_live_objects;
+
+// 每次查找都新建句柄，这里只计数
+static GpiObjHdl *CHECK_AND_STORE(GpiObjHdl *hdl) {
+    ++gpi_stats.handles_created;
+    return hdl;
+}
 #define CLEAR_STORE() (void)0  // No-op
 
+const char *gpi_cb_kind_name(int kind) {
+    static const char *const names[GPI_CB_KIND_COUNT] = {
+        "timed", "value_change", "readwrite", "readonly", "nexttime", "other"};
+    return (kind >= 0 && kind < GPI_CB_KIND_COUNT) ? names[kind] : "unknown";
+}
+
+const char *gpi_vpi_func_name(int func) {
+    static const char *const names[GPI_VPI_FUNC_COUNT] = {
+        "vpi_get",           "vpi_get_str",         "vpi_get_value",
+        "vpi_put_value",     "vpi_get_time",        "vpi_handle",
+        "vpi_handle_by_name", "vpi_handle_by_index", "vpi_iterate",
+        "vpi_scan",          "vpi_free_object",     "vpi_register_cb",
+        "vpi_remove_cb",     "vpi_control"};
+    return (func >= 0 && func < GPI_VPI_FUNC_COUNT) ? names[func] : "unknown";
+}
+
+void gpi_reset_stats() { gpi_stats = gpi_stats_t(); }
+
+void gpi_log_stats() {
+    const gpi_stats_t &s = gpi_stats;
+    LOG_INFO("mycocotb stats:");
+    for (int kind = 0; kind < GPI_CB_KIND_COUNT; ++kind) {
+        if (s.cb_registered[kind] || s.cb_fired[kind] || s.cb_removed[kind]) {
+            LOG_INFO("  callbacks.%-14s registered %llu, fired %llu, "
+                     "removed %llu",
+                     gpi_cb_kind_name(kind),
+                     (unsigned long long)s.cb_registered[kind],
+                     (unsigned long long)s.cb_fired[kind],
+                     (unsigned long long)s.cb_removed[kind]);
+        }
+    }
+    for (int func = 0; func < GPI_VPI_FUNC_COUNT; ++func) {
+        if (s.vpi_calls[func]) {
+            LOG_INFO("  vpi_calls.%-20s %llu", gpi_vpi_func_name(func),
+                     (unsigned long long)s.vpi_calls[func]);
+        }
+    }
+    LOG_INFO("  handles              created %llu, cached %llu",
+             (unsigned long long)s.handles_created,
+             (unsigned long long)s.handles_cached);
+    LOG_INFO("  binstr bytes         read %llu, written %llu",
+             (unsigned long long)s.binstr_bytes_read,
+             (unsigned long long)s.binstr_bytes_written);
+    LOG_INFO("  writes               scheduled %llu, applied %llu",
+             (unsigned long long)s.writes_scheduled,
+             (unsigned long long)s.writes_applied);
+    LOG_INFO("  python entries       %llu",
+             (unsigned long long)s.python_entries);
+}
+
+static vector<void (*)(void)> sim_end_hooks;
+
+void gpi_register_sim_end_hook(void (*hook)(void)) {
+    sim_end_hooks.push_back(hook);
+}
+
+void gpi_run_sim_end_hooks() {
+    for (auto hook : sim_end_hooks) {
+        hook();
+    }
+}
+
+const char *gpi_obj_kind_name(int kind) {
+    static const char *const names[GPI_OBJ_KIND_COUNT] = {
+        "sim_hdl",    "iterator",        "vpi_cb_hdl", "python_callback",
+        "py_sim_hdl", "py_iterator_hdl", "py_cb_hdl"};
+    return (kind >= 0 && kind < GPI_OBJ_KIND_COUNT) ? names[kind] : "unknown";
+}
+
+// 每个GpiObjHdl上还活着的Python句柄对象的个数，为0时从表里删掉
+static unordered_map<GpiObjHdl *, uint64_t> py_handle_counts;
+
+void gpi_track_py_handle(GpiObjHdl *hdl, int delta) {
+    if (delta > 0) {
+        py_handle_counts[hdl] += delta;
+        return;
+    }
+    auto it = py_handle_counts.find(hdl);
+    if (it == py_handle_counts.end()) {
+        return;
+    }
+    if (it->second <= (uint64_t)-delta) {
+        py_handle_counts.erase(it);
+    } else {
+        it->second += delta;
+    }
+}
+
+vector<pair<string, uint64_t>> gpi_top_py_handles(size_t top) {
+    // 同一个路径每次查找都有自己的GpiObjHdl，按全名合并
+    map<string, uint64_t> by_path;
+    for (auto &h : py_handle_counts) {
+        by_path[h.first->get_fullname()] += h.second;
+    }
+    vector<pair<string, uint64_t>> handles(by_path.begin(), by_path.end());
+    top = min(top, handles.size());
+    // 个数相同时按全名排，输出稳定
+    partial_sort(handles.begin(), handles.begin() + top, handles.end(),
+                 [](const pair<string, uint64_t> &a,
+                    const pair<string, uint64_t> &b) {
+                     if (a.second != b.second) {
+                         return a.second > b.second;
+                     }
+                     return a.first < b.first;
+                 });
+    handles.resize(top);
+    return handles;
+}
+
+void gpi_log_live_objects(size_t top) {
+    const gpi_live_objects_t &l = gpi_live_objects;
+    LOG_INFO("mycocotb objects still alive:");
+    for (int kind = 0; kind < GPI_OBJ_KIND_COUNT; ++kind) {
+        LOG_INFO("  %-16s %10llu alive of %llu created",
+                 gpi_obj_kind_name(kind),
+                 (unsigned long long)(l.created[kind] - l.freed[kind]),
+                 (unsigned long long)l.created[kind]);
+    }
+    auto handles = gpi_top_py_handles(top);
+    if (!handles.empty()) {
+        LOG_INFO("  signal paths by Python handles alive:");
+        for (auto &h : handles) {
+            LOG_INFO("  %10llu  %s", (unsigned long long)h.second,
+                     h.first.c_str());
+        }
+    }
+}
+
 void gpi_get_sim_time(uint32_t *high, uint32_t *low) {
     s_vpi_time vpi_time_s;
     vpi_time_s.type = vpiSimTime;  // vpiSimTime;
-    vpi_get_time(NULL, &vpi_time_s);
+    gpi_vpi_get_time(NULL, &vpi_time_s);
     // check_vpi_error();
     *high = vpi_time_s.high;
     *low = vpi_time_s.low;
 }
 
 void gpi_get_sim_precision(int32_t *precision) {
-    *precision = vpi_get(vpiTimePrecision, NULL);
+    *precision = gpi_vpi_get(vpiTimePrecision, NULL);
 }
 
 const char *gpi_get_simulator_product() {
@@ -116,17 +252,17 @@ GpiObjHdl *get_root_handle(const char *name) {
     std::string root_name;
 
     // vpi_iterate with a ref of NULL returns the top level module
-    iterator = vpi_iterate(vpiModule, NULL);
+    iterator = gpi_vpi_iterate(vpiModule, NULL);
     check_vpi_error();
     if (!iterator) {
         LOG_INFO("Nothing visible via VPI");
         return NULL;
     }
 
-    for (root = vpi_scan(iterator); root != NULL; root = vpi_scan(iterator)) {
-        if (to_gpi_objtype(vpi_get(vpiType, root)) != GPI_MODULE) continue;
+    for (root = gpi_vpi_scan(iterator); root != NULL; root = gpi_vpi_scan(iterator)) {
+        if (to_gpi_objtype(gpi_vpi_get(vpiType, root)) != GPI_MODULE) continue;
 
-        if (name == NULL || !strcmp(name, vpi_get_str(vpiFullName, root)))
+        if (name == NULL || !strcmp(name, gpi_vpi_get_str(vpiFullName, root)))
             break;
     }
 
@@ -136,13 +272,13 @@ GpiObjHdl *get_root_handle(const char *name) {
     }
 
     // Need to free the iterator if it didn't return NULL
-    if (iterator && !vpi_free_object(iterator)) {
+    if (iterator && !gpi_vpi_free_object(iterator)) {
         LOG_WARN("VPI: Attempting to free root iterator failed!");
         check_vpi_error();
     }
 
-    root_name = vpi_get_str(vpiFullName, root);
-    rv = new GpiObjHdl(NULL, root, to_gpi_objtype(vpi_get(vpiType, root)));
+    root_name = gpi_vpi_get_str(vpiFullName, root);
+    rv = new GpiObjHdl(NULL, root, to_gpi_objtype(gpi_vpi_get(vpiType, root)));
     rv->initialise(root_name, root_name);
 
     return rv;
@@ -151,13 +287,13 @@ error:
 
     LOG_ERROR("VPI: Couldn't find root handle %s", name);
 
-    iterator = vpi_iterate(vpiModule, NULL);
+    iterator = gpi_vpi_iterate(vpiModule, NULL);
 
-    for (root = vpi_scan(iterator); root != NULL; root = vpi_scan(iterator)) {
+    for (root = gpi_vpi_scan(iterator); root != NULL; root = gpi_vpi_scan(iterator)) {
         LOG_ERROR("VPI: Toplevel instances: %s != %s...", name,
-                  vpi_get_str(vpiFullName, root));
+                  gpi_vpi_get_str(vpiFullName, root));
 
-        if (name == NULL || !strcmp(name, vpi_get_str(vpiFullName, root)))
+        if (name == NULL || !strcmp(name, gpi_vpi_get_str(vpiFullName, root)))
             break;
     }
 
@@ -226,7 +362,7 @@ GpiObjHdl* create_gpi_obj_from_handle(vpiHandle new_hdl,
     GpiObjHdl *new_obj = NULL;
     // icarus 中没有找到vpiUnknown，临时定义
     const int vpiUnknown = 3;
-    if (vpiUnknown == (type = vpi_get(vpiType, new_hdl))) {
+    if (vpiUnknown == (type = gpi_vpi_get(vpiType, new_hdl))) {
         LOG_DEBUG("vpiUnknown returned from vpi_get(vpiType, ...)");
         return NULL;
     }
@@ -239,8 +375,8 @@ GpiObjHdl* create_gpi_obj_from_handle(vpiHandle new_hdl,
         case vpiRealVar:
         case vpiMemoryWord: 
         {
-            const auto is_vector = vpi_get(vpiVector, new_hdl);
-            const auto num_elements = vpi_get(vpiSize, new_hdl);
+            const auto is_vector = gpi_vpi_get(vpiVector, new_hdl);
+            const auto num_elements = gpi_vpi_get(vpiSize, new_hdl);
             new_obj = new VpiSignalObjHdl(
                 NULL, new_hdl, to_gpi_objtype(type, num_elements, is_vector),
                 false);
@@ -248,7 +384,7 @@ GpiObjHdl* create_gpi_obj_from_handle(vpiHandle new_hdl,
         }
         case vpiParameter:
         case vpiConstant: {
-            auto const_type = vpi_get(vpiConstType, new_hdl);
+            auto const_type = gpi_vpi_get(vpiConstType, new_hdl);
             new_obj = new VpiSignalObjHdl(
                 NULL, new_hdl, const_type_to_gpi_objtype(const_type), true);
             break;
@@ -256,8 +392,8 @@ GpiObjHdl* create_gpi_obj_from_handle(vpiHandle new_hdl,
         case vpiRegArray:
         case vpiNetArray:
         case vpiMemory:{
-            const auto is_vector = vpi_get(vpiVector, new_hdl);
-            const auto num_elements = vpi_get(vpiSize, new_hdl);
+            const auto is_vector = gpi_vpi_get(vpiVector, new_hdl);
+            const auto num_elements = gpi_vpi_get(vpiSize, new_hdl);
             new_obj = new VpiArrayObjHdl(
                 NULL, new_hdl, to_gpi_objtype(type, num_elements, is_vector));
             break;
@@ -265,7 +401,7 @@ GpiObjHdl* create_gpi_obj_from_handle(vpiHandle new_hdl,
         case vpiModule:
         case vpiPort:
         case vpiGenScope: {
-            std::string hdl_name = vpi_get_str(vpiName, new_hdl);
+            std::string hdl_name = gpi_vpi_get_str(vpiName, new_hdl);
 
             if (hdl_name != name) {
                 LOG_DEBUG("Found pseudo-region %s (hdl_name=%s but name=%s)",
@@ -281,7 +417,7 @@ GpiObjHdl* create_gpi_obj_from_handle(vpiHandle new_hdl,
                Verilog, It could be VHDL as some simulators allow querying of
                both languages via the same handle
                */
-            const char *type_name = vpi_get_str(vpiType, new_hdl);
+            const char *type_name = gpi_vpi_get_str(vpiType, new_hdl);
             std::string unknown = "vpiUnknown";
             if (type_name && (unknown != type_name)) {
                 LOG_WARN("VPI: Not able to map type %s(%d) to object.",
@@ -296,7 +432,7 @@ GpiObjHdl* create_gpi_obj_from_handle(vpiHandle new_hdl,
     new_obj->initialise(name, fq_name);
 
     LOG_DEBUG("VPI: Created GPI object from type %s(%d)",
-              vpi_get_str(vpiType, new_hdl), type);
+              gpi_vpi_get_str(vpiType, new_hdl), type);
 
     return new_obj;
 }
@@ -308,27 +444,27 @@ GpiObjHdl* native_check_create(const std::string &name,
         parent->get_fullname() + get_type_delimiter(parent) + name;
 
     vpiHandle new_hdl =
-        vpi_handle_by_name(const_cast<char *>(fq_name.c_str()), NULL);
+        gpi_vpi_handle_by_name(const_cast<char *>(fq_name.c_str()), NULL);
 
 #ifdef IUS
-    if (new_hdl != NULL && vpi_get(vpiType, new_hdl) == vpiGenScope) {
+    if (new_hdl != NULL && gpi_vpi_get(vpiType, new_hdl) == vpiGenScope) {
         // verify that this xcelium scope is valid, or else we segfault on the
         // invalid scope. Xcelium only returns vpiGenScope, no vpiGenScopeArray
 
-        vpiHandle iter = vpi_iterate(vpiInternalScope, parent_hdl);
+        vpiHandle iter = gpi_vpi_iterate(vpiInternalScope, parent_hdl);
         bool is_valid = [&]() -> bool {
-            for (auto rgn = vpi_scan(iter); rgn != NULL; rgn = vpi_scan(iter)) {
-                if (compare_generate_labels(vpi_get_str(vpiName, rgn),
+            for (auto rgn = gpi_vpi_scan(iter); rgn != NULL; rgn = gpi_vpi_scan(iter)) {
+                if (compare_generate_labels(gpi_vpi_get_str(vpiName, rgn),
                                                      name)) {
                     return true;
                 }
             }
             return false;
         }();
-        vpi_free_object(iter);
+        gpi_vpi_free_object(iter);
 
         if (!is_valid) {
-            vpi_free_object(new_hdl);
+            gpi_vpi_free_object(new_hdl);
             new_hdl = NULL;
         }
     }
@@ -365,15 +501,15 @@ GpiObjHdl* native_check_create(const std::string &name,
             "matching generate scope array using fallback",
             fq_name.c_str());
 
-        vpiHandle iter = vpi_iterate(vpiInternalScope, parent_hdl);
+        vpiHandle iter = gpi_vpi_iterate(vpiInternalScope, parent_hdl);
         if (iter != NULL) {
-            for (auto rgn = vpi_scan(iter); rgn != NULL; rgn = vpi_scan(iter)) {
-                auto rgn_type = vpi_get(vpiType, rgn);
+            for (auto rgn = gpi_vpi_scan(iter); rgn != NULL; rgn = gpi_vpi_scan(iter)) {
+                auto rgn_type = gpi_vpi_get(vpiType, rgn);
                 if (rgn_type == vpiGenScope || rgn_type == vpiModule) {
-                    std::string rgn_name = vpi_get_str(vpiName, rgn);
+                    std::string rgn_name = gpi_vpi_get_str(vpiName, rgn);
                     if (compare_generate_labels(rgn_name, name)) {
                         new_hdl = parent_hdl;
-                        vpi_free_object(iter);
+                        gpi_vpi_free_object(iter);
                         break;
                     }
                 }
@@ -398,15 +534,15 @@ GpiObjHdl* native_check_create(const std::string &name,
      */
     // icarus并不支持vpiGenScopeArray，头文件里也没有这个定义。这里临时补充定义
     const int vpiGenScopeArray = 133;
-    if (vpi_get(vpiType, new_hdl) == vpiGenScopeArray) {
-        vpi_free_object(new_hdl);
+    if (gpi_vpi_get(vpiType, new_hdl) == vpiGenScopeArray) {
+        gpi_vpi_free_object(new_hdl);
 
         new_hdl = parent_hdl;
     }
 
     GpiObjHdl *new_obj = create_gpi_obj_from_handle(new_hdl, name, fq_name);
     if (new_obj == NULL) {
-        vpi_free_object(new_hdl);
+        gpi_vpi_free_object(new_hdl);
         LOG_DEBUG("Unable to create object '%s'", fq_name.c_str());
         return NULL;
     }
@@ -434,10 +570,10 @@ GpiObjHdl* native_check_create(int32_t index, GpiObjHdl *parent) {
         std::vector<char> writable(hdl_name.begin(), hdl_name.end());
         writable.push_back('\0');
 
-        new_hdl = vpi_handle_by_name(&writable[0], NULL);
+        new_hdl = gpi_vpi_handle_by_name(&writable[0], NULL);
     } else if (obj_type == GPI_LOGIC || obj_type == GPI_LOGIC_ARRAY ||
                obj_type == GPI_ARRAY || obj_type == GPI_STRING) {
-        new_hdl = vpi_handle_by_index(vpi_hdl, index);
+        new_hdl = gpi_vpi_handle_by_index(vpi_hdl, index);
 
         /* vpi_handle_by_index() doesn't work for all simulators when dealing
          * with a two-dimensional array. For example: wire [7:0] sig_t4
@@ -471,17 +607,17 @@ GpiObjHdl* native_check_create(int32_t index, GpiObjHdl *parent) {
              * result in a pseudo-handle or should be found */
             vpiHandle p_hdl = parent->get_handle<vpiHandle>();
             const int vpiRange = 115;
-            vpiHandle it = vpi_iterate(vpiRange, p_hdl);
+            vpiHandle it = gpi_vpi_iterate(vpiRange, p_hdl);
             int constraint_cnt = 0;
             if (it != NULL) {
-                while (vpi_scan(it) != NULL) {
+                while (gpi_vpi_scan(it) != NULL) {
                     ++constraint_cnt;
                 }
             } else {
                 constraint_cnt = 1;
             }
 
-            std::string act_hdl_name = vpi_get_str(vpiName, p_hdl);
+            std::string act_hdl_name = gpi_vpi_get_str(vpiName, p_hdl);
 
             /* Removing the act_hdl_name from the parent->get_name() will leave
              * the pseudo-indices */
@@ -509,7 +645,7 @@ GpiObjHdl* native_check_create(int32_t index, GpiObjHdl *parent) {
             std::vector<char> writable(hdl_name.begin(), hdl_name.end());
             writable.push_back('\0');
 
-            new_hdl = vpi_handle_by_name(&writable[0], NULL);
+            new_hdl = gpi_vpi_handle_by_name(&writable[0], NULL);
 
             /* Create a pseudo-handle if not the last index into a
              * multi-dimensional array */
@@ -538,7 +674,7 @@ GpiObjHdl* native_check_create(int32_t index, GpiObjHdl *parent) {
     std::string fq_name = parent->get_fullname() + idx;
     GpiObjHdl *new_obj = create_gpi_obj_from_handle(new_hdl, name, fq_name);
     if (new_obj == NULL) {
-        vpi_free_object(new_hdl);
+        gpi_vpi_free_object(new_hdl);
         LOG_DEBUG("Unable to fetch object below entity (%s) at index (%d)",
                   parent->get_name_str(), index);
         return NULL;
@@ -551,7 +687,7 @@ GpiObjHdl* native_check_create(void *raw_hdl, GpiObjHdl *parent) {
 
     vpiHandle new_hdl = (vpiHandle)raw_hdl;
 
-    const char *c_name = vpi_get_str(vpiName, new_hdl);
+    const char *c_name = gpi_vpi_get_str(vpiName, new_hdl);
     if (!c_name) {
         LOG_DEBUG("Unable to query name of passed in handle");
         return NULL;
@@ -563,7 +699,7 @@ GpiObjHdl* native_check_create(void *raw_hdl, GpiObjHdl *parent) {
 
     GpiObjHdl *new_obj = create_gpi_obj_from_handle(new_hdl, name, fq_name);
     if (new_obj == NULL) {
-        vpi_free_object(new_hdl);
+        gpi_vpi_free_object(new_hdl);
         LOG_DEBUG("Unable to fetch object %s", fq_name.c_str());
         return NULL;
     }
@@ -679,11 +815,17 @@ static std::string g_binstr;
 const char *gpi_get_signal_value_binstr(gpi_sim_hdl sig_hdl) {
     GpiSignalObjHdl *obj_hdl = static_cast<GpiSignalObjHdl *>(sig_hdl);
     g_binstr = obj_hdl->get_signal_value_binstr();
+    gpi_stats.binstr_bytes_read += g_binstr.size();
     std::transform(g_binstr.begin(), g_binstr.end(), g_binstr.begin(),
                    ::toupper);
     return g_binstr.c_str();
 }
 
+const gpi_vecval *gpi_get_signal_value_vecval(gpi_sim_hdl sig_hdl) {
+    GpiSignalObjHdl *obj_hdl = static_cast<GpiSignalObjHdl *>(sig_hdl);
+    return obj_hdl->get_signal_value_vecval();
+}
+
 const char *gpi_get_signal_name_str(gpi_sim_hdl sig_hdl) {
     GpiSignalObjHdl *obj_hdl = static_cast<GpiSignalObjHdl *>(sig_hdl);
     return obj_hdl->get_name_str();
@@ -711,6 +853,7 @@ void gpi_set_signal_value_int(gpi_sim_hdl sig_hdl, int32_t value,
                               gpi_set_action_t action) {
     GpiSignalObjHdl *obj_hdl = static_cast<GpiSignalObjHdl *>(sig_hdl);
 
+    ++gpi_stats.writes_applied;
     obj_hdl->set_signal_value(value, action);
 }
 
@@ -718,9 +861,18 @@ void gpi_set_signal_value_binstr(gpi_sim_hdl sig_hdl, const char *binstr,
                                  gpi_set_action_t action) {
     std::string value = binstr;
     GpiSignalObjHdl *obj_hdl = static_cast<GpiSignalObjHdl *>(sig_hdl);
+    ++gpi_stats.writes_applied;
+    gpi_stats.binstr_bytes_written += value.size();
     obj_hdl->set_signal_value_binstr(value, action);
 }
 
+void gpi_set_signal_value_vecval(gpi_sim_hdl sig_hdl, const gpi_vecval *value,
+                                 gpi_set_action_t action) {
+    GpiSignalObjHdl *obj_hdl = static_cast<GpiSignalObjHdl *>(sig_hdl);
+    ++gpi_stats.writes_applied;
+    obj_hdl->set_signal_value_vecval(value, action);
+}
+
 
 int gpi_get_num_elems(gpi_sim_hdl obj_hdl) { return obj_hdl->get_num_elems(); }
 
@@ -753,6 +905,21 @@ gpi_cb_hdl gpi_register_value_change_callback(int (*gpi_function)(void *),
     }
 }
 
+gpi_cb_hdl gpi_register_value_watch_callback(int (*gpi_function)(void *),
+                                             void *gpi_cb_data,
+                                             gpi_sim_hdl sig_hdl) {
+    VpiSignalObjHdl *signal_hdl = static_cast<VpiSignalObjHdl *>(sig_hdl);
+    VpiValueWatchCbHdl *hdl = new VpiValueWatchCbHdl(NULL, signal_hdl);
+
+    if (hdl->arm_callback()) {
+        delete (hdl);
+        LOG_ERROR("Failed to register a value watch callback");
+        return NULL;
+    }
+    hdl->set_user_data(gpi_function, gpi_cb_data);
+    return (gpi_cb_hdl)hdl;
+}
+
 gpi_cb_hdl gpi_register_timed_callback(int (*gpi_function)(void *),
                                        void *gpi_cb_data, uint64_t time) {
     VpiTimedCbHdl *hdl = new VpiTimedCbHdl(time);
@@ -765,6 +932,18 @@ gpi_cb_hdl gpi_register_timed_callback(int (*gpi_function)(void *),
     return (gpi_cb_hdl)hdl;
 }
 
+gpi_cb_hdl gpi_register_periodic_callback(int (*gpi_function)(void *),
+                                          void *gpi_cb_data, uint64_t period) {
+    VpiPeriodicCbHdl *hdl = new VpiPeriodicCbHdl(period);
+
+    if (hdl->arm_callback()) {
+        delete (hdl);
+        return NULL;
+    }
+    hdl->set_user_data(gpi_function, gpi_cb_data);
+    return (gpi_cb_hdl)hdl;
+}
+
 VpiNextPhaseCbHdl m_next_phase;
 gpi_cb_hdl gpi_register_nexttime_callback(int (*gpi_function)(void *),
                                           void *gpi_cb_data) {
@@ -789,6 +968,26 @@ gpi_cb_hdl gpi_register_readonly_callback(int (*gpi_function)(void *),
     return (gpi_cb_hdl)&m_read_only;
 }
 
+gpi_cb_hdl gpi_create_wakeup_callback() { return new VpiWakeupCbHdl(); }
+
+int gpi_prime_wakeup_callback(gpi_cb_hdl cb_hdl, int (*gpi_function)(void *),
+                              void *gpi_cb_data) {
+    // 在它自己的回调里可以重新挂起
+    if (cb_hdl->get_call_state() == GPI_PRIMED) return -1;
+    cb_hdl->arm_callback();
+    cb_hdl->set_user_data(gpi_function, gpi_cb_data);
+    return 0;
+}
+
+void gpi_fire_wakeup_callback(gpi_cb_hdl cb_hdl) {
+    static_cast<VpiWakeupCbHdl *>(cb_hdl)->fire();
+}
+
+void gpi_free_wakeup_callback(gpi_cb_hdl cb_hdl) {
+    cb_hdl->cleanup_callback();
+    delete cb_hdl;
+}
+
 void gpi_deregister_callback(gpi_cb_hdl cb_hdl) {
     cb_hdl->cleanup_callback();
 }
@@ -797,4 +996,4 @@ void *gpi_get_callback_data(gpi_cb_hdl cb_hdl) {
     return cb_hdl->get_user_data();
 }
 
-void gpi_sim_end(void) {vpi_control(vpiFinish, 0);}
\ No newline at end of file
+void gpi_sim_end(void) {gpi_vpi_control(vpiFinish, 0);}
\ No newline at end of file
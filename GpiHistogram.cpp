@@ -0,0 +1,140 @@
+/******************************************************************************
+ * @file   GpiHistogram.cpp
+ * @brief  Log-bucketed latency histograms of callback handling
+ *
+ * Averages hide the slow callbacks. When COCOTB_LATENCY_HISTOGRAMS is set,
+ * or after simulator.set_latency_histograms(True), the time from entering a
+ * VPI callback to returning to the simulator, the time spent in Python and
+ * the time taken to apply the scheduled writes at ReadWrite are recorded in
+ * histograms, and their percentiles are printed at the end of simulation.
+ *
+ * The buckets follow HdrHistogram: values below 16 ns have a bucket each,
+ * above that every power of two is split in 16 buckets, so a value is known
+ * to within 1/16 of itself and recording is a bit scan and an increment.
+ */
+
+#include "GpiHistogram.h"
+
+#include <chrono>
+
+bool gpi_hist_enabled = false;
+gpi_cb_kind_e gpi_hist_current_kind = GPI_CB_OTHER;
+
+namespace {
+
+gpi_histogram_t histograms[GPI_HIST_COUNT][GPI_CB_KIND_COUNT];
+
+int bucket_index(uint64_t ns) {
+    if (ns < GPI_HIST_SUB_BUCKETS) {
+        return (int)ns;
+    }
+    int exponent = 63 - __builtin_clzll(ns);
+    int sub = (int)(ns >> (exponent - GPI_HIST_SUB_BITS)) &
+              (GPI_HIST_SUB_BUCKETS - 1);
+    return (exponent - GPI_HIST_SUB_BITS + 1) * GPI_HIST_SUB_BUCKETS + sub;
+}
+
+void log_histogram(const char *name, const char *kind,
+                   const gpi_histogram_t &h) {
+    LOG_INFO("  %-12s %-13s %10llu %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f",
+             name, kind, (unsigned long long)h.total, h.sum_ns / 1e3 / h.total,
+             gpi_hist_percentile(&h, 0.5) / 1e3,
+             gpi_hist_percentile(&h, 0.9) / 1e3,
+             gpi_hist_percentile(&h, 0.99) / 1e3,
+             gpi_hist_percentile(&h, 0.999) / 1e3, h.max_ns / 1e3);
+}
+
+}  // namespace
+
+uint64_t gpi_hist_clock() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void gpi_hist_record(gpi_hist_e which, int kind, uint64_t ns) {
+    gpi_histogram_t &h = histograms[which][kind];
+    ++h.counts[bucket_index(ns)];
+    if (h.total == 0 || ns < h.min_ns) {
+        h.min_ns = ns;
+    }
+    if (ns > h.max_ns) {
+        h.max_ns = ns;
+    }
+    ++h.total;
+    h.sum_ns += ns;
+}
+
+const gpi_histogram_t *gpi_hist_get(gpi_hist_e which, int kind) {
+    return &histograms[which][kind];
+}
+
+uint64_t gpi_hist_bucket_lower(int index) {
+    if (index < GPI_HIST_SUB_BUCKETS) {
+        return (uint64_t)index;
+    }
+    int exponent = index / GPI_HIST_SUB_BUCKETS + GPI_HIST_SUB_BITS - 1;
+    uint64_t sub = (uint64_t)(index % GPI_HIST_SUB_BUCKETS);
+    return (GPI_HIST_SUB_BUCKETS + sub) << (exponent - GPI_HIST_SUB_BITS);
+}
+
+uint64_t gpi_hist_percentile(const gpi_histogram_t *hist, double q) {
+    if (hist->total == 0) {
+        return 0;
+    }
+    // 和HdrHistogram一样，返回落进的那个桶的上界，再限制在最小最大值之间
+    uint64_t rank = (uint64_t)(q * hist->total + 0.5);
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < GPI_HIST_BUCKETS; ++i) {
+        seen += hist->counts[i];
+        if (seen >= rank) {
+            uint64_t upper = i + 1 < GPI_HIST_BUCKETS
+                                 ? gpi_hist_bucket_lower(i + 1) - 1
+                                 : UINT64_MAX;
+            if (upper > hist->max_ns) {
+                upper = hist->max_ns;
+            }
+            return upper < hist->min_ns ? hist->min_ns : upper;
+        }
+    }
+    return hist->max_ns;
+}
+
+const char *gpi_hist_name(int which) {
+    static const char *const names[GPI_HIST_COUNT] = {"callback", "python",
+                                                      "write_flush"};
+    return (which >= 0 && which < GPI_HIST_COUNT) ? names[which] : "unknown";
+}
+
+void gpi_hist_enable(bool enabled) { gpi_hist_enabled = enabled; }
+
+void gpi_hist_reset() {
+    for (auto &per_kind : histograms) {
+        for (gpi_histogram_t &h : per_kind) {
+            h = gpi_histogram_t();
+        }
+    }
+}
+
+void gpi_hist_log() {
+    bool header = false;
+    for (int which = 0; which < GPI_HIST_COUNT; ++which) {
+        for (int kind = 0; kind < GPI_CB_KIND_COUNT; ++kind) {
+            const gpi_histogram_t &h = histograms[which][kind];
+            if (h.total == 0) {
+                continue;
+            }
+            if (!header) {
+                header = true;
+                LOG_INFO("mycocotb latency histograms (us):");
+                LOG_INFO("  %-12s %-13s %10s %10s %10s %10s %10s %10s %10s",
+                         "histogram", "callback", "count", "mean", "p50",
+                         "p90", "p99", "p99.9", "max");
+            }
+            log_histogram(gpi_hist_name(which), gpi_cb_kind_name(kind), h);
+        }
+    }
+}
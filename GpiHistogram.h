@@ -0,0 +1,61 @@
+// 可选的延迟直方图：设置了COCOTB_LATENCY_HISTOGRAMS时，按对数分桶（HDR风格）记录
+// 回调处理、Python和ReadWrite时写入的耗时，仿真结束时输出各个百分位。
+#ifndef MYCOCOTB_GPI_HISTOGRAM_H_
+#define MYCOCOTB_GPI_HISTOGRAM_H_
+
+#include <cstdint>
+
+#include "VpiImpl.h"
+
+// 每个2的幂次区间再等分成这么多个桶，相对误差不超过1/16
+#define GPI_HIST_SUB_BITS 4
+#define GPI_HIST_SUB_BUCKETS (1 << GPI_HIST_SUB_BITS)
+#define GPI_HIST_BUCKETS ((64 - GPI_HIST_SUB_BITS + 1) * GPI_HIST_SUB_BUCKETS)
+
+typedef enum gpi_hist_e {
+    GPI_HIST_CALLBACK,     // VPI callback entry to return, per callback kind
+    GPI_HIST_PYTHON,       // time spent in Python, per callback kind
+    GPI_HIST_WRITE_FLUSH,  // applying the scheduled writes at ReadWrite
+    GPI_HIST_COUNT,
+} gpi_hist_e;
+
+typedef struct gpi_histogram {
+    uint64_t counts[GPI_HIST_BUCKETS];
+    uint64_t total;
+    uint64_t sum_ns;
+    uint64_t min_ns;
+    uint64_t max_ns;
+} gpi_histogram_t;
+
+// 热路径上只检查这个标志，没有打开直方图时不读时钟
+extern GPI_EXPORT bool gpi_hist_enabled;
+
+// 正在处理的回调的种类，Python那一段的耗时记在它名下
+extern GPI_EXPORT gpi_cb_kind_e gpi_hist_current_kind;
+
+// Monotonic wall-clock time in nanoseconds
+GPI_EXPORT uint64_t gpi_hist_clock(void);
+
+// Record a duration of *ns* in histogram *which* for callback kind *kind*
+GPI_EXPORT void gpi_hist_record(gpi_hist_e which, int kind, uint64_t ns);
+
+// The histogram of *which* for callback kind *kind*, writes are recorded
+// under GPI_CB_READWRITE
+GPI_EXPORT const gpi_histogram_t *gpi_hist_get(gpi_hist_e which, int kind);
+
+// Smallest value that falls into bucket *index*
+GPI_EXPORT uint64_t gpi_hist_bucket_lower(int index);
+
+// Value below which a fraction *q* (0 to 1) of the recorded values fall
+GPI_EXPORT uint64_t gpi_hist_percentile(const gpi_histogram_t *hist, double q);
+
+GPI_EXPORT const char *gpi_hist_name(int which);
+
+GPI_EXPORT void gpi_hist_enable(bool enabled);
+
+GPI_EXPORT void gpi_hist_reset(void);
+
+// Log the percentiles of all non-empty histograms
+GPI_EXPORT void gpi_hist_log(void);
+
+#endif /* MYCOCOTB_GPI_HISTOGRAM_H_ */
@@ -0,0 +1,219 @@
+/******************************************************************************
+ * @file   GpiMeter.cpp
+ * @brief  Periodic report of the simulation throughput
+ *
+ * For long runs it helps to see the simulation progress without asking
+ * Python for it. When COCOTB_METER_INTERVAL is set to a number of seconds,
+ * callbacks registered directly with the simulator, so that they never enter
+ * Python, compare the wall clock with the time of the last report a few times
+ * per interval. A cbAfterDelay callback waits for as many time steps as the
+ * simulation advanced in a quarter of the interval the last time, then a
+ * cbNextSimTime callback does the check at the next time step that has
+ * events of its own, so the meter doesn't keep an idle simulation running
+ * for more than one delay. Once the interval has passed it reports:
+ *
+ *  - the simulation time advanced per wall-clock second,
+ *  - the callbacks fired per second, from gpi_stats,
+ *  - the share of the wall-clock time spent in Python,
+ *  - the resident set size of the process.
+ *
+ * The lines go through the simulator log, or are appended to the file named
+ * by COCOTB_METER_FILE. A last line with the averages over the whole run is
+ * written at the end of simulation.
+ */
+
+#include "GpiMeter.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+bool gpi_meter_enabled = false;
+uint64_t gpi_meter_python_ns = 0;
+
+namespace {
+
+struct Sample {
+    uint64_t wall_ns;
+    uint64_t sim_steps;
+    uint64_t callbacks;
+    uint64_t python_ns;
+};
+
+uint64_t interval_ns;
+FILE *meter_file = nullptr;
+Sample first;
+Sample last;
+Sample checked;           // 上一次检查时钟时的采样，用来估计下一次的延迟
+uint64_t delay_steps = 1;
+double step_seconds = 0;  // 一个仿真时间步是多少秒，第一次报告时才查
+s_cb_data cb_data;
+s_vpi_time cb_time;
+
+uint64_t total_callbacks() {
+    uint64_t total = 0;
+    for (int kind = 0; kind < GPI_CB_KIND_COUNT; ++kind) {
+        total += gpi_stats.cb_fired[kind];
+    }
+    return total;
+}
+
+Sample take_sample() {
+    uint32_t high, low;
+    gpi_get_sim_time(&high, &low);
+    return Sample{gpi_meter_clock(), ((uint64_t)high << 32) | low,
+                  total_callbacks(), gpi_meter_python_ns};
+}
+
+// 常驻内存，单位MiB，读不到时返回负数
+double rss_mib() {
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (!f) {
+        return -1;
+    }
+    unsigned long size, resident;
+    int n = fscanf(f, "%lu %lu", &size, &resident);
+    fclose(f);
+    if (n != 2) {
+        return -1;
+    }
+    return (double)resident * sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+}
+
+// 按大小选一个合适的时间单位
+void format_seconds(char *buf, size_t size, double seconds) {
+    static const char *const units[] = {"s", "ms", "us", "ns", "ps", "fs"};
+    int unit = 0;
+    while (unit < 5 && seconds != 0 && std::fabs(seconds) < 1) {
+        seconds *= 1000;
+        ++unit;
+    }
+    snprintf(buf, size, "%.3f %s", seconds, units[unit]);
+}
+
+void report(const char *what, const Sample &from, const Sample &to) {
+    if (step_seconds == 0) {
+        int32_t precision;
+        gpi_get_sim_precision(&precision);
+        step_seconds = std::pow(10.0, precision);
+    }
+    double wall = (to.wall_ns - from.wall_ns) / 1e9;
+    if (wall <= 0) {
+        return;
+    }
+    // reset_stats()会让计数器变小，这时从0算起
+    uint64_t callbacks = to.callbacks >= from.callbacks
+                             ? to.callbacks - from.callbacks
+                             : to.callbacks;
+    char sim_now[32], sim_rate[32];
+    format_seconds(sim_now, sizeof(sim_now), to.sim_steps * step_seconds);
+    format_seconds(sim_rate, sizeof(sim_rate),
+                   (to.sim_steps - from.sim_steps) * step_seconds / wall);
+    uint64_t elapsed = (to.wall_ns - first.wall_ns) / 1000000000;
+    char line[256];
+    snprintf(line, sizeof(line),
+             "meter %s: wall %llu:%02llu:%02llu, sim %s, %s/s, %.0f cb/s, "
+             "python %.1f%%, rss %.1f MiB",
+             what, (unsigned long long)(elapsed / 3600),
+             (unsigned long long)(elapsed / 60 % 60),
+             (unsigned long long)(elapsed % 60), sim_now, sim_rate,
+             callbacks / wall,
+             100.0 * (to.python_ns - from.python_ns) / (wall * 1e9),
+             rss_mib());
+    if (meter_file) {
+        fprintf(meter_file, "%s\n", line);
+        fflush(meter_file);
+    } else {
+        LOG_INFO("%s", line);
+    }
+}
+
+int arm(PLI_INT32 reason, uint64_t delay, PLI_INT32 (*func)(p_cb_data));
+PLI_INT32 meter_delay_done(p_cb_data);
+
+PLI_INT32 meter_check(p_cb_data) {
+    if (!gpi_meter_enabled) {
+        return 0;
+    }
+    Sample now = take_sample();
+    if (now.wall_ns - last.wall_ns >= interval_ns) {
+        report("interval", last, now);
+        last = now;
+    }
+    // 按上一段的仿真速度估计四分之一个间隔里走多少个时间步
+    uint64_t wall = now.wall_ns - checked.wall_ns;
+    if (wall > 0) {
+        double steps = (double)(now.sim_steps - checked.sim_steps) *
+                       interval_ns / 4 / wall;
+        delay_steps = steps < 1 ? 1 : (uint64_t)steps;
+    }
+    checked = now;
+    arm(cbAfterDelay, delay_steps, meter_delay_done);
+    return 0;
+}
+
+PLI_INT32 meter_delay_done(p_cb_data) {
+    if (gpi_meter_enabled) {
+        arm(cbNextSimTime, 0, meter_check);
+    }
+    return 0;
+}
+
+int arm(PLI_INT32 reason, uint64_t delay, PLI_INT32 (*func)(p_cb_data)) {
+    cb_time.type = vpiSimTime;
+    cb_time.high = (uint32_t)(delay >> 32);
+    cb_time.low = (uint32_t)delay;
+    cb_data.reason = reason;
+    cb_data.cb_rtn = func;
+    cb_data.obj = NULL;
+    cb_data.time = &cb_time;
+    cb_data.value = NULL;
+    cb_data.user_data = NULL;
+    if (!gpi_vpi_register_cb(&cb_data)) {
+        LOG_ERROR("VPI: Failed to register the meter callback");
+        gpi_meter_enabled = false;
+        return -1;
+    }
+    return 0;
+}
+
+}  // namespace
+
+uint64_t gpi_meter_clock() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+int gpi_meter_start(double interval, const char *path) {
+    if (gpi_meter_enabled || !(interval > 0)) {
+        return 0;
+    }
+    if (path && *path) {
+        meter_file = fopen(path, "a");
+        if (!meter_file) {
+            LOG_ERROR("Unable to open meter file %s", path);
+            return -1;
+        }
+    }
+    interval_ns = (uint64_t)(interval * 1e9);
+    first = last = checked = Sample{gpi_meter_clock(), 0, 0, 0};
+    delay_steps = 1;
+    gpi_meter_python_ns = 0;
+    gpi_meter_enabled = true;
+    return arm(cbNextSimTime, 0, meter_check);
+}
+
+void gpi_meter_stop() {
+    if (!gpi_meter_enabled) {
+        return;
+    }
+    gpi_meter_enabled = false;
+    report("total", first, take_sample());
+    if (meter_file) {
+        fclose(meter_file);
+        meter_file = nullptr;
+    }
+}
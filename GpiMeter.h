@@ -0,0 +1,26 @@
+// 可选的吞吐量表：设置了COCOTB_METER_INTERVAL时，每个间隔里检查几次墙钟，
+// 每隔这么多秒输出一行仿真速度、回调速率、Python占比和内存占用。
+#ifndef MYCOCOTB_GPI_METER_H_
+#define MYCOCOTB_GPI_METER_H_
+
+#include <cstdint>
+
+#include "VpiImpl.h"
+
+// 热路径上只检查这个标志，没有打开时不读时钟
+extern GPI_EXPORT bool gpi_meter_enabled;
+
+// Wall-clock time spent in Python, added to by the simulator module
+extern GPI_EXPORT uint64_t gpi_meter_python_ns;
+
+// Monotonic wall-clock time in nanoseconds
+GPI_EXPORT uint64_t gpi_meter_clock(void);
+
+// Report every *interval* seconds to *path*, or through the simulator log if
+// *path* is NULL. Returns -1 if the file can't be opened.
+GPI_EXPORT int gpi_meter_start(double interval, const char *path);
+
+// Report the averages over the whole run and close the output
+GPI_EXPORT void gpi_meter_stop(void);
+
+#endif /* MYCOCOTB_GPI_METER_H_ */
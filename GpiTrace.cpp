@@ -0,0 +1,184 @@
+/******************************************************************************
+ * @file   GpiTrace.cpp
+ * @brief  Trace of where the wall time goes, in Chrome trace event format
+ *
+ * When COCOTB_TRACE_FILE names a file, every callback from the simulator
+ * is recorded as a span, with nested spans for the time spent in Python and
+ * in the scheduler, and the time between two callbacks is recorded as spent
+ * in the simulator. The file can be opened in chrome://tracing or Perfetto.
+ *
+ * Spans are collected in a batch owned by the simulator thread. Full batches
+ * are handed to a background thread which formats and writes them, so the
+ * simulator thread never waits on the file.
+ */
+
+#include "GpiTrace.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+bool gpi_trace_enabled = false;
+
+namespace {
+
+struct TraceEvent {
+    const char *cat;
+    std::string name;
+    uint64_t start;
+    uint64_t end;
+    int64_t sim_time;
+};
+
+using Batch = std::vector<TraceEvent>;
+
+// 攒够这么多条才交给后台线程
+constexpr size_t BATCH_SIZE = 4096;
+
+std::chrono::steady_clock::time_point trace_epoch;
+FILE *trace_file = nullptr;
+bool first_event = true;
+Batch current;  // 只由仿真线程访问
+
+std::mutex queue_mutex;
+std::condition_variable queue_cv;
+std::deque<Batch> queue;  // queue_mutex保护
+bool stopping = false;    // queue_mutex保护
+std::thread writer;
+
+void write_escaped(const std::string &s) {
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') {
+            fputc('\\', trace_file);
+            fputc(c, trace_file);
+        } else if (c < 0x20) {
+            fprintf(trace_file, "\\u%04x", c);
+        } else {
+            fputc(c, trace_file);
+        }
+    }
+}
+
+void write_batch(const Batch &batch) {
+    for (const TraceEvent &e : batch) {
+        // ts和dur的单位是微秒
+        fprintf(trace_file,
+                "%s{\"ph\":\"X\",\"pid\":1,\"tid\":1,\"cat\":\"%s\","
+                "\"ts\":%llu.%03llu,\"dur\":%llu.%03llu,\"name\":\"",
+                first_event ? "" : ",\n", e.cat,
+                (unsigned long long)(e.start / 1000),
+                (unsigned long long)(e.start % 1000),
+                (unsigned long long)((e.end - e.start) / 1000),
+                (unsigned long long)((e.end - e.start) % 1000));
+        write_escaped(e.name);
+        if (e.sim_time >= 0) {
+            fprintf(trace_file, "\",\"args\":{\"sim_time\":%lld}}",
+                    (long long)e.sim_time);
+        } else {
+            fputs("\"}", trace_file);
+        }
+        first_event = false;
+    }
+}
+
+void writer_main() {
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    while (true) {
+        queue_cv.wait(lock, [] { return stopping || !queue.empty(); });
+        while (!queue.empty()) {
+            Batch batch = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            write_batch(batch);
+            lock.lock();
+        }
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+void hand_over(Batch &&batch) {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        queue.push_back(std::move(batch));
+    }
+    queue_cv.notify_one();
+}
+
+}  // namespace
+
+uint64_t gpi_trace_clock() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - trace_epoch)
+        .count();
+}
+
+void gpi_trace_span(const char *cat, std::string name, uint64_t start,
+                    uint64_t end, int64_t sim_time) {
+    if (!gpi_trace_enabled) {
+        return;
+    }
+    current.push_back(TraceEvent{cat, std::move(name), start, end, sim_time});
+    if (current.size() >= BATCH_SIZE) {
+        hand_over(std::move(current));
+        current = Batch();
+        current.reserve(BATCH_SIZE);
+    }
+}
+
+int gpi_trace_open(const char *path) {
+    if (gpi_trace_enabled) {
+        return 0;
+    }
+    trace_file = fopen(path, "w");
+    if (!trace_file) {
+        LOG_ERROR("Unable to open trace file %s", path);
+        return -1;
+    }
+    setvbuf(trace_file, nullptr, _IOFBF, 1 << 20);
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+          "{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\","
+          "\"args\":{\"name\":\"mycocotb\"}},\n"
+          "{\"ph\":\"M\",\"pid\":1,\"tid\":1,\"name\":\"thread_name\","
+          "\"args\":{\"name\":\"simulator\"}},\n",
+          trace_file);
+    trace_epoch = std::chrono::steady_clock::now();
+    first_event = true;
+    stopping = false;
+    current.reserve(BATCH_SIZE);
+    writer = std::thread(writer_main);
+    gpi_trace_enabled = true;
+    // 仿真器没有走到cbEndOfSimulation就退出时，也要把记录写完
+    static bool registered = false;
+    if (!registered) {
+        registered = true;
+        atexit(gpi_trace_close);
+    }
+    return 0;
+}
+
+void gpi_trace_close() {
+    if (!gpi_trace_enabled) {
+        return;
+    }
+    gpi_trace_enabled = false;
+    if (!current.empty()) {
+        hand_over(std::move(current));
+        current = Batch();
+    }
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    queue_cv.notify_one();
+    writer.join();
+    fputs("\n]}\n", trace_file);
+    fclose(trace_file);
+    trace_file = nullptr;
+}
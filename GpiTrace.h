@@ -0,0 +1,29 @@
+// 可选的trace记录：设置了COCOTB_TRACE_FILE时，把仿真器回调、Python和调度器
+// 各自花掉的墙钟时间记录成Chrome trace event格式的JSON，由后台线程写入文件。
+#ifndef MYCOCOTB_GPI_TRACE_H_
+#define MYCOCOTB_GPI_TRACE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "VpiImpl.h"
+
+// 热路径上只检查这个标志，没有打开trace时不读时钟
+extern GPI_EXPORT bool gpi_trace_enabled;
+
+// Wall-clock time in nanoseconds since the trace was opened
+GPI_EXPORT uint64_t gpi_trace_clock(void);
+
+// Record a span of category *cat* from *start* to *end* (gpi_trace_clock()
+// values), annotated with the simulation time unless it is negative
+GPI_EXPORT void gpi_trace_span(const char *cat, std::string name,
+                               uint64_t start, uint64_t end,
+                               int64_t sim_time = -1);
+
+// Start writing the trace to *path*, returns -1 if the file can't be opened
+GPI_EXPORT int gpi_trace_open(const char *path);
+
+// Write out the recorded spans and close the trace file
+GPI_EXPORT void gpi_trace_close(void);
+
+#endif /* MYCOCOTB_GPI_TRACE_H_ */
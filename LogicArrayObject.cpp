@@ -0,0 +1,1176 @@
+/******************************************************************************
+ * @file   LogicArrayObject.cpp
+ * @brief  Native base type of mycocotb.types.LogicArray
+ *
+ * Stores the value of a LogicArray as 4-state bit planes in 32-bit words
+ * with the layout of s_vpi_vecval, so a value read from or written to the
+ * simulator is a plain memcpy. Indexing, slicing and the conversions to
+ * integers work on the words directly. Values outside of 0/1/X/Z (only ever
+ * created from Python) additionally keep the Logic code of every bit.
+ */
+
+#include "LogicArrayObject.h"
+#include "LogicKernels.h"
+#include "LogicObject.h"
+
+#include <structmember.h>
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace {
+
+// 每种Logic在位平面里对应的4态值：L、H当作0、1，其余的都是X
+const uint8_t code_aval[N_LOGIC_CODES] = {1, 1, 0, 1, 0, 1, 0, 1, 1};
+const uint8_t code_bval[N_LOGIC_CODES] = {1, 1, 0, 0, 1, 1, 0, 0, 1};
+const bool code_is_4state[N_LOGIC_CODES] = {false, true,  true,  true, true,
+                                            false, false, false, false};
+
+// Logic code of a bit in the planes, indexed by (bval << 1) | aval
+const uint8_t plane_codes[4] = {LOGIC_0, LOGIC_1, LOGIC_Z, LOGIC_X};
+
+// Characters of 4 bits, indexed by (bval nibble << 4) | aval nibble
+char nibble_chars[256][4];
+
+void init_nibble_chars() {
+    for (int idx = 0; idx < 256; idx++) {
+        for (int k = 0; k < 4; k++) {
+            int bit = 3 - k;
+            int planes = (((idx >> (4 + bit)) & 1) << 1) | ((idx >> bit) & 1);
+            nibble_chars[idx][k] = logic_code_chars[plane_codes[planes]];
+        }
+    }
+}
+
+/** LogicCode of a Logic object, or -1 with an exception set */
+int logic_code(PyObject *logic) {
+    if (!LogicObject_Check(logic)) {
+        PyErr_Format(PyExc_TypeError, "Expected Logic, not %s",
+                     Py_TYPE(logic)->tp_name);
+        return -1;
+    }
+    return ((LogicObject *)logic)->code;
+}
+
+/* Bit copies */
+
+void copy_bits(LogicWord *dst, Py_ssize_t dst_pos, const LogicWord *src,
+               Py_ssize_t src_n_words, Py_ssize_t src_pos, Py_ssize_t count) {
+    for (Py_ssize_t done = 0; done < count; done += 32) {
+        int n = (int)std::min<Py_ssize_t>(32, count - done);
+        logic_words_insert(dst, dst_pos + done,
+                           logic_words_extract(src, src_n_words, src_pos + done,
+                                               &LogicWord::aval),
+                           n, &LogicWord::aval);
+        logic_words_insert(dst, dst_pos + done,
+                           logic_words_extract(src, src_n_words, src_pos + done,
+                                               &LogicWord::bval),
+                           n, &LogicWord::bval);
+    }
+}
+
+/* Storage */
+
+/** Number of words in the storage the bits of *self* are read from */
+inline Py_ssize_t storage_n_words(const LogicArrayObject *self) {
+    return logic_array_n_words(self->base != NULL ? self->base->n_bits
+                                                  : self->n_bits);
+}
+
+/** Remove the view *self* from the views of its base */
+void unlink_view(LogicArrayObject *self) {
+    LogicArrayObject *base = self->base;
+    std::vector<LogicArrayObject *> &views = *base->views;
+    views.erase(std::find(views.begin(), views.end(), self));
+    self->base = NULL;
+    self->words = NULL;
+    self->nine = NULL;
+    self->offset = 0;
+    Py_DECREF(base);
+}
+
+void free_owned_storage(LogicArrayObject *self) {
+    if (self->words != self->small) {
+        PyMem_Free(self->words);
+    }
+    self->words = NULL;
+    PyMem_Free(self->nine);
+    self->nine = NULL;
+}
+
+/** Allocate zeroed words for *n_bits* bits */
+LogicWord *alloc_words(LogicArrayObject *self, Py_ssize_t n_bits) {
+    Py_ssize_t n_words = logic_array_n_words(n_bits);
+    if (n_words <= 2) {
+        std::memset(self->small, 0, sizeof(self->small));
+        return self->small;
+    }
+    LogicWord *words = (LogicWord *)PyMem_Calloc(n_words, sizeof(LogicWord));
+    if (words == NULL) {
+        PyErr_NoMemory();
+    }
+    return words;
+}
+
+/** Copy the value of the view *self* out of its base */
+int materialize(LogicArrayObject *self) {
+    Py_ssize_t n_bits = self->n_bits;
+    uint8_t *nine = NULL;
+    if (self->nine != NULL) {
+        nine = (uint8_t *)PyMem_Malloc(std::max<Py_ssize_t>(n_bits, 1));
+        if (nine == NULL) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        std::memcpy(nine, self->nine + self->offset, n_bits);
+    }
+    // 视图最多引用base的storage，small还没有用过
+    LogicWord *words = alloc_words(self, n_bits);
+    if (words == NULL) {
+        PyMem_Free(nine);
+        return -1;
+    }
+    copy_bits(words, 0, self->words, storage_n_words(self), self->offset,
+              n_bits);
+    unlink_view(self);
+    self->words = words;
+    self->nine = nine;
+    return 0;
+}
+
+/** Copy out all the views of *self* */
+int detach_views(LogicArrayObject *self) {
+    while (self->views != NULL && !self->views->empty()) {
+        if (materialize(self->views->back()) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/** Make sure the storage of *self* is not shared before it is modified */
+inline int make_writable(LogicArrayObject *self) {
+    if (self->base != NULL) {
+        return materialize(self);
+    }
+    if (self->views != NULL && !self->views->empty()) {
+        return detach_views(self);
+    }
+    return 0;
+}
+
+/** Drop the storage, copying out the views of it first */
+int release_storage(LogicArrayObject *self) {
+    if (self->base != NULL) {
+        unlink_view(self);
+    } else {
+        if (detach_views(self) < 0) {
+            return -1;
+        }
+        free_owned_storage(self);
+    }
+    self->n_bits = 0;
+    return 0;
+}
+
+/** Reallocate the words for *n_bits* bits, all set to 0 */
+int resize(LogicArrayObject *self, Py_ssize_t n_bits) {
+    if (release_storage(self) < 0) {
+        return -1;
+    }
+    self->words = alloc_words(self, n_bits);
+    if (self->words == NULL) {
+        return -1;
+    }
+    self->n_bits = n_bits;
+    return 0;
+}
+
+inline int get_code(const LogicArrayObject *self, Py_ssize_t pos) {
+    pos += self->offset;
+    if (self->nine != NULL) {
+        return self->nine[pos];
+    }
+    const LogicWord &w = self->words[pos / 32];
+    int b = pos % 32;
+    return plane_codes[(((w.bval >> b) & 1) << 1) | ((w.aval >> b) & 1)];
+}
+
+inline void set_planes(LogicWord *words, Py_ssize_t pos, int code) {
+    LogicWord &w = words[pos / 32];
+    uint32_t mask = 1u << (pos % 32);
+    w.aval = code_aval[code] ? (w.aval | mask) : (w.aval & ~mask);
+    w.bval = code_bval[code] ? (w.bval | mask) : (w.bval & ~mask);
+}
+
+/** Allocate the Logic codes, filled in from the planes */
+int ensure_nine(LogicArrayObject *self) {
+    if (self->nine != NULL) {
+        return 0;
+    }
+    uint8_t *nine = (uint8_t *)PyMem_Malloc(std::max<Py_ssize_t>(self->n_bits, 1));
+    if (nine == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    for (Py_ssize_t pos = 0; pos < self->n_bits; pos++) {
+        nine[pos] = (uint8_t)get_code(self, pos);
+    }
+    self->nine = nine;
+    return 0;
+}
+
+int set_code(LogicArrayObject *self, Py_ssize_t pos, int code) {
+    set_planes(self->words, pos, code);
+    if (self->nine == NULL && code_is_4state[code]) {
+        return 0;
+    }
+    if (ensure_nine(self) < 0) {
+        return -1;
+    }
+    self->nine[pos] = (uint8_t)code;
+    return 0;
+}
+
+/** Clear the bits above n_bits in the last word */
+void clear_unused_bits(LogicArrayObject *self) {
+    if (self->n_bits % 32 != 0) {
+        uint32_t mask = (1u << (self->n_bits % 32)) - 1;
+        LogicWord &last = self->words[logic_array_n_words(self->n_bits) - 1];
+        last.aval &= mask;
+        last.bval &= mask;
+    }
+}
+
+/** Word *i* of the value, with the bits above n_bits cleared */
+inline LogicWord read_word(const LogicArrayObject *self, Py_ssize_t i) {
+    if (self->base == NULL) {
+        return self->words[i];
+    }
+    Py_ssize_t n_words = storage_n_words(self);
+    Py_ssize_t pos = self->offset + 32 * i;
+    LogicWord w = {
+        logic_words_extract(self->words, n_words, pos, &LogicWord::aval),
+        logic_words_extract(self->words, n_words, pos, &LogicWord::bval)};
+    Py_ssize_t rest = self->n_bits - 32 * i;
+    if (rest < 32) {
+        uint32_t mask = (1u << rest) - 1;
+        w.aval &= mask;
+        w.bval &= mask;
+    }
+    return w;
+}
+
+/** Whether any bit is X or Z, not counting the values kept in nine */
+bool has_xz(const LogicArrayObject *self) {
+    Py_ssize_t n_words = logic_array_n_words(self->n_bits);
+    if (self->base == NULL) {
+        return logic_kernels->has_xz(self->words, n_words);
+    }
+    for (Py_ssize_t i = 0; i < n_words; i++) {
+        if (read_word(self, i).bval != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** The words of a value starting at bit 0, as the kernels take them. A view is
+ * copied into a temporary buffer, anything else is used in place. */
+class PackedWords {
+  public:
+    explicit PackedWords(const LogicArrayObject *self) {
+        if (self->base == NULL) {
+            m_words = self->words;
+            return;
+        }
+        Py_ssize_t n_words = logic_array_n_words(self->n_bits);
+        m_buf = (LogicWord *)PyMem_Calloc(std::max<Py_ssize_t>(n_words, 1),
+                                          sizeof(LogicWord));
+        if (m_buf == NULL) {
+            PyErr_NoMemory();
+            return;
+        }
+        copy_bits(m_buf, 0, self->words, storage_n_words(self), self->offset,
+                  self->n_bits);
+        m_words = m_buf;
+    }
+    ~PackedWords() { PyMem_Free(m_buf); }
+    PackedWords(const PackedWords &) = delete;
+    PackedWords &operator=(const PackedWords &) = delete;
+
+    // NULL if the copy could not be allocated
+    const LogicWord *get() const { return m_words; }
+
+  private:
+    const LogicWord *m_words = NULL;
+    LogicWord *m_buf = NULL;
+};
+
+LogicArrayObject *new_like(LogicArrayObject *self, Py_ssize_t n_bits) {
+    PyTypeObject *type = Py_TYPE(self);
+    LogicArrayObject *obj = (LogicArrayObject *)type->tp_alloc(type, 0);
+    if (obj == NULL) {
+        return NULL;
+    }
+    if (resize(obj, n_bits) < 0) {
+        Py_DECREF(obj);
+        return NULL;
+    }
+    return obj;
+}
+
+/* mycocotb.types.LogicArray objects made from the simulator values */
+
+PyObject *logic_array_type;
+PyObject *range_type;
+PyObject *ranges;  // n_bits -> Range(n_bits - 1, "downto", 0)
+
+int load_python_types() {
+    if (logic_array_type != NULL) {
+        return 0;
+    }
+    PyObject *mod = PyImport_ImportModule("mycocotb.types.range");
+    if (mod == NULL) {
+        return -1;
+    }
+    range_type = PyObject_GetAttrString(mod, "Range");
+    Py_DECREF(mod);
+    ranges = PyDict_New();
+    mod = PyImport_ImportModule("mycocotb.types.logic_array");
+    if (mod == NULL || range_type == NULL || ranges == NULL) {
+        Py_XDECREF(mod);
+        Py_CLEAR(range_type);
+        Py_CLEAR(ranges);
+        return -1;
+    }
+    logic_array_type = PyObject_GetAttrString(mod, "LogicArray");
+    Py_DECREF(mod);
+    if (logic_array_type == NULL) {
+        Py_CLEAR(range_type);
+        Py_CLEAR(ranges);
+        return -1;
+    }
+    return 0;
+}
+
+/** Range(n_bits - 1, "downto", 0), borrowed from the cache */
+PyObject *range_of_width(Py_ssize_t n_bits) {
+    PyObject *key = PyLong_FromSsize_t(n_bits);
+    if (key == NULL) {
+        return NULL;
+    }
+    PyObject *range = PyDict_GetItemWithError(ranges, key);
+    if (range == NULL && !PyErr_Occurred()) {
+        range = PyObject_CallFunction(range_type, "nsn", n_bits - 1, "downto",
+                                      (Py_ssize_t)0);
+        if (range != NULL) {
+            int rc = PyDict_SetItem(ranges, key, range);
+            Py_DECREF(range);
+            if (rc < 0) {
+                range = NULL;
+            }
+        }
+    }
+    Py_DECREF(key);
+    return range;
+}
+
+/** A new array of type(self) with Range(n_bits - 1, "downto", 0) */
+LogicArrayObject *new_downto(LogicArrayObject *self, Py_ssize_t n_bits) {
+    if (load_python_types() < 0) {
+        return NULL;
+    }
+    PyObject *range = range_of_width(n_bits);
+    if (range == NULL) {
+        return NULL;
+    }
+    LogicArrayObject *result = new_like(self, n_bits);
+    if (result == NULL) {
+        return NULL;
+    }
+    Py_INCREF(range);
+    result->range = range;
+    return result;
+}
+
+/* Conversions to int */
+
+enum ResolveMode { RESOLVE_NONE = 0, RESOLVE_ZEROS, RESOLVE_ONES };
+
+inline uint32_t resolved_word(const LogicWord &w, int mode) {
+    switch (mode) {
+        case RESOLVE_ZEROS:
+            return w.aval & ~w.bval;
+        case RESOLVE_ONES:
+            return w.aval | w.bval;
+    }
+    return w.aval;
+}
+
+PyObject *int_from_bytes;   // int.from_bytes
+PyObject *signed_kwargs[2];  // {"signed": False}, {"signed": True}
+PyObject *str_little;
+PyObject *str_to_bytes;
+
+/** Little-endian bytes of 32-bit words, written to *buf* */
+inline void put_le32(unsigned char *buf, uint32_t w) {
+    buf[0] = (unsigned char)w;
+    buf[1] = (unsigned char)(w >> 8);
+    buf[2] = (unsigned char)(w >> 16);
+    buf[3] = (unsigned char)(w >> 24);
+}
+
+inline uint32_t get_le32(const unsigned char *buf) {
+    return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) |
+           ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+PyObject *words_to_int(const LogicArrayObject *self, int mode, bool is_signed) {
+    Py_ssize_t n_bits = self->n_bits;
+    Py_ssize_t n_words = logic_array_n_words(n_bits);
+    if (n_bits == 0) {
+        return PyLong_FromLong(0);
+    }
+    if (n_words <= 2) {
+        uint64_t v = 0;
+        for (Py_ssize_t i = n_words - 1; i >= 0; i--) {
+            v = (v << 32) | resolved_word(read_word(self, i), mode);
+        }
+        if (is_signed) {
+            int shift = (int)(64 - n_bits);
+            return PyLong_FromLongLong((int64_t)(v << shift) >> shift);
+        }
+        return PyLong_FromUnsignedLongLong(v);
+    }
+    // 宽的值拼成小端的bytes交给int.from_bytes一次转换，避免逐字移位
+    PyObject *bytes = PyBytes_FromStringAndSize(NULL, n_words * 4);
+    if (bytes == NULL) {
+        return NULL;
+    }
+    unsigned char *buf = (unsigned char *)PyBytes_AS_STRING(bytes);
+    for (Py_ssize_t i = 0; i < n_words; i++) {
+        put_le32(buf + i * 4, resolved_word(read_word(self, i), mode));
+    }
+    int top = (int)((n_bits - 1) % 32);
+    uint32_t last = get_le32(buf + (n_words - 1) * 4);
+    if (is_signed && top != 31 && ((last >> top) & 1)) {
+        // 把符号位扩展到最后一个字里多出来的位
+        put_le32(buf + (n_words - 1) * 4, last | ~((2u << top) - 1));
+    }
+    PyObject *args = PyTuple_Pack(2, bytes, str_little);
+    Py_DECREF(bytes);
+    if (args == NULL) {
+        return NULL;
+    }
+    PyObject *result = PyObject_Call(int_from_bytes, args, signed_kwargs[is_signed]);
+    Py_DECREF(args);
+    return result;
+}
+
+/* Methods */
+
+void logic_array_dealloc(LogicArrayObject *self) {
+    // 视图都持有base的引用，走到这里时已经没有视图了
+    release_storage(self);
+    delete self->views;
+    Py_CLEAR(self->range);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+Py_ssize_t logic_array_length(LogicArrayObject *self) { return self->n_bits; }
+
+PyObject *logic_array_set_str(LogicArrayObject *self, PyObject *value) {
+    if (!PyUnicode_Check(value)) {
+        PyErr_Format(PyExc_TypeError, "Expected str, not %s",
+                     Py_TYPE(value)->tp_name);
+        return NULL;
+    }
+    Py_ssize_t n = PyUnicode_GET_LENGTH(value);
+    int kind = PyUnicode_KIND(value);
+    const void *data = PyUnicode_DATA(value);
+    if (resize(self, n) < 0) {
+        return NULL;
+    }
+    bool is_4state = true;
+    for (Py_ssize_t i = 0; i < n; i++) {
+        Py_UCS4 c = PyUnicode_READ(kind, data, i);
+        int code = logic_char_code(c);
+        if (code < 0) {
+            PyErr_SetString(PyExc_ValueError, "Invalid str literal");
+            return NULL;
+        }
+        set_planes(self->words, n - 1 - i, code);
+        is_4state = is_4state && code_is_4state[code];
+    }
+    if (!is_4state) {
+        if (ensure_nine(self) < 0) {
+            return NULL;
+        }
+        for (Py_ssize_t i = 0; i < n; i++) {
+            self->nine[n - 1 - i] =
+                (uint8_t)logic_char_code(PyUnicode_READ(kind, data, i));
+        }
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject *logic_array_set_int(LogicArrayObject *self, PyObject *args) {
+    PyObject *value;
+    Py_ssize_t n_bits;
+    if (!PyArg_ParseTuple(args, "O!n:_set_int", &PyLong_Type, &value,
+                          &n_bits)) {
+        return NULL;
+    }
+    if (resize(self, n_bits) < 0) {
+        return NULL;
+    }
+    // 调用者已经检查过value放得下，负数按补码存放
+    Py_ssize_t n_words = logic_array_n_words(n_bits);
+    if (n_words <= 2) {
+        unsigned long long v = PyLong_AsUnsignedLongLongMask(value);
+        if (v == (unsigned long long)-1 && PyErr_Occurred()) {
+            return NULL;
+        }
+        self->words[0].aval = (uint32_t)v;
+        if (n_words == 2) {
+            self->words[1].aval = (uint32_t)(v >> 32);
+        }
+    } else {
+        PyObject *zero = PyLong_FromLong(0);
+        int is_negative = zero ? PyObject_RichCompareBool(value, zero, Py_LT) : -1;
+        Py_XDECREF(zero);
+        if (is_negative < 0) {
+            return NULL;
+        }
+        // value.to_bytes(n_words * 4, "little", signed=is_negative)
+        PyObject *to_bytes = PyObject_GetAttr(value, str_to_bytes);
+        PyObject *args = Py_BuildValue("(nO)", n_words * 4, str_little);
+        PyObject *bytes =
+            to_bytes && args
+                ? PyObject_Call(to_bytes, args, signed_kwargs[is_negative])
+                : NULL;
+        Py_XDECREF(to_bytes);
+        Py_XDECREF(args);
+        if (bytes == NULL) {
+            return NULL;
+        }
+        const unsigned char *buf = (const unsigned char *)PyBytes_AS_STRING(bytes);
+        for (Py_ssize_t i = 0; i < n_words; i++) {
+            self->words[i].aval = get_le32(buf + i * 4);
+        }
+        Py_DECREF(bytes);
+    }
+    clear_unused_bits(self);
+    Py_RETURN_NONE;
+}
+
+PyObject *logic_array_set_logics(LogicArrayObject *self, PyObject *value) {
+    PyObject *seq = PySequence_Fast(value, "expected a sequence of Logic");
+    if (seq == NULL) {
+        return NULL;
+    }
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    if (resize(self, n) < 0) {
+        Py_DECREF(seq);
+        return NULL;
+    }
+    PyObject **items = PySequence_Fast_ITEMS(seq);
+    for (Py_ssize_t i = 0; i < n; i++) {
+        int code = logic_code(items[i]);
+        if (code < 0 || set_code(self, n - 1 - i, code) < 0) {
+            Py_DECREF(seq);
+            return NULL;
+        }
+    }
+    Py_DECREF(seq);
+    Py_RETURN_NONE;
+}
+
+PyObject *logic_array_get_str(LogicArrayObject *self, PyObject *) {
+    Py_ssize_t n = self->n_bits;
+    PyObject *result = PyUnicode_New(n, 127);
+    if (result == NULL) {
+        return NULL;
+    }
+    Py_UCS1 *buf = PyUnicode_1BYTE_DATA(result);
+    if (self->nine != NULL) {
+        for (Py_ssize_t i = 0; i < n; i++) {
+            buf[i] = (Py_UCS1)logic_code_chars[get_code(self, n - 1 - i)];
+        }
+        return result;
+    }
+    // 开头不满4位的部分逐位转换，之后每次查表转换4位
+    Py_ssize_t i = 0;
+    for (; i < n % 4; i++) {
+        buf[i] = (Py_UCS1)logic_code_chars[get_code(self, n - 1 - i)];
+    }
+    Py_ssize_t n_words = storage_n_words(self);
+    for (; i < n; i += 4) {
+        // 视图的位可能跨过字的边界，所以用logic_words_extract取
+        Py_ssize_t pos = self->offset + n - 4 - i;
+        uint32_t a =
+            logic_words_extract(self->words, n_words, pos, &LogicWord::aval);
+        uint32_t b =
+            logic_words_extract(self->words, n_words, pos, &LogicWord::bval);
+        std::memcpy(buf + i, nibble_chars[(a & 0xf) | ((b & 0xf) << 4)], 4);
+    }
+    return result;
+}
+
+PyObject *logic_array_get_array(LogicArrayObject *self, PyObject *) {
+    // 确保Logic对象都已经创建
+    if (logic_object(LOGIC_X) == NULL) {
+        return NULL;
+    }
+    Py_ssize_t n = self->n_bits;
+    PyObject *result = PyList_New(n);
+    if (result == NULL) {
+        return NULL;
+    }
+    for (Py_ssize_t i = 0; i < n; i++) {
+        PyObject *logic = logic_object(get_code(self, n - 1 - i));
+        Py_INCREF(logic);
+        PyList_SET_ITEM(result, i, logic);
+    }
+    return result;
+}
+
+/** Check that *i* indexes an element, counting from the left */
+bool check_index(LogicArrayObject *self, Py_ssize_t i) {
+    if (i < 0 || i >= self->n_bits) {
+        PyErr_Format(PyExc_IndexError, "index %zd out of range", i);
+        return false;
+    }
+    return true;
+}
+
+PyObject *logic_array_get_logic(LogicArrayObject *self, PyObject *arg) {
+    Py_ssize_t i = PyLong_AsSsize_t(arg);
+    if (i == -1 && PyErr_Occurred()) {
+        return NULL;
+    }
+    if (!check_index(self, i)) {
+        return NULL;
+    }
+    PyObject *logic = logic_object(get_code(self, self->n_bits - 1 - i));
+    Py_XINCREF(logic);
+    return logic;
+}
+
+PyObject *logic_array_set_logic(LogicArrayObject *self, PyObject *args) {
+    Py_ssize_t i;
+    PyObject *logic;
+    if (!PyArg_ParseTuple(args, "nO:_set_logic", &i, &logic)) {
+        return NULL;
+    }
+    if (!check_index(self, i)) {
+        return NULL;
+    }
+    int code = logic_code(logic);
+    if (code < 0 || make_writable(self) < 0 ||
+        set_code(self, self->n_bits - 1 - i, code) < 0) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+/** A view of *count* bits of the storage of *self* from bit *pos* */
+PyObject *new_view(LogicArrayObject *self, Py_ssize_t pos, Py_ssize_t count) {
+    LogicArrayObject *base = self->base != NULL ? self->base : self;
+    PyTypeObject *type = Py_TYPE(self);
+    LogicArrayObject *view = (LogicArrayObject *)type->tp_alloc(type, 0);
+    if (view == NULL) {
+        return NULL;
+    }
+    try {
+        if (base->views == NULL) {
+            base->views = new std::vector<LogicArrayObject *>();
+        }
+        base->views->push_back(view);
+    } catch (const std::bad_alloc &) {
+        Py_DECREF(view);
+        return PyErr_NoMemory();
+    }
+    Py_INCREF(base);
+    view->base = base;
+    view->offset = pos;
+    view->n_bits = count;
+    view->words = base->words;
+    view->nine = base->nine;
+    return (PyObject *)view;
+}
+
+PyObject *logic_array_get_slice(LogicArrayObject *self, PyObject *args) {
+    Py_ssize_t start, stop;
+    if (!PyArg_ParseTuple(args, "nn:_get_slice", &start, &stop)) {
+        return NULL;
+    }
+    if (!check_index(self, start) || !check_index(self, stop)) {
+        return NULL;
+    }
+    if (start > stop) {
+        PyErr_SetString(PyExc_IndexError, "slice direction is reversed");
+        return NULL;
+    }
+    Py_ssize_t count = stop - start + 1;
+    Py_ssize_t src_pos = self->offset + self->n_bits - 1 - stop;
+    if (count > 64) {
+        return new_view(self, src_pos, count);
+    }
+    // 64位以内的值放在small里，直接复制比视图更省
+    LogicArrayObject *result = new_like(self, count);
+    if (result == NULL) {
+        return NULL;
+    }
+    copy_bits(result->words, 0, self->words, storage_n_words(self), src_pos,
+              count);
+    if (self->nine != NULL) {
+        if (ensure_nine(result) < 0) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        std::memcpy(result->nine, self->nine + src_pos, count);
+    }
+    return (PyObject *)result;
+}
+
+PyObject *logic_array_set_slice(LogicArrayObject *self, PyObject *args) {
+    Py_ssize_t start;
+    LogicArrayObject *other;
+    if (!PyArg_ParseTuple(args, "nO!:_set_slice", &start, &LogicArrayBase_type,
+                          &other)) {
+        return NULL;
+    }
+    Py_ssize_t count = other->n_bits;
+    if (count == 0) {
+        Py_RETURN_NONE;
+    }
+    if (!check_index(self, start) || !check_index(self, start + count - 1)) {
+        return NULL;
+    }
+    // other是self的视图时，这里会先把它复制出去
+    if (make_writable(self) < 0) {
+        return NULL;
+    }
+    Py_ssize_t dst_pos = self->n_bits - start - count;
+    copy_bits(self->words, dst_pos, other->words, storage_n_words(other),
+              other->offset, count);
+    if (other->nine != NULL) {
+        if (ensure_nine(self) < 0) {
+            return NULL;
+        }
+        std::memcpy(self->nine + dst_pos, other->nine + other->offset, count);
+    } else if (self->nine != NULL) {
+        for (Py_ssize_t k = 0; k < count; k++) {
+            self->nine[dst_pos + k] = (uint8_t)get_code(other, k);
+        }
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject *logic_array_to_int(LogicArrayObject *self, PyObject *args) {
+    int mode;
+    int is_signed = 0;
+    if (!PyArg_ParseTuple(args, "i|p:_to_int", &mode, &is_signed)) {
+        return NULL;
+    }
+    if (mode == RESOLVE_NONE) {
+        // L、H在位平面里已经是0、1，其余非0/1的值都有bval
+        if (has_xz(self)) {
+            Py_RETURN_NONE;
+        }
+    }
+    return words_to_int(self, mode, is_signed);
+}
+
+PyObject *logic_array_to_bytes(LogicArrayObject *self, PyObject *arg) {
+    int big = PyObject_IsTrue(arg);
+    if (big < 0) {
+        return NULL;
+    }
+    if (has_xz(self)) {
+        Py_RETURN_NONE;
+    }
+    Py_ssize_t n_bytes = (self->n_bits + 7) / 8;
+    PyObject *result = PyBytes_FromStringAndSize(NULL, n_bytes);
+    if (result == NULL) {
+        return NULL;
+    }
+    unsigned char *buf = (unsigned char *)PyBytes_AS_STRING(result);
+    uint32_t aval = 0;
+    for (Py_ssize_t j = 0; j < n_bytes; j++) {
+        if (j % 4 == 0) {
+            aval = read_word(self, j / 4).aval;
+        }
+        buf[big ? n_bytes - 1 - j : j] = (unsigned char)(aval >> (8 * (j % 4)));
+    }
+    return result;
+}
+
+PyObject *logic_array_set_bytes(LogicArrayObject *self, PyObject *args) {
+    Py_buffer value;
+    int big;
+    if (!PyArg_ParseTuple(args, "y*p:_set_bytes", &value, &big)) {
+        return NULL;
+    }
+    Py_ssize_t n_bytes = value.len;
+    if (resize(self, n_bytes * 8) < 0) {
+        PyBuffer_Release(&value);
+        return NULL;
+    }
+    const unsigned char *buf = (const unsigned char *)value.buf;
+    for (Py_ssize_t j = 0; j < n_bytes; j++) {
+        uint32_t byte = buf[big ? n_bytes - 1 - j : j];
+        self->words[j / 4].aval |= byte << (8 * (j % 4));
+    }
+    PyBuffer_Release(&value);
+    Py_RETURN_NONE;
+}
+
+PyObject *logic_array_same_value(LogicArrayObject *self, PyObject *arg) {
+    if (!LogicArrayObject_Check(arg)) {
+        PyErr_Format(PyExc_TypeError, "Expected LogicArray, not %s",
+                     Py_TYPE(arg)->tp_name);
+        return NULL;
+    }
+    LogicArrayObject *other = (LogicArrayObject *)arg;
+    if (self->n_bits != other->n_bits) {
+        Py_RETURN_FALSE;
+    }
+    if (self->nine == NULL && other->nine == NULL) {
+        PackedWords x(self), y(other);
+        if (x.get() == NULL || y.get() == NULL) {
+            return NULL;
+        }
+        return PyBool_FromLong(logic_kernels->equal(
+            x.get(), y.get(), logic_array_n_words(self->n_bits)));
+    }
+    for (Py_ssize_t pos = 0; pos < self->n_bits; pos++) {
+        if (get_code(self, pos) != get_code(other, pos)) {
+            Py_RETURN_FALSE;
+        }
+    }
+    Py_RETURN_TRUE;
+}
+
+PyObject *logic_array_copy(LogicArrayObject *self, PyObject *) {
+    LogicArrayObject *result = new_like(self, self->n_bits);
+    if (result == NULL) {
+        return NULL;
+    }
+    copy_bits(result->words, 0, self->words, storage_n_words(self),
+              self->offset, self->n_bits);
+    if (self->nine != NULL) {
+        if (ensure_nine(result) < 0) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        std::memcpy(result->nine, self->nine + self->offset, self->n_bits);
+    }
+    Py_XINCREF(self->range);
+    result->range = self->range;
+    return (PyObject *)result;
+}
+
+typedef void (*BinaryKernel)(LogicWord *dst, const LogicWord *x,
+                             const LogicWord *y, Py_ssize_t n_words);
+
+/** Apply *kernel* to the planes of *self* and *arg*, None if either of them
+ * holds values other than 0/1/X/Z */
+PyObject *bitwise(LogicArrayObject *self, PyObject *arg, BinaryKernel kernel) {
+    if (!LogicArrayObject_Check(arg)) {
+        PyErr_Format(PyExc_TypeError, "Expected LogicArray, not %s",
+                     Py_TYPE(arg)->tp_name);
+        return NULL;
+    }
+    LogicArrayObject *other = (LogicArrayObject *)arg;
+    if (self->n_bits != other->n_bits) {
+        PyErr_SetString(PyExc_ValueError, "lengths differ");
+        return NULL;
+    }
+    if (self->nine != NULL || other->nine != NULL) {
+        Py_RETURN_NONE;
+    }
+    PackedWords x(self), y(other);
+    if (x.get() == NULL || y.get() == NULL) {
+        return NULL;
+    }
+    LogicArrayObject *result = new_downto(self, self->n_bits);
+    if (result == NULL) {
+        return NULL;
+    }
+    kernel(result->words, x.get(), y.get(), logic_array_n_words(self->n_bits));
+    return (PyObject *)result;
+}
+
+PyObject *logic_array_and(LogicArrayObject *self, PyObject *arg) {
+    return bitwise(self, arg, logic_kernels->and_);
+}
+
+PyObject *logic_array_or(LogicArrayObject *self, PyObject *arg) {
+    return bitwise(self, arg, logic_kernels->or_);
+}
+
+PyObject *logic_array_xor(LogicArrayObject *self, PyObject *arg) {
+    return bitwise(self, arg, logic_kernels->xor_);
+}
+
+PyObject *logic_array_invert(LogicArrayObject *self, PyObject *) {
+    if (self->nine != NULL) {
+        Py_RETURN_NONE;
+    }
+    PackedWords x(self);
+    if (x.get() == NULL) {
+        return NULL;
+    }
+    LogicArrayObject *result = new_downto(self, self->n_bits);
+    if (result == NULL) {
+        return NULL;
+    }
+    logic_kernels->invert(result->words, x.get(),
+                          logic_array_n_words(self->n_bits));
+    clear_unused_bits(result);
+    return (PyObject *)result;
+}
+
+PyObject *logic_array_count_ones(LogicArrayObject *self, PyObject *) {
+    // H在位平面里也是1，所以不用看nine
+    PackedWords x(self);
+    if (x.get() == NULL) {
+        return NULL;
+    }
+    return PyLong_FromSsize_t(logic_kernels->count_ones(
+        x.get(), logic_array_n_words(self->n_bits)));
+}
+
+PyObject *logic_array_is_resolvable(LogicArrayObject *self, void *) {
+    if (self->nine != NULL) {
+        for (Py_ssize_t pos = 0; pos < self->n_bits; pos++) {
+            int code = get_code(self, pos);
+            if (code != LOGIC_0 && code != LOGIC_1) {
+                Py_RETURN_FALSE;
+            }
+        }
+        Py_RETURN_TRUE;
+    }
+    return PyBool_FromLong(!has_xz(self));
+}
+
+PyGetSetDef logic_array_getsets[] = {
+    {"is_resolvable", (getter)logic_array_is_resolvable, NULL,
+     PyDoc_STR("``True`` if all elements are ``0`` or ``1``."), NULL},
+    {NULL, NULL, NULL, NULL, NULL} /* Sentinel */
+};
+
+PyMemberDef logic_array_members[] = {
+    {"_range", T_OBJECT, offsetof(LogicArrayObject, range), 0, NULL},
+    {NULL, 0, 0, 0, NULL} /* Sentinel */
+};
+
+PyMethodDef logic_array_methods[] = {
+    {"_set_str", (PyCFunction)logic_array_set_str, METH_O,
+     PyDoc_STR("_set_str($self, value, /)\n"
+               "--\n\n"
+               "_set_str(value: str) -> None\n"
+               "Set the value and length from a str literal.")},
+    {"_set_int", (PyCFunction)logic_array_set_int, METH_VARARGS,
+     PyDoc_STR("_set_int($self, value, n_bits, /)\n"
+               "--\n\n"
+               "_set_int(value: int, n_bits: int) -> None\n"
+               "Set the value from a non-negative int which fits in *n_bits*.")},
+    {"_set_logics", (PyCFunction)logic_array_set_logics, METH_O,
+     PyDoc_STR("_set_logics($self, value, /)\n"
+               "--\n\n"
+               "_set_logics(value: Sequence[Logic]) -> None\n"
+               "Set the value and length from a sequence of Logic.")},
+    {"_get_str", (PyCFunction)logic_array_get_str, METH_NOARGS,
+     PyDoc_STR("_get_str($self)\n"
+               "--\n\n"
+               "_get_str() -> str\n"
+               "Get the value as a str literal.")},
+    {"_get_array", (PyCFunction)logic_array_get_array, METH_NOARGS,
+     PyDoc_STR("_get_array($self)\n"
+               "--\n\n"
+               "_get_array() -> List[Logic]\n"
+               "Get the value as a new list of Logic, leftmost first.")},
+    {"_get_logic", (PyCFunction)logic_array_get_logic, METH_O,
+     PyDoc_STR("_get_logic($self, i, /)\n"
+               "--\n\n"
+               "_get_logic(i: int) -> Logic\n"
+               "Get the element at position *i*, counting from the left.")},
+    {"_set_logic", (PyCFunction)logic_array_set_logic, METH_VARARGS,
+     PyDoc_STR("_set_logic($self, i, value, /)\n"
+               "--\n\n"
+               "_set_logic(i: int, value: Logic) -> None\n"
+               "Set the element at position *i*, counting from the left.")},
+    {"_get_slice", (PyCFunction)logic_array_get_slice, METH_VARARGS,
+     PyDoc_STR("_get_slice($self, start, stop, /)\n"
+               "--\n\n"
+               "_get_slice(start: int, stop: int) -> LogicArray\n"
+               "Get the elements at positions *start* to *stop* inclusive, "
+               "counting from the left.\n"
+               "\n"
+               "Slices wider than 64 bits are views of the storage of *self*, "
+               "which are copied out when either of them is modified. The "
+               "range of the result is left for the caller to set.")},
+    {"_set_slice", (PyCFunction)logic_array_set_slice, METH_VARARGS,
+     PyDoc_STR("_set_slice($self, start, value, /)\n"
+               "--\n\n"
+               "_set_slice(start: int, value: LogicArray) -> None\n"
+               "Overwrite the elements from position *start* with *value*.")},
+    {"_to_int", (PyCFunction)logic_array_to_int, METH_VARARGS,
+     PyDoc_STR("_to_int($self, resolve, signed=False, /)\n"
+               "--\n\n"
+               "_to_int(resolve: int, signed: bool = False) -> Optional[int]\n"
+               "Get the value as an unsigned or two's complement int.\n"
+               "\n"
+               "*resolve* is 0 to return ``None`` if any bit is not 0 or 1, "
+               "1 to resolve them to 0, or 2 to resolve them to 1.")},
+    {"_to_bytes", (PyCFunction)logic_array_to_bytes, METH_O,
+     PyDoc_STR("_to_bytes($self, big, /)\n"
+               "--\n\n"
+               "_to_bytes(big: bool) -> Optional[bytes]\n"
+               "Get the value as big or little endian bytes, ``None`` if any "
+               "bit is not 0 or 1.")},
+    {"_set_bytes", (PyCFunction)logic_array_set_bytes, METH_VARARGS,
+     PyDoc_STR("_set_bytes($self, value, big, /)\n"
+               "--\n\n"
+               "_set_bytes(value: bytes, big: bool) -> None\n"
+               "Set the value and length from big or little endian bytes.")},
+    {"_same_value", (PyCFunction)logic_array_same_value, METH_O,
+     PyDoc_STR("_same_value($self, other, /)\n"
+               "--\n\n"
+               "_same_value(other: LogicArray) -> bool\n"
+               "Return ``True`` if *other* holds the same elements.")},
+    {"_and", (PyCFunction)logic_array_and, METH_O,
+     PyDoc_STR("_and($self, other, /)\n"
+               "--\n\n"
+               "_and(other: LogicArray) -> Optional[LogicArray]\n"
+               "Bitwise AND with a LogicArray of the same length.\n"
+               "\n"
+               "Returns ``None`` if either operand holds values other than "
+               "``0``, ``1``, ``X`` or ``Z``.")},
+    {"_or", (PyCFunction)logic_array_or, METH_O,
+     PyDoc_STR("_or($self, other, /)\n"
+               "--\n\n"
+               "_or(other: LogicArray) -> Optional[LogicArray]\n"
+               "Bitwise OR, as :meth:`_and`.")},
+    {"_xor", (PyCFunction)logic_array_xor, METH_O,
+     PyDoc_STR("_xor($self, other, /)\n"
+               "--\n\n"
+               "_xor(other: LogicArray) -> Optional[LogicArray]\n"
+               "Bitwise XOR, as :meth:`_and`.")},
+    {"_invert", (PyCFunction)logic_array_invert, METH_NOARGS,
+     PyDoc_STR("_invert($self)\n"
+               "--\n\n"
+               "_invert() -> Optional[LogicArray]\n"
+               "Bitwise NOT, ``None`` if the value holds anything other than "
+               "``0``, ``1``, ``X`` or ``Z``.")},
+    {"_count_ones", (PyCFunction)logic_array_count_ones, METH_NOARGS,
+     PyDoc_STR("_count_ones($self)\n"
+               "--\n\n"
+               "_count_ones() -> int\n"
+               "Return the number of ``1`` and ``H`` elements.")},
+    {"_copy", (PyCFunction)logic_array_copy, METH_NOARGS,
+     PyDoc_STR("_copy($self)\n"
+               "--\n\n"
+               "_copy() -> LogicArray\n"
+               "Return a copy with the same value and range.")},
+    {NULL, NULL, 0, NULL} /* Sentinel */
+};
+
+PySequenceMethods logic_array_as_sequence = []() -> PySequenceMethods {
+    PySequenceMethods methods = {};
+    methods.sq_length = (lenfunc)logic_array_length;
+    return methods;
+}();
+
+}  // namespace
+
+PyTypeObject LogicArrayBase_type = []() -> PyTypeObject {
+    PyTypeObject type = {};
+    type.ob_base = {PyObject_HEAD_INIT(NULL) 0};
+    type.tp_name = "mycocotb.simulator.LogicArrayBase";
+    type.tp_doc =
+        "Native base of :class:`mycocotb.types.LogicArray`.\n"
+        "\n"
+        "Stores the value as 4-state bit planes with the layout of\n"
+        "``s_vpi_vecval``.";
+    type.tp_basicsize = sizeof(LogicArrayObject);
+    type.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
+    type.tp_new = PyType_GenericNew;
+    type.tp_dealloc = (destructor)logic_array_dealloc;
+    type.tp_as_sequence = &logic_array_as_sequence;
+    type.tp_methods = logic_array_methods;
+    type.tp_members = logic_array_members;
+    type.tp_getset = logic_array_getsets;
+    return type;
+}();
+
+int logic_array_unshare(LogicArrayObject *self) {
+    return self->base != NULL ? materialize(self) : 0;
+}
+
+PyObject *logic_array_from_words(const LogicWord *words, Py_ssize_t n_bits) {
+    if (load_python_types() < 0) {
+        return NULL;
+    }
+    PyObject *range = range_of_width(n_bits);
+    if (range == NULL) {
+        return NULL;
+    }
+    PyTypeObject *type = (PyTypeObject *)logic_array_type;
+    LogicArrayObject *self = (LogicArrayObject *)type->tp_alloc(type, 0);
+    if (self == NULL) {
+        return NULL;
+    }
+    if (resize(self, n_bits) < 0) {
+        Py_DECREF(self);
+        return NULL;
+    }
+    Py_ssize_t n_words = logic_array_n_words(n_bits);
+    std::memcpy(self->words, words, n_words * sizeof(LogicWord));
+    // 仿真器不保证最后一个字里多出来的位是0
+    clear_unused_bits(self);
+    Py_INCREF(range);
+    self->range = range;
+    return (PyObject *)self;
+}
+
+int add_logic_array_type(PyObject *simulator) {
+    init_nibble_chars();
+    if (init_logic_kernels() < 0) {
+        return -1;
+    }
+    if (PyModule_AddStringConstant(simulator, "LOGIC_KERNELS",
+                                   logic_kernels->name) < 0) {
+        return -1;
+    }
+    if ((str_little = PyUnicode_InternFromString("little")) == NULL ||
+        (str_to_bytes = PyUnicode_InternFromString("to_bytes")) == NULL) {
+        return -1;
+    }
+    int_from_bytes = PyObject_GetAttrString((PyObject *)&PyLong_Type, "from_bytes");
+    if (int_from_bytes == NULL) {
+        return -1;
+    }
+    for (int is_signed = 0; is_signed < 2; is_signed++) {
+        signed_kwargs[is_signed] =
+            Py_BuildValue("{sO}", "signed", is_signed ? Py_True : Py_False);
+        if (signed_kwargs[is_signed] == NULL) {
+            return -1;
+        }
+    }
+    if (PyType_Ready(&LogicArrayBase_type) < 0) {
+        return -1;
+    }
+    PyObject *typ = (PyObject *)&LogicArrayBase_type;
+    Py_INCREF(typ);
+    if (PyModule_AddObject(simulator, "LogicArrayBase", typ) < 0) {
+        Py_DECREF(typ);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,86 @@
+// LogicArray的C层基类（simulator.LogicArrayBase）。值按位平面存放在和s_vpi_vecval
+// 布局一样的32位字里，和仿真器之间读写值只需要memcpy。
+#ifndef MYCOCOTB_LOGIC_ARRAY_OBJECT_H_
+#define MYCOCOTB_LOGIC_ARRAY_OBJECT_H_
+
+#include <Python.h>
+
+#include <cstdint>
+#include <vector>
+
+// One word of bit planes, laid out like s_vpi_vecval: a bit is 0 (aval=0,
+// bval=0), 1 (1, 0), Z (0, 1) or X (1, 1)
+struct LogicWord {
+    uint32_t aval;
+    uint32_t bval;
+};
+
+struct LogicArrayObject {
+    PyObject_HEAD PyObject *range;  // _range
+    Py_ssize_t n_bits;
+    // (n_bits + 31) / 32 words, least significant (rightmost) bit first. The
+    // bits above n_bits in the last word are always 0.
+    LogicWord *words;
+    // U、W、L、H、-没法用两个位平面表示，出现时按位另存一份Logic的编码，
+    // 这时位平面里存的是它们对应的4态值（L、H为0、1，其余为X）
+    uint8_t *nine;
+    // 切片视图不复制值：words和nine指向base的存储，从第offset位开始。base自己
+    // 不会是视图，它在修改之前先把所有views里的视图复制出去（写时复制），
+    // 视图在修改之前也先复制出自己的值。
+    LogicArrayObject *base;
+    Py_ssize_t offset;
+    std::vector<LogicArrayObject *> *views;
+    LogicWord small[2];  // storage of words for up to 64 bits
+};
+
+extern PyTypeObject LogicArrayBase_type;
+
+static inline bool LogicArrayObject_Check(PyObject *obj) {
+    return PyObject_TypeCheck(obj, &LogicArrayBase_type);
+}
+
+static inline Py_ssize_t logic_array_n_words(Py_ssize_t n_bits) {
+    return (n_bits + 31) / 32;
+}
+
+// 32 bits of a plane starting at bit *pos*, bits past the last word read as 0
+static inline uint32_t logic_words_extract(const LogicWord *words,
+                                           Py_ssize_t n_words, Py_ssize_t pos,
+                                           uint32_t LogicWord::*plane) {
+    Py_ssize_t i = pos / 32;
+    int s = pos % 32;
+    uint32_t lo = i < n_words ? words[i].*plane : 0;
+    if (s == 0) {
+        return lo;
+    }
+    uint32_t hi = i + 1 < n_words ? words[i + 1].*plane : 0;
+    return (lo >> s) | (hi << (32 - s));
+}
+
+// Overwrite *count* (1 to 32) bits of a plane starting at bit *pos*
+static inline void logic_words_insert(LogicWord *words, Py_ssize_t pos,
+                                      uint32_t value, int count,
+                                      uint32_t LogicWord::*plane) {
+    Py_ssize_t i = pos / 32;
+    int s = pos % 32;
+    uint64_t mask = (count == 32 ? 0xffffffffull : ((1ull << count) - 1)) << s;
+    uint64_t v = ((uint64_t)value << s) & mask;
+    words[i].*plane = (words[i].*plane & ~(uint32_t)mask) | (uint32_t)v;
+    if (s + count > 32) {
+        words[i + 1].*plane = (words[i + 1].*plane & ~(uint32_t)(mask >> 32)) |
+                              (uint32_t)(v >> 32);
+    }
+}
+
+// Give a slice view its own copy of the words, so they start at bit 0 and can
+// be handed to the simulator, returns -1 on failure
+int logic_array_unshare(LogicArrayObject *self);
+
+// Make a mycocotb.types.LogicArray with ``Range(n_bits - 1, "downto", 0)``
+// from *words*, returns NULL on failure
+PyObject *logic_array_from_words(const LogicWord *words, Py_ssize_t n_bits);
+
+// Add LogicArrayBase to the simulator module, returns -1 on failure
+int add_logic_array_type(PyObject *simulator);
+
+#endif /* MYCOCOTB_LOGIC_ARRAY_OBJECT_H_ */
@@ -0,0 +1,258 @@
+/******************************************************************************
+ * @file   LogicKernels.cpp
+ * @brief  4-state kernels over the bit planes of LogicArray
+ *
+ * Every LogicWord is handled as one 64-bit lane holding its aval and bval
+ * halves, so the same truth-table formulas are compiled for plain uint64_t
+ * and for GCC vector types of 2 (SSE2) and 4 (AVX2) lanes. The AVX2 kernels
+ * are compiled with a target attribute and only picked when the CPU
+ * supports it, so the extension itself needs no extra compiler flags.
+ */
+
+#include "LogicKernels.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LOGIC_KERNELS_X86 1
+#endif
+
+#define LOGIC_INLINE inline __attribute__((always_inline))
+
+// 32字节的向量类型只出现在总是内联的函数里，不会跨过函数调用的ABI
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+const LogicKernels *logic_kernels;
+
+namespace {
+
+typedef uint64_t u64x2 __attribute__((vector_size(16)));
+typedef uint64_t u64x4 __attribute__((vector_size(32)));
+
+// aval和bval在64位lane里的位置
+constexpr int A_SHIFT = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ ? 0 : 32;
+constexpr int B_SHIFT = 32 - A_SHIFT;
+constexpr uint64_t LO = 0xffffffffull;
+
+template <typename V>
+LOGIC_INLINE V load(const LogicWord *p) {
+    V v;
+    std::memcpy(&v, p, sizeof(V));
+    return v;
+}
+
+template <typename V>
+LOGIC_INLINE void store(LogicWord *p, V v) {
+    std::memcpy(p, &v, sizeof(V));
+}
+
+template <typename V>
+LOGIC_INLINE V aval(V v) {
+    return (v >> A_SHIFT) & LO;
+}
+
+template <typename V>
+LOGIC_INLINE V bval(V v) {
+    return (v >> B_SHIFT) & LO;
+}
+
+template <typename V>
+LOGIC_INLINE V pack(V a, V b) {
+    return ((a & LO) << A_SHIFT) | ((b & LO) << B_SHIFT);
+}
+
+LOGIC_INLINE uint64_t reduce_or(uint64_t v) { return v; }
+LOGIC_INLINE uint64_t reduce_or(u64x2 v) { return v[0] | v[1]; }
+LOGIC_INLINE uint64_t reduce_or(u64x4 v) { return v[0] | v[1] | v[2] | v[3]; }
+
+LOGIC_INLINE Py_ssize_t popcount(uint64_t v) { return __builtin_popcountll(v); }
+LOGIC_INLINE Py_ssize_t popcount(u64x2 v) {
+    return __builtin_popcountll(v[0]) + __builtin_popcountll(v[1]);
+}
+LOGIC_INLINE Py_ssize_t popcount(u64x4 v) {
+    return __builtin_popcountll(v[0]) + __builtin_popcountll(v[1]) +
+           __builtin_popcountll(v[2]) + __builtin_popcountll(v[3]);
+}
+
+/* Truth tables. A bit is 0 (a=0, b=0), 1 (1, 0), Z (0, 1) or X (1, 1), and
+ * Z is treated as X on input. */
+
+struct AndOp {
+    // 任一边是0时为0，两边都是1时为1，其余为X
+    template <typename V>
+    static LOGIC_INLINE void apply(V ax, V bx, V ay, V by, V &a, V &b) {
+        a = (ax | bx) & (ay | by);
+        b = a & ~(ax & ~bx & ay & ~by);
+    }
+};
+
+struct OrOp {
+    // 任一边是1时为1，两边都是0时为0，其余为X
+    template <typename V>
+    static LOGIC_INLINE void apply(V ax, V bx, V ay, V by, V &a, V &b) {
+        a = ax | bx | ay | by;
+        b = a & ~((ax & ~bx) | (ay & ~by));
+    }
+};
+
+struct XorOp {
+    // 两边都是0/1时按位异或，否则为X
+    template <typename V>
+    static LOGIC_INLINE void apply(V ax, V bx, V ay, V by, V &a, V &b) {
+        b = bx | by;
+        a = (ax ^ ay) | b;
+    }
+};
+
+template <typename Op, typename V>
+LOGIC_INLINE void binary_words(LogicWord *dst, const LogicWord *x,
+                               const LogicWord *y, Py_ssize_t n_words) {
+    constexpr Py_ssize_t step = sizeof(V) / sizeof(LogicWord);
+    Py_ssize_t i = 0;
+    for (; i + step <= n_words; i += step) {
+        V vx = load<V>(x + i), vy = load<V>(y + i), a, b;
+        Op::apply(aval(vx), bval(vx), aval(vy), bval(vy), a, b);
+        store(dst + i, pack(a, b));
+    }
+    for (; i < n_words; i++) {
+        uint64_t vx = load<uint64_t>(x + i), vy = load<uint64_t>(y + i), a, b;
+        Op::apply(aval(vx), bval(vx), aval(vy), bval(vy), a, b);
+        store(dst + i, pack(a, b));
+    }
+}
+
+template <typename V>
+LOGIC_INLINE void invert_words(LogicWord *dst, const LogicWord *x,
+                               Py_ssize_t n_words) {
+    constexpr Py_ssize_t step = sizeof(V) / sizeof(LogicWord);
+    Py_ssize_t i = 0;
+    // 0和1取反，X和Z变成X
+    for (; i + step <= n_words; i += step) {
+        V vx = load<V>(x + i), b = bval(vx);
+        store(dst + i, pack(~aval(vx) | b, b));
+    }
+    for (; i < n_words; i++) {
+        uint64_t vx = load<uint64_t>(x + i), b = bval(vx);
+        store(dst + i, pack(~aval(vx) | b, b));
+    }
+}
+
+template <typename V>
+LOGIC_INLINE bool equal_words(const LogicWord *x, const LogicWord *y,
+                              Py_ssize_t n_words) {
+    constexpr Py_ssize_t step = sizeof(V) / sizeof(LogicWord);
+    Py_ssize_t i = 0;
+    V acc = V();
+    for (; i + step <= n_words; i += step) {
+        acc |= load<V>(x + i) ^ load<V>(y + i);
+    }
+    uint64_t rest = reduce_or(acc);
+    for (; i < n_words; i++) {
+        rest |= load<uint64_t>(x + i) ^ load<uint64_t>(y + i);
+    }
+    return rest == 0;
+}
+
+template <typename V>
+LOGIC_INLINE bool has_xz_words(const LogicWord *x, Py_ssize_t n_words) {
+    constexpr Py_ssize_t step = sizeof(V) / sizeof(LogicWord);
+    Py_ssize_t i = 0;
+    V acc = V();
+    for (; i + step <= n_words; i += step) {
+        acc |= load<V>(x + i);
+    }
+    uint64_t rest = reduce_or(acc);
+    for (; i < n_words; i++) {
+        rest |= load<uint64_t>(x + i);
+    }
+    return bval(rest) != 0;
+}
+
+template <typename V>
+LOGIC_INLINE Py_ssize_t count_ones_words(const LogicWord *x,
+                                         Py_ssize_t n_words) {
+    constexpr Py_ssize_t step = sizeof(V) / sizeof(LogicWord);
+    Py_ssize_t i = 0, count = 0;
+    for (; i + step <= n_words; i += step) {
+        V vx = load<V>(x + i);
+        count += popcount(aval(vx) & ~bval(vx));
+    }
+    for (; i < n_words; i++) {
+        uint64_t vx = load<uint64_t>(x + i);
+        count += popcount(aval(vx) & ~bval(vx));
+    }
+    return count;
+}
+
+// 为一种lane类型生成一组kernel，TARGET是它们需要的目标指令集属性
+#define DEFINE_LOGIC_KERNELS(NAME, TARGET, V)                                  \
+    TARGET void NAME##_and(LogicWord *dst, const LogicWord *x,                 \
+                           const LogicWord *y, Py_ssize_t n_words) {           \
+        binary_words<AndOp, V>(dst, x, y, n_words);                            \
+    }                                                                          \
+    TARGET void NAME##_or(LogicWord *dst, const LogicWord *x,                  \
+                          const LogicWord *y, Py_ssize_t n_words) {            \
+        binary_words<OrOp, V>(dst, x, y, n_words);                             \
+    }                                                                          \
+    TARGET void NAME##_xor(LogicWord *dst, const LogicWord *x,                 \
+                           const LogicWord *y, Py_ssize_t n_words) {           \
+        binary_words<XorOp, V>(dst, x, y, n_words);                            \
+    }                                                                          \
+    TARGET void NAME##_invert(LogicWord *dst, const LogicWord *x,              \
+                              Py_ssize_t n_words) {                            \
+        invert_words<V>(dst, x, n_words);                                      \
+    }                                                                          \
+    TARGET bool NAME##_equal(const LogicWord *x, const LogicWord *y,           \
+                             Py_ssize_t n_words) {                             \
+        return equal_words<V>(x, y, n_words);                                  \
+    }                                                                          \
+    TARGET bool NAME##_has_xz(const LogicWord *x, Py_ssize_t n_words) {        \
+        return has_xz_words<V>(x, n_words);                                    \
+    }                                                                          \
+    TARGET Py_ssize_t NAME##_count_ones(const LogicWord *x,                    \
+                                        Py_ssize_t n_words) {                  \
+        return count_ones_words<V>(x, n_words);                                \
+    }                                                                          \
+    const LogicKernels NAME##_kernels = {                                      \
+        #NAME,          NAME##_and,    NAME##_or,         NAME##_xor,          \
+        NAME##_invert,  NAME##_equal,  NAME##_has_xz,     NAME##_count_ones};
+
+DEFINE_LOGIC_KERNELS(scalar, , uint64_t)
+#ifdef LOGIC_KERNELS_X86
+// x86-64上SSE2总是可用的
+DEFINE_LOGIC_KERNELS(sse2, __attribute__((target("sse2"))), u64x2)
+DEFINE_LOGIC_KERNELS(avx2, __attribute__((target("avx2,popcnt"))), u64x4)
+#endif
+
+}  // namespace
+
+int init_logic_kernels() {
+    const LogicKernels *available[3];
+    int n_available = 0;
+#ifdef LOGIC_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        available[n_available++] = &avx2_kernels;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        available[n_available++] = &sse2_kernels;
+    }
+#endif
+    available[n_available++] = &scalar_kernels;
+
+    const char *name = std::getenv("COCOTB_LOGIC_KERNELS");
+    if (name == NULL || name[0] == '\0') {
+        logic_kernels = available[0];
+        return 0;
+    }
+    for (int i = 0; i < n_available; i++) {
+        if (std::strcmp(name, available[i]->name) == 0) {
+            logic_kernels = available[i];
+            return 0;
+        }
+    }
+    PyErr_Format(PyExc_ValueError,
+                 "COCOTB_LOGIC_KERNELS=%s is not available on this CPU", name);
+    return -1;
+}
@@ -0,0 +1,33 @@
+// LogicArray位平面上的4态运算。启动时按CPU支持的指令集选用AVX2、SSE2或者标量的实现，
+// 设置COCOTB_LOGIC_KERNELS=avx2/sse2/scalar可以指定使用哪一种。
+#ifndef MYCOCOTB_LOGIC_KERNELS_H_
+#define MYCOCOTB_LOGIC_KERNELS_H_
+
+#include "LogicArrayObject.h"
+
+// All kernels take words with the unused bits of the last word set to 0 and
+// keep them 0 in their results, except invert which leaves them for the
+// caller to clear.
+struct LogicKernels {
+    const char *name;
+    void (*and_)(LogicWord *dst, const LogicWord *x, const LogicWord *y,
+                 Py_ssize_t n_words);
+    void (*or_)(LogicWord *dst, const LogicWord *x, const LogicWord *y,
+                Py_ssize_t n_words);
+    void (*xor_)(LogicWord *dst, const LogicWord *x, const LogicWord *y,
+                 Py_ssize_t n_words);
+    void (*invert)(LogicWord *dst, const LogicWord *x, Py_ssize_t n_words);
+    bool (*equal)(const LogicWord *x, const LogicWord *y, Py_ssize_t n_words);
+    // Whether any bit is X or Z
+    bool (*has_xz)(const LogicWord *x, Py_ssize_t n_words);
+    // Number of bits which are 1
+    Py_ssize_t (*count_ones)(const LogicWord *x, Py_ssize_t n_words);
+};
+
+extern const LogicKernels *logic_kernels;
+
+// Pick the kernels for this CPU, returns -1 with an exception set if
+// COCOTB_LOGIC_KERNELS names kernels which can't be used
+int init_logic_kernels();
+
+#endif /* MYCOCOTB_LOGIC_KERNELS_H_ */
@@ -0,0 +1,342 @@
+/******************************************************************************
+ * @file   LogicObject.cpp
+ * @brief  Native base type of mycocotb.types.Logic
+ *
+ * There is exactly one Logic object per value. They are created together the
+ * first time a Logic is constructed and never freed, so constructing a Logic
+ * from a literal and the ``&``, ``|``, ``^`` and ``~`` operators are table
+ * lookups which return one of these objects.
+ */
+
+#include "LogicObject.h"
+
+#include <structmember.h>
+
+#include <cstring>
+
+const char logic_code_chars[N_LOGIC_CODES + 1] = "UX01ZWLH-";
+
+int8_t logic_char_codes[128];
+
+namespace {
+
+// 表的行列都按LogicCode排列：U X 0 1 Z W L H -
+#define U LOGIC_U
+#define X LOGIC_X
+#define O LOGIC_0
+#define I LOGIC_1
+
+const uint8_t and_table[N_LOGIC_CODES][N_LOGIC_CODES] = {
+    {U, U, O, U, U, U, O, U, U},  // U
+    {U, X, O, X, X, X, O, X, X},  // X
+    {O, O, O, O, O, O, O, O, O},  // 0
+    {U, X, O, I, X, X, O, I, X},  // 1
+    {U, X, O, X, X, X, O, X, X},  // Z
+    {U, X, O, X, X, X, O, X, X},  // W
+    {O, O, O, O, O, O, O, O, O},  // L
+    {U, X, O, I, X, X, O, I, X},  // H
+    {U, X, O, X, X, X, O, X, X},  // -
+};
+
+const uint8_t or_table[N_LOGIC_CODES][N_LOGIC_CODES] = {
+    {U, U, U, I, U, U, U, I, U},  // U
+    {U, X, X, I, X, X, X, I, X},  // X
+    {U, X, O, I, X, X, O, I, X},  // 0
+    {I, I, I, I, I, I, I, I, I},  // 1
+    {U, X, X, I, X, X, X, I, X},  // Z
+    {U, X, X, I, X, X, X, I, X},  // W
+    {U, X, O, I, X, X, O, I, X},  // L
+    {I, I, I, I, I, I, I, I, I},  // H
+    {U, X, X, I, X, X, X, I, X},  // -
+};
+
+const uint8_t xor_table[N_LOGIC_CODES][N_LOGIC_CODES] = {
+    {U, U, U, U, U, U, U, U, U},  // U
+    {U, X, X, X, X, X, X, X, X},  // X
+    {U, X, O, I, X, X, O, I, X},  // 0
+    {U, X, I, O, X, X, I, O, X},  // 1
+    {U, X, X, X, X, X, X, X, X},  // Z
+    {U, X, X, X, X, X, X, X, X},  // W
+    {U, X, O, I, X, X, O, I, X},  // L
+    {U, X, I, O, X, X, I, O, X},  // H
+    {U, X, X, X, X, X, X, X, X},  // -
+};
+
+const uint8_t invert_table[N_LOGIC_CODES] = {U, X, I, O, X, X, I, O, X};
+
+#undef U
+#undef X
+#undef O
+#undef I
+
+// 唯一的9个对象，以及创建它们的类（mycocotb.types.Logic）
+PyObject *logic_objects[N_LOGIC_CODES];
+PyTypeObject *logic_objects_type;
+
+// str() of each value
+PyObject *logic_strs[N_LOGIC_CODES];
+
+int init_logic_objects(PyTypeObject *type) {
+    PyObject *objects[N_LOGIC_CODES];
+    for (int code = 0; code < N_LOGIC_CODES; code++) {
+        objects[code] = type->tp_alloc(type, 0);
+        if (objects[code] == NULL) {
+            for (int j = 0; j < code; j++) {
+                Py_DECREF(objects[j]);
+            }
+            return -1;
+        }
+        ((LogicObject *)objects[code])->code = code;
+    }
+    std::memcpy(logic_objects, objects, sizeof(objects));
+    Py_INCREF(type);
+    logic_objects_type = type;
+    return 0;
+}
+
+inline PyObject *new_ref(int code) {
+    PyObject *obj = logic_objects[code];
+    Py_INCREF(obj);
+    return obj;
+}
+
+/** LogicCode of a literal, or -1 with an exception set */
+int literal_code(PyTypeObject *type, PyObject *value) {
+    if (value == NULL || value == Py_None) {
+        return LOGIC_X;
+    }
+    if (PyUnicode_Check(value)) {
+        if (PyUnicode_GET_LENGTH(value) == 1) {
+            int code = logic_char_code(PyUnicode_READ_CHAR(value, 0));
+            if (code >= 0) {
+                return code;
+            }
+        }
+    } else if (PyLong_Check(value)) {
+        // bool也是int
+        int overflow;
+        long v = PyLong_AsLongAndOverflow(value, &overflow);
+        if (v == 0 || v == 1) {
+            return v ? LOGIC_1 : LOGIC_0;
+        }
+        if (v == -1 && PyErr_Occurred()) {
+            return -1;
+        }
+    } else {
+        PyErr_Format(PyExc_TypeError, "Expected str, bool, or int, not %s",
+                     Py_TYPE(value)->tp_name);
+        return -1;
+    }
+    PyErr_Format(PyExc_ValueError, "%R is not convertible to a %s", value,
+                 type->tp_name);
+    return -1;
+}
+
+PyObject *logic_new(PyTypeObject *type, PyObject *args, PyObject *kwargs) {
+    static const char *kwlist[] = {"value", NULL};
+    PyObject *value = NULL;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|O:Logic", (char **)kwlist,
+                                     &value)) {
+        return NULL;
+    }
+    if (value != NULL && LogicObject_Check(value)) {
+        Py_INCREF(value);
+        return value;
+    }
+    int code = literal_code(type, value);
+    if (code < 0) {
+        return NULL;
+    }
+    if (logic_objects_type == NULL && init_logic_objects(type) < 0) {
+        return NULL;
+    }
+    if (type != logic_objects_type) {
+        // Logic的子类不共享对象
+        PyObject *obj = type->tp_alloc(type, 0);
+        if (obj != NULL) {
+            ((LogicObject *)obj)->code = code;
+        }
+        return obj;
+    }
+    return new_ref(code);
+}
+
+void logic_dealloc(PyObject *self) { Py_TYPE(self)->tp_free(self); }
+
+inline int code_of(PyObject *self) { return ((LogicObject *)self)->code; }
+
+PyObject *logic_binary(PyObject *self, PyObject *other,
+                       const uint8_t (&table)[N_LOGIC_CODES][N_LOGIC_CODES]) {
+    if (!LogicObject_Check(self) || !LogicObject_Check(other)) {
+        Py_RETURN_NOTIMPLEMENTED;
+    }
+    PyObject *result = logic_object(table[code_of(self)][code_of(other)]);
+    Py_XINCREF(result);
+    return result;
+}
+
+PyObject *logic_and(PyObject *self, PyObject *other) {
+    return logic_binary(self, other, and_table);
+}
+
+PyObject *logic_or(PyObject *self, PyObject *other) {
+    return logic_binary(self, other, or_table);
+}
+
+PyObject *logic_xor(PyObject *self, PyObject *other) {
+    return logic_binary(self, other, xor_table);
+}
+
+PyObject *logic_invert(PyObject *self) {
+    PyObject *result = logic_object(invert_table[code_of(self)]);
+    Py_XINCREF(result);
+    return result;
+}
+
+/** 0 or 1 for the values 0 and 1, otherwise -1 with ValueError */
+int to_bit(PyObject *self, const char *what) {
+    switch (code_of(self)) {
+        case LOGIC_0:
+            return 0;
+        case LOGIC_1:
+            return 1;
+    }
+    PyErr_Format(PyExc_ValueError, "Cannot convert %R to %s", self, what);
+    return -1;
+}
+
+int logic_bool(PyObject *self) { return to_bit(self, "bool"); }
+
+PyObject *logic_int(PyObject *self) {
+    int bit = to_bit(self, "int");
+    return bit < 0 ? NULL : PyLong_FromLong(bit);
+}
+
+PyObject *logic_richcompare(PyObject *self, PyObject *other, int op) {
+    if (op != Py_EQ && op != Py_NE) {
+        Py_RETURN_NOTIMPLEMENTED;
+    }
+    int other_code;
+    if (LogicObject_Check(other)) {
+        other_code = code_of(other);
+    } else if (PyUnicode_Check(other) || PyLong_Check(other)) {
+        other_code = literal_code(Py_TYPE(self), other);
+        if (other_code < 0) {
+            if (!PyErr_ExceptionMatches(PyExc_ValueError)) {
+                return NULL;
+            }
+            PyErr_Clear();
+        }
+    } else {
+        Py_RETURN_NOTIMPLEMENTED;
+    }
+    return PyBool_FromLong((code_of(self) == other_code) == (op == Py_EQ));
+}
+
+Py_hash_t logic_hash(PyObject *self) { return code_of(self); }
+
+PyObject *logic_str(PyObject *self) {
+    PyObject *result = logic_strs[code_of(self)];
+    Py_INCREF(result);
+    return result;
+}
+
+PyObject *logic_repr(PyObject *self) {
+    return PyUnicode_FromFormat("%s('%c')", Py_TYPE(self)->tp_name,
+                                logic_code_chars[code_of(self)]);
+}
+
+PyObject *logic_reduce(PyObject *self, PyObject *) {
+    return Py_BuildValue("(O(O))", (PyObject *)Py_TYPE(self),
+                         logic_strs[code_of(self)]);
+}
+
+PyMethodDef logic_methods[] = {
+    {"__reduce__", (PyCFunction)logic_reduce, METH_NOARGS, NULL},
+    {NULL, NULL, 0, NULL} /* Sentinel */
+};
+
+PyMemberDef logic_members[] = {
+    {"_repr", T_INT, offsetof(LogicObject, code), READONLY, NULL},
+    {NULL, 0, 0, 0, NULL} /* Sentinel */
+};
+
+PyNumberMethods logic_as_number = []() -> PyNumberMethods {
+    PyNumberMethods methods = {};
+    methods.nb_and = logic_and;
+    methods.nb_or = logic_or;
+    methods.nb_xor = logic_xor;
+    methods.nb_invert = logic_invert;
+    methods.nb_bool = logic_bool;
+    methods.nb_int = logic_int;
+    methods.nb_index = logic_int;
+    return methods;
+}();
+
+}  // namespace
+
+PyTypeObject LogicBase_type = []() -> PyTypeObject {
+    PyTypeObject type = {};
+    type.ob_base = {PyObject_HEAD_INIT(NULL) 0};
+    type.tp_name = "mycocotb.simulator.LogicBase";
+    type.tp_doc = "Native base of :class:`mycocotb.types.Logic`.";
+    type.tp_basicsize = sizeof(LogicObject);
+    type.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
+    type.tp_new = logic_new;
+    type.tp_dealloc = logic_dealloc;
+    type.tp_as_number = &logic_as_number;
+    type.tp_richcompare = logic_richcompare;
+    type.tp_hash = logic_hash;
+    type.tp_str = logic_str;
+    type.tp_repr = logic_repr;
+    type.tp_methods = logic_methods;
+    type.tp_members = logic_members;
+    return type;
+}();
+
+PyObject *logic_object(int code) {
+    if (logic_objects_type == NULL) {
+        // 还没有构造过Logic，通过Logic()创建这些对象
+        PyObject *mod = PyImport_ImportModule("mycocotb.types.logic");
+        if (mod == NULL) {
+            return NULL;
+        }
+        PyObject *logic = PyObject_GetAttrString(mod, "Logic");
+        Py_DECREF(mod);
+        if (logic == NULL) {
+            return NULL;
+        }
+        PyObject *obj = PyObject_CallNoArgs(logic);
+        Py_DECREF(logic);
+        if (obj == NULL) {
+            return NULL;
+        }
+        Py_DECREF(obj);
+    }
+    return logic_objects[code];
+}
+
+int add_logic_type(PyObject *simulator) {
+    std::memset(logic_char_codes, -1, sizeof(logic_char_codes));
+    for (int code = 0; code < N_LOGIC_CODES; code++) {
+        char c = logic_code_chars[code];
+        logic_char_codes[(unsigned char)c] = (int8_t)code;
+        if (c >= 'A' && c <= 'Z') {
+            logic_char_codes[c - 'A' + 'a'] = (int8_t)code;
+        }
+        logic_strs[code] = PyUnicode_FromStringAndSize(&c, 1);
+        if (logic_strs[code] == NULL) {
+            return -1;
+        }
+    }
+    if (PyType_Ready(&LogicBase_type) < 0) {
+        return -1;
+    }
+    PyObject *typ = (PyObject *)&LogicBase_type;
+    Py_INCREF(typ);
+    if (PyModule_AddObject(simulator, "LogicBase", typ) < 0) {
+        Py_DECREF(typ);
+        return -1;
+    }
+    return 0;
+}
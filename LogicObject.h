@@ -0,0 +1,51 @@
+// Logic的C层基类（simulator.LogicBase）。9种值各只有一个对象，构造和运算都是查表，
+// 不会分配新的对象。
+#ifndef MYCOCOTB_LOGIC_OBJECT_H_
+#define MYCOCOTB_LOGIC_OBJECT_H_
+
+#include <Python.h>
+
+#include <cstdint>
+
+// Same order as the _U, _X, ... constants in mycocotb.types.logic
+enum LogicCode {
+    LOGIC_U = 0,
+    LOGIC_X,
+    LOGIC_0,
+    LOGIC_1,
+    LOGIC_Z,
+    LOGIC_W,
+    LOGIC_L,
+    LOGIC_H,
+    LOGIC_D,
+    N_LOGIC_CODES
+};
+
+// Character of each LogicCode
+extern const char logic_code_chars[N_LOGIC_CODES + 1];
+
+// LogicCode of each ASCII character, -1 if it is not a Logic literal
+extern int8_t logic_char_codes[128];
+
+static inline int logic_char_code(Py_UCS4 c) {
+    return c < 128 ? logic_char_codes[c] : -1;
+}
+
+struct LogicObject {
+    PyObject_HEAD int code;  // _repr
+};
+
+extern PyTypeObject LogicBase_type;
+
+static inline bool LogicObject_Check(PyObject *obj) {
+    return PyObject_TypeCheck(obj, &LogicBase_type);
+}
+
+// The interned mycocotb.types.Logic of *code* as a borrowed reference,
+// returns NULL on failure
+PyObject *logic_object(int code);
+
+// Add LogicBase to the simulator module, returns -1 on failure
+int add_logic_type(PyObject *simulator);
+
+#endif /* MYCOCOTB_LOGIC_OBJECT_H_ */
@@ -0,0 +1,495 @@
+/******************************************************************************
+ * @file   PackedLayoutObject.cpp
+ * @brief  Native base type of mycocotb.types.PackedLayout
+ *
+ * A packed structure reaches Python as one LogicArray, and pulling its fields
+ * out with slices and int conversions costs a LogicArray and a Python int per
+ * field on every read. A layout is declared once with the offset, width and
+ * signedness of every field; unpack() then walks the value words a single time
+ * and returns the value of every field, and pack() builds the whole value of
+ * the structure from field values so it can be written with one put_value.
+ */
+
+#include "PackedLayoutObject.h"
+
+#include <structmember.h>
+
+#include <algorithm>
+
+namespace {
+
+PyObject *int_from_bytes;    // int.from_bytes
+PyObject *signed_kwargs[2];  // {"signed": False}, {"signed": True}
+PyObject *str_little;
+
+inline uint32_t low_mask(Py_ssize_t count) {
+    return count >= 32 ? 0xffffffffu : ((1u << count) - 1);
+}
+
+/** Whether any bit of the field is X or Z */
+bool field_has_xz(const PackedField &f, const LogicWord *words,
+                  Py_ssize_t n_words) {
+    for (Py_ssize_t i = 0; i < f.width; i += 32) {
+        uint32_t b = logic_words_extract(words, n_words, f.offset + i,
+                                         &LogicWord::bval);
+        if (b & low_mask(f.width - i)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+PyObject *field_to_int(const PackedField &f, const LogicWord *words,
+                       Py_ssize_t n_words) {
+    if (f.width <= 64) {
+        uint64_t v = logic_words_extract(words, n_words, f.offset,
+                                         &LogicWord::aval);
+        if (f.width > 32) {
+            v |= (uint64_t)logic_words_extract(words, n_words, f.offset + 32,
+                                               &LogicWord::aval)
+                 << 32;
+        }
+        int shift = (int)(64 - f.width);
+        if (f.is_signed) {
+            return PyLong_FromLongLong((int64_t)(v << shift) >> shift);
+        }
+        return PyLong_FromUnsignedLongLong(v << shift >> shift);
+    }
+    // 宽字段和LogicArray一样拼成小端的bytes交给int.from_bytes
+    Py_ssize_t n_chunks = logic_array_n_words(f.width);
+    PyObject *bytes = PyBytes_FromStringAndSize(NULL, n_chunks * 4);
+    if (bytes == NULL) {
+        return NULL;
+    }
+    unsigned char *buf = (unsigned char *)PyBytes_AS_STRING(bytes);
+    for (Py_ssize_t i = 0; i < n_chunks; i++) {
+        uint32_t w = logic_words_extract(words, n_words, f.offset + i * 32,
+                                         &LogicWord::aval);
+        Py_ssize_t count = f.width - i * 32;
+        if (count < 32) {
+            bool negative = f.is_signed && ((w >> (count - 1)) & 1);
+            w = negative ? w | ~low_mask(count) : w & low_mask(count);
+        }
+        for (int k = 0; k < 4; k++) {
+            buf[i * 4 + k] = (unsigned char)(w >> (8 * k));
+        }
+    }
+    PyObject *args = PyTuple_Pack(2, bytes, str_little);
+    Py_DECREF(bytes);
+    if (args == NULL) {
+        return NULL;
+    }
+    PyObject *result =
+        PyObject_Call(int_from_bytes, args, signed_kwargs[f.is_signed]);
+    Py_DECREF(args);
+    return result;
+}
+
+/** Write the int *value* into the field, -1 with an exception set */
+int int_to_field(const PackedField &f, PyObject *value, LogicWord *words) {
+    int overflow;
+    long long v = PyLong_AsLongLongAndOverflow(value, &overflow);
+    if (v == -1 && PyErr_Occurred()) {
+        return -1;
+    }
+    if (f.width <= 64) {
+        uint64_t bits = (uint64_t)v;
+        bool fits;
+        if (overflow > 0) {
+            // 只有64位的字段能放下超过long long的正数
+            bits = PyLong_AsUnsignedLongLong(value);
+            if (bits == (uint64_t)-1 && PyErr_Occurred()) {
+                PyErr_Clear();
+                fits = false;
+            } else {
+                fits = f.width == 64;
+            }
+        } else if (overflow < 0) {
+            fits = false;
+        } else if (v < 0) {
+            fits = f.width == 64 || v >= -(1ll << (f.width - 1));
+        } else {
+            fits = f.width == 64 || (uint64_t)v < (1ull << f.width);
+        }
+        if (!fits) {
+            PyErr_Format(PyExc_OverflowError,
+                         "Value %R out of range for %zd-bit field %R", value,
+                         f.width, f.name);
+            return -1;
+        }
+        for (Py_ssize_t i = 0; i < f.width; i += 32) {
+            int count = (int)std::min<Py_ssize_t>(f.width - i, 32);
+            logic_words_insert(words, f.offset + i, (uint32_t)(bits >> i),
+                               count, &LogicWord::aval);
+            logic_words_insert(words, f.offset + i, 0, count, &LogicWord::bval);
+        }
+        return 0;
+    }
+    // 宽字段：负数先加上2**width，再用to_bytes取出所有位
+    bool negative = overflow < 0 || (overflow == 0 && v < 0);
+    PyObject *width = PyLong_FromSsize_t(f.width);
+    PyObject *one = PyLong_FromLong(1);
+    PyObject *modulus = width && one ? PyNumber_Lshift(one, width) : NULL;
+    PyObject *half = modulus ? PyNumber_Rshift(modulus, one) : NULL;
+    Py_XDECREF(width);
+    Py_XDECREF(one);
+    PyObject *unsigned_value = NULL;
+    int fits = -1;
+    if (half != NULL) {
+        if (negative) {
+            // 加上之后还小于2**(width-1)就是超出了范围
+            unsigned_value = PyNumber_Add(value, modulus);
+            if (unsigned_value != NULL) {
+                fits = PyObject_RichCompareBool(unsigned_value, half, Py_GE);
+            }
+        } else {
+            Py_INCREF(value);
+            unsigned_value = value;
+            fits = PyObject_RichCompareBool(value, modulus, Py_LT);
+        }
+    }
+    Py_XDECREF(modulus);
+    Py_XDECREF(half);
+    if (fits <= 0) {
+        if (fits == 0) {
+            PyErr_Format(PyExc_OverflowError,
+                         "Value %R out of range for %zd-bit field %R", value,
+                         f.width, f.name);
+        }
+        Py_XDECREF(unsigned_value);
+        return -1;
+    }
+    Py_ssize_t n_chunks = logic_array_n_words(f.width);
+    PyObject *bytes = PyObject_CallMethod(unsigned_value, "to_bytes", "nO",
+                                          n_chunks * 4, str_little);
+    Py_DECREF(unsigned_value);
+    if (bytes == NULL) {
+        return -1;
+    }
+    const unsigned char *buf = (const unsigned char *)PyBytes_AS_STRING(bytes);
+    for (Py_ssize_t i = 0; i < n_chunks; i++) {
+        uint32_t w = (uint32_t)buf[i * 4] | ((uint32_t)buf[i * 4 + 1] << 8) |
+                     ((uint32_t)buf[i * 4 + 2] << 16) |
+                     ((uint32_t)buf[i * 4 + 3] << 24);
+        int count = (int)std::min<Py_ssize_t>(f.width - i * 32, 32);
+        logic_words_insert(words, f.offset + i * 32, w, count, &LogicWord::aval);
+        logic_words_insert(words, f.offset + i * 32, 0, count, &LogicWord::bval);
+    }
+    Py_DECREF(bytes);
+    return 0;
+}
+
+/** Copy *n_bits* bits of *src* starting at *src_pos* to *dst* at *dst_pos* */
+void copy_field_bits(LogicWord *dst, Py_ssize_t dst_pos,
+                     const LogicArrayObject *src, Py_ssize_t src_pos,
+                     Py_ssize_t n_bits) {
+    // 切片视图的位从base存储的第offset位开始
+    const LogicWord *words = src->words;
+    Py_ssize_t start = src->offset + src_pos;
+    Py_ssize_t n_words = logic_array_n_words(src->offset + src->n_bits);
+    for (Py_ssize_t i = 0; i < n_bits; i += 32) {
+        int count = (int)std::min<Py_ssize_t>(n_bits - i, 32);
+        logic_words_insert(
+            dst, dst_pos + i,
+            logic_words_extract(words, n_words, start + i, &LogicWord::aval),
+            count, &LogicWord::aval);
+        logic_words_insert(
+            dst, dst_pos + i,
+            logic_words_extract(words, n_words, start + i, &LogicWord::bval),
+            count, &LogicWord::bval);
+    }
+}
+
+/* Methods */
+
+PyObject *packed_layout_new(PyTypeObject *type, PyObject *args,
+                            PyObject *kwargs) {
+    static const char *kwlist[] = {"width", "fields", NULL};
+    Py_ssize_t width;
+    PyObject *fields;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "nO:PackedLayout",
+                                     (char **)kwlist, &width, &fields)) {
+        return NULL;
+    }
+    if (width <= 0) {
+        PyErr_SetString(PyExc_ValueError, "width must be positive");
+        return NULL;
+    }
+    PyObject *seq = PySequence_Fast(fields, "fields must be iterable");
+    if (seq == NULL) {
+        return NULL;
+    }
+    PackedLayoutObject *self = (PackedLayoutObject *)type->tp_alloc(type, 0);
+    if (self == NULL) {
+        Py_DECREF(seq);
+        return NULL;
+    }
+    self->width = width;
+    self->fields = new std::vector<PackedField>();
+    self->indexes = PyDict_New();
+    if (self->indexes == NULL) {
+        goto error;
+    }
+    for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(seq); i++) {
+        PyObject *item = PySequence_Fast_GET_ITEM(seq, i);
+        PyObject *name;
+        Py_ssize_t offset, field_width;
+        int is_signed = 0;
+        if (!PyTuple_Check(item) ||
+            !PyArg_ParseTuple(item, "Unn|p:PackedLayout", &name, &offset,
+                              &field_width, &is_signed)) {
+            if (!PyErr_Occurred()) {
+                PyErr_SetString(PyExc_TypeError,
+                                "Expected fields of (name, offset, width[, "
+                                "signed]) tuples");
+            }
+            goto error;
+        }
+        if (field_width <= 0 || offset < 0 || offset > width - field_width) {
+            PyErr_Format(PyExc_ValueError,
+                         "Field %R at offset %zd with width %zd does not fit "
+                         "in %zd bits",
+                         name, offset, field_width, width);
+            goto error;
+        }
+        if (PyDict_GetItemWithError(self->indexes, name) != NULL) {
+            PyErr_Format(PyExc_ValueError, "Duplicate field %R", name);
+            goto error;
+        }
+        if (PyErr_Occurred()) {
+            goto error;
+        }
+        PyObject *index = PyLong_FromSsize_t((Py_ssize_t)self->fields->size());
+        if (index == NULL) {
+            goto error;
+        }
+        int rc = PyDict_SetItem(self->indexes, name, index);
+        Py_DECREF(index);
+        if (rc < 0) {
+            goto error;
+        }
+        Py_INCREF(name);
+        self->fields->push_back({name, offset, field_width, is_signed != 0});
+    }
+    Py_DECREF(seq);
+    return (PyObject *)self;
+
+error:
+    Py_DECREF(seq);
+    Py_DECREF(self);
+    return NULL;
+}
+
+void packed_layout_dealloc(PackedLayoutObject *self) {
+    if (self->fields != NULL) {
+        for (PackedField &f : *self->fields) {
+            Py_DECREF(f.name);
+        }
+        delete self->fields;
+    }
+    Py_CLEAR(self->indexes);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+PyObject *packed_layout_unpack_method(PackedLayoutObject *self,
+                                      PyObject *value) {
+    if (!LogicArrayObject_Check(value)) {
+        PyErr_Format(PyExc_TypeError, "Expected LogicArray, not %s",
+                     Py_TYPE(value)->tp_name);
+        return NULL;
+    }
+    LogicArrayObject *array = (LogicArrayObject *)value;
+    if (array->offset != 0 && logic_array_unshare(array) < 0) {
+        return NULL;
+    }
+    return packed_layout_unpack(self, array->words, array->n_bits);
+}
+
+PyObject *packed_layout_pack(PackedLayoutObject *self, PyObject *args,
+                             PyObject *kwargs) {
+    static const char *kwlist[] = {"values", "base", NULL};
+    PyObject *values, *base = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!|O:pack", (char **)kwlist,
+                                     &PyDict_Type, &values, &base)) {
+        return NULL;
+    }
+    if (base != Py_None) {
+        if (!LogicArrayObject_Check(base)) {
+            PyErr_Format(PyExc_TypeError, "Expected LogicArray base, not %s",
+                         Py_TYPE(base)->tp_name);
+            return NULL;
+        }
+        if (((LogicArrayObject *)base)->n_bits != self->width) {
+            PyErr_Format(PyExc_ValueError,
+                         "Base has %zd bits, the layout has %zd",
+                         ((LogicArrayObject *)base)->n_bits, self->width);
+            return NULL;
+        }
+    }
+    // 没有给出的位取base的值，没有base时是0
+    std::vector<LogicWord> words(logic_array_n_words(self->width), {0, 0});
+    if (base != Py_None) {
+        copy_field_bits(words.data(), 0, (LogicArrayObject *)base, 0,
+                        self->width);
+    }
+    Py_ssize_t pos = 0;
+    PyObject *name, *value;
+    while (PyDict_Next(values, &pos, &name, &value)) {
+        PyObject *index = PyDict_GetItemWithError(self->indexes, name);
+        if (index == NULL) {
+            if (!PyErr_Occurred()) {
+                PyErr_Format(PyExc_KeyError, "No field %R in the layout", name);
+            }
+            return NULL;
+        }
+        const PackedField &f = (*self->fields)[PyLong_AsSsize_t(index)];
+        if (LogicArrayObject_Check(value)) {
+            LogicArrayObject *array = (LogicArrayObject *)value;
+            if (array->n_bits != f.width) {
+                PyErr_Format(PyExc_ValueError,
+                             "Value of length %zd for %zd-bit field %R",
+                             array->n_bits, f.width, f.name);
+                return NULL;
+            }
+            copy_field_bits(words.data(), f.offset, array, 0, f.width);
+        } else if (PyLong_Check(value)) {
+            if (int_to_field(f, value, words.data()) < 0) {
+                return NULL;
+            }
+        } else {
+            PyErr_Format(PyExc_TypeError,
+                         "Expected int or LogicArray for field %R, not %s",
+                         f.name, Py_TYPE(value)->tp_name);
+            return NULL;
+        }
+    }
+    return logic_array_from_words(words.data(), self->width);
+}
+
+PyObject *packed_layout_get_fields(PackedLayoutObject *self, void *) {
+    PyObject *result = PyTuple_New((Py_ssize_t)self->fields->size());
+    if (result == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < self->fields->size(); i++) {
+        const PackedField &f = (*self->fields)[i];
+        PyObject *item = Py_BuildValue("(OnnO)", f.name, f.offset, f.width,
+                                       f.is_signed ? Py_True : Py_False);
+        if (item == NULL) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(result, (Py_ssize_t)i, item);
+    }
+    return result;
+}
+
+PyMethodDef packed_layout_methods[] = {
+    {"unpack", (PyCFunction)packed_layout_unpack_method, METH_O,
+     PyDoc_STR("unpack($self, value, /)\n"
+               "--\n\n"
+               "unpack(value: LogicArray) -> Dict[str, Optional[int]]\n"
+               "Return the value of every field of *value*.\n"
+               "\n"
+               "Fields containing X or Z bits are ``None``.")},
+    {"pack", (PyCFunction)(void (*)(void))packed_layout_pack,
+     METH_VARARGS | METH_KEYWORDS,
+     PyDoc_STR("pack($self, values, base=None)\n"
+               "--\n\n"
+               "pack(values: Dict[str, Union[int, LogicArray]], base: "
+               "Optional[LogicArray] = None) -> LogicArray\n"
+               "Return a value of the whole structure with the fields in "
+               "*values* set.\n"
+               "\n"
+               "Fields not in *values* are taken from *base*, or are 0 "
+               "without one.")},
+    {NULL, NULL, 0, NULL} /* Sentinel */
+};
+
+PyMemberDef packed_layout_members[] = {
+    {"width", T_PYSSIZET, offsetof(PackedLayoutObject, width), READONLY,
+     PyDoc_STR("Number of bits in the structure.")},
+    {NULL, 0, 0, 0, NULL} /* Sentinel */
+};
+
+PyGetSetDef packed_layout_getsets[] = {
+    {"fields", (getter)packed_layout_get_fields, NULL,
+     PyDoc_STR("``(name, offset, width, signed)`` of every field."), NULL},
+    {NULL, NULL, NULL, NULL, NULL} /* Sentinel */
+};
+
+}  // namespace
+
+PyObject *packed_layout_unpack(PackedLayoutObject *self, const LogicWord *words,
+                               Py_ssize_t n_bits) {
+    if (n_bits != self->width) {
+        PyErr_Format(PyExc_ValueError, "Value has %zd bits, the layout has %zd",
+                     n_bits, self->width);
+        return NULL;
+    }
+    Py_ssize_t n_words = logic_array_n_words(n_bits);
+    PyObject *result = _PyDict_NewPresized((Py_ssize_t)self->fields->size());
+    if (result == NULL) {
+        return NULL;
+    }
+    for (const PackedField &f : *self->fields) {
+        PyObject *value;
+        if (field_has_xz(f, words, n_words)) {
+            Py_INCREF(Py_None);
+            value = Py_None;
+        } else if ((value = field_to_int(f, words, n_words)) == NULL) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        int rc = PyDict_SetItem(result, f.name, value);
+        Py_DECREF(value);
+        if (rc < 0) {
+            Py_DECREF(result);
+            return NULL;
+        }
+    }
+    return result;
+}
+
+PyTypeObject PackedLayoutBase_type = []() -> PyTypeObject {
+    PyTypeObject type = {};
+    type.ob_base = {PyObject_HEAD_INIT(NULL) 0};
+    type.tp_name = "mycocotb.simulator.PackedLayoutBase";
+    type.tp_doc = "Native base of :class:`mycocotb.types.PackedLayout`.";
+    type.tp_basicsize = sizeof(PackedLayoutObject);
+    type.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
+    type.tp_new = packed_layout_new;
+    type.tp_dealloc = (destructor)packed_layout_dealloc;
+    type.tp_methods = packed_layout_methods;
+    type.tp_members = packed_layout_members;
+    type.tp_getset = packed_layout_getsets;
+    return type;
+}();
+
+int add_packed_layout_type(PyObject *simulator) {
+    if ((str_little = PyUnicode_InternFromString("little")) == NULL) {
+        return -1;
+    }
+    int_from_bytes =
+        PyObject_GetAttrString((PyObject *)&PyLong_Type, "from_bytes");
+    if (int_from_bytes == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < 2; i++) {
+        signed_kwargs[i] = Py_BuildValue("{sO}", "signed",
+                                         i ? Py_True : Py_False);
+        if (signed_kwargs[i] == NULL) {
+            return -1;
+        }
+    }
+    if (PyType_Ready(&PackedLayoutBase_type) < 0) {
+        return -1;
+    }
+    PyObject *typ = (PyObject *)&PackedLayoutBase_type;
+    Py_INCREF(typ);
+    if (PyModule_AddObject(simulator, "PackedLayoutBase", typ) < 0) {
+        Py_DECREF(typ);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,39 @@
+// 打包结构体的字段布局（simulator.PackedLayoutBase）。布局声明一次，之后读取时
+// 一次取出所有字段的值，写入时把所有字段拼成一个值。
+#ifndef MYCOCOTB_PACKED_LAYOUT_OBJECT_H_
+#define MYCOCOTB_PACKED_LAYOUT_OBJECT_H_
+
+#include <Python.h>
+
+#include <vector>
+
+#include "LogicArrayObject.h"
+
+struct PackedField {
+    PyObject *name;
+    Py_ssize_t offset;  // position of the least significant bit
+    Py_ssize_t width;
+    bool is_signed;
+};
+
+struct PackedLayoutObject {
+    PyObject_HEAD Py_ssize_t width;  // bits of the whole structure
+    std::vector<PackedField> *fields;
+    PyObject *indexes;  // name -> position in fields
+};
+
+extern PyTypeObject PackedLayoutBase_type;
+
+static inline bool PackedLayoutObject_Check(PyObject *obj) {
+    return PyObject_TypeCheck(obj, &PackedLayoutBase_type);
+}
+
+// A dict of the value of each field in the *n_bits* bits of *words*, None for
+// fields with X or Z bits. Returns NULL on failure.
+PyObject *packed_layout_unpack(PackedLayoutObject *self, const LogicWord *words,
+                               Py_ssize_t n_bits);
+
+// Add PackedLayoutBase to the simulator module, returns -1 on failure
+int add_packed_layout_type(PyObject *simulator);
+
+#endif /* MYCOCOTB_PACKED_LAYOUT_OBJECT_H_ */
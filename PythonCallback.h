@@ -0,0 +1,65 @@
+// GPI回调的用户数据（PythonCallback），simulatormodule.cpp和SchedulerCore.cpp共用。
+#ifndef MYCOCOTB_PYTHON_CALLBACK_H_
+#define MYCOCOTB_PYTHON_CALLBACK_H_
+
+#include <Python.h>
+
+#include <cstdint>
+
+#include "VpiImpl.h"
+#include "WaitList.h"
+
+#define COCOTB_ACTIVE_ID \
+    0xC0C07B  // User data flag to indicate callback is active
+#define COCOTB_INACTIVE_ID \
+    0xDEADB175  // User data flag set when callback has been de-registered
+
+// 回调触发时所处的仿真阶段，前三个和mycocotb.SimPhase一一对应，
+// NEXT_TIME在Python端看到的是SimPhase.NORMAL
+enum SimPhaseId {
+    SIM_PHASE_NORMAL = 0,
+    SIM_PHASE_READ_WRITE,
+    SIM_PHASE_READ_ONLY,
+    SIM_PHASE_NEXT_TIME
+};
+
+// The phase of the callback being handled, read by simulator.get_sim_phase()
+extern int current_sim_phase;
+
+// callback user data
+struct PythonCallback {
+    PythonCallback(PyObject *func, PyObject *_args, PyObject *_kwargs)
+        : function(func), args(_args), kwargs(_kwargs) {
+        // All PyObject references are stolen.
+        // Arguments may be NULL.
+        ++gpi_live_objects.created[GPI_OBJ_PYTHON_CB];
+    }
+    ~PythonCallback() {
+        ++gpi_live_objects.freed[GPI_OBJ_PYTHON_CB];
+        Py_XDECREF(function);
+        Py_XDECREF(args);
+        Py_XDECREF(kwargs);
+    }
+    uint32_t id_value =
+        COCOTB_ACTIVE_ID;  // COCOTB_ACTIVE_ID or COCOTB_INACTIVE_ID
+    PyObject *function;    // Function to call when the callback fires
+    PyObject *args;        // The arguments to call the function with
+    PyObject *kwargs;      // Keyword arguments to call the function with
+
+    // 周期回调触发后仍然保持COCOTB_ACTIVE_ID，直到被deregister
+    bool recurring = false;
+    // 正在handle_gpi_callback里执行，这时deregister只做标记，由它来释放
+    bool firing = false;
+    // SimPhaseId，注册时按回调的类型确定，触发时写进current_sim_phase
+    int phase = SIM_PHASE_NORMAL;
+
+    // 等待这个回调所属trigger的tasks，由SchedulerCore直接挂在这里，
+    // 回调触发时不用再去查trigger -> tasks的表
+    WaitList wait_list;
+};
+
+// Get the PythonCallback behind a simulator.gpi_cb_hdl object, or nullptr if
+// *obj* is not a callback handle
+PythonCallback *python_callback_from_handle(PyObject *obj);
+
+#endif /* MYCOCOTB_PYTHON_CALLBACK_H_ */
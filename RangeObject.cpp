@@ -0,0 +1,379 @@
+/******************************************************************************
+ * @file   RangeObject.cpp
+ * @brief  Native base type of mycocotb.types.Range
+ *
+ * Every index into a LogicArray or an Array is translated through its Range,
+ * so the Range keeps the left and right bounds and the direction as plain
+ * integers and answers index(), [], ``in`` and slicing by arithmetic instead
+ * of going through a Python range object.
+ */
+
+#include "RangeObject.h"
+
+#include <structmember.h>
+
+namespace {
+
+PyObject *str_to;
+PyObject *str_downto;
+
+/** Convert an int to a Py_ssize_t, false with an exception set */
+bool as_ssize_t(PyObject *obj, Py_ssize_t &value) {
+    if (!PyIndex_Check(obj)) {
+        PyErr_Format(PyExc_TypeError, "Expected int, not %s",
+                     Py_TYPE(obj)->tp_name);
+        return false;
+    }
+    value = PyNumber_AsSsize_t(obj, PyExc_OverflowError);
+    return !(value == -1 && PyErr_Occurred());
+}
+
+/** A new range of *type*, bypassing argument parsing */
+RangeObject *new_range(PyTypeObject *type, Py_ssize_t left, Py_ssize_t step,
+                       Py_ssize_t right) {
+    RangeObject *self = (RangeObject *)type->tp_alloc(type, 0);
+    if (self == NULL) {
+        return NULL;
+    }
+    self->left = left;
+    self->right = right;
+    self->step = step;
+    Py_ssize_t length = (right - left) * step + 1;
+    self->length = length > 0 ? length : 0;
+    self->hash = -1;
+    return self;
+}
+
+/** 1 for "to" and -1 for "downto" in any case, 0 with an exception set */
+int direction_step(PyObject *direction) {
+    // 绝大多数时候是小写的，不用先转换
+    if (PyUnicode_Compare(direction, str_to) == 0) {
+        return 1;
+    }
+    if (PyUnicode_Compare(direction, str_downto) == 0) {
+        return -1;
+    }
+    PyObject *lower = PyObject_CallMethod(direction, "lower", NULL);
+    if (lower == NULL) {
+        return 0;
+    }
+    int step = 0;
+    if (PyUnicode_Compare(lower, str_to) == 0) {
+        step = 1;
+    } else if (PyUnicode_Compare(lower, str_downto) == 0) {
+        step = -1;
+    } else if (!PyErr_Occurred()) {
+        PyErr_SetString(PyExc_ValueError, "direction must be 'to' or 'downto'");
+    }
+    Py_DECREF(lower);
+    return step;
+}
+
+PyObject *range_new(PyTypeObject *type, PyObject *args, PyObject *kwargs) {
+    static const char *kwlist[] = {"left", "direction", "right", NULL};
+    PyObject *left_obj, *direction = Py_None, *right_obj = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|OO:Range",
+                                     (char **)kwlist, &left_obj, &direction,
+                                     &right_obj)) {
+        return NULL;
+    }
+    Py_ssize_t left, right, step;
+    if (!as_ssize_t(left_obj, left)) {
+        return NULL;
+    }
+    if (PyLong_Check(direction) && right_obj == Py_None) {
+        // Range(left, right)
+        if (!as_ssize_t(direction, right)) {
+            return NULL;
+        }
+        step = left <= right ? 1 : -1;
+    } else if (PyUnicode_Check(direction) && PyLong_Check(right_obj)) {
+        if (!as_ssize_t(right_obj, right)) {
+            return NULL;
+        }
+        int dir = direction_step(direction);
+        if (dir == 0) {
+            return NULL;
+        }
+        step = dir;
+    } else if (direction == Py_None && PyLong_Check(right_obj)) {
+        if (!as_ssize_t(right_obj, right)) {
+            return NULL;
+        }
+        step = left <= right ? 1 : -1;
+    } else {
+        PyErr_SetString(PyExc_TypeError, "invalid arguments");
+        return NULL;
+    }
+    return (PyObject *)new_range(type, left, step, right);
+}
+
+void range_dealloc(PyObject *self) { Py_TYPE(self)->tp_free(self); }
+
+/** Position of an object in the range, -1 if it is not in it, -2 on error */
+Py_ssize_t position_of(RangeObject *self, PyObject *value) {
+    if (PyLong_Check(value)) {
+        int overflow;
+        long long v = PyLong_AsLongLongAndOverflow(value, &overflow);
+        if (v == -1 && PyErr_Occurred()) {
+            return -2;
+        }
+        // 远超出范围的值不参与计算，以免相减溢出
+        if (overflow || v < PY_SSIZE_T_MIN / 2 || v > PY_SSIZE_T_MAX / 2) {
+            return -1;
+        }
+        return range_object_position(self, (Py_ssize_t)v);
+    }
+    // 和range一样，其它类型的对象逐个比较
+    for (Py_ssize_t i = 0; i < self->length; i++) {
+        PyObject *item = PyLong_FromSsize_t(self->left + i * self->step);
+        if (item == NULL) {
+            return -2;
+        }
+        int rc = PyObject_RichCompareBool(item, value, Py_EQ);
+        Py_DECREF(item);
+        if (rc != 0) {
+            return rc < 0 ? -2 : i;
+        }
+    }
+    return -1;
+}
+
+Py_ssize_t range_length(RangeObject *self) { return self->length; }
+
+PyObject *range_item(RangeObject *self, Py_ssize_t i) {
+    if (i < 0) {
+        i += self->length;
+    }
+    if (i < 0 || i >= self->length) {
+        PyErr_SetString(PyExc_IndexError, "range object index out of range");
+        return NULL;
+    }
+    return PyLong_FromSsize_t(self->left + i * self->step);
+}
+
+PyObject *range_subscript(RangeObject *self, PyObject *item) {
+    if (PyIndex_Check(item)) {
+        Py_ssize_t i = PyNumber_AsSsize_t(item, PyExc_IndexError);
+        if (i == -1 && PyErr_Occurred()) {
+            return NULL;
+        }
+        return range_item(self, i);
+    }
+    if (!PySlice_Check(item)) {
+        PyErr_Format(PyExc_TypeError,
+                     "indices must be integers or slices, not %s",
+                     Py_TYPE(item)->tp_name);
+        return NULL;
+    }
+    Py_ssize_t start, stop, step;
+    if (PySlice_Unpack(item, &start, &stop, &step) < 0) {
+        return NULL;
+    }
+    PySlice_AdjustIndices(self->length, &start, &stop, step);
+    if (step != 1 && step != -1) {
+        PyErr_SetString(PyExc_ValueError, "step must be 1 or -1");
+        return NULL;
+    }
+    // 等价于Range.from_range(self.to_range()[item])
+    Py_ssize_t new_step = self->step * step;
+    return (PyObject *)new_range(Py_TYPE(self), self->left + start * self->step,
+                                 new_step,
+                                 self->left + stop * self->step - new_step);
+}
+
+int range_contains(RangeObject *self, PyObject *value) {
+    Py_ssize_t i = position_of(self, value);
+    return i == -2 ? -1 : i >= 0;
+}
+
+PyObject *range_iter(RangeObject *self) {
+    PyObject *range =
+        PyObject_CallFunction((PyObject *)&PyRange_Type, "nnn", self->left,
+                              self->left + self->length * self->step, self->step);
+    if (range == NULL) {
+        return NULL;
+    }
+    PyObject *iter = PyObject_GetIter(range);
+    Py_DECREF(range);
+    return iter;
+}
+
+PyObject *range_richcompare(PyObject *self, PyObject *other, int op) {
+    if ((op != Py_EQ && op != Py_NE) || !RangeObject_Check(other)) {
+        Py_RETURN_NOTIMPLEMENTED;
+    }
+    // 和range一样：长度相同，并且非空时起点相同，多于一个元素时方向也相同
+    RangeObject *x = (RangeObject *)self, *y = (RangeObject *)other;
+    bool equal = x->length == y->length &&
+                 (x->length == 0 ||
+                  (x->left == y->left && (x->length == 1 || x->step == y->step)));
+    return PyBool_FromLong(equal == (op == Py_EQ));
+}
+
+Py_hash_t range_hash(RangeObject *self) {
+    if (self->hash != -1) {
+        return self->hash;
+    }
+    // 和hash(self.to_range())相同
+    PyObject *t;
+    if (self->length == 0) {
+        t = Py_BuildValue("(nOO)", self->length, Py_None, Py_None);
+    } else if (self->length == 1) {
+        t = Py_BuildValue("(nnO)", self->length, self->left, Py_None);
+    } else {
+        t = Py_BuildValue("(nnn)", self->length, self->left, self->step);
+    }
+    if (t == NULL) {
+        return -1;
+    }
+    self->hash = PyObject_Hash(t);
+    Py_DECREF(t);
+    return self->hash;
+}
+
+PyObject *direction_of(RangeObject *self) {
+    return self->step == 1 ? str_to : str_downto;
+}
+
+PyObject *range_repr(RangeObject *self) {
+    PyObject *name = PyObject_GetAttrString((PyObject *)Py_TYPE(self),
+                                            "__qualname__");
+    if (name == NULL) {
+        return NULL;
+    }
+    PyObject *result = PyUnicode_FromFormat("%U(%zd, %R, %zd)", name,
+                                            self->left, direction_of(self),
+                                            self->right);
+    Py_DECREF(name);
+    return result;
+}
+
+PyObject *range_get_direction(RangeObject *self, void *) {
+    PyObject *direction = direction_of(self);
+    Py_INCREF(direction);
+    return direction;
+}
+
+PyObject *range_index(RangeObject *self, PyObject *args) {
+    PyObject *value;
+    Py_ssize_t start = 0, stop = PY_SSIZE_T_MAX;
+    if (!PyArg_ParseTuple(args, "O|nn:index", &value, &start, &stop)) {
+        return NULL;
+    }
+    Py_ssize_t i = position_of(self, value);
+    if (i == -2) {
+        return NULL;
+    }
+    if (start < 0) {
+        start += self->length;
+    }
+    if (stop < 0) {
+        stop += self->length;
+    }
+    if (i < 0 || i < start || i >= stop) {
+        PyErr_Format(PyExc_ValueError, "%R is not in range", value);
+        return NULL;
+    }
+    return PyLong_FromSsize_t(i);
+}
+
+PyObject *range_count(RangeObject *self, PyObject *value) {
+    Py_ssize_t i = position_of(self, value);
+    if (i == -2) {
+        return NULL;
+    }
+    return PyLong_FromLong(i >= 0);
+}
+
+PyObject *range_reduce(RangeObject *self, PyObject *) {
+    return Py_BuildValue("(O(nOn))", (PyObject *)Py_TYPE(self), self->left,
+                         direction_of(self), self->right);
+}
+
+PyMethodDef range_methods[] = {
+    {"index", (PyCFunction)range_index, METH_VARARGS,
+     PyDoc_STR("index($self, value, start=0, stop=sys.maxsize, /)\n"
+               "--\n\n"
+               "index(value: int, start: int = 0, stop: int = ...) -> int\n"
+               "Return the position of *value* in the range.\n"
+               "\n"
+               "Raises ValueError if the value is not present.")},
+    {"count", (PyCFunction)range_count, METH_O,
+     PyDoc_STR("count($self, value, /)\n"
+               "--\n\n"
+               "count(value: int) -> int\n"
+               "Return the number of occurrences of *value*, 0 or 1.")},
+    {"__reduce__", (PyCFunction)range_reduce, METH_NOARGS, NULL},
+    {NULL, NULL, 0, NULL} /* Sentinel */
+};
+
+PyMemberDef range_members[] = {
+    {"left", T_PYSSIZET, offsetof(RangeObject, left), READONLY,
+     PyDoc_STR("Leftmost value in a Range.")},
+    {"right", T_PYSSIZET, offsetof(RangeObject, right), READONLY,
+     PyDoc_STR("Rightmost value in a Range.")},
+    {NULL, 0, 0, 0, NULL} /* Sentinel */
+};
+
+PyGetSetDef range_getsets[] = {
+    {"direction", (getter)range_get_direction, NULL,
+     PyDoc_STR("``'to'`` if Range is ascending, ``'downto'`` otherwise."),
+     NULL},
+    {NULL, NULL, NULL, NULL, NULL} /* Sentinel */
+};
+
+PySequenceMethods range_as_sequence = []() -> PySequenceMethods {
+    PySequenceMethods methods = {};
+    methods.sq_length = (lenfunc)range_length;
+    methods.sq_item = (ssizeargfunc)range_item;
+    methods.sq_contains = (objobjproc)range_contains;
+    return methods;
+}();
+
+PyMappingMethods range_as_mapping = []() -> PyMappingMethods {
+    PyMappingMethods methods = {};
+    methods.mp_length = (lenfunc)range_length;
+    methods.mp_subscript = (binaryfunc)range_subscript;
+    return methods;
+}();
+
+}  // namespace
+
+PyTypeObject RangeBase_type = []() -> PyTypeObject {
+    PyTypeObject type = {};
+    type.ob_base = {PyObject_HEAD_INIT(NULL) 0};
+    type.tp_name = "mycocotb.simulator.RangeBase";
+    type.tp_doc = "Native base of :class:`mycocotb.types.Range`.";
+    type.tp_basicsize = sizeof(RangeObject);
+    type.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
+    type.tp_new = range_new;
+    type.tp_dealloc = range_dealloc;
+    type.tp_as_sequence = &range_as_sequence;
+    type.tp_as_mapping = &range_as_mapping;
+    type.tp_iter = (getiterfunc)range_iter;
+    type.tp_richcompare = range_richcompare;
+    type.tp_hash = (hashfunc)range_hash;
+    type.tp_repr = (reprfunc)range_repr;
+    type.tp_methods = range_methods;
+    type.tp_members = range_members;
+    type.tp_getset = range_getsets;
+    return type;
+}();
+
+int add_range_type(PyObject *simulator) {
+    if ((str_to = PyUnicode_InternFromString("to")) == NULL ||
+        (str_downto = PyUnicode_InternFromString("downto")) == NULL) {
+        return -1;
+    }
+    if (PyType_Ready(&RangeBase_type) < 0) {
+        return -1;
+    }
+    PyObject *typ = (PyObject *)&RangeBase_type;
+    Py_INCREF(typ);
+    if (PyModule_AddObject(simulator, "RangeBase", typ) < 0) {
+        Py_DECREF(typ);
+        return -1;
+    }
+    return 0;
+}
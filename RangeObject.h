@@ -0,0 +1,32 @@
+// Range的C层基类（simulator.RangeBase）。只保存两个端点和方向，index、取元素、in
+// 和切片都是O(1)的算术。对象不可变，可以被从同一个句柄读出的所有值共享。
+#ifndef MYCOCOTB_RANGE_OBJECT_H_
+#define MYCOCOTB_RANGE_OBJECT_H_
+
+#include <Python.h>
+
+struct RangeObject {
+    PyObject_HEAD Py_ssize_t left;
+    Py_ssize_t right;
+    Py_ssize_t step;    // 1 for "to", -1 for "downto"
+    Py_ssize_t length;  // 0 for a null range
+    Py_hash_t hash;     // -1 until computed
+};
+
+extern PyTypeObject RangeBase_type;
+
+static inline bool RangeObject_Check(PyObject *obj) {
+    return PyObject_TypeCheck(obj, &RangeBase_type);
+}
+
+// Position of *value* in *range*, -1 if it is not in it
+static inline Py_ssize_t range_object_position(const RangeObject *range,
+                                               Py_ssize_t value) {
+    Py_ssize_t i = (value - range->left) * range->step;
+    return i >= 0 && i < range->length ? i : -1;
+}
+
+// Add RangeBase to the simulator module, returns -1 on failure
+int add_range_type(PyObject *simulator);
+
+#endif /* MYCOCOTB_RANGE_OBJECT_H_ */
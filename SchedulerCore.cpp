@@ -0,0 +1,1466 @@
+/******************************************************************************
+ * @file   SchedulerCore.cpp
+ * @brief  Native implementation of the scheduler's hot loop
+ *
+ * Implements the bookkeeping of mycocotb._scheduler.Scheduler around
+ * ``coro.send``: the ready queue, the trigger -> tasks map, resuming tasks and
+ * reacting to fired triggers. Tasks are accessed through their native base
+ * (TaskObject.h); triggers remain the Python objects defined in the mycocotb
+ * package. Tasks are resumed with the sent value itself, an Outcome is only
+ * needed when Python code schedules a task with one.
+ */
+
+#include "SchedulerCore.h"
+
+#include <pythread.h>
+#include <structmember.h>
+
+#include <cstdint>
+#include <deque>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+#include "GpiHistogram.h"
+#include "GpiTrace.h"
+#include "PythonCallback.h"
+#include "TaskObject.h"
+#include "TaskProfiler.h"
+#include "WaitList.h"
+
+#if PY_VERSION_HEX < 0x030A0000
+// PyIter_Send是Python 3.10才加入的，老版本里退回到调用coro.send()
+typedef enum {
+    PYGEN_RETURN = 0,
+    PYGEN_ERROR = -1,
+    PYGEN_NEXT = 1,
+} PySendResult;
+#endif
+
+namespace {
+
+// Interned attribute names, created once in add_scheduler_core_types()
+PyObject *str__primed;
+PyObject *str__cbhdl;
+PyObject *str__prime;
+PyObject *str__unprime;
+PyObject *str__cleanup;
+PyObject *str__handle_termination;
+PyObject *str__terminate;
+PyObject *str_complete;
+PyObject *str_value;
+PyObject *str_error;
+PyObject *str_send;
+PyObject *str_throw;
+PyObject *str_set;
+PyObject *str_popleft;
+PyObject *str_log;
+PyObject *str_critical;
+PyObject *str_info;
+
+int intern_names() {
+#define INTERN(var, name)                                     \
+    if ((var = PyUnicode_InternFromString(name)) == NULL) { \
+        return -1;                                          \
+    }
+    INTERN(str__primed, "_primed");
+    INTERN(str__cbhdl, "_cbhdl");
+    INTERN(str__prime, "_prime");
+    INTERN(str__unprime, "_unprime");
+    INTERN(str__cleanup, "_cleanup");
+    INTERN(str__handle_termination, "_handle_termination");
+    INTERN(str__terminate, "_terminate");
+    INTERN(str_complete, "complete");
+    INTERN(str_value, "value");
+    INTERN(str_error, "error");
+    INTERN(str_send, "send");
+    INTERN(str_throw, "throw");
+    INTERN(str_set, "set");
+    INTERN(str_popleft, "popleft");
+    INTERN(str_log, "log");
+    INTERN(str_critical, "critical");
+    INTERN(str_info, "info");
+#undef INTERN
+    return 0;
+}
+
+/** Call ``obj.name()`` and discard the result, returns -1 on failure */
+int call_method_noargs(PyObject *obj, PyObject *name) {
+    PyObject *r = PyObject_CallMethodObjArgs(obj, name, NULL);
+    if (r == NULL) {
+        return -1;
+    }
+    Py_DECREF(r);
+    return 0;
+}
+
+/** Call ``obj.name(arg)`` and discard the result, returns -1 on failure */
+int call_method_onearg(PyObject *obj, PyObject *name, PyObject *arg) {
+    PyObject *r = PyObject_CallMethodObjArgs(obj, name, arg, NULL);
+    if (r == NULL) {
+        return -1;
+    }
+    Py_DECREF(r);
+    return 0;
+}
+
+/** Fetch the value of a pending StopIteration, returns false if it isn't one */
+bool fetch_stop_iteration(PyObject **value) {
+    if (!PyErr_ExceptionMatches(PyExc_StopIteration)) {
+        return false;
+    }
+    PyObject *type, *exc, *tb;
+    PyErr_Fetch(&type, &exc, &tb);
+    PyErr_NormalizeException(&type, &exc, &tb);
+    *value = ((PyStopIterationObject *)exc)->value;
+    Py_INCREF(*value);
+    Py_XDECREF(type);
+    Py_XDECREF(exc);
+    Py_XDECREF(tb);
+    return true;
+}
+
+#if PY_VERSION_HEX < 0x030A0000
+PySendResult PyIter_Send(PyObject *iter, PyObject *arg, PyObject **presult) {
+    *presult = PyObject_CallMethodObjArgs(iter, str_send, arg, NULL);
+    if (*presult != NULL) {
+        return PYGEN_NEXT;
+    }
+    return fetch_stop_iteration(presult) ? PYGEN_RETURN : PYGEN_ERROR;
+}
+#endif
+
+/** Fetch the pending exception as a normalized exception object with traceback */
+PyObject *fetch_exception() {
+    PyObject *type, *exc, *tb;
+    PyErr_Fetch(&type, &exc, &tb);
+    PyErr_NormalizeException(&type, &exc, &tb);
+    if (tb != NULL) {
+        PyException_SetTraceback(exc, tb);
+    }
+    Py_XDECREF(type);
+    Py_XDECREF(tb);
+    return exc;
+}
+
+/** Remove *task* from *waiters*, dropping the reference held by the list */
+void remove_waiter(std::vector<PyObject *> &waiters, PyObject *task) {
+    for (auto it = waiters.begin(); it != waiters.end(); ++it) {
+        if (*it == task) {
+            waiters.erase(it);
+            Py_DECREF(task);
+            return;
+        }
+    }
+}
+
+class SchedulerCore;
+
+// simulator.WaitTrigger: a trigger carrying its own wait list. Event, Lock and
+// Queue fire it directly, waking every attached task in one batch.
+struct WaitTriggerObject {
+    PyObject_HEAD WaitList wait_list;  // Tasks attached by a SchedulerCore
+    SchedulerCore *core;               // The core that attached them
+    PyObject *callback;  // Set by _prime() when the Python scheduler is used
+    char primed;
+};
+
+extern PyTypeObject WaitTrigger_type;
+
+// 恢复task的方式：绝大多数时候直接把value送进协程，只有注入异常时才throw
+enum ResumeKind : uint8_t {
+    RESUME_SEND,     // coro.send(value)
+    RESUME_THROW,    // coro.throw(value)
+    RESUME_OUTCOME,  // value.send(coro), any other Outcome from Python code
+};
+
+struct ReadyEntry {
+    TaskObject *task;  // strong reference
+    PyObject *value;   // strong reference
+    uint64_t seq;      // matches task->ready_seq while still queued
+    ResumeKind kind;
+};
+
+class SchedulerCore {
+  public:
+    explicit SchedulerCore(PyObject *scheduler) : m_scheduler(scheduler) {
+        m_attached.prev = m_attached.next = &m_attached;
+    }
+    ~SchedulerCore();
+
+    int initialise(PyObject *self);
+
+    int schedule_task(TaskObject *task, PyObject *value = Py_None,
+                      ResumeKind kind = RESUME_SEND);
+    int schedule_task_outcome(TaskObject *task, PyObject *outcome);
+    int schedule_task_upon(TaskObject *task, PyObject *trigger);
+    int react(PyObject *trigger);
+    int sim_react(PyObject *trigger);
+    int fire(PythonCallback *cb);
+    int wake_all(PyObject *trigger, WaitList *list) {
+        return wake(trigger, list->take());
+    }
+    int event_loop();
+    int resume_task(TaskObject *task, PyObject *value, ResumeKind kind);
+    int resume_task_outcome(TaskObject *task, PyObject *outcome);
+    int unschedule(TaskObject *task);
+
+    int has_waiters(PyObject *trigger);
+    PyObject *wakeup_stats();
+    PyObject *trigger2tasks();
+    PyObject *pop_scheduled();
+
+    int traverse(visitproc visit, void *arg);
+    void clear();
+
+  private:
+    int resume_task_(TaskObject *task, PyObject *value, ResumeKind kind);
+    PyObject *advance(TaskObject *task, PyObject *value, ResumeKind kind);
+    int finish_task(TaskObject *task, PyObject *outcome);
+    int outcome_kind(PyObject *outcome, PyObject **value, ResumeKind *kind);
+    int schedule_task_upon_gpi(TaskObject *task, PyObject *trigger);
+    int add_waiter(TaskObject *task, PyObject *trigger);
+    void attach(TaskObject *task, PyObject *trigger, WaitList *list);
+    int wait_list_of(PyObject *trigger, WaitList **list);
+    int wake(PyObject *trigger, std::vector<PyObject *> tasks);
+    int enter_phase();
+    int is_primed(PyObject *trigger);
+    PyObject *trigger_from_any(PyObject *result);
+    int terminating();
+    int drain_pending_events();
+    void drop_waiters(PyObject *trigger);
+
+    PyObject *m_scheduler;  // borrowed, the Scheduler owns this core
+    PyObject *m_scheduler_dict = nullptr;
+
+    // Python objects the core needs, looked up once in initialise()
+    PyObject *m_react = nullptr;      // bound SchedulerCore.react
+    PyObject *m_sim_react = nullptr;  // bound SchedulerCore.sim_react
+    PyObject *m_trigger_type = nullptr;
+    PyObject *m_gpi_trigger_type = nullptr;
+    PyObject *m_value_type = nullptr;
+    PyObject *m_error_type = nullptr;
+    PyObject *m_apply_writes = nullptr;
+    PyObject *m_none_outcome = nullptr;
+    PyObject *m_pending_events = nullptr;
+
+    TaskObject *m_current_task = nullptr;
+
+    // 用deque加序号来模拟OrderedDict：_unschedule时只清掉task->ready_seq，
+    // 留在deque里的旧条目在出队时发现序号对不上就直接丢弃。
+    std::deque<ReadyEntry> m_ready;
+    uint64_t m_seq = 0;
+
+    // trigger唤醒task的次数，以及task已经在就绪队列里、被合并掉的唤醒次数
+    uint64_t m_wakeups = 0;
+    uint64_t m_coalesced = 0;
+
+    // trigger -> 等待它的tasks，key和value都持有引用。Trigger没有重载
+    // __hash__/__eq__，所以按对象地址查找和Python的dict是等价的。
+    std::unordered_map<PyObject *, std::vector<PyObject *>> m_waiters;
+
+    // GPI trigger和WaitTrigger的等待队列挂在各自的回调记录/trigger上，
+    // 这里是所有非空等待队列组成的循环链表的哨兵节点
+    WaitList m_attached;
+};
+
+SchedulerCore::~SchedulerCore() { clear(); }
+
+// 就绪队列、等待队列里的tasks和trigger都由core持有，包括挂在WaitTrigger
+// 和GPI回调记录上的等待队列，它们都要让GC看到
+int SchedulerCore::traverse(visitproc visit, void *arg) {
+    Py_VISIT(m_react);
+    Py_VISIT(m_sim_react);
+    Py_VISIT(m_scheduler_dict);
+    Py_VISIT(m_trigger_type);
+    Py_VISIT(m_gpi_trigger_type);
+    Py_VISIT(m_value_type);
+    Py_VISIT(m_error_type);
+    Py_VISIT(m_apply_writes);
+    Py_VISIT(m_none_outcome);
+    Py_VISIT(m_pending_events);
+    for (auto &entry : m_ready) {
+        Py_VISIT(entry.task);
+        Py_VISIT(entry.value);
+    }
+    for (auto &item : m_waiters) {
+        Py_VISIT(item.first);
+        for (PyObject *task : item.second) {
+            Py_VISIT(task);
+        }
+    }
+    for (WaitList *list = m_attached.next; list != &m_attached;
+         list = list->next) {
+        for (PyObject *task : list->waiters) {
+            Py_VISIT(task);
+        }
+    }
+    return 0;
+}
+
+void SchedulerCore::clear() {
+    // 先把引用都从core里拿出来再释放，释放时运行的代码看到的是清空后的core
+    std::deque<ReadyEntry> ready;
+    ready.swap(m_ready);
+    std::unordered_map<PyObject *, std::vector<PyObject *>> waiters;
+    waiters.swap(m_waiters);
+    std::vector<PyObject *> attached;
+    while (m_attached.next != &m_attached) {
+        WaitList *list = m_attached.next;
+        if (PyObject_TypeCheck(list->trigger, &WaitTrigger_type)) {
+            // WaitTrigger可能比core活得更久，不能留下指向core的指针
+            ((WaitTriggerObject *)list->trigger)->core = nullptr;
+        }
+        for (PyObject *task : list->take()) {
+            attached.push_back(task);
+        }
+    }
+    for (auto &entry : ready) {
+        Py_DECREF(entry.task);
+        Py_DECREF(entry.value);
+    }
+    for (auto &item : waiters) {
+        for (PyObject *task : item.second) {
+            Py_DECREF(task);
+        }
+        Py_DECREF(item.first);
+    }
+    for (PyObject *task : attached) {
+        Py_DECREF(task);
+    }
+
+    Py_CLEAR(m_react);
+    Py_CLEAR(m_sim_react);
+    Py_CLEAR(m_scheduler_dict);
+    Py_CLEAR(m_trigger_type);
+    Py_CLEAR(m_gpi_trigger_type);
+    Py_CLEAR(m_value_type);
+    Py_CLEAR(m_error_type);
+    Py_CLEAR(m_apply_writes);
+    Py_CLEAR(m_none_outcome);
+    Py_CLEAR(m_pending_events);
+}
+
+/** Look up ``module.name`` (or ``module.name.attr``), returns a new reference */
+PyObject *import_attr(const char *module, const char *name,
+                      const char *attr = nullptr) {
+    PyObject *mod = PyImport_ImportModule(module);
+    if (mod == NULL) {
+        return NULL;
+    }
+    PyObject *obj = PyObject_GetAttrString(mod, name);
+    Py_DECREF(mod);
+    if (obj == NULL || attr == nullptr) {
+        return obj;
+    }
+    PyObject *sub = PyObject_GetAttrString(obj, attr);
+    Py_DECREF(obj);
+    return sub;
+}
+
+int SchedulerCore::initialise(PyObject *self) {
+    m_react = PyObject_GetAttrString(self, "react");
+    m_sim_react = PyObject_GetAttrString(self, "sim_react");
+    m_scheduler_dict = PyObject_GenericGetDict(m_scheduler, NULL);
+    m_trigger_type = import_attr("mycocotb.triggers", "Trigger");
+    m_gpi_trigger_type = import_attr("mycocotb.triggers", "GPITrigger");
+    m_value_type = import_attr("mycocotb._outcomes", "Value");
+    m_error_type = import_attr("mycocotb._outcomes", "Error");
+    m_apply_writes =
+        import_attr("mycocotb._write_scheduler", "apply_scheduled_writes");
+    if (PyErr_Occurred()) {
+        return -1;
+    }
+
+    // Scheduler上被复用的单例和列表，它们在Scheduler的生命周期内不会被替换
+    m_none_outcome = PyObject_GetAttrString(m_scheduler, "_none_outcome");
+    m_pending_events = PyObject_GetAttrString(m_scheduler, "_pending_events");
+    if (PyErr_Occurred()) {
+        return -1;
+    }
+    return 0;
+}
+
+int SchedulerCore::terminating() {
+    // 直接查Scheduler实例的__dict__，shutdown_soon()仍然是Python代码
+    PyObject *terminate =
+        PyDict_GetItemWithError(m_scheduler_dict, str__terminate);
+    if (terminate == NULL) {
+        return PyErr_Occurred() ? -1 : 0;
+    }
+    return PyObject_IsTrue(terminate);
+}
+
+int SchedulerCore::schedule_task(TaskObject *task, PyObject *value,
+                                 ResumeKind kind) {
+    // Don't queue the same task more than once (gh-2503)
+    if (task->ready_seq != 0) {
+        PyErr_SetString(PyExc_Exception, "Task was queued more than once.");
+        return -1;
+    }
+    task->state = TASK_SCHEDULED;
+    Py_INCREF(task);
+    Py_INCREF(value);
+    task->ready_seq = ++m_seq;
+    m_ready.push_back({task, value, m_seq, kind});
+    return 0;
+}
+
+// Python代码传进来的Outcome：Value和Error拆开成value直接送进协程，
+// 其它的Outcome子类原样保留，由它自己的send()恢复协程
+int SchedulerCore::outcome_kind(PyObject *outcome, PyObject **value,
+                                ResumeKind *kind) {
+    if (outcome == Py_None || outcome == m_none_outcome) {
+        Py_INCREF(Py_None);
+        *value = Py_None;
+        *kind = RESUME_SEND;
+    } else if (Py_TYPE(outcome) == (PyTypeObject *)m_value_type) {
+        *value = PyObject_GetAttr(outcome, str_value);
+        *kind = RESUME_SEND;
+    } else if (Py_TYPE(outcome) == (PyTypeObject *)m_error_type) {
+        *value = PyObject_GetAttr(outcome, str_error);
+        *kind = RESUME_THROW;
+    } else {
+        Py_INCREF(outcome);
+        *value = outcome;
+        *kind = RESUME_OUTCOME;
+    }
+    return *value == NULL ? -1 : 0;
+}
+
+int SchedulerCore::schedule_task_outcome(TaskObject *task, PyObject *outcome) {
+    PyObject *value;
+    ResumeKind kind;
+    if (outcome_kind(outcome, &value, &kind) < 0) {
+        return -1;
+    }
+    int rc = schedule_task(task, value, kind);
+    Py_DECREF(value);
+    return rc;
+}
+
+void SchedulerCore::drop_waiters(PyObject *trigger) {
+    auto it = m_waiters.find(trigger);
+    if (it == m_waiters.end()) {
+        return;
+    }
+    PyObject *key = it->first;
+    std::vector<PyObject *> tasks = std::move(it->second);
+    m_waiters.erase(it);
+    for (PyObject *task : tasks) {
+        Py_DECREF(task);
+    }
+    Py_DECREF(key);
+}
+
+int SchedulerCore::wait_list_of(PyObject *trigger, WaitList **list) {
+    *list = nullptr;
+    if (PyObject_TypeCheck(trigger, &WaitTrigger_type)) {
+        *list = &((WaitTriggerObject *)trigger)->wait_list;
+        return 0;
+    }
+    if (!PyObject_TypeCheck(trigger, (PyTypeObject *)m_gpi_trigger_type)) {
+        return 0;
+    }
+    PyObject *cbhdl = PyObject_GetAttr(trigger, str__cbhdl);
+    if (cbhdl == NULL) {
+        return -1;
+    }
+    PythonCallback *cb = python_callback_from_handle(cbhdl);
+    Py_DECREF(cbhdl);
+    if (cb != nullptr) {
+        *list = &cb->wait_list;
+    }
+    return 0;
+}
+
+void SchedulerCore::attach(TaskObject *task, PyObject *trigger,
+                           WaitList *list) {
+    Py_INCREF(task);
+    list->waiters.push_back((PyObject *)task);
+    if (!list->linked()) {
+        list->trigger = trigger;
+        list->link_after(&m_attached);
+    }
+}
+
+int SchedulerCore::has_waiters(PyObject *trigger) {
+    WaitList *list;
+    if (wait_list_of(trigger, &list) < 0) {
+        return -1;
+    }
+    if (list != nullptr && !list->waiters.empty()) {
+        return 1;
+    }
+    return m_waiters.find(trigger) != m_waiters.end();
+}
+
+int SchedulerCore::is_primed(PyObject *trigger) {
+    PyObject *primed = PyObject_GetAttr(trigger, str__primed);
+    if (primed == NULL) {
+        return -1;
+    }
+    int rc = PyObject_IsTrue(primed);
+    Py_DECREF(primed);
+    return rc;
+}
+
+int SchedulerCore::add_waiter(TaskObject *task, PyObject *trigger) {
+    auto it = m_waiters.find(trigger);
+    if (it == m_waiters.end()) {
+        Py_INCREF(trigger);
+        it = m_waiters.emplace(trigger, std::vector<PyObject *>()).first;
+    }
+    Py_INCREF(task);
+    it->second.push_back((PyObject *)task);
+    return (int)it->second.size();
+}
+
+int SchedulerCore::schedule_task_upon(TaskObject *task, PyObject *trigger) {
+    Py_INCREF(trigger);
+    Py_XSETREF(task->trigger, trigger);
+    task->state = TASK_PENDING;
+    if (PyObject_TypeCheck(trigger, &WaitTrigger_type)) {
+        // 自带等待队列，不需要prime，直接挂上去
+        auto *wait_trigger = (WaitTriggerObject *)trigger;
+        wait_trigger->core = this;
+        attach(task, trigger, &wait_trigger->wait_list);
+        return 0;
+    }
+    if (PyObject_TypeCheck(trigger, (PyTypeObject *)m_gpi_trigger_type)) {
+        return schedule_task_upon_gpi(task, trigger);
+    }
+
+    int n_waiting = add_waiter(task, trigger);
+    int primed = is_primed(trigger);
+    if (primed != 0) {
+        return primed < 0 ? -1 : 0;
+    }
+
+    if (n_waiting != 1) {
+        // should never happen
+        PyErr_SetString(PyExc_Exception,
+                        "More than one task waiting on an unprimed trigger");
+        return -1;
+    }
+
+    // 注意：_prime里可能会立即回调react（如NullTrigger），所以之后不能再用it
+    if (call_method_onearg(trigger, str__prime, m_react) < 0) {
+        if (!PyErr_ExceptionMatches(PyExc_Exception)) {
+            return -1;
+        }
+        PyObject *exc = fetch_exception();
+
+        // discard the trigger we associated, it will never fire
+        drop_waiters(trigger);
+
+        // replace it with a new trigger that throws back the exception
+        int rc = schedule_task(task, exc, RESUME_THROW);
+        Py_DECREF(exc);
+        return rc;
+    }
+    return 0;
+}
+
+// GPI trigger先prime，再把task挂到prime得到的回调记录上
+int SchedulerCore::schedule_task_upon_gpi(TaskObject *task, PyObject *trigger) {
+    int primed = is_primed(trigger);
+    if (primed < 0) {
+        return -1;
+    }
+    if (!primed &&
+        call_method_onearg(trigger, str__prime, m_sim_react) < 0) {
+        if (!PyErr_ExceptionMatches(PyExc_Exception)) {
+            return -1;
+        }
+        // replace it with a new trigger that throws back the exception
+        PyObject *exc = fetch_exception();
+        int rc = schedule_task(task, exc, RESUME_THROW);
+        Py_DECREF(exc);
+        return rc;
+    }
+
+    WaitList *list;
+    if (wait_list_of(trigger, &list) < 0) {
+        return -1;
+    }
+    if (list == nullptr) {
+        // 没有回调记录的GPI trigger还是记在m_waiters里
+        return add_waiter(task, trigger) < 0 ? -1 : 0;
+    }
+    if (!primed && !list->waiters.empty()) {
+        // should never happen
+        PyErr_SetString(PyExc_Exception,
+                        "More than one task waiting on an unprimed trigger");
+        return -1;
+    }
+    attach(task, trigger, list);
+    return 0;
+}
+
+// 把tasks（引用被偷走）全部排进就绪队列，然后清理trigger
+int SchedulerCore::wake(PyObject *trigger, std::vector<PyObject *> tasks) {
+    // queue all tasks to wake up. 某个task排队失败时先把异常存起来，其余的
+    // task照样排队，不然它们的trigger已经清掉，就再也不会被唤醒了
+    PyObject *exc_type = NULL, *exc_value = NULL, *exc_tb = NULL;
+    for (PyObject *obj : tasks) {
+        auto *task = (TaskObject *)obj;
+        // unset trigger
+        Py_CLEAR(task->trigger);
+        if (task->ready_seq != 0) {
+            // 这一批里task已经排进就绪队列（例如又被start_soon调度了一次），
+            // 它只会被恢复一次，这次唤醒合并掉
+            m_coalesced++;
+        } else {
+            m_wakeups++;
+            if (schedule_task(task) < 0) {
+                if (exc_type == NULL) {
+                    PyErr_Fetch(&exc_type, &exc_value, &exc_tb);
+                } else {
+                    // 只报告第一个错误
+                    PyErr_Clear();
+                }
+            }
+        }
+        Py_DECREF(task);
+    }
+
+    // cleanup trigger, a WaitTrigger is never primed by the core
+    int rc = 0;
+    if (!PyObject_TypeCheck(trigger, &WaitTrigger_type)) {
+        rc = call_method_noargs(trigger, str__cleanup);
+    }
+    if (exc_type != NULL) {
+        if (rc < 0) {
+            PyErr_Clear();
+        }
+        PyErr_Restore(exc_type, exc_value, exc_tb);
+        return -1;
+    }
+    return rc;
+}
+
+int SchedulerCore::react(PyObject *trigger) {
+    WaitList *list;
+    if (wait_list_of(trigger, &list) < 0) {
+        return -1;
+    }
+    if (list != nullptr && !list->waiters.empty()) {
+        return wake(trigger, list->take());
+    }
+
+    // find all tasks waiting on trigger that fired
+    auto it = m_waiters.find(trigger);
+    if (it == m_waiters.end()) {
+        // GPI triggers should only be ever pending if there is an
+        // associated task waiting on that trigger, otherwise it would
+        // have been unprimed already
+        if (PyObject_TypeCheck(trigger, (PyTypeObject *)m_gpi_trigger_type)) {
+            PyObject *msg = PyUnicode_FromFormat(
+                "No tasks waiting on trigger that fired: %S", trigger);
+            if (msg == NULL) {
+                return -1;
+            }
+            PyObject *log = PyObject_GetAttr(m_scheduler, str_log);
+            int rc = log ? call_method_onearg(log, str_critical, msg) : -1;
+            Py_XDECREF(log);
+            Py_DECREF(msg);
+            if (rc < 0) {
+                return -1;
+            }
+            log = PyObject_GetAttr(trigger, str_log);
+            msg = PyUnicode_FromString("I'm the culprit");
+            rc = log && msg ? call_method_onearg(log, str_info, msg) : -1;
+            Py_XDECREF(log);
+            Py_XDECREF(msg);
+            return rc;
+        }
+        // For Python triggers this isn't actually an error - we might do
+        // event.set() without knowing whether any tasks are actually
+        // waiting on this event, for example
+        return 0;
+    }
+
+    PyObject *key = it->first;
+    std::vector<PyObject *> scheduling = std::move(it->second);
+    m_waiters.erase(it);
+    int rc = wake(trigger, std::move(scheduling));
+    Py_DECREF(key);
+    return rc;
+}
+
+int SchedulerCore::enter_phase() {
+    // 阶段已经由handle_gpi_callback按回调记录写好，这里只需要在ReadWrite
+    // 阶段apply inertial writes
+    if (current_sim_phase == SIM_PHASE_READ_WRITE) {
+        uint64_t hist_start = gpi_hist_enabled ? gpi_hist_clock() : 0;
+        PyObject *r = PyObject_CallNoArgs(m_apply_writes);
+        if (r == NULL) {
+            return -1;
+        }
+        Py_DECREF(r);
+        if (gpi_hist_enabled && hist_start != 0) {
+            gpi_hist_record(GPI_HIST_WRITE_FLUSH, GPI_CB_READWRITE,
+                            gpi_hist_clock() - hist_start);
+        }
+    }
+    return 0;
+}
+
+int SchedulerCore::sim_react(PyObject *trigger) {
+    if (enter_phase() < 0 || react(trigger) < 0) {
+        return -1;
+    }
+    return event_loop();
+}
+
+int SchedulerCore::fire(PythonCallback *cb) {
+    PyObject *trigger = PyTuple_GET_ITEM(cb->args, 0);
+    Py_INCREF(trigger);
+    int rc = enter_phase();
+    if (rc == 0) {
+        if (!cb->wait_list.waiters.empty()) {
+            rc = wake_all(trigger, &cb->wait_list);
+        } else if (cb->recurring) {
+            // 周期回调这一拍没有task在等，先停下来，下次await时再注册
+            rc = call_method_noargs(trigger, str__unprime);
+        } else {
+            // 没有挂waiters时走react()，由它按原来的逻辑报告没人等待的trigger
+            rc = react(trigger);
+        }
+    }
+    if (rc == 0) {
+        rc = event_loop();
+    }
+    Py_DECREF(trigger);
+    return rc;
+}
+
+int SchedulerCore::drain_pending_events() {
+    // Schedule may have queued up some events so we'll burn through those
+    Py_ssize_t pending;
+    while ((pending = PyObject_Size(m_pending_events)) > 0) {
+        PyObject *event =
+            PyObject_CallMethodObjArgs(m_pending_events, str_popleft, NULL);
+        if (event == NULL) {
+            return -1;
+        }
+        int rc = call_method_noargs(event, str_set);
+        Py_DECREF(event);
+        if (rc < 0) {
+            return -1;
+        }
+    }
+    return pending < 0 ? -1 : 0;
+}
+
+int SchedulerCore::event_loop() {
+    // trace里调度器的时间只算恢复tasks的这一段，不含react()和写回
+    uint64_t trace_start =
+        gpi_trace_enabled && !m_ready.empty() ? gpi_trace_clock() : 0;
+    int terminate;
+    while ((terminate = terminating()) == 0 && !m_ready.empty()) {
+        ReadyEntry entry = m_ready.front();
+        m_ready.pop_front();
+
+        if (entry.task->ready_seq != entry.seq) {
+            // 排队期间已经被_unschedule取消了
+            Py_DECREF(entry.task);
+            Py_DECREF(entry.value);
+            continue;
+        }
+        entry.task->ready_seq = 0;
+
+        int rc = resume_task(entry.task, entry.value, entry.kind);
+
+        // remove our reference to the objects at the end of each loop,
+        // to try and avoid them being destroyed at a weird time (as
+        // happened in gh-957)
+        Py_DECREF(entry.task);
+        Py_DECREF(entry.value);
+
+        if (rc < 0 || drain_pending_events() < 0) {
+            return -1;
+        }
+    }
+    if (trace_start != 0) {
+        gpi_trace_span("scheduler", "event_loop", trace_start,
+                       gpi_trace_clock());
+    }
+    if (terminate < 0) {
+        return -1;
+    }
+
+    // no more pending tasks
+    if (terminate) {
+        return call_method_noargs(m_scheduler, str__handle_termination);
+    }
+    return 0;
+}
+
+int SchedulerCore::finish_task(TaskObject *task, PyObject *outcome) {
+    Py_INCREF(outcome);
+    Py_XSETREF(task->outcome, outcome);
+    task->state = TASK_FINISHED;
+    return task_do_done_callbacks(task);
+}
+
+// 等价于Task._advance()：把value送进协程，返回协程yield出来的对象，
+// 如果协程已经结束则返回None
+PyObject *SchedulerCore::advance(TaskObject *task, PyObject *value,
+                                 ResumeKind kind) {
+    task->state = TASK_RUNNING;
+    PyObject *coro = task->coro;
+    if (coro == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "Task has no coroutine");
+        return NULL;
+    }
+    Py_INCREF(coro);
+
+    uint64_t profile_start = task_profiler_enabled ? task_profiler_clock() : 0;
+    PyObject *result = NULL;
+    PySendResult status;
+    if (kind == RESUME_SEND) {
+        status = PyIter_Send(coro, value, &result);
+    } else {
+        if (kind == RESUME_THROW) {
+            result = PyObject_CallMethodObjArgs(coro, str_throw, value, NULL);
+        } else {
+            result = PyObject_CallMethodObjArgs(value, str_send, coro, NULL);
+        }
+        if (result != NULL) {
+            status = PYGEN_NEXT;
+        } else {
+            status = fetch_stop_iteration(&result) ? PYGEN_RETURN : PYGEN_ERROR;
+        }
+    }
+    Py_DECREF(coro);
+    // 协程里才打开profiler时profile_start还是0，这一次不算
+    if (task_profiler_enabled && profile_start != 0) {
+        task_profiler_record(task, task_profiler_clock() - profile_start);
+    }
+
+    if (status == PYGEN_NEXT) {
+        return result;
+    }
+
+    // 只有task结束时才需要构造Outcome
+    PyObject *task_outcome;
+    if (status == PYGEN_RETURN) {
+        task_outcome = PyObject_CallOneArg(m_value_type, result);
+        Py_DECREF(result);
+    } else {
+        // Allow these to bubble up to the execution root to fail the sim
+        // immediately. This follows asyncio's behavior.
+        if (PyErr_ExceptionMatches(PyExc_KeyboardInterrupt) ||
+            PyErr_ExceptionMatches(PyExc_SystemExit)) {
+            return NULL;
+        }
+        PyObject *exc = fetch_exception();
+        task_outcome = PyObject_CallOneArg(m_error_type, exc);
+        Py_DECREF(exc);
+    }
+    if (task_outcome == NULL) {
+        return NULL;
+    }
+    int rc = finish_task(task, task_outcome);
+    Py_DECREF(task_outcome);
+    if (rc < 0) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject *SchedulerCore::trigger_from_any(PyObject *result) {
+    // note: the order of these can significantly impact performance
+    PyTypeObject *type = Py_TYPE(result);
+    if (PyType_IsSubtype(type, (PyTypeObject *)m_trigger_type)) {
+        Py_INCREF(result);
+        return result;
+    }
+
+    if (PyType_IsSubtype(type, &TaskBase_type)) {
+        auto *task = (TaskObject *)result;
+        if (task->state == TASK_UNSTARTED && schedule_task(task) < 0) {
+            return NULL;
+        }
+        if (task->complete != NULL) {
+            Py_INCREF(task->complete);
+            return task->complete;
+        }
+        return PyObject_GetAttr(result, str_complete);
+    }
+
+    // 通过Trigger.register()注册的虚拟子类
+    int is_trigger = PyObject_IsInstance(result, m_trigger_type);
+    if (is_trigger < 0) {
+        return NULL;
+    } else if (is_trigger) {
+        Py_INCREF(result);
+        return result;
+    }
+
+    PyErr_Format(PyExc_TypeError,
+                 "Coroutine yielded an object of type %R, which the scheduler "
+                 "can't handle: %R\n",
+                 type, result);
+    return NULL;
+}
+
+int SchedulerCore::resume_task(TaskObject *task, PyObject *value,
+                               ResumeKind kind) {
+    if (m_current_task != nullptr) {
+        PyErr_SetString(PyExc_Exception,
+                        "_schedule() called while another Task is executing");
+        return -1;
+    }
+    m_current_task = task;
+    int rc = resume_task_(task, value, kind);
+    m_current_task = nullptr;
+    return rc;
+}
+
+int SchedulerCore::resume_task_outcome(TaskObject *task, PyObject *outcome) {
+    PyObject *value;
+    ResumeKind kind;
+    if (outcome_kind(outcome, &value, &kind) < 0) {
+        return -1;
+    }
+    int rc = resume_task(task, value, kind);
+    Py_DECREF(value);
+    return rc;
+}
+
+int SchedulerCore::resume_task_(TaskObject *task, PyObject *value,
+                                ResumeKind kind) {
+    PyObject *result = advance(task, value, kind);
+    if (result == NULL) {
+        return -1;
+    }
+
+    bool done = task_is_done(task);
+    if (done && unschedule(task) < 0) {
+        Py_DECREF(result);
+        return -1;
+    }
+
+    // Don't handle the result if we're shutting down
+    int terminate = terminating();
+    if (terminate != 0) {
+        Py_DECREF(result);
+        return terminate < 0 ? -1 : 0;
+    }
+
+    if (!done) {
+        PyObject *trigger = trigger_from_any(result);
+        int rc;
+        if (trigger == NULL) {
+            if (!PyErr_ExceptionMatches(PyExc_TypeError)) {
+                Py_DECREF(result);
+                return -1;
+            }
+            // restart this task with an exception object telling it that
+            // it wasn't allowed to yield that
+            PyObject *exc = fetch_exception();
+            rc = schedule_task(task, exc, RESUME_THROW);
+            Py_DECREF(exc);
+        } else {
+            rc = schedule_task_upon(task, trigger);
+            Py_DECREF(trigger);
+        }
+        if (rc < 0) {
+            Py_DECREF(result);
+            return -1;
+        }
+    }
+    Py_DECREF(result);
+    return 0;
+}
+
+int SchedulerCore::unschedule(TaskObject *task) {
+    // remove task from queue, the stale ReadyEntry is skipped by event_loop()
+    task->ready_seq = 0;
+
+    // Unprime the trigger this task is waiting on
+    PyObject *trigger = task->trigger;
+    task->trigger = NULL;
+    if (trigger != NULL && trigger != Py_None) {
+        WaitList *list;
+        if (wait_list_of(trigger, &list) < 0) {
+            Py_DECREF(trigger);
+            return -1;
+        }
+        bool unprime = true;
+        if (list != nullptr) {
+            remove_waiter(list->waiters, (PyObject *)task);
+            unprime = list->waiters.empty();
+            if (unprime) {
+                list->unlink();
+            }
+        } else {
+            auto it = m_waiters.find(trigger);
+            if (it != m_waiters.end()) {
+                remove_waiter(it->second, (PyObject *)task);
+                unprime = it->second.empty();
+                if (unprime) {
+                    drop_waiters(trigger);
+                }
+            }
+        }
+        if (unprime && call_method_noargs(trigger, str__unprime) < 0) {
+            Py_DECREF(trigger);
+            return -1;
+        }
+    }
+    Py_XDECREF(trigger);
+
+    int terminate = terminating();
+    if (terminate != 0) {
+        return terminate < 0 ? -1 : 0;
+    }
+
+    // 还没人取过task.complete，就不可能有task在等它
+    PyObject *complete = task->complete;
+    if (complete == NULL) {
+        return 0;
+    }
+    Py_INCREF(complete);
+    int rc = has_waiters(complete);
+    if (rc > 0) {
+        rc = react(complete);
+    }
+    Py_DECREF(complete);
+    return rc;
+}
+
+PyObject *SchedulerCore::wakeup_stats() {
+    return Py_BuildValue("{sKsK}", "wakeups", (unsigned long long)m_wakeups,
+                         "coalesced", (unsigned long long)m_coalesced);
+}
+
+/** Append ``(trigger, [tasks])`` to *items*, returns -1 on failure */
+int append_waiters(PyObject *items, PyObject *trigger,
+                   const std::vector<PyObject *> &waiters) {
+    PyObject *tasks = PyList_New((Py_ssize_t)waiters.size());
+    if (tasks == NULL) {
+        return -1;
+    }
+    for (size_t i = 0; i < waiters.size(); i++) {
+        Py_INCREF(waiters[i]);
+        PyList_SET_ITEM(tasks, (Py_ssize_t)i, waiters[i]);
+    }
+    PyObject *pair = PyTuple_Pack(2, trigger, tasks);
+    Py_DECREF(tasks);
+    if (pair == NULL) {
+        return -1;
+    }
+    int rc = PyList_Append(items, pair);
+    Py_DECREF(pair);
+    return rc;
+}
+
+PyObject *SchedulerCore::trigger2tasks() {
+    PyObject *items = PyList_New(0);
+    if (items == NULL) {
+        return NULL;
+    }
+    for (auto &item : m_waiters) {
+        if (append_waiters(items, item.first, item.second) < 0) {
+            Py_DECREF(items);
+            return NULL;
+        }
+    }
+    for (WaitList *list = m_attached.next; list != &m_attached;
+         list = list->next) {
+        if (append_waiters(items, list->trigger, list->waiters) < 0) {
+            Py_DECREF(items);
+            return NULL;
+        }
+    }
+    return items;
+}
+
+PyObject *SchedulerCore::pop_scheduled() {
+    while (!m_ready.empty()) {
+        ReadyEntry entry = m_ready.front();
+        m_ready.pop_front();
+        Py_DECREF(entry.value);
+        if (entry.task->ready_seq == entry.seq) {
+            entry.task->ready_seq = 0;
+            return (PyObject *)entry.task;
+        }
+        Py_DECREF(entry.task);
+    }
+    Py_RETURN_NONE;
+}
+
+/* Python wrapper type */
+
+struct SchedulerCoreObject {
+    PyObject_HEAD SchedulerCore *core;
+};
+
+PyObject *none_or_null(int rc) {
+    if (rc < 0) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+bool check_task(PyObject *task) {
+    if (!TaskObject_Check(task)) {
+        PyErr_Format(PyExc_TypeError, "expected a Task, got %R", task);
+        return false;
+    }
+    return true;
+}
+
+PyObject *core_new(PyTypeObject *type, PyObject *args, PyObject *kwargs) {
+    PyObject *scheduler;
+    static const char *kwlist[] = {"scheduler", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O:SchedulerCore",
+                                     const_cast<char **>(kwlist),
+                                     &scheduler)) {
+        return NULL;
+    }
+    auto *self = (SchedulerCoreObject *)type->tp_alloc(type, 0);
+    if (self == NULL) {
+        return NULL;
+    }
+    self->core = new SchedulerCore(scheduler);
+    if (self->core->initialise((PyObject *)self) < 0) {
+        Py_DECREF(self);
+        return NULL;
+    }
+    return (PyObject *)self;
+}
+
+int core_traverse(SchedulerCoreObject *self, visitproc visit, void *arg) {
+    return self->core ? self->core->traverse(visit, arg) : 0;
+}
+
+int core_clear(SchedulerCoreObject *self) {
+    if (self->core) {
+        self->core->clear();
+    }
+    return 0;
+}
+
+void core_dealloc(SchedulerCoreObject *self) {
+    PyObject_GC_UnTrack(self);
+    delete self->core;
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+PyObject *core_schedule_task(SchedulerCoreObject *self, PyObject *args) {
+    PyObject *task;
+    PyObject *outcome = NULL;
+    if (!PyArg_ParseTuple(args, "O|O:schedule_task", &task, &outcome) ||
+        !check_task(task)) {
+        return NULL;
+    }
+    if (outcome == NULL) {
+        return none_or_null(self->core->schedule_task((TaskObject *)task));
+    }
+    return none_or_null(
+        self->core->schedule_task_outcome((TaskObject *)task, outcome));
+}
+
+PyObject *core_schedule_task_upon(SchedulerCoreObject *self, PyObject *args) {
+    PyObject *task, *trigger;
+    if (!PyArg_ParseTuple(args, "OO:schedule_task_upon", &task, &trigger) ||
+        !check_task(task)) {
+        return NULL;
+    }
+    return none_or_null(
+        self->core->schedule_task_upon((TaskObject *)task, trigger));
+}
+
+PyObject *core_react(SchedulerCoreObject *self, PyObject *trigger) {
+    return none_or_null(self->core->react(trigger));
+}
+
+PyObject *core_sim_react(SchedulerCoreObject *self, PyObject *trigger) {
+    return none_or_null(self->core->sim_react(trigger));
+}
+
+PyObject *core_event_loop(SchedulerCoreObject *self, PyObject *) {
+    return none_or_null(self->core->event_loop());
+}
+
+PyObject *core_resume_task(SchedulerCoreObject *self, PyObject *args) {
+    PyObject *task, *outcome;
+    if (!PyArg_ParseTuple(args, "OO:resume_task", &task, &outcome) ||
+        !check_task(task)) {
+        return NULL;
+    }
+    return none_or_null(
+        self->core->resume_task_outcome((TaskObject *)task, outcome));
+}
+
+PyObject *core_unschedule(SchedulerCoreObject *self, PyObject *task) {
+    if (!check_task(task)) {
+        return NULL;
+    }
+    return none_or_null(self->core->unschedule((TaskObject *)task));
+}
+
+PyObject *core_has_waiters(SchedulerCoreObject *self, PyObject *trigger) {
+    int rc = self->core->has_waiters(trigger);
+    if (rc < 0) {
+        return NULL;
+    }
+    return PyBool_FromLong(rc);
+}
+
+PyObject *core_wakeup_stats(SchedulerCoreObject *self, PyObject *) {
+    return self->core->wakeup_stats();
+}
+
+PyObject *core_trigger2tasks(SchedulerCoreObject *self, PyObject *) {
+    return self->core->trigger2tasks();
+}
+
+PyObject *core_pop_scheduled(SchedulerCoreObject *self, PyObject *) {
+    return self->core->pop_scheduled();
+}
+
+PyMethodDef core_methods[] = {
+    {"schedule_task", (PyCFunction)core_schedule_task, METH_VARARGS,
+     PyDoc_STR("schedule_task($self, task, outcome=None, /)\n"
+               "--\n\n"
+               "schedule_task(task: Task, outcome: Outcome) -> None\n"
+               "Queue *task* to be resumed with *outcome*.")},
+    {"schedule_task_upon", (PyCFunction)core_schedule_task_upon, METH_VARARGS,
+     PyDoc_STR("schedule_task_upon($self, task, trigger, /)\n"
+               "--\n\n"
+               "schedule_task_upon(task: Task, trigger: Trigger) -> None\n"
+               "Schedule *task* to be resumed when *trigger* fires.")},
+    {"react", (PyCFunction)core_react, METH_O,
+     PyDoc_STR("react($self, trigger, /)\n"
+               "--\n\n"
+               "react(trigger: Trigger) -> None\n"
+               "Queue all tasks waiting on *trigger*.")},
+    {"sim_react", (PyCFunction)core_sim_react, METH_O,
+     PyDoc_STR("sim_react($self, trigger, /)\n"
+               "--\n\n"
+               "sim_react(trigger: GPITrigger) -> None\n"
+               "Apply the scheduled writes in the ReadWrite phase, react to "
+               "*trigger* and run the event loop.")},
+    {"event_loop", (PyCFunction)core_event_loop, METH_NOARGS,
+     PyDoc_STR("event_loop($self)\n"
+               "--\n\n"
+               "event_loop() -> None\n"
+               "Run queued tasks until the queue is empty.")},
+    {"resume_task", (PyCFunction)core_resume_task, METH_VARARGS,
+     PyDoc_STR("resume_task($self, task, outcome, /)\n"
+               "--\n\n"
+               "resume_task(task: Task, outcome: Outcome) -> None\n"
+               "Resume *task* with *outcome* until its next ``await``.")},
+    {"unschedule", (PyCFunction)core_unschedule, METH_O,
+     PyDoc_STR("unschedule($self, task, /)\n"
+               "--\n\n"
+               "unschedule(task: Task) -> None\n"
+               "Unschedule *task* and unprime dangling pending triggers.")},
+    {"has_waiters", (PyCFunction)core_has_waiters, METH_O,
+     PyDoc_STR("has_waiters($self, trigger, /)\n"
+               "--\n\n"
+               "has_waiters(trigger: Trigger) -> bool\n"
+               "Return ``True`` if any task is waiting on *trigger*.")},
+    {"wakeup_stats", (PyCFunction)core_wakeup_stats, METH_NOARGS,
+     PyDoc_STR("wakeup_stats($self)\n"
+               "--\n\n"
+               "wakeup_stats() -> Dict[str, int]\n"
+               "Get the number of tasks woken up by triggers, and of wakeups "
+               "coalesced because the task was already queued.")},
+    {"trigger2tasks", (PyCFunction)core_trigger2tasks, METH_NOARGS,
+     PyDoc_STR("trigger2tasks($self)\n"
+               "--\n\n"
+               "trigger2tasks() -> List[Tuple[Trigger, List[Task]]]\n"
+               "Get a snapshot of the pending triggers and their tasks.")},
+    {"pop_scheduled", (PyCFunction)core_pop_scheduled, METH_NOARGS,
+     PyDoc_STR("pop_scheduled($self)\n"
+               "--\n\n"
+               "pop_scheduled() -> Optional[Task]\n"
+               "Remove and return the oldest queued task, or ``None``.")},
+    {NULL, NULL, 0, NULL} /* Sentinel */
+};
+
+PyTypeObject SchedulerCore_type = []() -> PyTypeObject {
+    PyTypeObject type = {};
+    type.ob_base = {PyObject_HEAD_INIT(NULL) 0};
+    type.tp_name = "mycocotb.simulator.SchedulerCore";
+    type.tp_doc =
+        "Native implementation of the scheduler's event loop.\n"
+        "\n"
+        "Owned by a mycocotb._scheduler.Scheduler instance.";
+    type.tp_basicsize = sizeof(SchedulerCoreObject);
+    type.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC;
+    type.tp_new = core_new;
+    type.tp_dealloc = (destructor)core_dealloc;
+    type.tp_traverse = (traverseproc)core_traverse;
+    type.tp_clear = (inquiry)core_clear;
+    type.tp_methods = core_methods;
+    return type;
+}();
+
+/* WaitTrigger */
+
+PyObject *wait_trigger_new(PyTypeObject *type, PyObject *, PyObject *) {
+    auto *self = (WaitTriggerObject *)type->tp_alloc(type, 0);
+    if (self == NULL) {
+        return NULL;
+    }
+    new (&self->wait_list) WaitList();
+    self->core = nullptr;
+    self->callback = NULL;
+    self->primed = 0;
+    return (PyObject *)self;
+}
+
+// wait_list里的tasks由挂上它们的SchedulerCore遍历
+int wait_trigger_traverse(WaitTriggerObject *self, visitproc visit,
+                          void *arg) {
+    Py_VISIT(self->callback);
+    return 0;
+}
+
+int wait_trigger_clear(WaitTriggerObject *self) {
+    Py_CLEAR(self->callback);
+    self->wait_list.clear();
+    return 0;
+}
+
+void wait_trigger_dealloc(WaitTriggerObject *self) {
+    PyObject_GC_UnTrack(self);
+    wait_trigger_clear(self);
+    self->wait_list.~WaitList();
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+PyObject *wait_trigger_fire(WaitTriggerObject *self, PyObject *) {
+    if (self->core != nullptr && !self->wait_list.waiters.empty()) {
+        if (self->core->wake_all((PyObject *)self, &self->wait_list) < 0) {
+            return NULL;
+        }
+        Py_RETURN_TRUE;
+    }
+    if (self->callback != NULL) {
+        // 使用Python实现的调度器时，由_prime()传进来的react负责唤醒
+        PyObject *callback = self->callback;
+        Py_INCREF(callback);
+        PyObject *r = PyObject_CallOneArg(callback, (PyObject *)self);
+        Py_DECREF(callback);
+        if (r == NULL) {
+            return NULL;
+        }
+        Py_DECREF(r);
+        Py_RETURN_TRUE;
+    }
+    Py_RETURN_FALSE;
+}
+
+PyObject *wait_trigger_prime(WaitTriggerObject *self, PyObject *callback) {
+    Py_INCREF(callback);
+    Py_XSETREF(self->callback, callback);
+    self->primed = 1;
+    Py_RETURN_NONE;
+}
+
+PyObject *wait_trigger_cleanup(WaitTriggerObject *self, PyObject *) {
+    Py_CLEAR(self->callback);
+    self->primed = 0;
+    Py_RETURN_NONE;
+}
+
+PyMethodDef wait_trigger_methods[] = {
+    {"fire", (PyCFunction)wait_trigger_fire, METH_NOARGS,
+     PyDoc_STR("fire($self)\n"
+               "--\n\n"
+               "fire() -> bool\n"
+               "Wake up every task waiting on this trigger.\n"
+               "Returns ``False`` if no task was waiting.")},
+    {"_prime", (PyCFunction)wait_trigger_prime, METH_O,
+     PyDoc_STR("_prime($self, callback, /)\n"
+               "--\n\n"
+               "_prime(callback: Callable[[Trigger], None]) -> None\n"
+               "Set the callback used by :meth:`fire` when no task is "
+               "attached natively.")},
+    {"_unprime", (PyCFunction)wait_trigger_cleanup, METH_NOARGS,
+     PyDoc_STR("_unprime($self)\n"
+               "--\n\n"
+               "_unprime() -> None\n"
+               "Remove the callback.")},
+    {"_cleanup", (PyCFunction)wait_trigger_cleanup, METH_NOARGS,
+     PyDoc_STR("_cleanup($self)\n"
+               "--\n\n"
+               "_cleanup() -> None\n"
+               "Remove the callback.")},
+    {NULL, NULL, 0, NULL} /* Sentinel */
+};
+
+PyMemberDef wait_trigger_members[] = {
+    {"_primed", T_BOOL, offsetof(WaitTriggerObject, primed), 0, NULL},
+    {NULL, 0, 0, 0, NULL} /* Sentinel */
+};
+
+PyTypeObject WaitTrigger_type = []() -> PyTypeObject {
+    PyTypeObject type = {};
+    type.ob_base = {PyObject_HEAD_INIT(NULL) 0};
+    type.tp_name = "mycocotb.simulator.WaitTrigger";
+    type.tp_doc =
+        "Trigger with a native wait list.\n"
+        "\n"
+        "Tasks awaiting it are attached directly by the native scheduler and\n"
+        "all of them are woken up in one batch by :meth:`fire`.";
+    type.tp_basicsize = sizeof(WaitTriggerObject);
+    type.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC;
+    type.tp_new = wait_trigger_new;
+    type.tp_dealloc = (destructor)wait_trigger_dealloc;
+    type.tp_traverse = (traverseproc)wait_trigger_traverse;
+    type.tp_clear = (inquiry)wait_trigger_clear;
+    type.tp_methods = wait_trigger_methods;
+    type.tp_members = wait_trigger_members;
+    return type;
+}();
+
+}  // namespace
+
+int scheduler_core_fire(PythonCallback *cb) {
+    // 只接管由SchedulerCore.sim_react prime的回调
+    PyObject *function = cb->function;
+    if (!PyCFunction_Check(function) ||
+        PyCFunction_GET_FUNCTION(function) != (PyCFunction)core_sim_react ||
+        cb->kwargs != NULL || cb->args == NULL ||
+        PyTuple_GET_SIZE(cb->args) != 1) {
+        return 0;
+    }
+    auto *self = (SchedulerCoreObject *)PyCFunction_GET_SELF(function);
+    return self->core->fire(cb) < 0 ? -1 : 1;
+}
+
+int add_scheduler_core_types(PyObject *simulator) {
+    if (intern_names() < 0) {
+        return -1;
+    }
+    if (PyType_Ready(&SchedulerCore_type) < 0) {
+        return -1;
+    }
+    PyObject *typ = (PyObject *)&SchedulerCore_type;
+    Py_INCREF(typ);
+    if (PyModule_AddObject(simulator, "SchedulerCore", typ) < 0) {
+        Py_DECREF(typ);
+        return -1;
+    }
+
+    if (PyType_Ready(&WaitTrigger_type) < 0) {
+        return -1;
+    }
+    typ = (PyObject *)&WaitTrigger_type;
+    Py_INCREF(typ);
+    if (PyModule_AddObject(simulator, "WaitTrigger", typ) < 0) {
+        Py_DECREF(typ);
+        return -1;
+    }
+    return 0;
+}
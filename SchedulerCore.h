@@ -0,0 +1,19 @@
+// 调度器热路径的C++实现（SchedulerCore），编译进simulator扩展模块中。
+// Python端的mycocotb._scheduler.Scheduler在可用时会把_event_loop、_resume_task、
+// _react等方法转交给这里的实现，其余的逻辑（清理、外部线程等）仍然留在Python里。
+#ifndef MYCOCOTB_SCHEDULER_CORE_H_
+#define MYCOCOTB_SCHEDULER_CORE_H_
+
+#include <Python.h>
+
+struct PythonCallback;
+
+// Add SchedulerCore and WaitTrigger to the simulator module, returns -1 on failure
+int add_scheduler_core_types(PyObject *simulator);
+
+// Fire a GPI callback primed by a SchedulerCore: wakes up the tasks attached
+// to *cb* and runs the event loop. Returns 1 if handled, 0 if *cb* does not
+// belong to a SchedulerCore, -1 on a Python exception
+int scheduler_core_fire(PythonCallback *cb);
+
+#endif /* MYCOCOTB_SCHEDULER_CORE_H_ */
@@ -0,0 +1,269 @@
+/******************************************************************************
+ * @file   TaskObject.cpp
+ * @brief  Native base type of mycocotb.task.Task
+ *
+ * Holds the state of a Task in fixed slots so the SchedulerCore can resume it
+ * without attribute lookups. Task objects are allocated very often (one per
+ * ``start_soon``), so the memory of dead tasks is kept on a free list and
+ * reused by the next one.
+ */
+
+#include "TaskObject.h"
+
+#include <structmember.h>
+
+#include <cstring>
+
+namespace {
+
+// Task._State members indexed by TaskState, looked up on first use because
+// the enum is defined in mycocotb.task, which subclasses TaskBase
+PyObject *task_states[TASK_N_STATES];
+
+int load_task_states() {
+    static const char *names[TASK_N_STATES] = {
+        "UNSTARTED", "SCHEDULED", "PENDING", "RUNNING", "FINISHED", "CANCELLED"};
+    if (task_states[0] != NULL) {
+        return 0;
+    }
+    PyObject *mod = PyImport_ImportModule("mycocotb.task");
+    if (mod == NULL) {
+        return -1;
+    }
+    PyObject *task = PyObject_GetAttrString(mod, "Task");
+    Py_DECREF(mod);
+    if (task == NULL) {
+        return -1;
+    }
+    PyObject *states = PyObject_GetAttrString(task, "_State");
+    Py_DECREF(task);
+    if (states == NULL) {
+        return -1;
+    }
+    PyObject *members[TASK_N_STATES];
+    for (int i = 0; i < TASK_N_STATES; i++) {
+        members[i] = PyObject_GetAttrString(states, names[i]);
+        if (members[i] == NULL) {
+            for (int j = 0; j < i; j++) {
+                Py_DECREF(members[j]);
+            }
+            Py_DECREF(states);
+            return -1;
+        }
+    }
+    Py_DECREF(states);
+    std::memcpy(task_states, members, sizeof(members));
+    return 0;
+}
+
+/* Free list */
+
+// 只有和TaskObject一样大、没有__dict__/__weakref__的子类（也就是用了
+// __slots__ = ()的Task）才能复用内存块，这样内存块里不会有额外的字段
+const int FREE_LIST_MAX = 256;
+PyObject *free_list[FREE_LIST_MAX];
+int free_list_len = 0;
+
+bool recyclable(PyTypeObject *type) {
+    return type->tp_basicsize == (Py_ssize_t)sizeof(TaskObject) &&
+           type->tp_itemsize == 0 && type->tp_dictoffset == 0 &&
+           type->tp_weaklistoffset == 0 && type->tp_finalize == NULL &&
+           PyType_IS_GC(type);
+}
+
+PyObject *task_new(PyTypeObject *type, PyObject *, PyObject *) {
+    if (free_list_len > 0 && recyclable(type)) {
+        PyObject *self = free_list[--free_list_len];
+        std::memset((char *)self + sizeof(PyObject), 0,
+                    sizeof(TaskObject) - sizeof(PyObject));
+        PyObject_Init(self, type);
+        PyObject_GC_Track(self);
+        return self;
+    }
+    return type->tp_alloc(type, 0);
+}
+
+int task_traverse(TaskObject *self, visitproc visit, void *arg) {
+    Py_VISIT(self->coro);
+    Py_VISIT(self->outcome);
+    Py_VISIT(self->trigger);
+    Py_VISIT(self->cancelled_error);
+    Py_VISIT(self->done_callbacks);
+    Py_VISIT(self->name);
+    Py_VISIT(self->log);
+    Py_VISIT(self->complete);
+    return 0;
+}
+
+int task_clear(TaskObject *self) {
+    Py_CLEAR(self->coro);
+    Py_CLEAR(self->outcome);
+    Py_CLEAR(self->trigger);
+    Py_CLEAR(self->cancelled_error);
+    Py_CLEAR(self->done_callbacks);
+    Py_CLEAR(self->name);
+    Py_CLEAR(self->log);
+    Py_CLEAR(self->complete);
+    return 0;
+}
+
+void task_dealloc(TaskObject *self) {
+    PyObject_GC_UnTrack(self);
+    task_clear(self);
+    PyTypeObject *type = Py_TYPE(self);
+    if (free_list_len < FREE_LIST_MAX && recyclable(type)) {
+        // 子类的subtype_dealloc会在返回后释放对type的引用，复用时PyObject_Init会重新加上
+        free_list[free_list_len++] = (PyObject *)self;
+        return;
+    }
+    type->tp_free((PyObject *)self);
+}
+
+/* Attributes */
+
+PyObject *task_get_state(TaskObject *self, void *) {
+    if (load_task_states() < 0) {
+        return NULL;
+    }
+    PyObject *state = task_states[self->state];
+    Py_INCREF(state);
+    return state;
+}
+
+int task_set_state(TaskObject *self, PyObject *value, void *) {
+    if (value == NULL) {
+        PyErr_SetString(PyExc_AttributeError, "can't delete _state");
+        return -1;
+    }
+    if (load_task_states() < 0) {
+        return -1;
+    }
+    for (int i = 0; i < TASK_N_STATES; i++) {
+        if (value == task_states[i]) {
+            self->state = i;
+            return 0;
+        }
+    }
+    PyErr_Format(PyExc_TypeError, "_state must be a Task._State, not %R", value);
+    return -1;
+}
+
+PyGetSetDef task_getsets[] = {
+    {"_state", (getter)task_get_state, (setter)task_set_state, NULL, NULL},
+    {NULL, NULL, NULL, NULL, NULL} /* Sentinel */
+};
+
+PyMemberDef task_members[] = {
+    {"_coro", T_OBJECT, offsetof(TaskObject, coro), 0, NULL},
+    {"_outcome", T_OBJECT, offsetof(TaskObject, outcome), 0, NULL},
+    {"_trigger", T_OBJECT, offsetof(TaskObject, trigger), 0, NULL},
+    {"_cancelled_error", T_OBJECT, offsetof(TaskObject, cancelled_error), 0,
+     NULL},
+    {"_done_callbacks", T_OBJECT, offsetof(TaskObject, done_callbacks), 0,
+     NULL},
+    {"__name__", T_OBJECT, offsetof(TaskObject, name), 0, NULL},
+    {"__qualname__", T_OBJECT, offsetof(TaskObject, name), 0, NULL},
+    {"_log", T_OBJECT, offsetof(TaskObject, log), 0, NULL},
+    {"_complete", T_OBJECT, offsetof(TaskObject, complete), 0, NULL},
+    {"_task_id", T_PYSSIZET, offsetof(TaskObject, task_id), 0, NULL},
+    {NULL, 0, 0, 0, NULL} /* Sentinel */
+};
+
+/* Methods */
+
+PyObject *task_done(TaskObject *self, PyObject *) {
+    return PyBool_FromLong(task_is_done(self));
+}
+
+PyObject *task_cancelled(TaskObject *self, PyObject *) {
+    return PyBool_FromLong(self->state == TASK_CANCELLED);
+}
+
+PyObject *task_do_done_callbacks_meth(TaskObject *self, PyObject *) {
+    if (task_do_done_callbacks(self) < 0) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+PyMethodDef task_methods[] = {
+    {"done", (PyCFunction)task_done, METH_NOARGS,
+     PyDoc_STR("done($self)\n"
+               "--\n\n"
+               "done() -> bool\n"
+               "Return ``True`` if the Task has finished executing.")},
+    {"cancelled", (PyCFunction)task_cancelled, METH_NOARGS,
+     PyDoc_STR("cancelled($self)\n"
+               "--\n\n"
+               "cancelled() -> bool\n"
+               "Return ``True`` if the Task was cancelled.")},
+    {"_do_done_callbacks", (PyCFunction)task_do_done_callbacks_meth,
+     METH_NOARGS,
+     PyDoc_STR("_do_done_callbacks($self)\n"
+               "--\n\n"
+               "_do_done_callbacks() -> None\n"
+               "Call the callbacks added with :meth:`_add_done_callback`.")},
+    {NULL, NULL, 0, NULL} /* Sentinel */
+};
+
+}  // namespace
+
+PyTypeObject TaskBase_type = []() -> PyTypeObject {
+    PyTypeObject type = {};
+    type.ob_base = {PyObject_HEAD_INIT(NULL) 0};
+    type.tp_name = "mycocotb.simulator.TaskBase";
+    type.tp_doc =
+        "Native base of :class:`mycocotb.task.Task`.\n"
+        "\n"
+        "Stores the state of the Task in slots accessed directly by the\n"
+        "native scheduler.";
+    type.tp_basicsize = sizeof(TaskObject);
+    type.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC;
+    type.tp_new = task_new;
+    type.tp_dealloc = (destructor)task_dealloc;
+    type.tp_traverse = (traverseproc)task_traverse;
+    type.tp_clear = (inquiry)task_clear;
+    type.tp_methods = task_methods;
+    type.tp_members = task_members;
+    type.tp_getset = task_getsets;
+    return type;
+}();
+
+int task_do_done_callbacks(TaskObject *self) {
+    PyObject *callbacks = self->done_callbacks;
+    if (callbacks == NULL || callbacks == Py_None) {
+        return 0;
+    }
+    if (!PyList_Check(callbacks)) {
+        PyErr_SetString(PyExc_TypeError, "Task._done_callbacks must be a list");
+        return -1;
+    }
+    // 回调里可能会再添加回调，和Python的for循环一样每次都重新取长度
+    Py_INCREF(callbacks);
+    for (Py_ssize_t i = 0; i < PyList_GET_SIZE(callbacks); i++) {
+        PyObject *callback = PyList_GET_ITEM(callbacks, i);
+        Py_INCREF(callback);
+        PyObject *r = PyObject_CallOneArg(callback, (PyObject *)self);
+        Py_DECREF(callback);
+        if (r == NULL) {
+            Py_DECREF(callbacks);
+            return -1;
+        }
+        Py_DECREF(r);
+    }
+    Py_DECREF(callbacks);
+    return 0;
+}
+
+int add_task_type(PyObject *simulator) {
+    if (PyType_Ready(&TaskBase_type) < 0) {
+        return -1;
+    }
+    PyObject *typ = (PyObject *)&TaskBase_type;
+    Py_INCREF(typ);
+    if (PyModule_AddObject(simulator, "TaskBase", typ) < 0) {
+        Py_DECREF(typ);
+        return -1;
+    }
+    return 0;
+}
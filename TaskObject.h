@@ -0,0 +1,55 @@
+// Task的C层基类（simulator.TaskBase）。mycocotb.task.Task继承它，task的状态都放在
+// 这里的定长字段里，SchedulerCore恢复task时直接读写字段，不再经过属性查找。
+#ifndef MYCOCOTB_TASK_OBJECT_H_
+#define MYCOCOTB_TASK_OBJECT_H_
+
+#include <Python.h>
+
+#include <cstdint>
+
+// Same order as mycocotb.task.Task._State
+enum TaskState {
+    TASK_UNSTARTED = 0,
+    TASK_SCHEDULED,
+    TASK_PENDING,
+    TASK_RUNNING,
+    TASK_FINISHED,
+    TASK_CANCELLED,
+    TASK_N_STATES
+};
+
+struct TaskObject {
+    PyObject_HEAD PyObject *coro;  // _coro
+    PyObject *outcome;             // _outcome, set once the task is done
+    PyObject *trigger;             // _trigger, the trigger it is pending on
+    PyObject *cancelled_error;     // _cancelled_error
+    PyObject *done_callbacks;      // _done_callbacks
+    PyObject *name;                // __name__ and __qualname__
+    PyObject *log;                 // _log, created on first use of Task.log
+    PyObject *complete;            // _complete, created on first use of Task.complete
+    Py_ssize_t task_id;            // _task_id
+    int state;                     // TaskState, exposed as _state
+
+    // SchedulerCore就绪队列里对应条目的序号，0表示不在队列里
+    uint64_t ready_seq;
+    // TaskProfiler里这个task的记录的序号加一，0表示还没有记录
+    uint32_t profile_slot;
+};
+
+extern PyTypeObject TaskBase_type;
+
+static inline bool TaskObject_Check(PyObject *obj) {
+    return PyObject_TypeCheck(obj, &TaskBase_type);
+}
+
+static inline bool task_is_done(TaskObject *task) {
+    return task->state == TASK_FINISHED || task->state == TASK_CANCELLED;
+}
+
+// Call every callback in task._done_callbacks, returns -1 on failure
+int task_do_done_callbacks(TaskObject *task);
+
+// Add TaskBase to the simulator module, returns -1 on failure
+int add_task_type(PyObject *simulator);
+
+#endif /* MYCOCOTB_TASK_OBJECT_H_ */
@@ -0,0 +1,302 @@
+/******************************************************************************
+ * @file   TaskProfiler.cpp
+ * @brief  Wall time and resume count of each Task and coroutine function
+ *
+ * A Python profiler charges all the time of the testbench to the event loop
+ * and the scheduler. When enabled, with COCOTB_PROFILE_TASKS or
+ * simulator.set_task_profiling(), the scheduler reads the clock around each
+ * resume of a Task and charges the time to that Task and to the coroutine
+ * function it runs, which shows the monitor or driver that costs the most.
+ *
+ * The records are kept in native vectors: a Task finds its record through
+ * the slot stored in its native base, so recording a resume is a clock read
+ * and two additions. The names are only read from Python on the first resume
+ * of each Task.
+ */
+
+#include "TaskProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "VpiImpl.h"
+
+bool task_profiler_enabled = false;
+
+namespace {
+
+struct TaskProfile {
+    std::string name;  // Task.__name__
+    uint32_t function;  // index into functions
+    uint64_t ns;
+    uint64_t resumes;
+};
+
+struct FunctionProfile {
+    std::string name;  // __qualname__ of the coroutine
+    uint64_t ns;
+    uint64_t resumes;
+    uint32_t overflow_slot;  // record shared by its tasks beyond MAX_TASKS
+};
+
+// 超过这么多个task以后，同一个协程函数的其余task合并成一条记录，
+// 这样不停创建短命task的仿真不会让记录无限增长
+constexpr size_t MAX_TASKS = 65536;
+// 仿真结束时输出的条数
+constexpr size_t REPORT_TOP = 10;
+
+std::vector<TaskProfile> tasks;
+std::vector<FunctionProfile> functions;
+std::unordered_map<std::string, uint32_t> function_index;
+
+std::string str_of(PyObject *obj, const char *fallback) {
+    const char *s = (obj && PyUnicode_Check(obj)) ? PyUnicode_AsUTF8(obj) : NULL;
+    return s ? s : fallback;
+}
+
+uint32_t new_slot(TaskObject *task) {
+    // 协程抛出的异常可能还挂着，查名字时不能碰它
+    PyObject *type, *value, *tb;
+    PyErr_Fetch(&type, &value, &tb);
+    PyObject *qualname =
+        task->coro ? PyObject_GetAttrString(task->coro, "__qualname__") : NULL;
+    std::string func_name = str_of(qualname, "<unknown>");
+    std::string task_name = str_of(task->name, "Task");
+    Py_XDECREF(qualname);
+    PyErr_Clear();
+    PyErr_Restore(type, value, tb);
+
+    auto it = function_index.find(func_name);
+    uint32_t func;
+    if (it == function_index.end()) {
+        func = (uint32_t)functions.size();
+        functions.push_back(FunctionProfile{func_name, 0, 0, 0});
+        function_index.emplace(std::move(func_name), func);
+    } else {
+        func = it->second;
+    }
+
+    if (tasks.size() >= MAX_TASKS) {
+        FunctionProfile &fp = functions[func];
+        if (fp.overflow_slot == 0) {
+            tasks.push_back(TaskProfile{"(other tasks)", func, 0, 0});
+            fp.overflow_slot = (uint32_t)tasks.size();
+        }
+        return fp.overflow_slot;
+    }
+    tasks.push_back(TaskProfile{std::move(task_name), func, 0, 0});
+    return (uint32_t)tasks.size();
+}
+
+template <typename T>
+std::vector<const T *> by_cost(const std::vector<T> &records) {
+    std::vector<const T *> sorted;
+    for (const T &r : records) {
+        if (r.resumes) {
+            sorted.push_back(&r);
+        }
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const T *a, const T *b) { return a->ns > b->ns; });
+    return sorted;
+}
+
+void log_line(const std::string &name, uint64_t ns, uint64_t resumes,
+              uint64_t total_ns) {
+    LOG_INFO("  %12.3f %6.1f%% %10llu %10.2f  %s", ns / 1e6,
+             total_ns ? 100.0 * ns / total_ns : 0.0,
+             (unsigned long long)resumes, resumes ? ns / 1e3 / resumes : 0.0,
+             name.c_str());
+}
+
+void log_profile(size_t top) {
+    uint64_t total_ns = 0, total_resumes = 0;
+    for (const FunctionProfile &fp : functions) {
+        total_ns += fp.ns;
+        total_resumes += fp.resumes;
+    }
+    if (total_resumes == 0) {
+        return;
+    }
+    LOG_INFO("mycocotb task profile: %llu resumes, %.3f ms in tasks",
+             (unsigned long long)total_resumes, total_ns / 1e6);
+    LOG_INFO("  %12s %7s %10s %10s  %s", "wall ms", "share", "resumes",
+             "us/resume", "task");
+    auto sorted_tasks = by_cost(tasks);
+    for (size_t i = 0; i < sorted_tasks.size() && i < top; ++i) {
+        const TaskProfile *tp = sorted_tasks[i];
+        log_line(tp->name + " (" + functions[tp->function].name + ")", tp->ns,
+                 tp->resumes, total_ns);
+    }
+    LOG_INFO("  %12s %7s %10s %10s  %s", "wall ms", "share", "resumes",
+             "us/resume", "coroutine function");
+    auto sorted_functions = by_cost(functions);
+    for (size_t i = 0; i < sorted_functions.size() && i < top; ++i) {
+        const FunctionProfile *fp = sorted_functions[i];
+        log_line(fp->name, fp->ns, fp->resumes, total_ns);
+    }
+}
+
+void log_profile_at_end() { log_profile(REPORT_TOP); }
+
+/* Python functions */
+
+PyObject *set_task_profiling(PyObject *, PyObject *arg) {
+    int enabled = PyObject_IsTrue(arg);
+    if (enabled < 0) {
+        return NULL;
+    }
+    task_profiler_enabled = enabled;
+    Py_RETURN_NONE;
+}
+
+PyObject *get_task_profiling(PyObject *, PyObject *) {
+    return PyBool_FromLong(task_profiler_enabled);
+}
+
+PyObject *get_task_profile(PyObject *, PyObject *) {
+    auto sorted_tasks = by_cost(tasks);
+    auto sorted_functions = by_cost(functions);
+    PyObject *task_list = PyList_New((Py_ssize_t)sorted_tasks.size());
+    PyObject *function_list = PyList_New((Py_ssize_t)sorted_functions.size());
+    if (task_list == NULL || function_list == NULL) {
+        Py_XDECREF(task_list);
+        Py_XDECREF(function_list);
+        return NULL;
+    }
+    for (size_t i = 0; i < sorted_tasks.size(); ++i) {
+        const TaskProfile *tp = sorted_tasks[i];
+        PyObject *item = Py_BuildValue(
+            "(ssKK)", tp->name.c_str(), functions[tp->function].name.c_str(),
+            (unsigned long long)tp->resumes, (unsigned long long)tp->ns);
+        if (item == NULL) {
+            Py_DECREF(task_list);
+            Py_DECREF(function_list);
+            return NULL;
+        }
+        PyList_SET_ITEM(task_list, (Py_ssize_t)i, item);
+    }
+    for (size_t i = 0; i < sorted_functions.size(); ++i) {
+        const FunctionProfile *fp = sorted_functions[i];
+        PyObject *item =
+            Py_BuildValue("(sKK)", fp->name.c_str(),
+                          (unsigned long long)fp->resumes,
+                          (unsigned long long)fp->ns);
+        if (item == NULL) {
+            Py_DECREF(task_list);
+            Py_DECREF(function_list);
+            return NULL;
+        }
+        PyList_SET_ITEM(function_list, (Py_ssize_t)i, item);
+    }
+    return Py_BuildValue("{sNsN}", "tasks", task_list, "functions",
+                         function_list);
+}
+
+PyObject *reset_task_profile(PyObject *, PyObject *) {
+    // 记录本身要留着，活着的task里还存着它们的序号
+    for (TaskProfile &tp : tasks) {
+        tp.ns = tp.resumes = 0;
+    }
+    for (FunctionProfile &fp : functions) {
+        fp.ns = fp.resumes = 0;
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject *log_task_profile(PyObject *, PyObject *args) {
+    Py_ssize_t top = (Py_ssize_t)REPORT_TOP;
+    if (!PyArg_ParseTuple(args, "|n:log_task_profile", &top)) {
+        return NULL;
+    }
+    log_profile(top < 0 ? 0 : (size_t)top);
+    Py_RETURN_NONE;
+}
+
+PyObject *record_task_resume(PyObject *, PyObject *args) {
+    PyObject *task;
+    unsigned long long ns;
+    if (!PyArg_ParseTuple(args, "O!K:record_task_resume", &TaskBase_type,
+                          &task, &ns)) {
+        return NULL;
+    }
+    task_profiler_record((TaskObject *)task, ns);
+    Py_RETURN_NONE;
+}
+
+PyMethodDef task_profiler_methods[] = {
+    {"set_task_profiling", set_task_profiling, METH_O,
+     PyDoc_STR("set_task_profiling(enabled, /)\n"
+               "--\n\n"
+               "set_task_profiling(enabled: bool) -> None\n"
+               "Start or stop measuring the wall time of each resume of a "
+               "Task. Also enabled by :envvar:`COCOTB_PROFILE_TASKS`.")},
+    {"get_task_profiling", get_task_profiling, METH_NOARGS,
+     PyDoc_STR("get_task_profiling()\n"
+               "--\n\n"
+               "get_task_profiling() -> bool\n"
+               "Whether the resumes of Tasks are being measured.")},
+    {"get_task_profile", get_task_profile, METH_NOARGS,
+     PyDoc_STR("get_task_profile()\n"
+               "--\n\n"
+               "get_task_profile() -> Dict[str, List[Tuple[Any, ...]]]\n"
+               "Get the measured resumes, most expensive first.\n"
+               "\n"
+               "``tasks`` holds ``(task_name, function, resumes, wall_ns)`` "
+               "and ``functions`` holds ``(function, resumes, wall_ns)`` per "
+               "coroutine function.")},
+    {"reset_task_profile", reset_task_profile, METH_NOARGS,
+     PyDoc_STR("reset_task_profile()\n"
+               "--\n\n"
+               "reset_task_profile() -> None\n"
+               "Set the measured time and resumes of all Tasks to zero.")},
+    {"log_task_profile", log_task_profile, METH_VARARGS,
+     PyDoc_STR("log_task_profile(top=10, /)\n"
+               "--\n\n"
+               "log_task_profile(top: int = 10) -> None\n"
+               "Print the *top* most expensive Tasks and coroutine functions "
+               "through the simulator. This is done at the end of the "
+               "simulation when anything was measured.")},
+    {"record_task_resume", record_task_resume, METH_VARARGS,
+     PyDoc_STR("record_task_resume(task, ns, /)\n"
+               "--\n\n"
+               "record_task_resume(task: Task, ns: int) -> None\n"
+               "Charge a resume of *task* taking *ns* nanoseconds. Used by "
+               "the Python scheduler, users should not call this function.")},
+    {NULL, NULL, 0, NULL} /* Sentinel */
+};
+
+}  // namespace
+
+uint64_t task_profiler_clock() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void task_profiler_record(TaskObject *task, uint64_t ns) {
+    if (task->profile_slot == 0) {
+        task->profile_slot = new_slot(task);
+    }
+    TaskProfile &tp = tasks[task->profile_slot - 1];
+    tp.ns += ns;
+    tp.resumes += 1;
+    FunctionProfile &fp = functions[tp.function];
+    fp.ns += ns;
+    fp.resumes += 1;
+}
+
+int add_task_profiler_functions(PyObject *simulator) {
+    // COCOTB_PROFILE_TASKS不为空也不为"0"时从一开始就打开
+    const char *env = std::getenv("COCOTB_PROFILE_TASKS");
+    if (env && *env && std::strcmp(env, "0") != 0) {
+        task_profiler_enabled = true;
+    }
+    gpi_register_sim_end_hook(log_profile_at_end);
+    return PyModule_AddFunctions(simulator, task_profiler_methods);
+}
@@ -0,0 +1,25 @@
+// Task级别的profiler：调度器在每次恢复task前后读时钟，把墙钟时间和恢复次数
+// 记在这个task以及它的协程函数名下，仿真结束时输出耗时最多的几项。
+#ifndef MYCOCOTB_TASK_PROFILER_H_
+#define MYCOCOTB_TASK_PROFILER_H_
+
+#include <Python.h>
+
+#include <cstdint>
+
+#include "TaskObject.h"
+
+// 热路径上只检查这个标志，没有打开profiler时不读时钟
+extern bool task_profiler_enabled;
+
+// Monotonic wall-clock time in nanoseconds
+uint64_t task_profiler_clock();
+
+// Charge one resume of *task* taking *ns* nanoseconds. Does not touch a
+// pending Python exception.
+void task_profiler_record(TaskObject *task, uint64_t ns);
+
+// Add the profiler functions to the simulator module, returns -1 on failure
+int add_task_profiler_functions(PyObject *simulator);
+
+#endif /* MYCOCOTB_TASK_PROFILER_H_ */
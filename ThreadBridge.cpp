@@ -0,0 +1,433 @@
+/******************************************************************************
+ * @file   ThreadBridge.cpp
+ * @brief  Requests from worker threads into the simulator thread
+ *
+ * A worker thread started by mycocotb.bridge() submits requests (a function
+ * to call, or a coroutine function to await, in the simulator thread) with
+ * ThreadBridge.call(). Requests go through a lock-free multi-producer
+ * single-consumer queue and the simulator thread is woken through an
+ * eventfd. Each worker blocks on its own eventfd until the simulator thread
+ * completes its request, so neither side has to poll the other.
+ */
+
+#include "ThreadBridge.h"
+
+#include <structmember.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <new>
+
+namespace {
+
+struct BridgeRequest;
+
+// MPSC队列的节点，嵌在BridgeRequest里；ThreadBridge里另有一个哨兵节点
+struct QueueNode {
+    std::atomic<QueueNode *> next{nullptr};
+    BridgeRequest *request = nullptr;
+};
+
+struct BridgeRequest {
+    PyObject_HEAD QueueNode node;
+    PyObject *func;    // called in the simulator thread
+    PyObject *args;    // tuple
+    PyObject *kwargs;  // dict or NULL
+    PyObject *result;  // the return value, or the exception if failed
+    bool failed;
+    std::atomic<bool> done;
+    int efd;  // eventfd of the worker thread waiting for this request
+};
+
+struct ThreadBridgeObject {
+    PyObject_HEAD std::atomic<QueueNode *> head;  // pushed by the workers
+    QueueNode *tail;                              // popped by the simulator
+    QueueNode stub;
+    std::atomic<bool> closed;
+    int efd;  // wakes up the simulator thread
+};
+
+extern PyTypeObject BridgeRequest_type;
+
+/* eventfd helpers */
+
+void signal_fd(int fd) {
+    uint64_t one = 1;
+    while (write(fd, &one, sizeof(one)) < 0 && errno == EINTR) {
+    }
+}
+
+/** Block on *fd* with the GIL released until it is signalled */
+void wait_fd(int fd) {
+    uint64_t count;
+    ssize_t r;
+    Py_BEGIN_ALLOW_THREADS;
+    do {
+        r = read(fd, &count, sizeof(count));
+    } while (r < 0 && errno == EINTR);
+    Py_END_ALLOW_THREADS;
+}
+
+// 每个工作线程一个eventfd，线程退出时关闭
+struct WorkerEventFd {
+    int fd = -1;
+    ~WorkerEventFd() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+};
+thread_local WorkerEventFd worker_efd;
+
+int worker_fd() {
+    if (worker_efd.fd < 0) {
+        worker_efd.fd = eventfd(0, EFD_CLOEXEC);
+    }
+    return worker_efd.fd;
+}
+
+/* BridgeRequest */
+
+/** Complete *req* once, waking up its worker. Returns false if already done */
+bool complete_request(BridgeRequest *req, PyObject *result, bool failed) {
+    bool expected = false;
+    if (!req->done.compare_exchange_strong(expected, true)) {
+        return false;
+    }
+    Py_INCREF(result);
+    req->result = result;
+    req->failed = failed;
+    signal_fd(req->efd);
+    return true;
+}
+
+int request_traverse(BridgeRequest *self, visitproc visit, void *arg) {
+    Py_VISIT(self->func);
+    Py_VISIT(self->args);
+    Py_VISIT(self->kwargs);
+    Py_VISIT(self->result);
+    return 0;
+}
+
+int request_clear(BridgeRequest *self) {
+    Py_CLEAR(self->func);
+    Py_CLEAR(self->args);
+    Py_CLEAR(self->kwargs);
+    Py_CLEAR(self->result);
+    return 0;
+}
+
+void request_dealloc(BridgeRequest *self) {
+    PyObject_GC_UnTrack(self);
+    request_clear(self);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+PyObject *request_set_result(BridgeRequest *self, PyObject *value) {
+    if (!complete_request(self, value, false)) {
+        PyErr_SetString(PyExc_RuntimeError, "Request is already completed");
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject *request_set_exception(BridgeRequest *self, PyObject *exc) {
+    if (!PyExceptionInstance_Check(exc)) {
+        PyErr_Format(PyExc_TypeError,
+                     "set_exception() expects an exception instance, not %R",
+                     exc);
+        return NULL;
+    }
+    if (!complete_request(self, exc, true)) {
+        PyErr_SetString(PyExc_RuntimeError, "Request is already completed");
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject *request_cancel(BridgeRequest *self, PyObject *exc) {
+    if (!PyExceptionInstance_Check(exc)) {
+        PyErr_Format(PyExc_TypeError,
+                     "cancel() expects an exception instance, not %R", exc);
+        return NULL;
+    }
+    // 工作线程看到close以后可能已经自己结束了这个请求，这时什么也不做
+    return PyBool_FromLong(complete_request(self, exc, true));
+}
+
+PyMemberDef request_members[] = {
+    {"func", T_OBJECT, offsetof(BridgeRequest, func), READONLY, NULL},
+    {"args", T_OBJECT, offsetof(BridgeRequest, args), READONLY, NULL},
+    {"kwargs", T_OBJECT, offsetof(BridgeRequest, kwargs), READONLY, NULL},
+    {NULL, 0, 0, 0, NULL} /* Sentinel */
+};
+
+PyMethodDef request_methods[] = {
+    {"set_result", (PyCFunction)request_set_result, METH_O,
+     PyDoc_STR("set_result($self, value, /)\n"
+               "--\n\n"
+               "set_result(value: Any) -> None\n"
+               "Complete the request, returning *value* to the worker.")},
+    {"set_exception", (PyCFunction)request_set_exception, METH_O,
+     PyDoc_STR("set_exception($self, exc, /)\n"
+               "--\n\n"
+               "set_exception(exc: BaseException) -> None\n"
+               "Complete the request, raising *exc* in the worker.")},
+    {"cancel", (PyCFunction)request_cancel, METH_O,
+     PyDoc_STR("cancel($self, exc, /)\n"
+               "--\n\n"
+               "cancel(exc: BaseException) -> bool\n"
+               "Complete the request with *exc* unless it is already "
+               "completed.\n"
+               "Returns ``False`` if it was.")},
+    {NULL, NULL, 0, NULL} /* Sentinel */
+};
+
+/* ThreadBridge */
+
+// Vyukov的侵入式MPSC队列：生产者只做一次exchange，消费者只有仿真线程一个
+void push(ThreadBridgeObject *self, QueueNode *node) {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    QueueNode *prev = self->head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
+
+QueueNode *pop(ThreadBridgeObject *self) {
+    QueueNode *tail = self->tail;
+    QueueNode *next = tail->next.load(std::memory_order_acquire);
+    if (tail == &self->stub) {
+        if (next == nullptr) {
+            return nullptr;
+        }
+        self->tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+        self->tail = next;
+        return tail;
+    }
+    // 生产者已经exchange了head但还没接上next，它接上后会再signal一次
+    if (tail != self->head.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    push(self, &self->stub);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+        self->tail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+PyObject *bridge_new(PyTypeObject *type, PyObject *args, PyObject *kwargs) {
+    if (!PyArg_ParseTuple(args, ":ThreadBridge") ||
+        (kwargs != NULL && !PyArg_ValidateKeywordArguments(kwargs))) {
+        return NULL;
+    }
+    if (kwargs != NULL && PyDict_GET_SIZE(kwargs) > 0) {
+        PyErr_SetString(PyExc_TypeError, "ThreadBridge() takes no arguments");
+        return NULL;
+    }
+    int efd = eventfd(0, EFD_CLOEXEC);
+    if (efd < 0) {
+        return PyErr_SetFromErrno(PyExc_OSError);
+    }
+    ThreadBridgeObject *self = (ThreadBridgeObject *)type->tp_alloc(type, 0);
+    if (self == NULL) {
+        close(efd);
+        return NULL;
+    }
+    new (&self->head) std::atomic<QueueNode *>(&self->stub);
+    new (&self->stub) QueueNode();
+    new (&self->closed) std::atomic<bool>(false);
+    self->tail = &self->stub;
+    self->efd = efd;
+    return (PyObject *)self;
+}
+
+void bridge_dealloc(ThreadBridgeObject *self) {
+    // 没有被取走的请求，它们的工作线程已经在close时自己结束了等待
+    QueueNode *node;
+    while ((node = pop(self)) != nullptr) {
+        Py_DECREF(node->request);
+    }
+    close(self->efd);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+PyObject *bridge_call(ThreadBridgeObject *self, PyObject *args,
+                      PyObject *kwargs) {
+    Py_ssize_t numargs = PyTuple_GET_SIZE(args);
+    if (numargs < 1) {
+        PyErr_SetString(PyExc_TypeError,
+                        "call() missing required argument 'func'");
+        return NULL;
+    }
+    if (self->closed.load()) {
+        PyErr_SetString(PyExc_RuntimeError, "ThreadBridge is closed");
+        return NULL;
+    }
+    int efd = worker_fd();
+    if (efd < 0) {
+        return PyErr_SetFromErrno(PyExc_OSError);
+    }
+
+    BridgeRequest *req = PyObject_GC_New(BridgeRequest, &BridgeRequest_type);
+    if (req == NULL) {
+        return NULL;
+    }
+    new (&req->node) QueueNode();
+    new (&req->done) std::atomic<bool>(false);
+    req->node.request = req;
+    req->func = PyTuple_GET_ITEM(args, 0);
+    Py_INCREF(req->func);
+    req->args = PyTuple_GetSlice(args, 1, numargs);
+    req->kwargs = kwargs != NULL ? PyDict_Copy(kwargs) : NULL;
+    req->result = NULL;
+    req->failed = false;
+    req->efd = efd;
+    PyObject_GC_Track(req);
+    if (req->args == NULL || (kwargs != NULL && req->kwargs == NULL)) {
+        Py_DECREF(req);
+        return NULL;
+    }
+
+    // 队列持有一个引用，由仿真线程的wait()取走
+    Py_INCREF(req);
+    push(self, &req->node);
+    signal_fd(self->efd);
+    // 仿真线程可能在push之前就close并清空了队列，这时自己结束这个请求
+    if (self->closed.load()) {
+        PyObject *exc = PyObject_CallFunction(PyExc_RuntimeError, "s",
+                                              "ThreadBridge is closed");
+        if (exc == NULL) {
+            Py_DECREF(req);
+            return NULL;
+        }
+        complete_request(req, exc, true);
+        Py_DECREF(exc);
+    }
+
+    wait_fd(efd);
+
+    PyObject *result = req->result;
+    Py_INCREF(result);
+    bool failed = req->failed;
+    Py_DECREF(req);
+    if (failed) {
+        PyErr_SetObject((PyObject *)Py_TYPE(result), result);
+        Py_DECREF(result);
+        return NULL;
+    }
+    return result;
+}
+
+PyObject *bridge_wait(ThreadBridgeObject *self, PyObject *) {
+    for (;;) {
+        QueueNode *node = pop(self);
+        if (node != nullptr) {
+            return (PyObject *)node->request;
+        }
+        if (self->closed.load()) {
+            Py_RETURN_NONE;
+        }
+        wait_fd(self->efd);
+    }
+}
+
+PyObject *bridge_close(ThreadBridgeObject *self, PyObject *) {
+    self->closed.store(true);
+    signal_fd(self->efd);
+    Py_RETURN_NONE;
+}
+
+PyObject *bridge_get_closed(ThreadBridgeObject *self, void *) {
+    return PyBool_FromLong(self->closed.load());
+}
+
+PyGetSetDef bridge_getsets[] = {
+    {"closed", (getter)bridge_get_closed, NULL, NULL, NULL},
+    {NULL, NULL, NULL, NULL, NULL} /* Sentinel */
+};
+
+PyMethodDef bridge_methods[] = {
+    {"call", (PyCFunction)(void (*)(void))bridge_call,
+     METH_VARARGS | METH_KEYWORDS,
+     PyDoc_STR("call($self, func, /, *args, **kwargs)\n"
+               "--\n\n"
+               "call(func: Callable[..., Any], *args: Any, **kwargs: Any) -> "
+               "Any\n"
+               "Submit a request from a worker thread and block until the "
+               "simulator thread completes it.")},
+    {"wait", (PyCFunction)bridge_wait, METH_NOARGS,
+     PyDoc_STR("wait($self)\n"
+               "--\n\n"
+               "wait() -> Optional[BridgeRequest]\n"
+               "Take the next request, blocking the simulator thread until "
+               "one is submitted.\n"
+               "\n"
+               "Returns ``None`` once the bridge is closed and no request is "
+               "left.")},
+    {"close", (PyCFunction)bridge_close, METH_NOARGS,
+     PyDoc_STR("close($self)\n"
+               "--\n\n"
+               "close() -> None\n"
+               "Refuse further requests and wake up :meth:`wait`.")},
+    {NULL, NULL, 0, NULL} /* Sentinel */
+};
+
+PyTypeObject BridgeRequest_type = []() -> PyTypeObject {
+    PyTypeObject type = {};
+    type.ob_base = {PyObject_HEAD_INIT(NULL) 0};
+    type.tp_name = "mycocotb.simulator.BridgeRequest";
+    type.tp_doc = "A request submitted through a :class:`ThreadBridge`.";
+    type.tp_basicsize = sizeof(BridgeRequest);
+    type.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC;
+    type.tp_dealloc = (destructor)request_dealloc;
+    type.tp_traverse = (traverseproc)request_traverse;
+    type.tp_clear = (inquiry)request_clear;
+    type.tp_methods = request_methods;
+    type.tp_members = request_members;
+    return type;
+}();
+
+PyTypeObject ThreadBridge_type = []() -> PyTypeObject {
+    PyTypeObject type = {};
+    type.ob_base = {PyObject_HEAD_INIT(NULL) 0};
+    type.tp_name = "mycocotb.simulator.ThreadBridge";
+    type.tp_doc =
+        "Queue of requests from worker threads to the simulator thread.\n"
+        "\n"
+        "Any thread may :meth:`call`, only the simulator thread may\n"
+        ":meth:`wait`.";
+    type.tp_basicsize = sizeof(ThreadBridgeObject);
+    type.tp_flags = Py_TPFLAGS_DEFAULT;
+    type.tp_new = bridge_new;
+    type.tp_dealloc = (destructor)bridge_dealloc;
+    type.tp_methods = bridge_methods;
+    type.tp_getset = bridge_getsets;
+    return type;
+}();
+
+}  // namespace
+
+int add_thread_bridge_types(PyObject *simulator) {
+    PyTypeObject *types[] = {&ThreadBridge_type, &BridgeRequest_type};
+    const char *names[] = {"ThreadBridge", "BridgeRequest"};
+    for (int i = 0; i < 2; i++) {
+        if (PyType_Ready(types[i]) < 0) {
+            return -1;
+        }
+        Py_INCREF(types[i]);
+        if (PyModule_AddObject(simulator, names[i], (PyObject *)types[i]) <
+            0) {
+            Py_DECREF(types[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
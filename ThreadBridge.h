@@ -0,0 +1,11 @@
+// 外部线程和仿真线程之间的桥（simulator.ThreadBridge）。工作线程把请求放进无锁的
+// MPSC队列后在自己的eventfd上阻塞，仿真线程取出请求执行完再通过eventfd唤醒它。
+#ifndef MYCOCOTB_THREAD_BRIDGE_H_
+#define MYCOCOTB_THREAD_BRIDGE_H_
+
+#include <Python.h>
+
+// Add ThreadBridge and BridgeRequest to the simulator module, returns -1 on failure
+int add_thread_bridge_types(PyObject *simulator);
+
+#endif /* MYCOCOTB_THREAD_BRIDGE_H_ */
@@ -0,0 +1,259 @@
+/******************************************************************************
+ * @file   TimeUnits.cpp
+ * @brief  Conversions between simulation steps and time units
+ *
+ * Native fast path of mycocotb.utils.get_sim_steps() and
+ * get_time_from_sim_steps(). The factor between each time unit and the
+ * simulator step is an integer computed once from the simulator precision.
+ * ``int`` and ``float`` times are converted here with the same arithmetic as
+ * the Python implementation, which still handles Fraction and Decimal.
+ */
+
+#include "TimeUnits.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "VpiImpl.h"
+
+namespace {
+
+struct TimeUnit {
+    const char *name;
+    int exponent;  // log10 of the unit in seconds
+};
+
+const TimeUnit time_units[] = {{"fs", -15}, {"ps", -12}, {"ns", -9},
+                               {"us", -6},  {"ms", -3},  {"sec", 0}};
+const int N_UNITS = sizeof(time_units) / sizeof(time_units[0]);
+const int UNIT_STEP = N_UNITS;
+
+// steps = time * mul / div，两者中至少有一个是1
+struct UnitFactor {
+    int64_t mul;
+    int64_t div;
+    PyObject *py_mul;
+    PyObject *py_div;
+};
+
+UnitFactor factors[N_UNITS];
+int32_t precision;
+bool factors_ready = false;
+
+int64_t pow10(int n) {
+    int64_t r = 1;
+    while (n-- > 0) {
+        r *= 10;
+    }
+    return r;
+}
+
+int init_factors() {
+    if (factors_ready) {
+        return 0;
+    }
+    gpi_get_sim_precision(&precision);
+    for (int i = 0; i < N_UNITS; i++) {
+        int d = time_units[i].exponent - precision;
+        UnitFactor &f = factors[i];
+        f.mul = d > 0 ? pow10(d) : 1;
+        f.div = d < 0 ? pow10(-d) : 1;
+        f.py_mul = PyLong_FromLongLong(f.mul);
+        f.py_div = PyLong_FromLongLong(f.div);
+        if (f.py_mul == NULL || f.py_div == NULL) {
+            return -1;
+        }
+    }
+    factors_ready = true;
+    return 0;
+}
+
+/** Index of *units* in time_units (UNIT_STEP for "step" if *allow_step*), or -1 */
+int find_unit(PyObject *units, bool allow_step) {
+    const char *name = PyUnicode_AsUTF8(units);
+    if (name == NULL) {
+        return -1;
+    }
+    if (allow_step && std::strcmp(name, "step") == 0) {
+        return UNIT_STEP;
+    }
+    // 和Python实现一样不区分大小写
+    char lower[8];
+    size_t len = std::strlen(name);
+    if (len < sizeof(lower)) {
+        for (size_t i = 0; i <= len; i++) {
+            char c = name[i];
+            lower[i] = (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+        }
+        for (int i = 0; i < N_UNITS; i++) {
+            if (std::strcmp(lower, time_units[i].name) == 0) {
+                return i;
+            }
+        }
+    }
+    PyErr_Format(PyExc_ValueError, "Invalid unit (%U) provided", units);
+    return -1;
+}
+
+enum RoundMode { ROUND_ERROR, ROUND_CEIL, ROUND_ROUND, ROUND_FLOOR };
+
+int find_round_mode(PyObject *round_mode) {
+    static const char *names[] = {"error", "ceil", "round", "floor"};
+    const char *name = PyUnicode_AsUTF8(round_mode);
+    if (name == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < 4; i++) {
+        if (std::strcmp(name, names[i]) == 0) {
+            return i;
+        }
+    }
+    PyErr_Format(PyExc_ValueError, "Invalid round_mode specifier: %U",
+                 round_mode);
+    return -1;
+}
+
+PyObject *round_steps(double steps, int mode, PyObject *time, PyObject *units) {
+    switch (mode) {
+        case ROUND_CEIL:
+            return PyLong_FromDouble(std::ceil(steps));
+        case ROUND_ROUND:
+            // round()对float是四舍六入五成双，和默认舍入模式下的nearbyint一致
+            return PyLong_FromDouble(std::nearbyint(steps));
+        case ROUND_FLOOR:
+            return PyLong_FromDouble(std::floor(steps));
+    }
+    PyObject *result = PyLong_FromDouble(std::floor(steps));
+    if (result != NULL && std::floor(steps) != steps) {
+        Py_DECREF(result);
+        PyErr_Format(PyExc_ValueError,
+                     "Unable to accurately represent %S(%U) with the simulator "
+                     "precision of 1e%d",
+                     time, units, (int)precision);
+        return NULL;
+    }
+    return result;
+}
+
+PyObject *get_sim_steps(PyObject *, PyObject *args) {
+    PyObject *time;
+    PyObject *units;
+    PyObject *round_mode;
+    if (!PyArg_ParseTuple(args, "OUU:get_sim_steps", &time, &units,
+                          &round_mode)) {
+        return NULL;
+    }
+    bool is_int = PyLong_CheckExact(time);
+    if (!is_int && !PyFloat_CheckExact(time)) {
+        Py_RETURN_NOTIMPLEMENTED;
+    }
+    int unit = find_unit(units, true);
+    if (unit < 0 || init_factors() < 0) {
+        return NULL;
+    }
+    int mode = find_round_mode(round_mode);
+    if (mode < 0) {
+        return NULL;
+    }
+
+    double steps;
+    if (is_int) {
+        if (unit == UNIT_STEP) {
+            Py_INCREF(time);
+            return time;
+        } else if (factors[unit].mul != 1) {
+            // 整数乘整数是精确的，不需要再舍入
+            return PyNumber_Multiply(time, factors[unit].py_mul);
+        }
+        // _ldexp10对非正的指数做的是除法，int / int在Python里得到float
+        PyObject *quotient = PyNumber_TrueDivide(time, factors[unit].py_div);
+        if (quotient == NULL) {
+            return NULL;
+        }
+        steps = PyFloat_AS_DOUBLE(quotient);
+        Py_DECREF(quotient);
+    } else {
+        steps = PyFloat_AS_DOUBLE(time);
+        if (unit != UNIT_STEP) {
+            // 10的幂在这个范围内都能精确地表示成double，和Python的float * int一样
+            if (factors[unit].mul != 1) {
+                steps *= (double)factors[unit].mul;
+            } else {
+                steps /= (double)factors[unit].div;
+            }
+        }
+    }
+    return round_steps(steps, mode, time, units);
+}
+
+PyObject *get_time_from_sim_steps(PyObject *, PyObject *args) {
+    PyObject *steps;
+    PyObject *units;
+    if (!PyArg_ParseTuple(args, "OU:get_time_from_sim_steps", &steps,
+                          &units)) {
+        return NULL;
+    }
+    int unit = find_unit(units, false);
+    if (unit < 0 || init_factors() < 0) {
+        return NULL;
+    }
+    // 和_ldexp10一样：单位比步长小时乘，否则做除法
+    if (factors[unit].div != 1) {
+        return PyNumber_Multiply(steps, factors[unit].py_div);
+    }
+    return PyNumber_TrueDivide(steps, factors[unit].py_mul);
+}
+
+PyObject *get_time_unit_factors(PyObject *, PyObject *) {
+    if (init_factors() < 0) {
+        return NULL;
+    }
+    PyObject *result = PyDict_New();
+    if (result == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < N_UNITS; i++) {
+        PyObject *pair =
+            PyTuple_Pack(2, factors[i].py_mul, factors[i].py_div);
+        if (pair == NULL ||
+            PyDict_SetItemString(result, time_units[i].name, pair) < 0) {
+            Py_XDECREF(pair);
+            Py_DECREF(result);
+            return NULL;
+        }
+        Py_DECREF(pair);
+    }
+    return result;
+}
+
+PyMethodDef time_unit_methods[] = {
+    {"get_sim_steps", get_sim_steps, METH_VARARGS,
+     PyDoc_STR("get_sim_steps(time, units, round_mode, /)\n"
+               "--\n\n"
+               "get_sim_steps(time: Union[int, float], units: str, "
+               "round_mode: str) -> int\n"
+               "Convert *time* to simulation steps.\n"
+               "\n"
+               "Returns ``NotImplemented`` if *time* is not an ``int`` or a "
+               "``float``.")},
+    {"get_time_from_sim_steps", get_time_from_sim_steps, METH_VARARGS,
+     PyDoc_STR("get_time_from_sim_steps(steps, units, /)\n"
+               "--\n\n"
+               "get_time_from_sim_steps(steps: int, units: str) -> "
+               "Union[int, float]\n"
+               "Convert *steps* to a time in *units*.")},
+    {"get_time_unit_factors", get_time_unit_factors, METH_NOARGS,
+     PyDoc_STR("get_time_unit_factors()\n"
+               "--\n\n"
+               "get_time_unit_factors() -> Dict[str, Tuple[int, int]]\n"
+               "Get the ``(mul, div)`` factors of each time unit, such that "
+               "``steps = time * mul / div``.")},
+    {NULL, NULL, 0, NULL} /* Sentinel */
+};
+
+}  // namespace
+
+int add_time_unit_functions(PyObject *simulator) {
+    return PyModule_AddFunctions(simulator, time_unit_methods);
+}
@@ -0,0 +1,11 @@
+// 时间单位换算（simulator.get_sim_steps等）的C实现，换算系数只在第一次用到时
+// 根据仿真器的精度算一次。
+#ifndef MYCOCOTB_TIME_UNITS_H_
+#define MYCOCOTB_TIME_UNITS_H_
+
+#include <Python.h>
+
+// Add the time conversion functions to the simulator module, returns -1 on failure
+int add_time_unit_functions(PyObject *simulator);
+
+#endif /* MYCOCOTB_TIME_UNITS_H_ */
@@ -0,0 +1,655 @@
+/******************************************************************************
+ * @file   ValueMonitor.cpp
+ * @brief  Record the value changes of a set of signals natively
+ *
+ * Awaiting Edge() on a signal costs a Python callback, a task wakeup and a
+ * value conversion for every change, and a task that has not re-armed its
+ * trigger yet misses the changes in between. A ValueMonitor keeps a value
+ * change callback registered on each watched signal for as long as it is
+ * open; the callback copies the simulation time, the position of the signal
+ * in the watch list and the value words into a ring buffer allocated up
+ * front, without entering Python. drain() hands the recorded changes to
+ * Python in one batch.
+ *
+ * A ChangeSet answers "which of these signals changed in this time step"
+ * without reading and comparing all of them: its callbacks only set a dirty
+ * flag per signal, and the flags are dropped lazily when a change or a query
+ * comes in a later time step.
+ *
+ * A task waiting for changes waits on the wakeup callback of the recorder, a
+ * ReadOnly callback that the first change registers with the simulator, so
+ * that Python is only resumed in the time steps in which something changed.
+ *
+ * Records are written from the simulator callbacks and read from Python in
+ * the simulator thread, so neither side takes a lock.
+ */
+
+#include "ValueMonitor.h"
+
+#include <structmember.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "LogicArrayObject.h"
+
+namespace {
+
+enum OverflowPolicy { DROP_OLDEST = 0, DROP_NEWEST };
+
+const char *const policy_names[] = {"drop_oldest", "drop_newest"};
+
+// 每个被监视的信号一个，作为值变化回调的用户数据
+struct Watch {
+    void *owner;  // the ValueMonitorObject or ChangeSetObject
+    gpi_sim_hdl hdl;
+    gpi_cb_hdl cb;
+    uint32_t index;  // position in the watch list
+    Py_ssize_t n_bits;
+};
+
+uint64_t sim_time_now() {
+    uint32_t high, low;
+    gpi_get_sim_time(&high, &low);
+    return ((uint64_t)high << 32) | low;
+}
+
+/** Fill *watches* from the gpi_sim_hdl sequence *handles*, false with an
+ * exception set */
+bool parse_watches(PyObject *handles, void *owner, std::vector<Watch> &watches) {
+    PyObject *seq = PySequence_Fast(handles, "Expected a sequence of gpi_sim_hdl");
+    if (seq == NULL) {
+        return false;
+    }
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    if (n == 0 || n > (Py_ssize_t)UINT32_MAX) {
+        PyErr_SetString(PyExc_ValueError, "Expected at least one handle");
+        Py_DECREF(seq);
+        return false;
+    }
+    // 回调拿的是元素的地址，之后不能再扩容
+    watches.reserve(n);
+    for (Py_ssize_t i = 0; i < n; i++) {
+        gpi_sim_hdl hdl = sim_handle_from_object(PySequence_Fast_GET_ITEM(seq, i));
+        if (hdl == NULL) {
+            PyErr_SetString(PyExc_TypeError, "Expected a sequence of gpi_sim_hdl");
+            Py_DECREF(seq);
+            return false;
+        }
+        gpi_objtype_t t = gpi_get_object_type(hdl);
+        if (t != GPI_LOGIC && t != GPI_LOGIC_ARRAY &&
+            t != GPI_PACKED_STRUCTURE) {
+            PyErr_Format(PyExc_TypeError, "Cannot watch %s, a %s",
+                         gpi_get_signal_name_str(hdl),
+                         gpi_get_signal_type_str(hdl));
+            Py_DECREF(seq);
+            return false;
+        }
+        watches.push_back({owner, hdl, NULL, (uint32_t)i,
+                           (Py_ssize_t)gpi_get_num_elems(hdl)});
+    }
+    Py_DECREF(seq);
+    return true;
+}
+
+/** Register *callback* for the changes of every watch, false with an
+ * exception set */
+bool arm_watches(std::vector<Watch> &watches, int (*callback)(void *)) {
+    for (Watch &watch : watches) {
+        watch.cb = gpi_register_value_watch_callback(callback, &watch, watch.hdl);
+        if (watch.cb == NULL) {
+            PyErr_Format(PyExc_RuntimeError,
+                         "Failed to watch value changes of %s",
+                         gpi_get_signal_name_str(watch.hdl));
+            return false;
+        }
+    }
+    return true;
+}
+
+void disarm_watches(std::vector<Watch> &watches) {
+    for (Watch &watch : watches) {
+        if (watch.cb != NULL) {
+            gpi_deregister_callback(watch.cb);
+            watch.cb = NULL;
+        }
+    }
+}
+
+/* ValueMonitor */
+
+struct ValueMonitorObject {
+    PyObject_HEAD std::vector<Watch> *watches;
+    Py_ssize_t capacity;    // records in the ring
+    Py_ssize_t slot_words;  // words of the widest watched signal
+    // 环形缓冲区：第i条记录的时间、信号序号和值分别在times[i]、indexes[i]
+    // 和words[i * slot_words]开始的slot_words个字里
+    uint64_t *times;
+    uint32_t *indexes;
+    LogicWord *words;
+    Py_ssize_t head;   // oldest record
+    Py_ssize_t count;  // records in the ring
+    int policy;
+    bool closed;
+    gpi_cb_hdl wakeup;  // registered for ReadOnly by the first change
+    unsigned long long recorded;  // changes seen, including dropped ones
+    unsigned long long dropped;
+    Py_ssize_t high_water;  // most records ever held at once
+};
+
+/** Value change callback, called by the simulator for every change */
+int record_change(void *user_data) {
+    Watch *watch = (Watch *)user_data;
+    ValueMonitorObject *self = (ValueMonitorObject *)watch->owner;
+    gpi_fire_wakeup_callback(self->wakeup);
+    self->recorded++;
+    const gpi_vecval *value = gpi_get_signal_value_vecval(watch->hdl);
+    if (value == NULL) {
+        // 读不到值的变化和缓冲区满时丢掉的一样计数
+        self->dropped++;
+        return 0;
+    }
+    if (self->count == self->capacity) {
+        self->dropped++;
+        if (self->policy == DROP_NEWEST) {
+            return 0;
+        }
+        // 覆盖最老的一条
+        self->head = (self->head + 1) % self->capacity;
+        self->count--;
+    }
+    Py_ssize_t slot = (self->head + self->count) % self->capacity;
+    self->times[slot] = sim_time_now();
+    self->indexes[slot] = watch->index;
+    std::memcpy(self->words + slot * self->slot_words, value,
+                logic_array_n_words(watch->n_bits) * sizeof(LogicWord));
+    self->count++;
+    self->high_water = std::max(self->high_water, self->count);
+    return 0;
+}
+
+void close_monitor(ValueMonitorObject *self) {
+    if (self->closed) {
+        return;
+    }
+    self->closed = true;
+    disarm_watches(*self->watches);
+    // 让等待变化的task醒来看到已经关闭
+    gpi_fire_wakeup_callback(self->wakeup);
+}
+
+PyObject *monitor_new(PyTypeObject *type, PyObject *args, PyObject *kwargs) {
+    static const char *kwlist[] = {"handles", "capacity", "overflow", NULL};
+    PyObject *handles;
+    Py_ssize_t capacity = 4096;
+    const char *overflow = policy_names[DROP_OLDEST];
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|ns:ValueMonitor",
+                                     (char **)kwlist, &handles, &capacity,
+                                     &overflow)) {
+        return NULL;
+    }
+    int policy;
+    if (std::strcmp(overflow, policy_names[DROP_OLDEST]) == 0) {
+        policy = DROP_OLDEST;
+    } else if (std::strcmp(overflow, policy_names[DROP_NEWEST]) == 0) {
+        policy = DROP_NEWEST;
+    } else {
+        PyErr_SetString(PyExc_ValueError,
+                        "overflow must be 'drop_oldest' or 'drop_newest'");
+        return NULL;
+    }
+    if (capacity <= 0) {
+        PyErr_SetString(PyExc_ValueError, "capacity must be positive");
+        return NULL;
+    }
+    ValueMonitorObject *self = (ValueMonitorObject *)type->tp_alloc(type, 0);
+    if (self == NULL) {
+        return NULL;
+    }
+    self->wakeup = gpi_create_wakeup_callback();
+    self->watches = new std::vector<Watch>();
+    self->capacity = capacity;
+    self->slot_words = 1;
+    self->policy = policy;
+    if (!parse_watches(handles, self, *self->watches)) {
+        Py_DECREF(self);
+        return NULL;
+    }
+    for (const Watch &watch : *self->watches) {
+        self->slot_words =
+            std::max(self->slot_words, logic_array_n_words(watch.n_bits));
+    }
+
+    // 缓冲区一次分配好，回调里不再分配内存
+    if ((size_t)capacity > PY_SSIZE_T_MAX / sizeof(LogicWord) / self->slot_words) {
+        Py_DECREF(self);
+        return PyErr_NoMemory();
+    }
+    self->times = PyMem_New(uint64_t, capacity);
+    self->indexes = PyMem_New(uint32_t, capacity);
+    self->words = PyMem_New(LogicWord, capacity * self->slot_words);
+    if (self->times == NULL || self->indexes == NULL || self->words == NULL) {
+        Py_DECREF(self);
+        return PyErr_NoMemory();
+    }
+    if (!arm_watches(*self->watches, record_change)) {
+        Py_DECREF(self);
+        return NULL;
+    }
+    return (PyObject *)self;
+}
+
+void monitor_dealloc(ValueMonitorObject *self) {
+    if (self->watches != NULL) {
+        close_monitor(self);
+        delete self->watches;
+    }
+    PyMem_Free(self->times);
+    PyMem_Free(self->indexes);
+    PyMem_Free(self->words);
+    if (self->wakeup != NULL) {
+        gpi_free_wakeup_callback(self->wakeup);
+    }
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+Py_ssize_t monitor_length(ValueMonitorObject *self) { return self->count; }
+
+PyObject *monitor_drain(ValueMonitorObject *self, PyObject *args) {
+    Py_ssize_t limit = -1;
+    if (!PyArg_ParseTuple(args, "|n:drain", &limit)) {
+        return NULL;
+    }
+    Py_ssize_t n = limit < 0 ? self->count : std::min(limit, self->count);
+    PyObject *result = PyList_New(n);
+    if (result == NULL) {
+        return NULL;
+    }
+    for (Py_ssize_t i = 0; i < n; i++) {
+        Py_ssize_t slot = (self->head + i) % self->capacity;
+        const Watch &watch = (*self->watches)[self->indexes[slot]];
+        PyObject *value = logic_array_from_words(
+            self->words + slot * self->slot_words, watch.n_bits);
+        if (value == NULL) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyObject *item = Py_BuildValue("(KIN)", (unsigned long long)self->times[slot],
+                                       (unsigned int)watch.index, value);
+        if (item == NULL) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyList_SET_ITEM(result, i, item);
+    }
+    // 全部转换成功之后才移出缓冲区
+    self->head = (self->head + n) % self->capacity;
+    self->count -= n;
+    return result;
+}
+
+PyObject *monitor_clear(ValueMonitorObject *self, PyObject *) {
+    self->head = 0;
+    self->count = 0;
+    Py_RETURN_NONE;
+}
+
+PyObject *monitor_close(ValueMonitorObject *self, PyObject *) {
+    close_monitor(self);
+    Py_RETURN_NONE;
+}
+
+PyObject *monitor_get_overflow(ValueMonitorObject *self, void *) {
+    return PyUnicode_FromString(policy_names[self->policy]);
+}
+
+PyObject *monitor_get_closed(ValueMonitorObject *self, void *) {
+    return PyBool_FromLong(self->closed);
+}
+
+PySequenceMethods monitor_as_sequence = []() -> PySequenceMethods {
+    PySequenceMethods methods = {};
+    methods.sq_length = (lenfunc)monitor_length;
+    return methods;
+}();
+
+PyMethodDef monitor_methods[] = {
+    {"drain", (PyCFunction)monitor_drain, METH_VARARGS,
+     PyDoc_STR("drain($self, limit=-1, /)\n"
+               "--\n\n"
+               "drain(limit: int = -1) -> List[Tuple[int, int, LogicArray]]\n"
+               "Remove and return the oldest *limit* records, all of them by "
+               "default.\n"
+               "\n"
+               "Each record is ``(time, index, value)``: the simulation time "
+               "in steps, the position of the signal in the watch list and "
+               "its new value.")},
+    {"clear", (PyCFunction)monitor_clear, METH_NOARGS,
+     PyDoc_STR("clear($self)\n"
+               "--\n\n"
+               "clear() -> None\n"
+               "Discard all records. The counters are kept.")},
+    {"close", (PyCFunction)monitor_close, METH_NOARGS,
+     PyDoc_STR("close($self)\n"
+               "--\n\n"
+               "close() -> None\n"
+               "Stop recording. Records already made can still be drained.")},
+    {NULL, NULL, 0, NULL} /* Sentinel */
+};
+
+PyMemberDef monitor_members[] = {
+    {"capacity", T_PYSSIZET, offsetof(ValueMonitorObject, capacity), READONLY,
+     PyDoc_STR("Number of records the ring buffer holds.")},
+    {"recorded", T_ULONGLONG, offsetof(ValueMonitorObject, recorded), READONLY,
+     PyDoc_STR("Number of value changes seen, including dropped ones.")},
+    {"dropped", T_ULONGLONG, offsetof(ValueMonitorObject, dropped), READONLY,
+     PyDoc_STR("Number of value changes lost because the buffer was full "
+               "or the value could not be read.")},
+    {"high_water", T_PYSSIZET, offsetof(ValueMonitorObject, high_water),
+     READONLY, PyDoc_STR("Most records held at once.")},
+    {NULL, 0, 0, 0, NULL} /* Sentinel */
+};
+
+PyGetSetDef monitor_getsets[] = {
+    {"overflow", (getter)monitor_get_overflow, NULL,
+     PyDoc_STR("``'drop_oldest'`` or ``'drop_newest'``, what happens to a "
+               "change when the buffer is full."),
+     NULL},
+    {"closed", (getter)monitor_get_closed, NULL, NULL, NULL},
+    {NULL, NULL, NULL, NULL, NULL} /* Sentinel */
+};
+
+/* ChangeSet */
+
+struct ChangeSetObject {
+    PyObject_HEAD std::vector<Watch> *watches;
+    // 在step_time这个时间步里变化过的信号：dirty按序号标记，changed按第一次
+    // 变化的顺序记下序号。两者都预先分配好，回调里不分配内存
+    std::vector<uint8_t> *dirty;
+    std::vector<uint32_t> *changed;
+    uint64_t step_time;
+    bool closed;
+    gpi_cb_hdl wakeup;  // registered for ReadOnly by the first change
+};
+
+void reset_changes(ChangeSetObject *self) {
+    for (uint32_t index : *self->changed) {
+        (*self->dirty)[index] = 0;
+    }
+    self->changed->clear();
+}
+
+/** Drop the changes of an earlier time step */
+void sync_step(ChangeSetObject *self) {
+    uint64_t now = sim_time_now();
+    if (now != self->step_time) {
+        reset_changes(self);
+        self->step_time = now;
+    }
+}
+
+/** Value change callback, only marks the signal as changed */
+int mark_change(void *user_data) {
+    Watch *watch = (Watch *)user_data;
+    ChangeSetObject *self = (ChangeSetObject *)watch->owner;
+    gpi_fire_wakeup_callback(self->wakeup);
+    sync_step(self);
+    uint8_t &dirty = (*self->dirty)[watch->index];
+    if (!dirty) {
+        dirty = 1;
+        self->changed->push_back(watch->index);
+    }
+    return 0;
+}
+
+PyObject *change_set_new(PyTypeObject *type, PyObject *args, PyObject *kwargs) {
+    static const char *kwlist[] = {"handles", NULL};
+    PyObject *handles;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O:ChangeSet",
+                                     (char **)kwlist, &handles)) {
+        return NULL;
+    }
+    ChangeSetObject *self = (ChangeSetObject *)type->tp_alloc(type, 0);
+    if (self == NULL) {
+        return NULL;
+    }
+    self->wakeup = gpi_create_wakeup_callback();
+    self->watches = new std::vector<Watch>();
+    if (!parse_watches(handles, self, *self->watches)) {
+        Py_DECREF(self);
+        return NULL;
+    }
+    size_t n = self->watches->size();
+    self->dirty = new std::vector<uint8_t>(n, 0);
+    self->changed = new std::vector<uint32_t>();
+    self->changed->reserve(n);
+    self->step_time = sim_time_now();
+    if (!arm_watches(*self->watches, mark_change)) {
+        Py_DECREF(self);
+        return NULL;
+    }
+    return (PyObject *)self;
+}
+
+void change_set_dealloc(ChangeSetObject *self) {
+    if (self->watches != NULL) {
+        disarm_watches(*self->watches);
+        delete self->watches;
+    }
+    delete self->dirty;
+    delete self->changed;
+    if (self->wakeup != NULL) {
+        gpi_free_wakeup_callback(self->wakeup);
+    }
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+Py_ssize_t change_set_length(ChangeSetObject *self) {
+    sync_step(self);
+    return (Py_ssize_t)self->changed->size();
+}
+
+/** Indexes of the changed signals in watch list order */
+const std::vector<uint32_t> &sorted_changes(ChangeSetObject *self) {
+    sync_step(self);
+    std::sort(self->changed->begin(), self->changed->end());
+    return *self->changed;
+}
+
+PyObject *change_set_changed(ChangeSetObject *self, PyObject *) {
+    const std::vector<uint32_t> &changed = sorted_changes(self);
+    PyObject *result = PyList_New((Py_ssize_t)changed.size());
+    if (result == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < changed.size(); i++) {
+        PyObject *index = PyLong_FromUnsignedLong(changed[i]);
+        if (index == NULL) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyList_SET_ITEM(result, (Py_ssize_t)i, index);
+    }
+    return result;
+}
+
+PyObject *change_set_values(ChangeSetObject *self, PyObject *) {
+    const std::vector<uint32_t> &changed = sorted_changes(self);
+    PyObject *result = PyList_New((Py_ssize_t)changed.size());
+    if (result == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < changed.size(); i++) {
+        const Watch &watch = (*self->watches)[changed[i]];
+        // 只读取变化过的信号，读到的是调用时的值
+        const gpi_vecval *words = gpi_get_signal_value_vecval(watch.hdl);
+        if (words == NULL) {
+            // LCOV_EXCL_START
+            PyErr_SetString(
+                PyExc_RuntimeError,
+                "Simulator yielded a null pointer instead of vecval");
+            Py_DECREF(result);
+            return NULL;
+            // LCOV_EXCL_STOP
+        }
+        PyObject *value = logic_array_from_words(
+            reinterpret_cast<const LogicWord *>(words), watch.n_bits);
+        if (value == NULL) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyObject *item = Py_BuildValue("(IN)", (unsigned int)watch.index, value);
+        if (item == NULL) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyList_SET_ITEM(result, (Py_ssize_t)i, item);
+    }
+    return result;
+}
+
+PyObject *change_set_bitmap(ChangeSetObject *self, PyObject *) {
+    sync_step(self);
+    std::vector<unsigned char> bytes((self->watches->size() + 7) / 8, 0);
+    for (uint32_t index : *self->changed) {
+        bytes[index / 8] |= (unsigned char)(1u << (index % 8));
+    }
+    PyObject *raw = PyBytes_FromStringAndSize((const char *)bytes.data(),
+                                              (Py_ssize_t)bytes.size());
+    if (raw == NULL) {
+        return NULL;
+    }
+    PyObject *result = PyObject_CallMethod((PyObject *)&PyLong_Type,
+                                           "from_bytes", "Ns", raw, "little");
+    return result;
+}
+
+PyObject *change_set_clear(ChangeSetObject *self, PyObject *) {
+    reset_changes(self);
+    Py_RETURN_NONE;
+}
+
+PyObject *change_set_close(ChangeSetObject *self, PyObject *) {
+    if (!self->closed) {
+        self->closed = true;
+        disarm_watches(*self->watches);
+        gpi_fire_wakeup_callback(self->wakeup);
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject *change_set_get_closed(ChangeSetObject *self, void *) {
+    return PyBool_FromLong(self->closed);
+}
+
+PySequenceMethods change_set_as_sequence = []() -> PySequenceMethods {
+    PySequenceMethods methods = {};
+    methods.sq_length = (lenfunc)change_set_length;
+    return methods;
+}();
+
+PyMethodDef change_set_methods[] = {
+    {"changed", (PyCFunction)change_set_changed, METH_NOARGS,
+     PyDoc_STR("changed($self)\n"
+               "--\n\n"
+               "changed() -> List[int]\n"
+               "Return the positions in the watch list of the signals that "
+               "changed in the current time step.")},
+    {"values", (PyCFunction)change_set_values, METH_NOARGS,
+     PyDoc_STR("values($self)\n"
+               "--\n\n"
+               "values() -> List[Tuple[int, LogicArray]]\n"
+               "Return ``(index, value)`` of the signals that changed in the "
+               "current time step, reading only those signals.")},
+    {"bitmap", (PyCFunction)change_set_bitmap, METH_NOARGS,
+     PyDoc_STR("bitmap($self)\n"
+               "--\n\n"
+               "bitmap() -> int\n"
+               "Return an int with bit *i* set if signal *i* changed in the "
+               "current time step.")},
+    {"clear", (PyCFunction)change_set_clear, METH_NOARGS,
+     PyDoc_STR("clear($self)\n"
+               "--\n\n"
+               "clear() -> None\n"
+               "Forget the changes seen so far in the current time step.")},
+    {"close", (PyCFunction)change_set_close, METH_NOARGS,
+     PyDoc_STR("close($self)\n"
+               "--\n\n"
+               "close() -> None\n"
+               "Stop tracking changes.")},
+    {NULL, NULL, 0, NULL} /* Sentinel */
+};
+
+PyGetSetDef change_set_getsets[] = {
+    {"closed", (getter)change_set_get_closed, NULL, NULL, NULL},
+    {NULL, NULL, NULL, NULL, NULL} /* Sentinel */
+};
+
+}  // namespace
+
+PyTypeObject ValueMonitor_type = []() -> PyTypeObject {
+    PyTypeObject type = {};
+    type.ob_base = {PyObject_HEAD_INIT(NULL) 0};
+    type.tp_name = "mycocotb.simulator.ValueMonitor";
+    type.tp_doc =
+        "ValueMonitor(handles, capacity=4096, overflow='drop_oldest')\n"
+        "--\n\n"
+        "Record every value change of the signals *handles* into a ring "
+        "buffer of *capacity* records.";
+    type.tp_basicsize = sizeof(ValueMonitorObject);
+    type.tp_flags = Py_TPFLAGS_DEFAULT;
+    type.tp_new = monitor_new;
+    type.tp_dealloc = (destructor)monitor_dealloc;
+    type.tp_as_sequence = &monitor_as_sequence;
+    type.tp_methods = monitor_methods;
+    type.tp_members = monitor_members;
+    type.tp_getset = monitor_getsets;
+    return type;
+}();
+
+PyTypeObject ChangeSet_type = []() -> PyTypeObject {
+    PyTypeObject type = {};
+    type.ob_base = {PyObject_HEAD_INIT(NULL) 0};
+    type.tp_name = "mycocotb.simulator.ChangeSet";
+    type.tp_doc =
+        "ChangeSet(handles)\n"
+        "--\n\n"
+        "Track which of the signals *handles* changed in the current time "
+        "step.";
+    type.tp_basicsize = sizeof(ChangeSetObject);
+    type.tp_flags = Py_TPFLAGS_DEFAULT;
+    type.tp_new = change_set_new;
+    type.tp_dealloc = (destructor)change_set_dealloc;
+    type.tp_as_sequence = &change_set_as_sequence;
+    type.tp_methods = change_set_methods;
+    type.tp_getset = change_set_getsets;
+    return type;
+}();
+
+gpi_cb_hdl wakeup_from_object(PyObject *obj) {
+    if (Py_TYPE(obj) == &ValueMonitor_type) {
+        return ((ValueMonitorObject *)obj)->wakeup;
+    }
+    if (Py_TYPE(obj) == &ChangeSet_type) {
+        return ((ChangeSetObject *)obj)->wakeup;
+    }
+    return nullptr;
+}
+
+int add_value_monitor_types(PyObject *simulator) {
+    PyTypeObject *types[] = {&ValueMonitor_type, &ChangeSet_type};
+    const char *names[] = {"ValueMonitor", "ChangeSet"};
+    for (int i = 0; i < 2; i++) {
+        if (PyType_Ready(types[i]) < 0) {
+            return -1;
+        }
+        Py_INCREF(types[i]);
+        if (PyModule_AddObject(simulator, names[i], (PyObject *)types[i]) <
+            0) {
+            Py_DECREF(types[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
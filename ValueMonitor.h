@@ -0,0 +1,22 @@
+// 信号值变化的记录器。ValueMonitor在每次值变化的回调里直接把(时间, 信号序号, 值)
+// 写进预先分配好的环形缓冲区；ChangeSet只标记当前时间步里哪些信号变化过。
+// 两者的回调都不调用Python，只在时间步里第一次变化时为唤醒回调注册ReadOnly。
+#ifndef MYCOCOTB_VALUE_MONITOR_H_
+#define MYCOCOTB_VALUE_MONITOR_H_
+
+#include <Python.h>
+
+#include "VpiImpl.h"
+
+// Get the GPI handle behind a simulator.gpi_sim_hdl object, or nullptr if
+// *obj* is not a signal handle
+gpi_sim_hdl sim_handle_from_object(PyObject *obj);
+
+// Get the wakeup callback of a ValueMonitor or ChangeSet object, or nullptr
+// if *obj* is neither
+gpi_cb_hdl wakeup_from_object(PyObject *obj);
+
+// Add ValueMonitor and ChangeSet to the simulator module, returns -1 on failure
+int add_value_monitor_types(PyObject *simulator);
+
+#endif /* MYCOCOTB_VALUE_MONITOR_H_ */
@@ -2,17 +2,23 @@
 // gpi_embed.cpp
 
 # include "VpiImpl.h"
+#include "GpiHistogram.h"
+#include "GpiMeter.h"
+#include "GpiTrace.h"
 #include <queue>
 #include <Python.h>
 
 
 extern "C" {
 static VpiCbHdl *sim_init_cb;
+static VpiCbHdl *sim_finish_cb;
 #ifndef VPI_NO_QUEUE_SETIMMEDIATE_CALLBACKS
 static std::deque<VpiCbHdl *> cb_queue;
 #endif
 static wchar_t progname[] = L"mycocotb";
 static wchar_t *argv[] = {progname};
+// 上一个回调返回仿真器的时刻，到下一个回调进来之间的时间记在仿真器头上
+static uint64_t trace_last_exit = 0;
 
 static int32_t handle_vpi_callback_(VpiCbHdl *cb_hdl) {
     gpi_to_user();
@@ -22,9 +28,25 @@ static int32_t handle_vpi_callback_(VpiCbHdl *cb_hdl) {
         return -1;
     }
 
+    // 回调执行完可能已经被释放，所以先记下它的种类
+    uint64_t trace_start = 0;
+    uint64_t hist_start = 0;
+    gpi_cb_kind_e kind = GPI_CB_OTHER;
+    if (gpi_trace_enabled) {
+        trace_start = gpi_trace_clock();
+        kind = cb_hdl->get_kind();
+        gpi_trace_span("simulator", "simulator", trace_last_exit, trace_start);
+    }
+    if (gpi_hist_enabled) {
+        hist_start = gpi_hist_clock();
+        kind = cb_hdl->get_kind();
+        gpi_hist_current_kind = kind;
+    }
+
     gpi_cb_state_e old_state = cb_hdl->get_call_state();
 
     if (old_state == GPI_PRIMED) {
+        ++gpi_stats.cb_fired[cb_hdl->get_kind()];
         cb_hdl->set_call_state(GPI_CALL);
         cb_hdl->run_callback();
 
@@ -43,6 +65,19 @@ static int32_t handle_vpi_callback_(VpiCbHdl *cb_hdl) {
         }
     }
 
+    if (gpi_trace_enabled) {
+        uint32_t high, low;
+        gpi_get_sim_time(&high, &low);
+        trace_last_exit = gpi_trace_clock();
+        gpi_trace_span("gpi", gpi_cb_kind_name(kind), trace_start,
+                       trace_last_exit, (int64_t)(((uint64_t)high << 32) | low));
+    }
+
+    // 回调里才打开直方图时hist_start还是0，这一次不算
+    if (gpi_hist_enabled && hist_start != 0) {
+        gpi_hist_record(GPI_HIST_CALLBACK, kind, gpi_hist_clock() - hist_start);
+    }
+
     gpi_to_simulator();
 
     return 0;
@@ -259,16 +294,36 @@ int _embed_sim_init(int argc, char const *const *_argv) {
 }
 
 static void register_initial_callback() {
+    const char *trace_path = getenv("COCOTB_TRACE_FILE");
+    if (trace_path && *trace_path) {
+        gpi_trace_open(trace_path);
+    }
+    // COCOTB_LATENCY_HISTOGRAMS不为空也不为"0"时从一开始就记录延迟
+    const char *histograms = getenv("COCOTB_LATENCY_HISTOGRAMS");
+    if (histograms && *histograms && strcmp(histograms, "0") != 0) {
+        gpi_hist_enable(true);
+    }
+    // COCOTB_METER_INTERVAL秒输出一次吞吐量，COCOTB_METER_FILE为空时输出到日志
+    const char *meter_interval = getenv("COCOTB_METER_INTERVAL");
+    if (meter_interval && *meter_interval) {
+        gpi_meter_start(atof(meter_interval), getenv("COCOTB_METER_FILE"));
+    }
+
     sim_init_cb = new VpiStartupCbHdl();
     sim_init_cb->arm_callback();
 }
 
+static void register_final_callback() {
+    sim_finish_cb = new VpiShutdownCbHdl();
+    sim_finish_cb->arm_callback();
+}
+
 // 在这里定义两个vpi的钩子函数，他们将在仿真器启动时，由仿真器调用执行。
 // 实际上只使用一个也行，但cocotb里分成了两个：一个负责初始化python环境，
 // 如，获取python库路径、初始化配置等；一个负责执行实际的cocotb的基础python
 // 代码，如启动事件循环等，并在启动完成后，跳入用户端的代码开始执行
 void (*vlog_startup_routines[])() = {
-    gpi_entry_point, register_initial_callback,
+    gpi_entry_point, register_initial_callback, register_final_callback,
     nullptr
 };
 
@@ -287,15 +342,19 @@ VpiCbHdl::VpiCbHdl() {
     cb_data.value = NULL;
     cb_data.index = 0;
     cb_data.user_data = (char *)this;
+    ++gpi_live_objects.created[GPI_OBJ_VPI_CB];
 }
 
+VpiCbHdl::~VpiCbHdl() { ++gpi_live_objects.freed[GPI_OBJ_VPI_CB]; }
+
 int VpiCbHdl::arm_callback() {
-    vpiHandle new_hdl = vpi_register_cb(&cb_data);
+    vpiHandle new_hdl = gpi_vpi_register_cb(&cb_data);
     if (!new_hdl) {
         LOG_ERROR("VPI: Failed to register callback\n");
         return -1;
     } else {
         m_state = GPI_PRIMED;
+        ++gpi_stats.cb_registered[get_kind()];
     }
     m_obj_hdl = new_hdl;
     return 0;
@@ -319,10 +378,11 @@ int VpiCbHdl::cleanup_callback() {
             return -1;
         }
 
-        if (!(vpi_remove_cb(get_handle<vpiHandle>()))) {
+        if (!(gpi_vpi_remove_cb(get_handle<vpiHandle>()))) {
             LOG_ERROR("VPI: unable to remove callback");
             return -1;
         }
+        ++gpi_stats.cb_removed[get_kind()];
 
     } 
 
@@ -344,6 +404,23 @@ int VpiCbHdl::set_user_data(int (*_gpi_function)(void *), void *data) {
 void VpiCbHdl::set_call_state(gpi_cb_state_e new_state) { m_state = new_state; }
 gpi_cb_state_e VpiCbHdl::get_call_state() { return m_state; }
 
+gpi_cb_kind_e VpiCbHdl::get_kind() const {
+    switch (cb_data.reason) {
+        case cbAfterDelay:
+            return GPI_CB_TIMED;
+        case cbValueChange:
+            return GPI_CB_VALUE_CHANGE;
+        case cbReadWriteSynch:
+            return GPI_CB_READWRITE;
+        case cbReadOnlySynch:
+            return GPI_CB_READONLY;
+        case cbNextSimTime:
+            return GPI_CB_NEXTTIME;
+        default:
+            return GPI_CB_OTHER;
+    }
+}
+
 
 VpiStartupCbHdl::VpiStartupCbHdl() {
     cb_data.reason = cbStartOfSimulation;
@@ -363,6 +440,28 @@ int VpiStartupCbHdl::run_callback() {
     return 0;
 }
 
+VpiShutdownCbHdl::VpiShutdownCbHdl() {
+    cb_data.reason = cbEndOfSimulation;
+}
+
+int VpiShutdownCbHdl::run_callback() {
+    // COCOTB_STATS不为空也不为"0"时输出计数器
+    const char *stats = getenv("COCOTB_STATS");
+    if (stats && *stats && strcmp(stats, "0") != 0) {
+        gpi_log_stats();
+    }
+    gpi_hist_log();
+    gpi_meter_stop();
+    // COCOTB_LEAK_REPORT不为空也不为"0"时输出还活着的对象
+    const char *leaks = getenv("COCOTB_LEAK_REPORT");
+    if (leaks && *leaks && strcmp(leaks, "0") != 0) {
+        gpi_log_live_objects(10);
+    }
+    gpi_run_sim_end_hooks();
+    gpi_trace_close();
+    return 0;
+}
+
 VpiTimedCbHdl::VpiTimedCbHdl(uint64_t time) {
     vpi_time.high = (uint32_t)(time >> 32);
     vpi_time.low = (uint32_t)(time);
@@ -371,6 +470,17 @@ VpiTimedCbHdl::VpiTimedCbHdl(uint64_t time) {
     cb_data.reason = cbAfterDelay;
 }
 
+int VpiPeriodicCbHdl::run_callback() {
+    this->gpi_function(m_cb_data);
+
+    // 回调里没有被注销的话就再等一个周期，handle_vpi_callback_看到
+    // GPI_PRIMED就不会再清理它
+    if (m_state == GPI_CALL) {
+        arm_callback();
+    }
+    return 0;
+}
+
 VpiValueCbHdl::VpiValueCbHdl(GpiImplInterface *impl, VpiSignalObjHdl *sig,
                              gpi_edge_e edge) {
     vpi_time.type = vpiSuppressTime;
@@ -419,15 +529,25 @@ int VpiValueCbHdl::run_callback() {
 }
 
 
+int VpiValueWatchCbHdl::run_callback() {
+    this->gpi_function(m_cb_data);
+
+    if (m_state == GPI_CALL) {
+        m_state = GPI_PRIMED;
+    }
+    return 0;
+}
+
 int VpiValueCbHdl::cleanup_callback() {
     if (m_state == GPI_FREE) return 0;
 
     /* This is a recurring callback so just remove when
      * not wanted */
-    if (!(vpi_remove_cb(get_handle<vpiHandle>()))) {
+    if (!(gpi_vpi_remove_cb(get_handle<vpiHandle>()))) {
         LOG_ERROR("VPI: unable to remove callback");
         return -1;
     }
+    ++gpi_stats.cb_removed[get_kind()];
 
     m_obj_hdl = NULL;
     m_state = GPI_FREE;
@@ -444,4 +564,29 @@ VpiReadWriteCbHdl::VpiReadWriteCbHdl() {
 
 VpiReadOnlyCbHdl::VpiReadOnlyCbHdl() {
     cb_data.reason = cbReadOnlySynch;
+}
+
+int VpiWakeupCbHdl::arm_callback() {
+    m_obj_hdl = NULL;
+    m_state = GPI_PRIMED;
+    return 0;
+}
+
+int VpiWakeupCbHdl::fire() {
+    // 没有挂起，或者这个时间步已经注册过
+    if (m_state != GPI_PRIMED || m_obj_hdl) return 0;
+    return VpiCbHdl::arm_callback();
+}
+
+int VpiWakeupCbHdl::cleanup_callback() {
+    if (m_state == GPI_PRIMED && !m_obj_hdl) {
+        m_state = GPI_FREE;
+        return 0;
+    }
+    // 出错时也不能让分发函数delete它
+    if (VpiCbHdl::cleanup_callback()) {
+        m_obj_hdl = NULL;
+        m_state = GPI_FREE;
+    }
+    return 0;
 }
\ No newline at end of file
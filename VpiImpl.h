@@ -21,6 +21,83 @@
 
 // #define PATH_MAX 256
 
+// 给用到的VPI函数计数：GPI层调用这些包装，而不是直接调用VPI函数
+static inline PLI_INT32 gpi_vpi_get(PLI_INT32 property, vpiHandle object) {
+    ++gpi_stats.vpi_calls[GPI_VPI_GET];
+    return vpi_get(property, object);
+}
+
+static inline PLI_BYTE8 *gpi_vpi_get_str(PLI_INT32 property,
+                                         vpiHandle object) {
+    ++gpi_stats.vpi_calls[GPI_VPI_GET_STR];
+    return vpi_get_str(property, object);
+}
+
+static inline void gpi_vpi_get_value(vpiHandle expr, p_vpi_value value_p) {
+    ++gpi_stats.vpi_calls[GPI_VPI_GET_VALUE];
+    vpi_get_value(expr, value_p);
+}
+
+static inline vpiHandle gpi_vpi_put_value(vpiHandle object,
+                                          p_vpi_value value_p,
+                                          p_vpi_time time_p, PLI_INT32 flags) {
+    ++gpi_stats.vpi_calls[GPI_VPI_PUT_VALUE];
+    return vpi_put_value(object, value_p, time_p, flags);
+}
+
+static inline void gpi_vpi_get_time(vpiHandle object, p_vpi_time time_p) {
+    ++gpi_stats.vpi_calls[GPI_VPI_GET_TIME];
+    vpi_get_time(object, time_p);
+}
+
+static inline vpiHandle gpi_vpi_handle(PLI_INT32 type, vpiHandle ref) {
+    ++gpi_stats.vpi_calls[GPI_VPI_HANDLE];
+    return vpi_handle(type, ref);
+}
+
+static inline vpiHandle gpi_vpi_handle_by_name(PLI_BYTE8 *name,
+                                               vpiHandle scope) {
+    ++gpi_stats.vpi_calls[GPI_VPI_HANDLE_BY_NAME];
+    return vpi_handle_by_name(name, scope);
+}
+
+static inline vpiHandle gpi_vpi_handle_by_index(vpiHandle object,
+                                                PLI_INT32 index) {
+    ++gpi_stats.vpi_calls[GPI_VPI_HANDLE_BY_INDEX];
+    return vpi_handle_by_index(object, index);
+}
+
+static inline vpiHandle gpi_vpi_iterate(PLI_INT32 type, vpiHandle ref) {
+    ++gpi_stats.vpi_calls[GPI_VPI_ITERATE];
+    return vpi_iterate(type, ref);
+}
+
+static inline vpiHandle gpi_vpi_scan(vpiHandle iterator) {
+    ++gpi_stats.vpi_calls[GPI_VPI_SCAN];
+    return vpi_scan(iterator);
+}
+
+static inline PLI_INT32 gpi_vpi_free_object(vpiHandle object) {
+    ++gpi_stats.vpi_calls[GPI_VPI_FREE_OBJECT];
+    return vpi_free_object(object);
+}
+
+static inline vpiHandle gpi_vpi_register_cb(p_cb_data cb_data_p) {
+    ++gpi_stats.vpi_calls[GPI_VPI_REGISTER_CB];
+    return vpi_register_cb(cb_data_p);
+}
+
+static inline PLI_INT32 gpi_vpi_remove_cb(vpiHandle cb_obj) {
+    ++gpi_stats.vpi_calls[GPI_VPI_REMOVE_CB];
+    return vpi_remove_cb(cb_obj);
+}
+
+// vpi_control是变参函数，这里只用到带一个参数的操作（vpiFinish等）
+static inline PLI_INT32 gpi_vpi_control(PLI_INT32 operation, PLI_INT32 arg) {
+    ++gpi_stats.vpi_calls[GPI_VPI_CONTROL];
+    return vpi_control(operation, arg);
+}
+
 #define to_python() do { LOG_TRACE("Returning to Python"); } while (0)
 #define to_simulator() do { LOG_TRACE("Returning to simulator"); } while (0)
 
@@ -48,12 +125,16 @@ constexpr Deferable<F> make_deferable(F f) {
 class VpiCbHdl {
   public:
     VpiCbHdl();
+    // 子类VpiValueCbHdl有string成员，要通过基类指针delete
+    virtual ~VpiCbHdl();
 
     virtual int arm_callback();
     virtual int run_callback();
     virtual int cleanup_callback();
     void set_call_state(gpi_cb_state_e new_state);
     gpi_cb_state_e get_call_state();
+    // 回调的种类，用于gpi_stats的计数
+    gpi_cb_kind_e get_kind() const;
 
     int set_user_data(int (*function)(void *), void *cb_data);
     void *get_user_data() noexcept { return m_cb_data; };
@@ -79,11 +160,27 @@ class VpiStartupCbHdl : public VpiCbHdl
     int run_callback() override;
 };
 
+// 仿真结束时触发，输出gpi_stats等运行统计
+class VpiShutdownCbHdl : public VpiCbHdl
+{
+  public:
+    VpiShutdownCbHdl();
+    int run_callback() override;
+};
+
 class VpiTimedCbHdl : public VpiCbHdl {
   public:
     VpiTimedCbHdl(uint64_t time);
 };
 
+// 周期性的定时回调：每次触发后以同样的间隔重新注册自己，
+// 直到被gpi_deregister_callback注销
+class VpiPeriodicCbHdl : public VpiTimedCbHdl {
+  public:
+    VpiPeriodicCbHdl(uint64_t period) : VpiTimedCbHdl(period) {}
+    int run_callback() override;
+};
+
 class VpiValueCbHdl : public VpiCbHdl {
   public:
     VpiValueCbHdl(GpiImplInterface *impl, VpiSignalObjHdl *sig,
@@ -97,6 +194,15 @@ class VpiValueCbHdl : public VpiCbHdl {
     std::string required_value;
 };
 
+// 不检查边沿、触发后不注销的值变化回调：cbValueChange本身在VPI里一直有效，
+// 每次触发后只需要回到GPI_PRIMED，直到被gpi_deregister_callback注销
+class VpiValueWatchCbHdl : public VpiValueCbHdl {
+  public:
+    VpiValueWatchCbHdl(GpiImplInterface *impl, VpiSignalObjHdl *sig)
+        : VpiValueCbHdl(impl, sig, GPI_VALUE_CHANGE) {}
+    int run_callback() override;
+};
+
 class VpiNextPhaseCbHdl : public VpiCbHdl {
   public:
     VpiNextPhaseCbHdl();
@@ -112,6 +218,15 @@ class VpiReadOnlyCbHdl : public VpiCbHdl {
     VpiReadOnlyCbHdl();
 };
 
+// 挂起时只标记为GPI_PRIMED，fire()时才向仿真器注册cbReadOnlySynch，
+// 这样没有值变化的时间步里不会进入Python。由创建者持有，不会被回调分发时delete
+class VpiWakeupCbHdl : public VpiReadOnlyCbHdl {
+  public:
+    int arm_callback() override;
+    int cleanup_callback() override;
+    int fire();
+};
+
 #define gpi_to_user()  do { vpi_printf("Passing control to GPI user\n"); } while (0)
 #define gpi_to_simulator() do { vpi_printf("Return control to simulator\n"); } while (0)
 
@@ -14,11 +14,11 @@
 
 int VpiSignalObjHdl::initialise(const std::string &name,
                                 const std::string &fq_name) {
-    int32_t type = vpi_get(vpiType, GpiObjHdl::get_handle<vpiHandle>());
+    int32_t type = gpi_vpi_get(vpiType, GpiObjHdl::get_handle<vpiHandle>());
     if ((vpiIntegerVar == type)) {
         m_num_elems = 1;
     } else {
-        m_num_elems = vpi_get(vpiSize, GpiObjHdl::get_handle<vpiHandle>());
+        m_num_elems = gpi_vpi_get(vpiSize, GpiObjHdl::get_handle<vpiHandle>());
 
         if (GpiObjHdl::get_type() == GPI_STRING || type == vpiConstant ||
             type == vpiParameter) {
@@ -28,7 +28,7 @@ int VpiSignalObjHdl::initialise(const std::string &name,
         } else if (GpiObjHdl::get_type() == GPI_LOGIC ||
                    GpiObjHdl::get_type() == GPI_LOGIC_ARRAY) {
             vpiHandle hdl = GpiObjHdl::get_handle<vpiHandle>();
-            m_indexable = vpi_get(vpiVector, hdl);
+            m_indexable = gpi_vpi_get(vpiVector, hdl);
 
             if (m_indexable) {
                 s_vpi_value val;
@@ -36,40 +36,40 @@ int VpiSignalObjHdl::initialise(const std::string &name,
 
                 val.format = vpiIntVal;
                 const int vpiRange = 115;
-                iter = vpi_iterate(vpiRange, hdl);
+                iter = gpi_vpi_iterate(vpiRange, hdl);
 
                 /* Only ever need the first "range" */
                 if (iter != NULL) {
-                    vpiHandle rangeHdl = vpi_scan(iter);
+                    vpiHandle rangeHdl = gpi_vpi_scan(iter);
 
-                    vpi_free_object(iter);
+                    gpi_vpi_free_object(iter);
 
                     if (rangeHdl != NULL) {
-                        vpi_get_value(vpi_handle(vpiLeftRange, rangeHdl), &val);
+                        gpi_vpi_get_value(gpi_vpi_handle(vpiLeftRange, rangeHdl), &val);
                         check_vpi_error();
                         m_range_left = val.value.integer;
 
-                        vpi_get_value(vpi_handle(vpiRightRange, rangeHdl),
+                        gpi_vpi_get_value(gpi_vpi_handle(vpiRightRange, rangeHdl),
                                       &val);
                         check_vpi_error();
                         m_range_right = val.value.integer;
                     } else {
                         LOG_ERROR(
                             "VPI: Unable to get range for %s of type %s (%d)",
-                            name.c_str(), vpi_get_str(vpiType, hdl), type);
+                            name.c_str(), gpi_vpi_get_str(vpiType, hdl), type);
                         return -1;
                     }
                 } else {
-                    vpiHandle leftRange = vpi_handle(vpiLeftRange, hdl);
+                    vpiHandle leftRange = gpi_vpi_handle(vpiLeftRange, hdl);
                     check_vpi_error();
-                    vpiHandle rightRange = vpi_handle(vpiRightRange, hdl);
+                    vpiHandle rightRange = gpi_vpi_handle(vpiRightRange, hdl);
                     check_vpi_error();
 
                     if (leftRange != NULL and rightRange != NULL) {
-                        vpi_get_value(leftRange, &val);
+                        gpi_vpi_get_value(leftRange, &val);
                         m_range_left = val.value.integer;
 
-                        vpi_get_value(rightRange, &val);
+                        gpi_vpi_get_value(rightRange, &val);
                         m_range_right = val.value.integer;
                     } else {
                         LOG_WARN(
@@ -99,12 +99,24 @@ int VpiSignalObjHdl::initialise(const std::string &name,
 const char *VpiSignalObjHdl::get_signal_value_binstr() {
     s_vpi_value value_s = {vpiBinStrVal, {NULL}};
 
-    vpi_get_value(GpiObjHdl::get_handle<vpiHandle>(), &value_s);
+    gpi_vpi_get_value(GpiObjHdl::get_handle<vpiHandle>(), &value_s);
     check_vpi_error();
 
     return value_s.value.str;
 }
 
+static_assert(sizeof(gpi_vecval) == sizeof(s_vpi_vecval),
+              "gpi_vecval must have the layout of s_vpi_vecval");
+
+const gpi_vecval *VpiSignalObjHdl::get_signal_value_vecval() {
+    s_vpi_value value_s = {vpiVectorVal, {NULL}};
+
+    gpi_vpi_get_value(GpiObjHdl::get_handle<vpiHandle>(), &value_s);
+    check_vpi_error();
+
+    return reinterpret_cast<const gpi_vecval *>(value_s.value.vector);
+}
+
 // Value related functions
 int VpiSignalObjHdl::set_signal_value(int32_t value, gpi_set_action_t action) {
     s_vpi_value value_s;
@@ -137,6 +149,18 @@ int VpiSignalObjHdl::set_signal_value_binstr(std::string &value,
     return set_signal_value(value_s, action);
 }
 
+int VpiSignalObjHdl::set_signal_value_vecval(const gpi_vecval *value,
+                                             gpi_set_action_t action) {
+    s_vpi_value value_s;
+
+    // vpi_put_value不会修改传入的值
+    value_s.value.vector =
+        reinterpret_cast<p_vpi_vecval>(const_cast<gpi_vecval *>(value));
+    value_s.format = vpiVectorVal;
+
+    return set_signal_value(value_s, action);
+}
+
 
 int VpiSignalObjHdl::set_signal_value(s_vpi_value value_s,
                                       gpi_set_action_t action) {
@@ -153,7 +177,7 @@ int VpiSignalObjHdl::set_signal_value(s_vpi_value value_s,
             // Xcelium and Questa do not like setting string variables using
             // vpiInertialDelay.
             if (vpiStringVar ==
-                vpi_get(vpiType, GpiObjHdl::get_handle<vpiHandle>())) {
+                gpi_vpi_get(vpiType, GpiObjHdl::get_handle<vpiHandle>())) {
                 vpi_put_flag = vpiNoDelay;
             } else {
                 vpi_put_flag = vpiInertialDelay;
@@ -167,7 +191,7 @@ int VpiSignalObjHdl::set_signal_value(s_vpi_value value_s,
             break;
         case GPI_RELEASE:
             // Best to pass its current value to the sim when releasing
-            vpi_get_value(GpiObjHdl::get_handle<vpiHandle>(), &value_s);
+            gpi_vpi_get_value(GpiObjHdl::get_handle<vpiHandle>(), &value_s);
             vpi_put_flag = vpiReleaseFlag;
             break;
         case GPI_NO_DELAY:
@@ -178,10 +202,10 @@ int VpiSignalObjHdl::set_signal_value(s_vpi_value value_s,
     }
 
     if (vpi_put_flag == vpiNoDelay) {
-        vpi_put_value(GpiObjHdl::get_handle<vpiHandle>(), &value_s, NULL,
+        gpi_vpi_put_value(GpiObjHdl::get_handle<vpiHandle>(), &value_s, NULL,
                       vpiNoDelay);
     } else {
-        vpi_put_value(GpiObjHdl::get_handle<vpiHandle>(), &value_s, &vpi_time_s,
+        gpi_vpi_put_value(GpiObjHdl::get_handle<vpiHandle>(), &value_s, &vpi_time_s,
                       vpi_put_flag);
     }
 
@@ -210,7 +234,7 @@ int VpiArrayObjHdl::initialise(const std::string &name,
 
    /* Need to determine if this is a pseudo-handle to be able to select the
     * correct range */
-   std::string hdl_name = vpi_get_str(vpiName, hdl);
+   std::string hdl_name = gpi_vpi_get_str(vpiName, hdl);
 
    /* Removing the hdl_name from the name will leave the pseudo-indices */
    if (hdl_name.length() < name.length()) {
@@ -229,14 +253,14 @@ int VpiArrayObjHdl::initialise(const std::string &name,
 
    /* After determining the range_idx, get the range and set the limits */
    const int vpiRange = 115;
-   vpiHandle iter = vpi_iterate(vpiRange, hdl);
+   vpiHandle iter = gpi_vpi_iterate(vpiRange, hdl);
    vpiHandle rangeHdl;
 
    if (iter != NULL) {
-       rangeHdl = vpi_scan(iter);
+       rangeHdl = gpi_vpi_scan(iter);
 
        for (int i = 0; i < range_idx; ++i) {
-           rangeHdl = vpi_scan(iter);
+           rangeHdl = gpi_vpi_scan(iter);
            if (rangeHdl == NULL) {
                break;
            }
@@ -245,7 +269,7 @@ int VpiArrayObjHdl::initialise(const std::string &name,
            LOG_ERROR("Unable to get range for indexable array");
            return -1;
        }
-       vpi_free_object(iter);  // Need to free iterator since exited early
+       gpi_vpi_free_object(iter);  // Need to free iterator since exited early
    } else if (range_idx == 0) {
        rangeHdl = hdl;
    } else {
@@ -255,11 +279,11 @@ int VpiArrayObjHdl::initialise(const std::string &name,
 
    s_vpi_value val;
    val.format = vpiIntVal;
-   vpi_get_value(vpi_handle(vpiLeftRange, rangeHdl), &val);
+   gpi_vpi_get_value(gpi_vpi_handle(vpiLeftRange, rangeHdl), &val);
    check_vpi_error();
    m_range_left = val.value.integer;
 
-   vpi_get_value(vpi_handle(vpiRightRange, rangeHdl), &val);
+   gpi_vpi_get_value(gpi_vpi_handle(vpiRightRange, rangeHdl), &val);
    check_vpi_error();
    m_range_right = val.value.integer;
 
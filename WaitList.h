@@ -0,0 +1,56 @@
+// 侵入式的等待队列：挂在trigger（或者trigger对应的GPI回调记录）上，保存等待这个
+// trigger的tasks，SchedulerCore在trigger触发时一次性把整个队列放进就绪队列。
+#ifndef MYCOCOTB_WAIT_LIST_H_
+#define MYCOCOTB_WAIT_LIST_H_
+
+#include <Python.h>
+
+#include <vector>
+
+struct WaitList {
+    WaitList() = default;
+    WaitList(const WaitList &) = delete;
+    WaitList &operator=(const WaitList &) = delete;
+    ~WaitList() { clear(); }
+
+    std::vector<PyObject *> waiters;  // Tasks waiting, strong references
+    PyObject *trigger = nullptr;      // The trigger they wait on, borrowed
+
+    // 非空的等待队列通过prev/next串在SchedulerCore的循环链表上，
+    // 清理的时候要能遍历到它们
+    WaitList *prev = nullptr;
+    WaitList *next = nullptr;
+
+    bool linked() const { return prev != nullptr; }
+
+    void link_after(WaitList *head) {
+        prev = head;
+        next = head->next;
+        head->next->prev = this;
+        head->next = this;
+    }
+
+    void unlink() {
+        if (linked()) {
+            prev->next = next;
+            next->prev = prev;
+            prev = next = nullptr;
+        }
+    }
+
+    /** Move the waiting tasks out and unlink, the caller owns the references */
+    std::vector<PyObject *> take() {
+        std::vector<PyObject *> tasks;
+        tasks.swap(waiters);
+        unlink();
+        return tasks;
+    }
+
+    void clear() {
+        for (PyObject *task : take()) {
+            Py_DECREF(task);
+        }
+    }
+};
+
+#endif /* MYCOCOTB_WAIT_LIST_H_ */
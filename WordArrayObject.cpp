@@ -0,0 +1,487 @@
+/******************************************************************************
+ * @file   WordArrayObject.cpp
+ * @brief  Typed storage of fixed-width elements for mycocotb.types.Array
+ *
+ * The elements of a memory or an array of vectors are all LogicArray of the
+ * same width. A WordArray keeps each of them as one uint32 or uint64 in a
+ * buffer allocated together with the object, plus a second WordArray with
+ * the X/Z bits which only exists once such a bit is stored. Reading a whole
+ * memory is then one allocation, and LogicArray objects are only created
+ * for the elements which are actually accessed. The buffer protocol exposes
+ * the values, so numpy can use them without a copy.
+ */
+
+#include "WordArrayObject.h"
+
+#include <structmember.h>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+inline uint64_t width_mask(int width) {
+    return width == 64 ? ~0ull : ((1ull << width) - 1);
+}
+
+inline uint64_t load(const WordArrayObject *self, const char *values,
+                     Py_ssize_t i) {
+    if (self->itemsize == 4) {
+        uint32_t v;
+        std::memcpy(&v, values + i * 4, 4);
+        return v;
+    }
+    uint64_t v;
+    std::memcpy(&v, values + i * 8, 8);
+    return v;
+}
+
+inline void store(const WordArrayObject *self, char *values, Py_ssize_t i,
+                  uint64_t v) {
+    if (self->itemsize == 4) {
+        uint32_t w = (uint32_t)v;
+        std::memcpy(values + i * 4, &w, 4);
+    } else {
+        std::memcpy(values + i * 8, &v, 8);
+    }
+}
+
+/** The planes of element *i* */
+void get_planes(const WordArrayObject *self, Py_ssize_t i, uint64_t &a,
+                uint64_t &b) {
+    // 通过缓冲区写进来的值可能超出width，读的时候截掉
+    uint64_t mask = width_mask(self->width);
+    a = load(self, self->values, i) & mask;
+    b = self->mask != NULL ? load(self, self->mask->values, i) & mask : 0;
+}
+
+int set_planes(WordArrayObject *self, Py_ssize_t i, uint64_t a, uint64_t b) {
+    uint64_t mask = width_mask(self->width);
+    if (b != 0 && self->mask == NULL) {
+        self->mask = word_array_new(self->length, self->width);
+        if (self->mask == NULL) {
+            return -1;
+        }
+    }
+    store(self, self->values, i, a & mask);
+    if (self->mask != NULL) {
+        store(self, self->mask->values, i, b & mask);
+    }
+    return 0;
+}
+
+/** Planes of an element value, a LogicArray of the element width or an int */
+int planes_of(WordArrayObject *self, PyObject *value, uint64_t &a,
+              uint64_t &b) {
+    if (LogicArrayObject_Check(value)) {
+        LogicArrayObject *array = (LogicArrayObject *)value;
+        if (array->n_bits != self->width) {
+            PyErr_Format(PyExc_ValueError,
+                         "Expected a LogicArray of %d bits, not %zd",
+                         self->width, array->n_bits);
+            return -1;
+        }
+        if (array->nine != NULL) {
+            PyErr_SetString(PyExc_TypeError,
+                            "WordArray elements can only hold 0, 1, X and Z");
+            return -1;
+        }
+        // 64位以内的LogicArray不会是视图
+        const LogicWord *words = array->words;
+        a = words[0].aval;
+        b = words[0].bval;
+        if (self->width > 32) {
+            a |= (uint64_t)words[1].aval << 32;
+            b |= (uint64_t)words[1].bval << 32;
+        }
+        return 0;
+    }
+    if (PyLong_Check(value)) {
+        a = PyLong_AsUnsignedLongLong(value);
+        if (a == (uint64_t)-1 && PyErr_Occurred()) {
+            if (!PyErr_ExceptionMatches(PyExc_OverflowError)) {
+                return -1;
+            }
+            PyErr_Clear();
+        } else if ((a & ~width_mask(self->width)) == 0) {
+            b = 0;
+            return 0;
+        }
+        PyErr_Format(PyExc_ValueError, "%R does not fit in %d bits", value,
+                     self->width);
+        return -1;
+    }
+    PyErr_Format(PyExc_TypeError, "Expected LogicArray or int, not %s",
+                 Py_TYPE(value)->tp_name);
+    return -1;
+}
+
+PyObject *get_item(WordArrayObject *self, Py_ssize_t i) {
+    uint64_t a, b;
+    get_planes(self, i, a, b);
+    LogicWord words[2] = {{(uint32_t)a, (uint32_t)b},
+                          {(uint32_t)(a >> 32), (uint32_t)(b >> 32)}};
+    return logic_array_from_words(words, self->width);
+}
+
+/** Normalize a negative index, checking it is in range */
+bool check_index(WordArrayObject *self, Py_ssize_t &i) {
+    if (i < 0) {
+        i += self->length;
+    }
+    if (i < 0 || i >= self->length) {
+        PyErr_SetString(PyExc_IndexError, "WordArray index out of range");
+        return false;
+    }
+    return true;
+}
+
+PyObject *word_array_new_py(PyTypeObject *, PyObject *args, PyObject *kwargs) {
+    static const char *kwlist[] = {"length", "width", NULL};
+    Py_ssize_t length;
+    int width;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "ni:WordArray",
+                                     (char **)kwlist, &length, &width)) {
+        return NULL;
+    }
+    if (length < 0 || width < 1 || width > 64) {
+        PyErr_SetString(PyExc_ValueError,
+                        "length must be >= 0 and width from 1 to 64");
+        return NULL;
+    }
+    return (PyObject *)word_array_new(length, width);
+}
+
+void word_array_dealloc(WordArrayObject *self) {
+    Py_XDECREF(self->mask);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+Py_ssize_t word_array_length(WordArrayObject *self) { return self->length; }
+
+PyObject *word_array_item(WordArrayObject *self, Py_ssize_t i) {
+    if (!check_index(self, i)) {
+        return NULL;
+    }
+    return get_item(self, i);
+}
+
+PyObject *word_array_subscript(WordArrayObject *self, PyObject *key) {
+    if (PyIndex_Check(key)) {
+        Py_ssize_t i = PyNumber_AsSsize_t(key, PyExc_IndexError);
+        if (i == -1 && PyErr_Occurred()) {
+            return NULL;
+        }
+        return word_array_item(self, i);
+    }
+    if (!PySlice_Check(key)) {
+        PyErr_Format(PyExc_TypeError, "indices must be integers or slices, not %s",
+                     Py_TYPE(key)->tp_name);
+        return NULL;
+    }
+    Py_ssize_t start, stop, step;
+    if (PySlice_Unpack(key, &start, &stop, &step) < 0) {
+        return NULL;
+    }
+    Py_ssize_t n = PySlice_AdjustIndices(self->length, &start, &stop, step);
+    WordArrayObject *result = word_array_new(n, self->width);
+    if (result == NULL) {
+        return NULL;
+    }
+    if (step == 1) {
+        std::memcpy(result->values, self->values + start * self->itemsize,
+                    n * self->itemsize);
+    } else {
+        for (Py_ssize_t k = 0; k < n; k++) {
+            store(result, result->values, k,
+                  load(self, self->values, start + k * step));
+        }
+    }
+    if (self->mask != NULL) {
+        // 子数组里也可能没有X/Z，这时mask是多余的，但不影响结果
+        PyObject *mask = word_array_subscript(self->mask, key);
+        if (mask == NULL) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        result->mask = (WordArrayObject *)mask;
+    }
+    return (PyObject *)result;
+}
+
+int word_array_ass_item(WordArrayObject *self, Py_ssize_t i, PyObject *value) {
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "WordArray elements can't be deleted");
+        return -1;
+    }
+    if (!check_index(self, i)) {
+        return -1;
+    }
+    uint64_t a, b;
+    if (planes_of(self, value, a, b) < 0) {
+        return -1;
+    }
+    return set_planes(self, i, a, b);
+}
+
+int word_array_ass_subscript(WordArrayObject *self, PyObject *key,
+                             PyObject *value) {
+    if (PyIndex_Check(key)) {
+        Py_ssize_t i = PyNumber_AsSsize_t(key, PyExc_IndexError);
+        if (i == -1 && PyErr_Occurred()) {
+            return -1;
+        }
+        return word_array_ass_item(self, i, value);
+    }
+    if (!PySlice_Check(key)) {
+        PyErr_Format(PyExc_TypeError, "indices must be integers or slices, not %s",
+                     Py_TYPE(key)->tp_name);
+        return -1;
+    }
+    if (value == NULL) {
+        PyErr_SetString(PyExc_TypeError, "WordArray elements can't be deleted");
+        return -1;
+    }
+    Py_ssize_t start, stop, step;
+    if (PySlice_Unpack(key, &start, &stop, &step) < 0) {
+        return -1;
+    }
+    Py_ssize_t n = PySlice_AdjustIndices(self->length, &start, &stop, step);
+    PyObject *seq = PySequence_Fast(value, "can only assign an iterable");
+    if (seq == NULL) {
+        return -1;
+    }
+    if (PySequence_Fast_GET_SIZE(seq) != n) {
+        PyErr_Format(PyExc_ValueError,
+                     "can't assign %zd elements to a slice of %zd",
+                     PySequence_Fast_GET_SIZE(seq), n);
+        Py_DECREF(seq);
+        return -1;
+    }
+    // 先全部转换，出错时不改动数组
+    std::vector<uint64_t> planes(2 * n);
+    PyObject **items = PySequence_Fast_ITEMS(seq);
+    for (Py_ssize_t k = 0; k < n; k++) {
+        if (planes_of(self, items[k], planes[2 * k], planes[2 * k + 1]) < 0) {
+            Py_DECREF(seq);
+            return -1;
+        }
+    }
+    Py_DECREF(seq);
+    for (Py_ssize_t k = 0; k < n; k++) {
+        if (set_planes(self, start + k * step, planes[2 * k],
+                       planes[2 * k + 1]) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/** Whether the mask of *self* has no bits set */
+bool mask_is_clear(const WordArrayObject *self) {
+    if (self->mask == NULL) {
+        return true;
+    }
+    for (Py_ssize_t i = 0; i < self->length; i++) {
+        if (load(self, self->mask->values, i) & width_mask(self->width)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool same_elements(const WordArrayObject *x, const WordArrayObject *y) {
+    if (x->length != y->length) {
+        return false;
+    }
+    if (x->length == 0) {
+        return true;
+    }
+    if (x->width != y->width) {
+        // 宽度不同的LogicArray不相等
+        return false;
+    }
+    for (Py_ssize_t i = 0; i < x->length; i++) {
+        uint64_t ax, bx, ay, by;
+        get_planes(x, i, ax, bx);
+        get_planes(y, i, ay, by);
+        if (ax != ay || bx != by) {
+            return false;
+        }
+    }
+    return true;
+}
+
+PyObject *word_array_richcompare(WordArrayObject *self, PyObject *other,
+                                 int op) {
+    if (op != Py_EQ && op != Py_NE) {
+        Py_RETURN_NOTIMPLEMENTED;
+    }
+    bool equal;
+    if (WordArrayObject_Check(other)) {
+        equal = same_elements(self, (WordArrayObject *)other);
+    } else if (PyList_Check(other) || PyTuple_Check(other)) {
+        // 和普通的元素序列逐个比较
+        Py_ssize_t n = PySequence_Fast_GET_SIZE(other);
+        equal = n == self->length;
+        PyObject **items = PySequence_Fast_ITEMS(other);
+        for (Py_ssize_t i = 0; equal && i < n; i++) {
+            PyObject *item = get_item(self, i);
+            if (item == NULL) {
+                return NULL;
+            }
+            int rc = PyObject_RichCompareBool(item, items[i], Py_EQ);
+            Py_DECREF(item);
+            if (rc < 0) {
+                return NULL;
+            }
+            equal = rc;
+        }
+    } else {
+        Py_RETURN_NOTIMPLEMENTED;
+    }
+    return PyBool_FromLong(equal == (op == Py_EQ));
+}
+
+PyObject *word_array_repr(WordArrayObject *self) {
+    PyObject *list = PySequence_List((PyObject *)self);
+    if (list == NULL) {
+        return NULL;
+    }
+    PyObject *result = PyObject_Repr(list);
+    Py_DECREF(list);
+    return result;
+}
+
+int word_array_getbuffer(WordArrayObject *self, Py_buffer *view, int flags) {
+    Py_INCREF(self);
+    view->obj = (PyObject *)self;
+    view->buf = self->values;
+    view->len = self->length * self->itemsize;
+    view->readonly = 0;
+    view->itemsize = self->itemsize;
+    view->format = (flags & PyBUF_FORMAT)
+                       ? (char *)(self->itemsize == 4 ? "I" : "Q")
+                       : NULL;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? &self->length : NULL;
+    view->strides = (flags & PyBUF_STRIDES) ? &self->itemsize : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    return 0;
+}
+
+PyObject *word_array_get_mask(WordArrayObject *self, void *) {
+    if (mask_is_clear(self)) {
+        Py_RETURN_NONE;
+    }
+    Py_INCREF(self->mask);
+    return (PyObject *)self->mask;
+}
+
+PyGetSetDef word_array_getsets[] = {
+    {"mask", (getter)word_array_get_mask, NULL,
+     PyDoc_STR("A :class:`WordArray` with the X and Z bits of the elements, "
+               "``None`` if every bit is ``0`` or ``1``.\n"
+               "\n"
+               "A bit is X if it is also set in the values, otherwise Z."),
+     NULL},
+    {NULL, NULL, NULL, NULL, NULL} /* Sentinel */
+};
+
+PyMemberDef word_array_members[] = {
+    {"width", T_INT, offsetof(WordArrayObject, width), READONLY,
+     PyDoc_STR("Number of bits of each element.")},
+    {NULL, 0, 0, 0, NULL} /* Sentinel */
+};
+
+PySequenceMethods word_array_as_sequence = []() -> PySequenceMethods {
+    PySequenceMethods methods = {};
+    methods.sq_length = (lenfunc)word_array_length;
+    methods.sq_item = (ssizeargfunc)word_array_item;
+    methods.sq_ass_item = (ssizeobjargproc)word_array_ass_item;
+    return methods;
+}();
+
+PyMappingMethods word_array_as_mapping = []() -> PyMappingMethods {
+    PyMappingMethods methods = {};
+    methods.mp_length = (lenfunc)word_array_length;
+    methods.mp_subscript = (binaryfunc)word_array_subscript;
+    methods.mp_ass_subscript = (objobjargproc)word_array_ass_subscript;
+    return methods;
+}();
+
+PyBufferProcs word_array_as_buffer = []() -> PyBufferProcs {
+    PyBufferProcs procs = {};
+    procs.bf_getbuffer = (getbufferproc)word_array_getbuffer;
+    return procs;
+}();
+
+}  // namespace
+
+PyTypeObject WordArray_type = []() -> PyTypeObject {
+    PyTypeObject type = {};
+    type.ob_base = {PyObject_HEAD_INIT(NULL) 0};
+    type.tp_name = "mycocotb.simulator.WordArray";
+    type.tp_doc =
+        "WordArray(length, width)\n"
+        "--\n"
+        "\n"
+        "Elements of *width* bits (at most 64) stored as unsigned integers\n"
+        "in one contiguous buffer, used as the storage of an\n"
+        ":class:`~mycocotb.types.Array` of :class:`~mycocotb.types.LogicArray`.\n"
+        "\n"
+        "Indexing returns a new LogicArray. The buffer protocol exposes the\n"
+        "values as ``uint32`` or ``uint64``, and :attr:`mask` the X/Z bits.";
+    type.tp_basicsize = offsetof(WordArrayObject, values);
+    type.tp_itemsize = 1;
+    type.tp_flags = Py_TPFLAGS_DEFAULT;
+    type.tp_new = word_array_new_py;
+    type.tp_dealloc = (destructor)word_array_dealloc;
+    type.tp_as_sequence = &word_array_as_sequence;
+    type.tp_as_mapping = &word_array_as_mapping;
+    type.tp_as_buffer = &word_array_as_buffer;
+    type.tp_richcompare = (richcmpfunc)word_array_richcompare;
+    type.tp_hash = PyObject_HashNotImplemented;
+    type.tp_repr = (reprfunc)word_array_repr;
+    type.tp_getset = word_array_getsets;
+    type.tp_members = word_array_members;
+    return type;
+}();
+
+WordArrayObject *word_array_new(Py_ssize_t length, int width) {
+    Py_ssize_t itemsize = width > 32 ? 8 : 4;
+    // tp_alloc把值清零
+    WordArrayObject *self = (WordArrayObject *)WordArray_type.tp_alloc(
+        &WordArray_type, length * itemsize);
+    if (self == NULL) {
+        return NULL;
+    }
+    self->length = length;
+    self->width = width;
+    self->itemsize = itemsize;
+    return self;
+}
+
+int word_array_set_words(WordArrayObject *self, Py_ssize_t i,
+                         const LogicWord *words) {
+    uint64_t a = words[0].aval, b = words[0].bval;
+    if (self->width > 32) {
+        a |= (uint64_t)words[1].aval << 32;
+        b |= (uint64_t)words[1].bval << 32;
+    }
+    return set_planes(self, i, a, b);
+}
+
+int add_word_array_type(PyObject *simulator) {
+    if (PyType_Ready(&WordArray_type) < 0) {
+        return -1;
+    }
+    PyObject *typ = (PyObject *)&WordArray_type;
+    Py_INCREF(typ);
+    if (PyModule_AddObject(simulator, "WordArray", typ) < 0) {
+        Py_DECREF(typ);
+        return -1;
+    }
+    return 0;
+}
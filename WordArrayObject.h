@@ -0,0 +1,39 @@
+// Array的定宽元素存储（simulator.WordArray）。每个元素是一个uint32/uint64，
+// 整个数组和对象头在同一块内存里，X/Z另存在一个同样布局的mask里。
+#ifndef MYCOCOTB_WORD_ARRAY_OBJECT_H_
+#define MYCOCOTB_WORD_ARRAY_OBJECT_H_
+
+#include <Python.h>
+
+#include "LogicArrayObject.h"
+
+// ob_size is the number of bytes in values
+struct WordArrayObject {
+    PyObject_VAR_HEAD Py_ssize_t length;
+    int width;            // bits of each element, 1 to 64
+    Py_ssize_t itemsize;  // 4 or 8 bytes per element
+    // bval planes of the elements, NULL while every bit is 0 or 1
+    WordArrayObject *mask;
+    // aval planes of the elements, length * itemsize bytes
+    char values[1];
+};
+
+extern PyTypeObject WordArray_type;
+
+static inline bool WordArrayObject_Check(PyObject *obj) {
+    return PyObject_TypeCheck(obj, &WordArray_type);
+}
+
+// A new WordArray of *length* elements of *width* bits, all 0, returns NULL
+// on failure
+WordArrayObject *word_array_new(Py_ssize_t length, int width);
+
+// Store the bit planes of element *i*, laid out as in a LogicArray of *width*
+// bits, returns -1 on failure
+int word_array_set_words(WordArrayObject *self, Py_ssize_t i,
+                         const LogicWord *words);
+
+// Add WordArray to the simulator module, returns -1 on failure
+int add_word_array_type(PyObject *simulator);
+
+#endif /* MYCOCOTB_WORD_ARRAY_OBJECT_H_ */
@@ -129,6 +129,17 @@
  // This is all slightly verbose but it saves having to enumerate various value
  // types We only care about a limited subset of values.
  GPI_EXPORT const char *gpi_get_signal_value_binstr(gpi_sim_hdl gpi_hdl);
+ 
+ // 4态的值按位平面存放，和s_vpi_vecval的布局完全一样：
+ // 每一位是0 (aval=0, bval=0)、1 (1, 0)、Z (0, 1)或者X (1, 1)
+ typedef struct gpi_vecval {
+     uint32_t aval;
+     uint32_t bval;
+ } gpi_vecval;
+ 
+ // Returns the value of a logic array as (gpi_get_num_elems() + 31) / 32
+ // words, least significant word first. Only valid until the next call.
+ GPI_EXPORT const gpi_vecval *gpi_get_signal_value_vecval(gpi_sim_hdl gpi_hdl);
  GPI_EXPORT const char *gpi_get_signal_name_str(gpi_sim_hdl gpi_hdl);
  GPI_EXPORT const char *gpi_get_signal_type_str(gpi_sim_hdl gpi_hdl);
  
@@ -147,6 +158,10 @@
      gpi_set_action_t action);  // String of binary char(s) [1, 0, x, z]
  GPI_EXPORT void gpi_set_signal_value_int(gpi_sim_hdl gpi_hdl, int32_t value,
                                          gpi_set_action_t action);
+ // Same layout as gpi_get_signal_value_vecval()
+ GPI_EXPORT void gpi_set_signal_value_vecval(gpi_sim_hdl gpi_hdl,
+                                             const gpi_vecval *value,
+                                             gpi_set_action_t action);
  
  typedef enum gpi_edge {
      GPI_RISING,
@@ -164,11 +179,33 @@
  GPI_EXPORT gpi_cb_hdl gpi_register_timed_callback(int (*gpi_function)(void *),
                                                    void *gpi_cb_data,
                                                    uint64_t time);
+ // Like gpi_register_timed_callback, but the callback rearms itself every
+ // *period* until it is deregistered
+ GPI_EXPORT gpi_cb_hdl gpi_register_periodic_callback(
+     int (*gpi_function)(void *), void *gpi_cb_data, uint64_t period);
  GPI_EXPORT gpi_cb_hdl gpi_register_value_change_callback(
      int (*gpi_function)(void *), void *gpi_cb_data, gpi_sim_hdl gpi_hdl,
      gpi_edge_e edge);
+ // Like gpi_register_value_change_callback with GPI_VALUE_CHANGE, but the
+ // callback fires on every change of the signal until it is deregistered
+ GPI_EXPORT gpi_cb_hdl gpi_register_value_watch_callback(
+     int (*gpi_function)(void *), void *gpi_cb_data, gpi_sim_hdl gpi_hdl);
  GPI_EXPORT gpi_cb_hdl
  gpi_register_readonly_callback(int (*gpi_function)(void *), void *gpi_cb_data);
+ // A ReadOnly callback that is only registered with the simulator when
+ // gpi_fire_wakeup_callback() is called for it, from a value watch callback
+ // for example. The caller owns it: prime it with gpi_prime_wakeup_callback()
+ // as often as needed, deregister it with gpi_deregister_callback() and free
+ // it with gpi_free_wakeup_callback()
+ GPI_EXPORT gpi_cb_hdl gpi_create_wakeup_callback(void);
+ // Returns -1 if the callback is already primed
+ GPI_EXPORT int gpi_prime_wakeup_callback(gpi_cb_hdl cb_hdl,
+                                          int (*gpi_function)(void *),
+                                          void *gpi_cb_data);
+ // Register a primed wakeup callback for the ReadOnly phase of the current
+ // time step, does nothing if it is not primed or already registered
+ GPI_EXPORT void gpi_fire_wakeup_callback(gpi_cb_hdl cb_hdl);
+ GPI_EXPORT void gpi_free_wakeup_callback(gpi_cb_hdl cb_hdl);
  GPI_EXPORT gpi_cb_hdl
  gpi_register_nexttime_callback(int (*gpi_function)(void *), void *gpi_cb_data);
  GPI_EXPORT gpi_cb_hdl
@@ -183,6 +220,102 @@
  // callback data
  GPI_EXPORT void *gpi_get_callback_data(gpi_cb_hdl gpi_hdl);
 
+ // 进程内的计数器，GPI层和simulator模块直接对它们自增，由
+ // simulator.get_stats()读出。仿真是单线程驱动的，所以不需要原子操作
+ typedef enum gpi_cb_kind_e {
+     GPI_CB_TIMED = 0,
+     GPI_CB_VALUE_CHANGE,
+     GPI_CB_READWRITE,
+     GPI_CB_READONLY,
+     GPI_CB_NEXTTIME,
+     GPI_CB_OTHER,  // cbStartOfSimulation, cbEndOfSimulation
+     GPI_CB_KIND_COUNT,
+ } gpi_cb_kind_e;
+
+ // VpiImpl.h里的同名宏在每次调用这些VPI函数时计数
+ typedef enum gpi_vpi_func_e {
+     GPI_VPI_GET = 0,
+     GPI_VPI_GET_STR,
+     GPI_VPI_GET_VALUE,
+     GPI_VPI_PUT_VALUE,
+     GPI_VPI_GET_TIME,
+     GPI_VPI_HANDLE,
+     GPI_VPI_HANDLE_BY_NAME,
+     GPI_VPI_HANDLE_BY_INDEX,
+     GPI_VPI_ITERATE,
+     GPI_VPI_SCAN,
+     GPI_VPI_FREE_OBJECT,
+     GPI_VPI_REGISTER_CB,
+     GPI_VPI_REMOVE_CB,
+     GPI_VPI_CONTROL,
+     GPI_VPI_FUNC_COUNT,
+ } gpi_vpi_func_e;
+
+ typedef struct gpi_stats {
+     uint64_t cb_registered[GPI_CB_KIND_COUNT];
+     uint64_t cb_fired[GPI_CB_KIND_COUNT];
+     uint64_t cb_removed[GPI_CB_KIND_COUNT];
+     uint64_t vpi_calls[GPI_VPI_FUNC_COUNT];
+     uint64_t handles_created;
+     uint64_t handles_cached;     // counted by the Python handle cache
+     uint64_t binstr_bytes_read;
+     uint64_t binstr_bytes_written;
+     uint64_t writes_scheduled;   // counted by the Python write scheduler
+     uint64_t writes_applied;
+     uint64_t python_entries;
+ } gpi_stats_t;
+
+ extern GPI_EXPORT gpi_stats_t gpi_stats;
+
+ // Names of the entries of gpi_cb_kind_e and gpi_vpi_func_e
+ GPI_EXPORT const char *gpi_cb_kind_name(int kind);
+ GPI_EXPORT const char *gpi_vpi_func_name(int func);
+
+ GPI_EXPORT void gpi_reset_stats(void);
+
+ // Log all non-zero counters
+ GPI_EXPORT void gpi_log_stats(void);
+
+ // Call *hook* from the cbEndOfSimulation callback, when the simulation has
+ // finished but Python is still running. Hooks run in registration order.
+ GPI_EXPORT void gpi_register_sim_end_hook(void (*hook)(void));
+ GPI_EXPORT void gpi_run_sim_end_hooks(void);
+ 
+ // 活着的原生对象的种类。没有清理的路径，仿真结束时还活着的都是泄漏
+ typedef enum gpi_obj_kind {
+     GPI_OBJ_SIM_HDL,         // GpiObjHdl
+     GPI_OBJ_ITERATOR,        // GpiIterator
+     GPI_OBJ_VPI_CB,          // VpiCbHdl
+     GPI_OBJ_PYTHON_CB,       // PythonCallback, counted by the simulator module
+     GPI_OBJ_PY_SIM_HDL,      // Python objects made by gpi_hdl_New
+     GPI_OBJ_PY_ITERATOR_HDL,
+     GPI_OBJ_PY_CB_HDL,
+     GPI_OBJ_KIND_COUNT,
+ } gpi_obj_kind_e;
+ 
+ typedef struct gpi_live_objects {
+     uint64_t created[GPI_OBJ_KIND_COUNT];
+     uint64_t freed[GPI_OBJ_KIND_COUNT];
+ } gpi_live_objects_t;
+ 
+ // 不随gpi_reset_stats清零
+ extern GPI_EXPORT gpi_live_objects_t gpi_live_objects;
+ 
+ GPI_EXPORT const char *gpi_obj_kind_name(int kind);
+ 
+ // Add *delta* to the number of Python handle objects referring to *hdl*,
+ // kept per handle for the signal paths of the leak report
+ GPI_EXPORT void gpi_track_py_handle(GpiObjHdl *hdl, int delta);
+ 
+ // The *top* signal paths with the most Python handle objects alive, most
+ // first
+ GPI_EXPORT std::vector<std::pair<std::string, uint64_t>> gpi_top_py_handles(
+     size_t top);
+ 
+ // Log the objects still alive, with the *top* signal paths by Python
+ // handle objects
+ GPI_EXPORT void gpi_log_live_objects(size_t top);
+
  /* Base GPI class others are derived from */
  class GPI_EXPORT GpiHdl {
    public:
@@ -218,9 +351,11 @@
    public:
      GpiObjHdl(GpiImplInterface *impl, void *hdl = nullptr,
                gpi_objtype_t objtype = GPI_UNKNOWN, bool is_const = false)
-         : GpiHdl(impl, hdl), m_type(objtype), m_const(is_const) {}
+         : GpiHdl(impl, hdl), m_type(objtype), m_const(is_const) {
+         ++gpi_live_objects.created[GPI_OBJ_SIM_HDL];
+     }
  
-     virtual ~GpiObjHdl() = default;
+     virtual ~GpiObjHdl() { ++gpi_live_objects.freed[GPI_OBJ_SIM_HDL]; }
  
      virtual const char *get_name_str() { return m_name.c_str(); };
      virtual const char *get_fullname_str() { return m_fullname.c_str(); };
@@ -277,6 +412,7 @@
      virtual ~GpiSignalObjHdl() = default;
      // Provide public access to the implementation (composition vs inheritance)
      virtual const char *get_signal_value_binstr() = 0;
+     virtual const gpi_vecval *get_signal_value_vecval() = 0;
  
      int m_length = 0;
  
@@ -286,6 +422,8 @@
                                   gpi_set_action_t action) = 0;
      virtual int set_signal_value_binstr(std::string &value,
                                          gpi_set_action_t action) = 0;
+     virtual int set_signal_value_vecval(const gpi_vecval *value,
+                                         gpi_set_action_t action) = 0;
  
      virtual VpiCbHdl *register_value_change_callback(
          gpi_edge_e edge, int (*gpi_function)(void *), void *gpi_cb_data) = 0;
@@ -298,11 +436,14 @@
         : GpiSignalObjHdl(impl, hdl, objtype, is_const) {}
 
     const char *get_signal_value_binstr() override;
+    const gpi_vecval *get_signal_value_vecval() override;
 
     int set_signal_value(const int32_t value, gpi_set_action_t action) override;
     int set_signal_value(const double value, gpi_set_action_t action) override;
     int set_signal_value_binstr(std::string &value,
                                 gpi_set_action_t action) override;
+    int set_signal_value_vecval(const gpi_vecval *value,
+                                gpi_set_action_t action) override;
 
     /* Value change callback accessor */
     int initialise(const std::string &name,
@@ -335,8 +476,10 @@ class VpiArrayObjHdl : public GpiObjHdl {
      };
  
      GpiIterator(GpiImplInterface *impl, GpiObjHdl *hdl)
-         : GpiHdl(impl), m_parent(hdl) {}
-     virtual ~GpiIterator() = default;
+         : GpiHdl(impl), m_parent(hdl) {
+         ++gpi_live_objects.created[GPI_OBJ_ITERATOR];
+     }
+     virtual ~GpiIterator() { ++gpi_live_objects.freed[GPI_OBJ_ITERATOR]; }
  
      virtual Status next_handle(std::string &name, GpiObjHdl **hdl, void **) {
          name = "";
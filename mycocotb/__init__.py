@@ -21,6 +21,8 @@ import mycocotb.task
 import mycocotb.triggers
 from mycocotb._scheduler import Scheduler
 import mycocotb._write_scheduler
+from mycocotb import simulator
+from mycocotb._bridge import bridge, resume
 # from cocotb.logging import default_config
 # 这里不使用cocotb.tests这样的注解，由用户直接用mycocotb.start_soon来创建协程
 # from cocotb.regression import RegressionManager, RegressionMode
@@ -63,9 +65,24 @@ class SimPhase(Enum):
     READ_ONLY = (auto(), "In a ReadOnly phase.")
 
 
-sim_phase: SimPhase = SimPhase.NORMAL
+sim_phase: SimPhase
 """The current phase of the time step."""
 
+# simulator.SIM_PHASE_* -> SimPhase，NEXT_TIME回调所处的也是时间步的开始
+_sim_phases = {
+    simulator.SIM_PHASE_NORMAL: SimPhase.NORMAL,
+    simulator.SIM_PHASE_READ_WRITE: SimPhase.READ_WRITE,
+    simulator.SIM_PHASE_READ_ONLY: SimPhase.READ_ONLY,
+    simulator.SIM_PHASE_NEXT_TIME: SimPhase.NORMAL,
+}
+
+
+def __getattr__(name: str) -> Any:
+    # sim_phase由simulator模块在每个回调触发时记录，这里只是把它翻译成SimPhase
+    if name == "sim_phase":
+        return _sim_phases[simulator.get_sim_phase()]
+    raise AttributeError(f"module {__name__!r} has no attribute {name!r}")
+
 
 def _setup_logging() -> None:
     # default_config()
@@ -80,7 +97,7 @@ def _task_done_callback(task: "cocotb.task.Task[Any]") -> None:
     if task.cancelled():
         return
     # if there's a Task awaiting this one, don't fail
-    if task.complete in _scheduler_inst._trigger2tasks:
+    if _scheduler_inst._has_waiters(task.complete):
         return
     # if no failure, do nothing
     e = task.exception()
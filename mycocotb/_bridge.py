@@ -0,0 +1,104 @@
+"""Run blocking code in worker threads and call back into the simulation from them.
+
+A function decorated with :func:`bridge` runs in its own thread while the calling
+:class:`~cocotb.task.Task` waits for it. The thread talks to the simulator thread
+through a :class:`simulator.ThreadBridge`: functions decorated with :func:`resume`
+submit a request to it and block until the simulator thread has run the request.
+"""
+
+import functools
+import inspect
+import threading
+from typing import Any, Callable, Coroutine, TypeVar, Union
+
+from mycocotb import _outcomes, simulator
+
+ResultType = TypeVar("ResultType")
+
+# 工作线程所属的ThreadBridge，由bridge()启动线程时设置
+_current = threading.local()
+
+
+async def _serve(bridge_: simulator.ThreadBridge) -> None:
+    """Run the requests of *bridge_* in the simulator thread until it is closed."""
+    try:
+        while True:
+            # 工作线程运行期间仿真时间不前进：仿真线程阻塞在eventfd上，
+            # 直到有请求或者工作线程退出
+            request = bridge_.wait()
+            if request is None:
+                return
+            try:
+                result = request.func(*request.args, **(request.kwargs or {}))
+                if inspect.iscoroutine(result):
+                    result = await result
+            except (GeneratorExit, KeyboardInterrupt, SystemExit):
+                request.set_exception(RuntimeError("Bridged call was cancelled"))
+                raise
+            except BaseException as e:
+                request.set_exception(e)
+            else:
+                request.set_result(result)
+    finally:
+        # 被kill时工作线程可能还会提交请求，让它们都直接失败。提交以后才看到
+        # close的工作线程会自己结束请求，所以这里用不会报错的cancel()
+        bridge_.close()
+        request = bridge_.wait()
+        while request is not None:
+            request.cancel(RuntimeError("Bridged call was cancelled"))
+            request = bridge_.wait()
+
+
+def bridge(
+    func: Callable[..., ResultType],
+) -> Callable[..., Coroutine[Any, Any, ResultType]]:
+    """Decorator to run a blocking function in a worker thread.
+
+    Awaiting the decorated function starts *func* in a new thread and returns its result.
+    Simulation time does not advance while *func* runs,
+    except during calls it makes back into the simulation through :func:`resume`.
+    """
+
+    @functools.wraps(func)
+    async def wrapper(*args: Any, **kwargs: Any) -> ResultType:
+        bridge_ = simulator.ThreadBridge()
+        outcome: Union[_outcomes.Outcome[ResultType], None] = None
+
+        def run() -> None:
+            nonlocal outcome
+            _current.bridge = bridge_
+            try:
+                outcome = _outcomes.Value(func(*args, **kwargs))
+            except BaseException as e:
+                outcome = _outcomes.Error(e)
+            finally:
+                bridge_.close()
+
+        thread = threading.Thread(target=run, name=func.__qualname__, daemon=True)
+        thread.start()
+        await _serve(bridge_)
+        thread.join()
+        assert outcome is not None
+        return outcome.get()
+
+    return wrapper
+
+
+def resume(func: Callable[..., Any]) -> Callable[..., Any]:
+    """Decorator to call *func* in the simulator thread from a :func:`bridge` thread.
+
+    The calling thread blocks until *func* returns.
+    If *func* is a coroutine function, the coroutine is awaited in the simulator thread,
+    so it may wait on triggers, and simulation time advances until it finishes.
+    """
+
+    @functools.wraps(func)
+    def wrapper(*args: Any, **kwargs: Any) -> Any:
+        bridge_ = getattr(_current, "bridge", None)
+        if bridge_ is None:
+            raise RuntimeError(
+                f"{func.__qualname__} must be called from a thread started by bridge()"
+            )
+        return bridge_.call(func, *args, **kwargs)
+
+    return wrapper
@@ -14,17 +14,19 @@ the ReadOnly (and this is invalid, at least in Modelsim).
 import logging
 import os
 import threading
-from collections import OrderedDict
+import time
+from collections import OrderedDict, deque
 from typing import Any, Callable, Dict
 
 import mycocotb
 import mycocotb._write_scheduler
-from mycocotb import _outcomes
+from mycocotb import _outcomes, simulator
 from mycocotb.task import Task
 from mycocotb.triggers import (
     Event,
     GPITrigger,
     NextTimeStep,
+    PeriodicTimer,
     ReadOnly,
     ReadWrite,
     Trigger,
@@ -35,12 +37,15 @@ from mycocotb.triggers import (
 # _debug = "COCOTB_SCHEDULER_DEBUG" in os.environ
 _debug = False
 
+# 调度器的热路径（事件循环、唤醒task、维护trigger和task的对应关系）默认由
+# simulator.SchedulerCore在C++里完成，设置COCOTB_SCHEDULER_NATIVE=0可以退回到
+# 下面的纯Python实现。调试日志只在Python实现里有，所以_debug时也不启用。
+_native = (
+    os.environ.get("COCOTB_SCHEDULER_NATIVE", "1") != "0"
+    and hasattr(simulator, "SchedulerCore")
+    and not _debug
+)
 
-class external_state:
-    INIT = 0
-    RUNNING = 1
-    PAUSED = 2
-    EXITED = 3
 
 class Scheduler:
     """The main Task scheduler.
@@ -107,7 +112,8 @@ class Scheduler:
         This function immediately cancels the Task by re-entering the scheduler.
         This can cause issues if you are trying to cancel the Test Task or the currently executing Task.
 
-        TODO: There are attributes and methods for dealing with "externals", but I'm not quite sure how it all works yet.
+        Worker threads started by :func:`cocotb.bridge` do not go through the scheduler:
+        their requests are served by the awaiting Task through a :class:`simulator.ThreadBridge`.
     """
 
     # Singleton events, recycled to avoid spurious object creation
@@ -130,14 +136,41 @@ class Scheduler:
         )
 
         self._scheduled_tasks: OrderedDict[Task[Any], _outcomes.Outcome] = OrderedDict()
-        self._pending_threads = []
-        self._pending_events = []  # Events we need to call set on once we've unwound
+        self._pending_events = deque()  # Events we need to call set on once we've unwound
 
         self._terminate = False
         self._main_thread = threading.current_thread()
 
+        # 被trigger唤醒的次数，以及task已经在队列里而被合并掉的唤醒次数
+        self._wakeups = 0
+        self._coalesced_wakeups = 0
+
         self._current_task = None
 
+        # 用native实现替换掉热路径上的方法，对外的接口保持不变
+        self._core = None
+        if _native:
+            self._core = simulator.SchedulerCore(self)
+            self._event_loop = self._core.event_loop
+            self._sim_react = self._core.sim_react
+            self._react = self._core.react
+            self._resume_task = self._core.resume_task
+            self._unschedule = self._core.unschedule
+            self._schedule_task = self._core.schedule_task
+            self._schedule_task_upon = self._core.schedule_task_upon
+
+    def _wakeup_stats(self) -> Dict[str, int]:
+        """Get the number of wakeups, and of wakeups coalesced into an already queued resume."""
+        if self._core is not None:
+            return self._core.wakeup_stats()
+        return {"wakeups": self._wakeups, "coalesced": self._coalesced_wakeups}
+
+    def _has_waiters(self, trigger: Trigger) -> bool:
+        """Return ``True`` if any task is waiting on *trigger*."""
+        if self._core is not None:
+            return self._core.has_waiters(trigger)
+        return trigger in self._trigger2tasks
+
     def _handle_termination(self) -> None:
         """
         Handle a termination that causes us to move onto the next test.
@@ -159,20 +192,19 @@ class Scheduler:
 
         This is often the entry point into Python from the simulator,
         so this function is in charge of enabling profiling.
-        It must also track the current simulator time phase,
+        It must also apply the scheduled writes in the ReadWrite phase,
         and start the unstarted event loop.
+        The phase itself is recorded by the simulator module for every callback it fires,
+        see :func:`simulator.get_sim_phase`.
         """
-        # TODO: move state tracking to global variable
-        # and handle this via some kind of trigger-specific Python callback
-        if trigger is self._read_write:
-            mycocotb.sim_phase = mycocotb.SimPhase.READ_WRITE
-        elif trigger is self._read_only:
-            mycocotb.sim_phase = mycocotb.SimPhase.READ_ONLY
-        else:
-            mycocotb.sim_phase = mycocotb.SimPhase.NORMAL
         # apply inertial writes if ReadWrite
-        if trigger is self._read_write:
-            mycocotb._write_scheduler.apply_scheduled_writes()
+        if simulator.get_sim_phase() == simulator.SIM_PHASE_READ_WRITE:
+            if simulator.get_latency_tracking():
+                start = time.perf_counter_ns()
+                mycocotb._write_scheduler.apply_scheduled_writes()
+                simulator.record_write_flush(time.perf_counter_ns() - start)
+            else:
+                mycocotb._write_scheduler.apply_scheduled_writes()
         self._react(trigger)
         self._event_loop()
 
@@ -188,10 +220,14 @@ class Scheduler:
         try:
             scheduling = self._trigger2tasks.pop(trigger)
         except KeyError:
+            # A PeriodicTimer keeps firing after its waiters have gone,
+            # stop it until it is awaited again
+            if isinstance(trigger, PeriodicTimer):
+                trigger._unprime()
             # GPI triggers should only be ever pending if there is an
             # associated task waiting on that trigger, otherwise it would
             # have been unprimed already
-            if isinstance(trigger, GPITrigger):
+            elif isinstance(trigger, GPITrigger):
                 self.log.critical(f"No tasks waiting on trigger that fired: {trigger}")
                 trigger.log.info("I'm the culprit")
             # For Python triggers this isn't actually an error - we might do
@@ -213,6 +249,15 @@ class Scheduler:
         for task in scheduling:
             # unset trigger
             task._trigger = None
+            if task in self._scheduled_tasks:
+                # already queued in this batch, resume it only once
+                self._coalesced_wakeups += 1
+                if _debug:
+                    self.log.debug(
+                        f"Coalesced wakeup of already scheduled task {task} by {trigger}"
+                    )
+                continue
+            self._wakeups += 1
             self._schedule_task(task)
 
         # cleanup trigger
@@ -226,6 +271,11 @@ class Scheduler:
         * A GPI trigger
         """
 
+        # trace里调度器的时间只算恢复tasks的这一段
+        trace_start = None
+        if self._scheduled_tasks and simulator.get_tracing():
+            trace_start = simulator.trace_clock()
+
         while self._scheduled_tasks and not self._terminate:
             task, outcome = self._scheduled_tasks.popitem(last=False)
 
@@ -246,7 +296,10 @@ class Scheduler:
                     self.log.debug(
                         f"Scheduling pending event {self._pending_events[0]}"
                     )
-                self._pending_events.pop(0).set()
+                self._pending_events.popleft().set()
+
+        if trace_start is not None:
+            simulator.record_scheduler_span(trace_start)
 
         # no more pending tasks
         if self._terminate:
@@ -325,51 +378,6 @@ class Scheduler:
         task._state = Task._State.SCHEDULED
         self._scheduled_tasks[task] = outcome
 
-    def _queue_function(self, task):
-        """Queue a task for execution and move the containing thread
-        so that it does not block execution of the main thread any longer.
-        """
-        # We should be able to find ourselves inside the _pending_threads list
-        matching_threads = [
-            t for t in self._pending_threads if t.thread == threading.current_thread()
-        ]
-        if len(matching_threads) == 0:
-            raise RuntimeError("queue_function called from unrecognized thread")
-
-        # Raises if there is more than one match. This can never happen, since
-        # each entry always has a unique thread.
-        (t,) = matching_threads
-
-        async def wrapper():
-            # This function runs in the scheduler thread
-            try:
-                _outcome = _outcomes.Value(await task)
-            except (KeyboardInterrupt, SystemExit):
-                # Allow these to bubble up to the execution root to fail the sim immediately.
-                # This follows asyncio's behavior.
-                raise
-            except BaseException as e:
-                _outcome = _outcomes.Error(e)
-            event.outcome = _outcome
-            # Notify the current (scheduler) thread that we are about to wake
-            # up the background (`@external`) thread, making sure to do so
-            # before the background thread gets a chance to go back to sleep by
-            # calling thread_suspend.
-            # We need to do this here in the scheduler thread so that no more
-            # tasks run until the background thread goes back to sleep.
-            t.thread_resume()
-            event.set()
-
-        event = threading.Event()
-        self._schedule_task(Task(wrapper()))
-        # The scheduler thread blocks in `thread_wait`, and is woken when we
-        # call `thread_suspend` - so we need to make sure the task is
-        # queued before that.
-        t.thread_suspend()
-        # This blocks the calling `@external` thread until the task finishes
-        event.wait()
-        return event.outcome.get()
-
     # This collection of functions parses a trigger out of the object
     # that was yielded by a task, converting `list` -> `Waitable`,
     # `Waitable` -> `Task`, `Task` -> `Trigger`.
@@ -424,7 +432,12 @@ class Scheduler:
         try:
             self._current_task = task
 
-            result = task._advance(outcome=outcome)
+            if simulator.get_task_profiling():
+                start = time.perf_counter_ns()
+                result = task._advance(outcome=outcome)
+                simulator.record_task_resume(task, time.perf_counter_ns() - start)
+            else:
+                result = task._advance(outcome=outcome)
 
             if task.done():
                 if _debug:
@@ -447,36 +460,19 @@ class Scheduler:
                     self._schedule_task(task, _outcomes.Error(exc))
                 else:
                     self._schedule_task_upon(task, result)
-
-            # We do not return from here until pending threads have completed, but only
-            # from the main thread, this seems like it could be problematic in cases
-            # where a sim might change what this thread is.
-
-            if self._main_thread is threading.current_thread():
-                for ext in self._pending_threads:
-                    ext.thread_start()
-                    if _debug:
-                        self.log.debug(
-                            f"Blocking from {threading.current_thread()} on {ext.thread}"
-                        )
-                    state = ext.thread_wait()
-                    if _debug:
-                        self.log.debug(
-                            f"Back from wait on self {threading.current_thread()} with newstate {state}"
-                        )
-                    if state == external_state.EXITED:
-                        self._pending_threads.remove(ext)
-                        self._pending_events.append(ext.event)
         finally:
             self._current_task = None
 
     def _cleanup(self) -> None:
         """Clear up all our state.
 
-        Unprime all pending triggers and kill off any tasks, stop all externals.
+        Unprime all pending triggers and kill off any tasks.
         """
         # copy since we modify this in kill
-        items = list((k, list(v)) for k, v in self._trigger2tasks.items())
+        if self._core is not None:
+            items = self._core.trigger2tasks()
+        else:
+            items = list((k, list(v)) for k, v in self._trigger2tasks.items())
 
         # reversing seems to fix gh-928, although the order is still somewhat
         # arbitrary.
@@ -487,11 +483,19 @@ class Scheduler:
                 task.kill()
             # we don't unprime trigger here since removing all tasks waiting on
             # the trigger should cause it to be unprimed in _unschedule
-        assert not self._trigger2tasks
+        if self._core is not None:
+            assert not self._core.trigger2tasks()
+        else:
+            assert not self._trigger2tasks
 
         # Kill any queued coroutines.
         # We use a while loop because task.kill() calls _unschedule(), which will remove the task from _pending_tasks.
         # If that happens a for loop will stop early and then the assert will fail.
+        if self._core is not None:
+            task = self._core.pop_scheduled()
+            while task is not None:
+                task.kill()
+                task = self._core.pop_scheduled()
         while self._scheduled_tasks:
             task, _ = self._scheduled_tasks.popitem(last=False)
             task.kill()
@@ -499,8 +503,5 @@ class Scheduler:
         if self._main_thread is not threading.current_thread():
             raise Exception("Cleanup() called outside of the main thread")
 
-        for ext in self._pending_threads:
-            self.log.warning(f"Waiting for {ext.thread} to exit")
-
     def shutdown_soon(self) -> None:
         self._terminate = True
@@ -8,6 +8,7 @@ from typing import Any, Callable, Sequence, Tuple, Union
 import mycocotb
 import mycocotb.handle
 import mycocotb.task
+from mycocotb import simulator
 from mycocotb.triggers import Event, ReadWrite
 
 # A dictionary of pending (write_func, args), keyed by handle.
@@ -51,15 +52,24 @@ def apply_scheduled_writes() -> None:
     _writes_pending.clear()
 
 
+def pending_write(
+    handle: mycocotb.handle.SimHandleBase,
+) -> Union[Tuple[Callable[..., None], Sequence[Any]], None]:
+    """The ``(write_func, args)`` scheduled for *handle* and not applied yet, if any."""
+    return _write_calls.get(handle)
+
+
 def schedule_write(
     handle: mycocotb.handle.SimHandleBase,
     write_func: Callable[..., None],
     args: Sequence[Any],
 ) -> None:
     """Queue *write_func* to be called on the next ``ReadWrite`` trigger."""
-    if mycocotb.sim_phase == mycocotb.SimPhase.READ_WRITE:
+    simulator.count_scheduled_write()
+    phase = simulator.get_sim_phase()
+    if phase == simulator.SIM_PHASE_READ_WRITE:
         write_func(*args)
-    elif mycocotb.sim_phase == mycocotb.SimPhase.READ_ONLY:
+    elif phase == simulator.SIM_PHASE_READ_ONLY:
         raise RuntimeError(
             f"Write to object {handle._name} was scheduled during a read-only simulation phase."
         )
@@ -15,6 +15,7 @@ from typing import (
     Generic,
     Iterable,
     Iterator,
+    List,
     NoReturn,
     Optional,
     Sequence,
@@ -28,7 +29,7 @@ from typing import (
 from mycocotb import simulator
 from functools import cached_property
 from mycocotb._utils import cached_method
-from mycocotb.types import Array, Logic, LogicArray
+from mycocotb.types import Array, Logic, LogicArray, PackedLayout, Range
 
 
 def _write_now(
@@ -230,9 +231,12 @@ class HierarchyObjectBase(SimHandleBase, Generic[KeyType]):
     def __getitem__(self, key: KeyType) -> SimHandleBase:
         # try to use cached value
         try:
-            return self._sub_handles[key]
+            sub_handle = self._sub_handles[key]
         except KeyError:
             pass
+        else:
+            simulator.count_cached_handle()
+            return sub_handle
 
         # try to get value from GPI
         new_handle = self._get_handle_by_key(key)
@@ -591,6 +595,30 @@ class ArrayObject(
     def __init__(self, handle: simulator.gpi_sim_hdl, path: Optional[str]) -> None:
         super().__init__(handle, path)
         self._sub_handles: Dict[int, ChildObjectT] = {}
+        # 元素都是LogicArrayObject时它们的gpi_sim_hdl，这样value可以一次读进WordArray
+        self._vecval_handles: Optional[List[simulator.gpi_sim_hdl]] = None
+        self._vecval_handles_checked = False
+
+    @cached_property
+    def range(self) -> Range:
+        """The indexes of the elements of the array as a :class:`~cocotb.types.Range`."""
+        left, right, direction = self._handle.get_range()
+        if direction == simulator.RANGE_DOWN:
+            return Range(left, "downto", right)
+        return Range(left, "to", right)
+
+    @property
+    def left(self) -> int:
+        """Leftmost index of the array."""
+        return self.range.left
+
+    @property
+    def right(self) -> int:
+        """Rightmost index of the array."""
+        return self.range.right
+
+    def __len__(self) -> int:
+        return len(self.range)
 
     @property
     def value(self) -> Array[ElemValueT]:
@@ -598,6 +626,8 @@ class ArrayObject(
 
         :getter:
             Returns the current values of each element of the array object as an :class:`~cocotb.types.Array` of element values.
+            Arrays of logic vectors of up to 64 bits are read in one go into a
+            :class:`~mycocotb.simulator.WordArray`, which :func:`numpy.asarray` can use without a copy.
             The elements of the array appear in the list in left-to-right order.
 
         :setter:
@@ -629,8 +659,21 @@ class ArrayObject(
             ValueError:
                 If assigning a :class:`list` of different length than the simulation object.
         """
+        handles = self._get_vecval_handles()
+        if handles is not None:
+            words = simulator.get_signal_vals_vecval(handles)
+            if words is not None:
+                return Array._from_words(words, self.range)
         return Array((self[i].value for i in self.range), range=self.range)
 
+    def _get_vecval_handles(self) -> Optional[List[simulator.gpi_sim_hdl]]:
+        if not self._vecval_handles_checked:
+            self._vecval_handles_checked = True
+            elems = [self[i] for i in self.range]
+            if elems and all(isinstance(e, LogicArrayObject) for e in elems):
+                self._vecval_handles = [e._handle for e in elems]
+        return self._vecval_handles
+
     @value.setter
     def value(self, value: Array[ElemValueT]) -> None:
         self.set(value)
@@ -654,6 +697,7 @@ class ArrayObject(
         if isinstance(index, slice):
             raise IndexError("Slice indexing is not supported")
         if index in self._sub_handles:
+            simulator.count_cached_handle()
             return self._sub_handles[index]
         new_handle = self._handle.get_handle_by_index(index)
         if not new_handle:
@@ -729,8 +773,7 @@ class LogicObject(ValueObjectBase[Logic, Union[Logic, int, str]]):
 
             ValueError: If value can't be converted to a :class:`~cocotb.types.Logic`.
         """
-        binstr = self._handle.get_signal_val_binstr()
-        return Logic(binstr)
+        return self._handle.get_signal_val_logic()
 
     @value.setter
     def value(self, value: Logic) -> None:
@@ -766,7 +809,7 @@ class LogicArrayObject(
             [ValueObjectBase[Any, Any], Callable[..., None], Sequence[Any]], None
         ],
     ) -> None:
-        value_: str
+        value_: LogicArray
         if isinstance(value, int):
             min_val, max_val = _value_limits(len(self), _Limits.VECTOR_NBIT)
             if min_val <= value <= max_val:
@@ -776,20 +819,15 @@ class LogicArrayObject(
                     )
                     return
 
-                # LogicArray used for checking
                 if value < 0:
-                    value_ = str(
-                        LogicArray.from_signed(
-                            value,
-                            Range(len(self) - 1, "downto", 0),
-                        )
+                    value_ = LogicArray.from_signed(
+                        value,
+                        Range(len(self) - 1, "downto", 0),
                     )
                 else:
-                    value_ = str(
-                        LogicArray.from_unsigned(
-                            value,
-                            Range(len(self) - 1, "downto", 0),
-                        )
+                    value_ = LogicArray.from_unsigned(
+                        value,
+                        Range(len(self) - 1, "downto", 0),
                     )
             else:
                 raise OverflowError(
@@ -797,29 +835,32 @@ class LogicArrayObject(
                 )
 
         elif isinstance(value, str):
-            # LogicArray used for checking
-            value_ = str(LogicArray(value, self.range))
+            value_ = LogicArray(value, len(self))
 
         elif isinstance(value, LogicArray):
             if len(self) != len(value):
                 raise ValueError(
                     f"cannot assign value of length {len(value)} to handle of length {len(self)}"
                 )
-            value_ = str(value)
+            # 写入要等到ReadWrite阶段，不能让之后对value的修改影响到它
+            value_ = value._copy()
 
         elif isinstance(value, Logic):
             if len(self) != 1:
                 raise ValueError(
                     f"cannot assign value of length 1 to handle of length {len(self)}"
                 )
-            value_ = str(value)
+            schedule_write(
+                self, self._handle.set_signal_val_binstr, (action, str(value))
+            )
+            return
 
         else:
             raise TypeError(
                 f"Unsupported type for value assignment: {type(value)} ({value!r})"
             )
 
-        schedule_write(self, self._handle.set_signal_val_binstr, (action, value_))
+        schedule_write(self, self._handle.set_signal_val_vecval, (action, value_))
 
     @property
     def value(self) -> LogicArray:
@@ -850,13 +891,76 @@ class LogicArrayObject(
             Convert the dictionary to an integer before assignment using
             ``sum(v << (d['bits'] * i) for i, v in enumerate(d['values']))`` instead.
         """
-        binstr = self._handle.get_signal_val_binstr()
-        return LogicArray._from_handle(binstr)
+        return self._handle.get_signal_val_vecval()
 
     @value.setter
     def value(self, value: LogicArray) -> None:
         self.set(value)
 
+    def get_fields(self, layout: PackedLayout) -> Dict[str, Optional[int]]:
+        """Get the value of every field of a packed structure.
+
+        The value is read from the simulator once and all fields are extracted in one pass,
+        rather than slicing :attr:`value` once per field.
+
+        Args:
+            layout: The :class:`~cocotb.types.PackedLayout` of the structure.
+
+        Returns:
+            A :class:`dict` of field name to value, ``None`` for fields containing ``X`` or ``Z`` bits.
+        """
+        return self._handle.get_signal_fields(layout)
+
+    def set_fields(
+        self,
+        layout: PackedLayout,
+        values: Dict[str, Union[int, LogicArray]],
+    ) -> None:
+        """Set some fields of a packed structure with a single write.
+
+        Fields not in *values* keep their current value,
+        or the value of a write to this object already scheduled in the current delta cycle,
+        so several calls in the same delta cycle combine.
+        The new value of the whole structure is written at the end of the current delta cycle, like :meth:`set`.
+
+        Args:
+            layout: The :class:`~cocotb.types.PackedLayout` of the structure.
+            values: Field name to :class:`int` or :class:`~cocotb.types.LogicArray` value.
+        """
+        if self.is_const:
+            raise TypeError(f"{self._path} is constant")
+
+        import mycocotb._write_scheduler
+
+        base, action = self._pending_value()
+        if base is None:
+            base = self._handle.get_signal_val_vecval()
+        self._set_value(
+            layout.pack(values, base),
+            action,
+            mycocotb._write_scheduler.schedule_write,
+        )
+
+    def _pending_value(self) -> Tuple[Optional[LogicArray], _GPISetAction]:
+        """The value and action of the write scheduled for this object, if any."""
+        import mycocotb._write_scheduler
+
+        pending = mycocotb._write_scheduler.pending_write(self)
+        if pending is None:
+            return None, _GPISetAction.DEPOSIT
+        _, (action, value) = pending
+        # Release之后的值由仿真器决定，不能在它上面改字段
+        if action == _GPISetAction.RELEASE:
+            return None, _GPISetAction.DEPOSIT
+        if isinstance(value, LogicArray):
+            return value, action
+        if isinstance(value, int):
+            rng = Range(len(self) - 1, "downto", 0)
+            if value < 0:
+                return LogicArray.from_signed(value, rng), action
+            return LogicArray.from_unsigned(value, rng), action
+        return LogicArray(str(value), len(self)), action
+
     @cached_method
     def __len__(self) -> int:
         # can't use `range` to get length because `range` is for outer-most dimension only
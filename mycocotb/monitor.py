@@ -0,0 +1,243 @@
+# Copyright cocotb contributors
+# Licensed under the Revised BSD License, see LICENSE for details.
+# SPDX-License-Identifier: BSD-3-Clause
+
+"""Track the value changes of a set of signals without a Python call per change."""
+
+import logging
+from typing import (
+    Any,
+    AsyncIterator,
+    Callable,
+    Dict,
+    Iterable,
+    List,
+    NamedTuple,
+    Tuple,
+    Union,
+)
+
+from mycocotb import simulator
+from mycocotb.handle import LogicArrayObject, LogicObject
+from mycocotb.triggers import GPITrigger, ReadOnly, Trigger
+from mycocotb.types import Logic, LogicArray
+from mycocotb.utils import get_sim_time
+
+
+class _Changed(GPITrigger):
+    """Fires in the ReadOnly phase of the next time step in which a signal watched by *recorder* changes.
+
+    The ReadOnly callback is only registered with the simulator by the first change,
+    so the time steps without changes cost no Python call.
+    It also fires when *recorder* is closed.
+    """
+
+    def __init__(self, recorder: Union[simulator.ValueMonitor, simulator.ChangeSet]) -> None:
+        super().__init__()
+        self._recorder = recorder
+
+    def _prime(self, callback: Callable[[Trigger], None]) -> None:
+        if self._cbhdl is None:
+            self._cbhdl = simulator.register_change_callback(self._recorder, callback, self)
+            if self._cbhdl is None:
+                raise RuntimeError(f"Unable set up {str(self)} Trigger")
+        super()._prime(callback)
+
+    def __repr__(self) -> str:
+        return f"{type(self).__qualname__}({self._recorder!r})"
+
+
+class ValueChange(NamedTuple):
+    """A value change recorded by a :class:`ValueChangeMonitor`."""
+
+    time: int
+    """Simulation time of the change, in steps."""
+
+    handle: Union[LogicObject, LogicArrayObject]
+    """The signal that changed."""
+
+    value: Union[Logic, LogicArray]
+    """The new value of the signal."""
+
+
+class ValueChangeMonitor:
+    """Record every value change of *handles* into a ring buffer in native code.
+
+    Unlike awaiting :class:`~cocotb.triggers.Edge` in a loop, no change is missed
+    between two wakeups and no Python code runs when a signal changes:
+    the simulation time, the signal and its new value are copied into a buffer of *capacity* records
+    allocated up front, and are handed to Python in batches by :meth:`drain`.
+
+    .. code-block:: python3
+
+        monitor = ValueChangeMonitor([dut.valid, dut.data])
+        async for changes in monitor.batches():
+            for change in changes:
+                ...
+
+    When the buffer is full, *overflow* decides which change is lost:
+    ``"drop_oldest"`` overwrites the oldest record, ``"drop_newest"`` discards the new change.
+    Lost changes are counted in :attr:`dropped` and logged as a warning when the buffer is next drained.
+
+    Recording starts immediately and continues until :meth:`close` is called.
+    """
+
+    def __init__(
+        self,
+        handles: Iterable[Union[LogicObject, LogicArrayObject]],
+        capacity: int = 4096,
+        overflow: str = "drop_oldest",
+    ) -> None:
+        self._handles = list(handles)
+        self._is_logic = [isinstance(h, LogicObject) for h in self._handles]
+        self._monitor = simulator.ValueMonitor(
+            [h._handle for h in self._handles], capacity, overflow
+        )
+        self._changed = _Changed(self._monitor)
+        self._reported_dropped = 0
+        self._log = logging.getLogger("mycocotb.monitor")
+
+    def drain(self, limit: int = -1) -> List[ValueChange]:
+        """Remove and return the oldest *limit* recorded changes, all of them by default."""
+        records = self._monitor.drain(limit)
+        dropped = self._monitor.dropped
+        if dropped != self._reported_dropped:
+            self._log.warning(
+                "%d value changes dropped (%s) since the last drain, capacity is %d",
+                dropped - self._reported_dropped,
+                self._monitor.overflow,
+                self._monitor.capacity,
+            )
+            self._reported_dropped = dropped
+        handles = self._handles
+        is_logic = self._is_logic
+        return [
+            ValueChange(time, handles[i], value[0] if is_logic[i] else value)
+            for time, i, value in records
+        ]
+
+    async def batches(self) -> AsyncIterator[List[ValueChange]]:
+        """Yield the changes of each time step in its ReadOnly phase.
+
+        Time steps without changes are skipped without resuming Python.
+        Only one task at a time can iterate over the batches of a monitor.
+        """
+        monitor = self._monitor
+        while not monitor.closed or len(monitor):
+            if not len(monitor):
+                await self._changed
+            elif simulator.get_sim_phase() != simulator.SIM_PHASE_READ_ONLY:
+                await ReadOnly()
+            if len(monitor):
+                yield self.drain()
+
+    def close(self) -> None:
+        """Stop recording. Changes already recorded can still be drained."""
+        self._monitor.close()
+
+    def __enter__(self) -> "ValueChangeMonitor":
+        return self
+
+    def __exit__(self, *args: Any) -> None:
+        self.close()
+
+    def __len__(self) -> int:
+        """Number of changes waiting to be drained."""
+        return len(self._monitor)
+
+    @property
+    def dropped(self) -> int:
+        """Number of changes lost because the buffer was full."""
+        return self._monitor.dropped
+
+    @property
+    def stats(self) -> Dict[str, Any]:
+        """Counters of the buffer: changes recorded and dropped, pending and peak records."""
+        m = self._monitor
+        return {
+            "recorded": m.recorded,
+            "dropped": m.dropped,
+            "pending": len(m),
+            "high_water": m.high_water,
+            "capacity": m.capacity,
+            "overflow": m.overflow,
+        }
+
+
+class ChangeSet:
+    """Track which of *handles* changed in the current time step.
+
+    Finding the signals that changed in a time step by reading all of them in
+    :class:`~cocotb.triggers.ReadOnly` and comparing with the previous values costs a read per signal.
+    A :class:`ChangeSet` instead keeps a value change callback on every signal that only marks it as changed,
+    so the query reads just the signals that did change.
+
+    .. code-block:: python3
+
+        changes = ChangeSet(dut.outputs)
+        async for time, values in changes.steps():
+            for handle, value in values.items():
+                ...
+
+    The queries report the changes of the time step they are made in, and are complete in its ReadOnly phase.
+    Tracking continues until :meth:`close` is called.
+    """
+
+    def __init__(self, handles: Iterable[Union[LogicObject, LogicArrayObject]]) -> None:
+        self._handles = list(handles)
+        self._is_logic = [isinstance(h, LogicObject) for h in self._handles]
+        self._change_set = simulator.ChangeSet([h._handle for h in self._handles])
+        self._changed = _Changed(self._change_set)
+
+    def changed(self) -> List[Union[LogicObject, LogicArrayObject]]:
+        """The signals that changed in the current time step, in the order they were given."""
+        handles = self._handles
+        return [handles[i] for i in self._change_set.changed()]
+
+    def values(self) -> Dict[Union[LogicObject, LogicArrayObject], Union[Logic, LogicArray]]:
+        """The current values of the signals that changed in the current time step."""
+        handles = self._handles
+        is_logic = self._is_logic
+        return {
+            handles[i]: value[0] if is_logic[i] else value
+            for i, value in self._change_set.values()
+        }
+
+    @property
+    def bitmap(self) -> int:
+        """An :class:`int` with bit *i* set if the *i*-th signal changed in the current time step."""
+        return self._change_set.bitmap()
+
+    async def steps(
+        self,
+    ) -> AsyncIterator[
+        Tuple[int, Dict[Union[LogicObject, LogicArrayObject], Union[Logic, LogicArray]]]
+    ]:
+        """Yield the simulation time in steps and :meth:`values` in the ReadOnly phase of each time step.
+
+        Time steps without changes are skipped without resuming Python.
+        Only one task at a time can iterate over the steps of a change set.
+        """
+        change_set = self._change_set
+        while not change_set.closed:
+            # 这个时间步里已经有变化、又还没到ReadOnly时，直接等ReadOnly
+            if len(change_set) and simulator.get_sim_phase() != simulator.SIM_PHASE_READ_ONLY:
+                await ReadOnly()
+            else:
+                await self._changed
+            if len(change_set):
+                yield get_sim_time(), self.values()
+
+    def close(self) -> None:
+        """Stop tracking changes."""
+        self._change_set.close()
+
+    def __enter__(self) -> "ChangeSet":
+        return self
+
+    def __exit__(self, *args: Any) -> None:
+        self.close()
+
+    def __len__(self) -> int:
+        """Number of signals that changed in the current time step."""
+        return len(self._change_set)
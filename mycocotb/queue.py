@@ -0,0 +1,149 @@
+# Copyright cocotb contributors
+# Licensed under the Revised BSD License, see LICENSE for details.
+# SPDX-License-Identifier: BSD-3-Clause
+
+"""A queue for passing items between :class:`~cocotb.task.Task`\\ s."""
+
+from collections import deque
+from typing import Deque, Generic, TypeVar
+
+from mycocotb import simulator
+from mycocotb.triggers import Trigger, _pointer_str
+
+T = TypeVar("T")
+
+
+class QueueFull(Exception):
+    """Raised when the Queue.put_nowait() method is called on a full Queue."""
+
+
+class QueueEmpty(Exception):
+    """Raised when the Queue.get_nowait() method is called on a empty Queue."""
+
+
+class _QueueWait(simulator.WaitTrigger, Trigger):
+    """Unique instance used by the Queue object.
+
+    One created for each task blocked in :meth:`Queue.put` or :meth:`Queue.get`,
+    so that waiters can be woken up one at a time, in order.
+    """
+
+    def __init__(self, waiters: "Deque[_QueueWait]", name: str) -> None:
+        super().__init__()
+        self._waiters = waiters
+        self._name = name
+
+    def _unprime(self) -> None:
+        # the waiting task was killed, don't wake it up for an item
+        try:
+            self._waiters.remove(self)
+        except ValueError:
+            pass
+        return super()._unprime()
+
+    def __repr__(self) -> str:
+        return f"<{self._name} at {_pointer_str(self)}>"
+
+
+class Queue(Generic[T]):
+    """A queue, useful for coordinating producer and consumer tasks.
+
+    If *maxsize* is less than or equal to 0, the queue size is infinite. If it
+    is an integer greater than 0, then :meth:`put` will block when the queue
+    reaches *maxsize*, until an item is removed by :meth:`get`.
+    """
+
+    def __init__(self, maxsize: int = 0) -> None:
+        self._maxsize: int = maxsize
+        self._queue: Deque[T] = deque()
+        self._getters: Deque[_QueueWait] = deque()
+        self._putters: Deque[_QueueWait] = deque()
+
+    def _wakeup_next(self, waiters: Deque[_QueueWait]) -> None:
+        while waiters:
+            if waiters.popleft().fire():
+                return
+
+    def __repr__(self) -> str:
+        return f"<{type(self).__name__} at {_pointer_str(self)} maxsize={self._maxsize} {self._format()}>"
+
+    def __str__(self) -> str:
+        return f"<{type(self).__name__} maxsize={self._maxsize} {self._format()}>"
+
+    def _format(self) -> str:
+        result = f"_queue={list(self._queue)!r}"
+        if self._getters:
+            result += f" _getters[{len(self._getters)}]"
+        if self._putters:
+            result += f" _putters[{len(self._putters)}]"
+        return result
+
+    def qsize(self) -> int:
+        """Number of items in the queue."""
+        return len(self._queue)
+
+    @property
+    def maxsize(self) -> int:
+        """Number of items allowed in the queue."""
+        return self._maxsize
+
+    def empty(self) -> bool:
+        """Return ``True`` if the queue is empty, ``False`` otherwise."""
+        return not self._queue
+
+    def full(self) -> bool:
+        """Return ``True`` if there are :meth:`maxsize` items in the queue.
+
+        .. note::
+            If the Queue was initialized with ``maxsize=0`` (the default), then
+            :meth:`full` is never ``True``.
+        """
+        if self._maxsize <= 0:
+            return False
+        else:
+            return self.qsize() >= self._maxsize
+
+    async def put(self, item: T) -> None:
+        """Put an *item* into the queue.
+
+        If the queue is full, wait until a free
+        slot is available before adding the item.
+        """
+        while self.full():
+            trigger = _QueueWait(self._putters, f"{type(self).__name__}.put()")
+            self._putters.append(trigger)
+            await trigger
+        self.put_nowait(item)
+
+    def put_nowait(self, item: T) -> None:
+        """Put an *item* into the queue without blocking.
+
+        If no free slot is immediately available, raise :exc:`~cocotb.queue.QueueFull`.
+        """
+        if self.full():
+            raise QueueFull()
+        self._queue.append(item)
+        self._wakeup_next(self._getters)
+
+    async def get(self) -> T:
+        """Remove and return an item from the queue.
+
+        If the queue is empty, wait until an item is available.
+        """
+        while self.empty():
+            trigger = _QueueWait(self._getters, f"{type(self).__name__}.get()")
+            self._getters.append(trigger)
+            await trigger
+        return self.get_nowait()
+
+    def get_nowait(self) -> T:
+        """Remove and return an item from the queue.
+
+        Return an item if one is immediately available, else raise
+        :exc:`~cocotb.queue.QueueEmpty`.
+        """
+        if self.empty():
+            raise QueueEmpty()
+        item = self._queue.popleft()
+        self._wakeup_next(self._putters)
+        return item
@@ -21,8 +21,8 @@ from typing import (
 
 import mycocotb
 import mycocotb.triggers
+from mycocotb import simulator
 from mycocotb._outcomes import Error, Outcome, Value
-from functools import cached_property
 from enum import Enum
 from mycocotb._utils import extract_coro_stack, remove_traceback_frames
 
@@ -34,7 +34,7 @@ ResultType = TypeVar("ResultType")
 _debug = "COCOTB_SCHEDULER_DEBUG" in os.environ
 
 
-class Task(Generic[ResultType]):
+class Task(simulator.TaskBase, Generic[ResultType]):
     """Concurrently executing task.
 
     This class is not intended for users to directly instantiate.
@@ -50,6 +50,10 @@ class Task(Generic[ResultType]):
         Use :meth:`result`, :meth:`done`, and :meth:`done` methods instead, respectively.
     """
 
+    # 所有状态都在simulator.TaskBase的定长字段里，没有__dict__，
+    # 这样结束的Task占用的内存可以被下一个Task直接复用
+    __slots__ = ()
+
     class _State(Enum):
         """State of a Task."""
 
@@ -89,13 +93,15 @@ class Task(Generic[ResultType]):
         self.__name__ = f"{type(self)._name} {self._task_id}"
         self.__qualname__ = self.__name__
 
-    @cached_property
+    @property
     def log(self) -> logging.Logger:
         # Creating a logger is expensive, only do it if we actually plan to
         # log anything
-        return logging.getLogger(
-            f"cocotb.{self.__qualname__}.{self._coro.__qualname__}"
-        )
+        if self._log is None:
+            self._log = logging.getLogger(
+                f"cocotb.{self.__qualname__}.{self._coro.__qualname__}"
+            )
+        return self._log
 
     def __str__(self) -> str:
         return f"<{self.__name__}>"
@@ -195,14 +201,12 @@ class Task(Generic[ResultType]):
         self._state = Task._State.FINISHED
         self._do_done_callbacks()
 
-    def _do_done_callbacks(self) -> None:
-        for callback in self._done_callbacks:
-            callback(self)
-
-    @cached_property
+    @property
     def complete(self) -> "cocotb.triggers.TaskComplete[ResultType]":
         r"""Trigger which fires when the Task completes."""
-        return mycocotb.triggers.TaskComplete._make(self)
+        if self._complete is None:
+            self._complete = mycocotb.triggers.TaskComplete._make(self)
+        return self._complete
 
     def cancel(self, msg: Optional[str] = None) -> None:
         """Cancel a Task's further execution.
@@ -227,14 +231,6 @@ class Task(Generic[ResultType]):
         self._state = Task._State.CANCELLED
         self._do_done_callbacks()
 
-    def cancelled(self) -> bool:
-        """Return ``True`` if the Task was cancelled."""
-        return self._state is Task._State.CANCELLED
-
-    def done(self) -> bool:
-        """Return ``True`` if the Task has finished executing."""
-        return self._state in (Task._State.FINISHED, Task._State.CANCELLED)
-
     def result(self) -> ResultType:
         """Return the result of the Task.
 
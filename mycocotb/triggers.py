@@ -7,6 +7,7 @@
 import logging
 import warnings
 from abc import abstractmethod
+from collections import deque
 from decimal import Decimal
 from fractions import Fraction
 from typing import (
@@ -17,6 +18,7 @@ from typing import (
     Callable,
     ClassVar,
     Coroutine,
+    Deque,
     Generator,
     Generic,
     List,
@@ -238,6 +240,65 @@ class Timer(GPITrigger):
         )
 
 
+class PeriodicTimer(Timer):
+    r"""Fire every *period* of simulation time.
+
+    The period is converted to simulator steps once, and a single timed
+    callback rearms itself at fixed intervals while the trigger is being
+    awaited, so awaiting it in a loop doesn't create or register anything.
+
+    Args:
+        period: The time between two firings, see :class:`Timer`.
+
+        units: The unit of the time value, see :class:`Timer`.
+
+        round_mode: How to handle time values that sit between time steps,
+            see :class:`Timer`.
+
+    Usage:
+
+        >>> period = PeriodicTimer(5, units="ns")
+        >>> while True:
+        ...     dut.clk.value = 0
+        ...     await period
+        ...     dut.clk.value = 1
+        ...     await period
+
+    .. note::
+        The timer stops when it fires with no task waiting on it, the next
+        ``await`` starts a new period from the current time.
+    """
+
+    def __init__(
+        self,
+        period: Union[float, Fraction, Decimal],
+        units: str = "step",
+        *,
+        round_mode: Optional[str] = None,
+    ) -> None:
+        super().__init__(period, units, round_mode=round_mode)
+
+    def _prime(self, callback: Callable[[Trigger], None]) -> None:
+        """Register the periodic callback, unless it is still running."""
+        if self._cbhdl is None:
+            self._cbhdl = simulator.register_periodic_callback(
+                self._sim_steps, callback, self
+            )
+            if self._cbhdl is None:
+                raise RuntimeError(f"Unable set up {str(self)} Trigger")
+        Trigger._prime(self, callback)
+
+    def _unprime(self) -> None:
+        if self._cbhdl is not None:
+            self._cbhdl.deregister()
+            self._cbhdl = None
+        self._primed = False
+
+    def _cleanup(self) -> None:
+        # fired, but the callback is already waiting for the next period
+        pass
+
+
 @singleton
 class ReadOnly(GPITrigger):
     """Fires when the current simulation timestep moves to the read-only phase.
@@ -249,7 +310,7 @@ class ReadOnly(GPITrigger):
     """
 
     def _prime(self, callback: Callable[[Trigger], None]) -> None:
-        if mycocotb.sim_phase is mycocotb.SimPhase.READ_ONLY:
+        if simulator.get_sim_phase() == simulator.SIM_PHASE_READ_ONLY:
             raise RuntimeError(
                 "Attempted illegal transition: awaiting ReadOnly in ReadOnly phase"
             )
@@ -268,7 +329,7 @@ class ReadWrite(GPITrigger):
     """Fires when the read-write simulation phase is reached."""
 
     def _prime(self, callback: Callable[[Trigger], None]) -> None:
-        if mycocotb.sim_phase is mycocotb.SimPhase.READ_ONLY:
+        if simulator.get_sim_phase() == simulator.SIM_PHASE_READ_ONLY:
             raise RuntimeError(
                 "Attempted illegal transition: awaiting ReadWrite in ReadOnly phase"
             )
@@ -400,30 +461,17 @@ class Edge(_EdgeBase):
         return signal
 
 
-class _Event(Trigger):
+class _Event(simulator.WaitTrigger, Trigger):
     """Unique instance used by the Event object.
 
-    One created for each attempt to wait on the event so that the scheduler
-    can maintain a unique mapping of triggers to tasks.
+    One is shared by all tasks waiting on the event, they are attached to its
+    native wait list and woken up together when the event is set.
     """
 
     def __init__(self, parent: "Event") -> None:
         super().__init__()
         self._parent = parent
 
-    def _prime(self, callback: Callable[[Trigger], None]) -> None:
-        if self._primed:
-            return
-        self._callback = callback
-        self._parent._prime_trigger(self, callback)
-        return super()._prime(callback)
-
-    def _unprime(self) -> None:
-        if not self._primed:
-            return
-        self._parent._unprime_trigger(self)
-        return super()._unprime()
-
     def __repr__(self) -> str:
         return f"<{self._parent!r}.wait() at {_pointer_str(self)}>"
 
@@ -461,19 +509,11 @@ class Event:
     """
 
     def __init__(self, name: Optional[str] = None) -> None:
-        self._pending_events: List[_Event] = []
+        self._trigger = _Event(self)
         self.name: Optional[str] = name
         self._fired: bool = False
         self._data: Any = None
 
-    def _prime_trigger(
-        self, trigger: _Event, callback: Callable[[Trigger], None]
-    ) -> None:
-        self._pending_events.append(trigger)
-
-    def _unprime_trigger(self, trigger: _Event) -> None:
-        self._pending_events.remove(trigger)
-
     def set(self, data: Optional[Any] = None) -> None:
         """Set the Event and unblock all Tasks blocked on this Event."""
         self._fired = True
@@ -484,9 +524,7 @@ class Event:
             )
         self._data = data
 
-        pending_events, self._pending_events = self._pending_events, []
-        for event in pending_events:
-            event._callback(event)
+        self._trigger.fire()
 
     def wait(self) -> Trigger:
         """Block the current Task until the Event is set.
@@ -499,7 +537,7 @@ class Event:
         """
         if self._fired:
             return NullTrigger(name=f"{str(self)}.wait()")
-        return _Event(self)
+        return self._trigger
 
     def clear(self) -> None:
         """Clear this event that has been set.
@@ -521,6 +559,111 @@ class Event:
         return fmt.format(type(self).__qualname__, self.name, _pointer_str(self))
 
 
+class _Lock(simulator.WaitTrigger, Trigger):
+    """Unique instance used by the Lock object.
+
+    One created for each attempt to acquire the Lock so that the Lock can be
+    handed over to the waiting tasks one at a time, in order.
+    """
+
+    def __init__(self, parent: "Lock") -> None:
+        super().__init__()
+        self._parent = parent
+
+    def _unprime(self) -> None:
+        # the waiting task was killed, don't hand the Lock over to it
+        self._parent._unprime_trigger(self)
+        return super()._unprime()
+
+    def __repr__(self) -> str:
+        return f"<{self._parent!r}.acquire() at {_pointer_str(self)}>"
+
+
+class Lock(AsyncContextManager["Lock"]):
+    """A mutual exclusion lock.
+
+    Guarantees fair scheduling.
+    Lock acquisition is given in order of attempted lock acquisition.
+
+    Args:
+        name: Name for the Lock.
+
+    Usage:
+        By directly calling :meth:`acquire` and :meth:`release`.
+
+        .. code-block:: python3
+
+            await lock.acquire()
+            try:
+                # do some stuff
+                pass
+            finally:
+                lock.release()
+
+        Or...
+
+        .. code-block:: python3
+
+            async with lock:
+                # do some stuff
+                pass
+    """
+
+    def __init__(self, name: Optional[str] = None) -> None:
+        self._pending_primed: Deque[_Lock] = deque()
+        self.name: Optional[str] = name
+        self._locked: bool = False
+
+    def locked(self) -> bool:
+        """Return ``True`` if the lock has been acquired."""
+        return self._locked
+
+    def _unprime_trigger(self, trigger: _Lock) -> None:
+        try:
+            self._pending_primed.remove(trigger)
+        except ValueError:
+            pass
+
+    def acquire(self) -> Trigger:
+        """Produce a trigger which fires when the lock is acquired."""
+        if not self._locked:
+            self._locked = True
+            return NullTrigger(name=f"{str(self)}.acquire()")
+        trigger = _Lock(self)
+        self._pending_primed.append(trigger)
+        return trigger
+
+    def release(self) -> None:
+        """Release the lock."""
+        if not self._locked:
+            raise RuntimeError(f"Lock {self} is not acquired")
+
+        # hand the lock over to the next task still waiting on it
+        while self._pending_primed:
+            if self._pending_primed.popleft().fire():
+                return
+        self._locked = False
+
+    def __repr__(self) -> str:
+        if self.name is None:
+            fmt = "<{0} [{2} waiting] at {3}>"
+        else:
+            fmt = "<{0} for {1} [{2} waiting] at {3}>"
+        return fmt.format(
+            type(self).__qualname__,
+            self.name,
+            len(self._pending_primed),
+            _pointer_str(self),
+        )
+
+    async def __aenter__(self) -> "Lock":
+        await self.acquire()
+        return self
+
+    async def __aexit__(self, *args: Any) -> None:
+        self.release()
+
+
 class NullTrigger(Trigger):
     """Fires immediately.
 
@@ -120,3 +120,4 @@ class ArrayLike(ABC, Generic[T]):
 from .array import Array  # noqa: E402 F401
 from .logic import Logic  # noqa: E402 F401
 from .logic_array import LogicArray  # noqa: E402 F401
+from .packed_layout import PackedLayout  # noqa: E402 F401
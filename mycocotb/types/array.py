@@ -1,8 +1,20 @@
 # Copyright cocotb contributors
 # Licensed under the Revised BSD License, see LICENSE for details.
 # SPDX-License-Identifier: BSD-3-Clause
-from typing import Iterable, Iterator, TypeVar, Union, cast, overload
-
+from itertools import islice
+from typing import (
+    Any,
+    Iterable,
+    Iterator,
+    List,
+    Optional,
+    TypeVar,
+    Union,
+    cast,
+    overload,
+)
+
+from mycocotb import simulator
 from mycocotb.types import ArrayLike
 from mycocotb.types.range import Range
 
@@ -23,6 +35,10 @@ class Array(ArrayLike[T]):
     acts as shorthand for ``Range(0, "to", width-1)``.
 
     Initial values are treated as iterables, which are copied into an internal buffer.
+    Arrays of :class:`~cocotb.types.LogicArray` read from the simulator keep their elements
+    as integers in one contiguous buffer instead (see :class:`~mycocotb.simulator.WordArray`);
+    the elements are created when they are accessed,
+    and :func:`numpy.asarray` can use the buffer without copying it.
 
     .. code-block:: python3
 
@@ -44,6 +60,8 @@ class Array(ArrayLike[T]):
     which is commonly seen in HDLs.
     Like :class:`list`\ s, if a start or stop index is not specified, it is inferred as the start or end of the array.
     Slicing an array returns a new :class:`~cocotb.types.Array` object, whose bounds are the slice indexes.
+    The slice shares the elements of the original array until either of them is modified,
+    so taking a slice does not copy the elements.
 
     .. code-block:: python3
 
@@ -143,7 +161,16 @@ class Array(ArrayLike[T]):
         range: Union[Range, int, None] = None,
         width: Union[int, None] = None,
     ) -> None:
-        self._value = list(value)
+        # 切片和原数组共享同一个_value，切片从_offset开始。
+        # _shared为True时_value可能被别的Array引用，修改之前先复制一份。
+        # _exported为True时有可写的numpy数组引用着_value，切片不能再共享它
+        if isinstance(value, simulator.WordArray):
+            self._value: Any = value[:]
+        else:
+            self._value = list(value)
+        self._offset = 0
+        self._shared = False
+        self._exported = False
         if width is not None:
             if range is not None:
                 raise TypeError("Only provide argument to one of 'range' or 'width'")
@@ -163,6 +190,17 @@ class Array(ArrayLike[T]):
                 f"Value of length {len(self._value)!r} does not fit in {self._range!r}"
             )
 
+    @classmethod
+    def _from_words(cls, words: "simulator.WordArray", range: Range) -> "Array[Any]":
+        """Make an array using *words* as its storage, without copying them."""
+        self = cast(Array[Any], object.__new__(cls))
+        self._value = words
+        self._offset = 0
+        self._shared = False
+        self._exported = False
+        self._range = range
+        return self
+
     @property
     def range(self) -> Range:
         """:class:`Range` of the indexes of the array."""
@@ -179,18 +217,47 @@ class Array(ArrayLike[T]):
             )
         self._range = new_range
 
+    def _is_whole(self) -> bool:
+        return self._offset == 0 and len(self._value) == len(self._range)
+
+    def _values(self) -> List[T]:
+        """The elements as a list, which must not be modified."""
+        if self._is_whole():
+            return self._value
+        return self._value[self._offset : self._offset + len(self._range)]
+
+    def _own(self) -> None:
+        """Copy the shared elements before modifying them."""
+        if self._shared:
+            self._value = self._value[self._offset : self._offset + len(self._range)]
+            self._offset = 0
+            self._shared = False
+
+    def _store(self, key: Union[int, slice], value: Any) -> None:
+        self._own()
+        try:
+            self._value[key] = value
+        except (TypeError, ValueError):
+            if isinstance(self._value, list):
+                raise
+            # WordArray放不下的值，改用list存放所有元素
+            self._value = list(self._value)
+            self._value[key] = value
+
     def __iter__(self) -> Iterator[T]:
-        return iter(self._value)
+        if self._is_whole():
+            return iter(self._value)
+        return islice(self._value, self._offset, self._offset + len(self._range))
 
     def __reversed__(self) -> Iterator[T]:
-        return reversed(self._value)
+        return reversed(self._values())
 
     def __contains__(self, item: object) -> bool:
-        return item in self._value
+        return item in self._values()
 
     def __eq__(self, other: object) -> bool:
         if isinstance(other, Array):
-            return self._value == other._value
+            return self._values() == other._values()
         elif isinstance(other, (list, tuple)):
             return self == Array(other)
         else:
@@ -205,7 +272,7 @@ class Array(ArrayLike[T]):
     def __getitem__(self, item: Union[int, slice]) -> Union[T, "Array[T]"]:
         if isinstance(item, int):
             idx = self._translate_index(item)
-            return self._value[idx]
+            return self._value[self._offset + idx]
         elif isinstance(item, slice):
             start = item.start if item.start is not None else self.left
             stop = item.stop if item.stop is not None else self.right
@@ -217,9 +284,20 @@ class Array(ArrayLike[T]):
                 raise IndexError(
                     f"slice [{start}:{stop}] direction does not match array direction [{self.left}:{self.right}]"
                 )
-            value = self._value[start_i : stop_i + 1]
-            range = Range(start, self.direction, stop)
-            return Array(value=value, range=range)
+            view = cast(Array[T], object.__new__(Array))
+            view._range = Range(start, self.direction, stop)
+            view._exported = False
+            if self._exported:
+                view._value = self._value[
+                    self._offset + start_i : self._offset + stop_i + 1
+                ]
+                view._offset = 0
+                view._shared = False
+            else:
+                view._value = self._value
+                view._offset = self._offset + start_i
+                view._shared = self._shared = True
+            return view
         raise TypeError(f"indexes must be ints or slices, not {type(item).__name__}")
 
     @overload
@@ -233,7 +311,7 @@ class Array(ArrayLike[T]):
     ) -> None:
         if isinstance(item, int):
             idx = self._translate_index(item)
-            self._value[idx] = cast(T, value)
+            self._store(idx, value)
         elif isinstance(item, slice):
             start = item.start if item.start is not None else self.left
             stop = item.stop if item.stop is not None else self.right
@@ -250,14 +328,42 @@ class Array(ArrayLike[T]):
                 raise ValueError(
                     f"value of length {len(value)!r} will not fit in slice [{start}:{stop}]"
                 )
-            self._value[start_i : stop_i + 1] = value
+            self._store(slice(start_i, stop_i + 1), value)
         else:
             raise TypeError(
                 f"indexes must be ints or slices, not {type(item).__name__}"
             )
 
+    def __array__(self, dtype: Any = None, copy: Optional[bool] = None) -> Any:
+        """Convert to a :mod:`numpy` array.
+
+        An array stored in a :class:`~mycocotb.simulator.WordArray` becomes an array of
+        ``uint32`` or ``uint64`` sharing its buffer, which is read-only while the buffer is
+        shared with a slice. Slices taken after a writable array was returned get a copy
+        of their elements. Any other array becomes an array of its elements.
+
+        Raises:
+            ValueError: If an element stored in a WordArray has ``X`` or ``Z`` bits.
+        """
+        import numpy
+
+        if not isinstance(self._value, simulator.WordArray):
+            return numpy.array(self._values(), dtype=dtype)
+        stop = self._offset + len(self._range)
+        mask = self._value.mask
+        if mask is not None and any(memoryview(mask)[self._offset : stop]):
+            raise ValueError("Array holds X or Z values")
+        values = memoryview(self._value)[self._offset : stop]
+        if copy:
+            return numpy.array(values, dtype=dtype)
+        if self._shared:
+            values = values.toreadonly()
+        else:
+            self._exported = True
+        return numpy.asarray(values, dtype=dtype)
+
     def __repr__(self) -> str:
-        return f"{type(self).__name__}({self._value!r}, {self._range!r})"
+        return f"{type(self).__name__}({self._values()!r}, {self._range!r})"
 
     def _translate_index(self, item: int) -> int:
         try:
@@ -1,8 +1,9 @@
 # Copyright cocotb contributors
 # Licensed under the Revised BSD License, see LICENSE for details.
 # SPDX-License-Identifier: BSD-3-Clause
-from functools import lru_cache
-from typing import Dict, Optional, Set, Type, Union
+from typing import Dict, Set, Union
+
+from mycocotb import simulator
 
 LogicLiteralT = Union[str, int, bool]
 LogicConstructibleT = Union[LogicLiteralT, "Logic"]
@@ -50,7 +51,7 @@ _literal_repr: Dict[LogicLiteralT, int] = {
 _str_literals: Set[str] = {k for k in _literal_repr.keys() if isinstance(k, str)}
 
 
-class Logic:
+class Logic(simulator.LogicBase):
     r"""
     Model of a 9-value (``U``, ``X``, ``0``, ``1``, ``Z``, ``W``, ``L``, ``H``, ``-``) datatype commonly seen in VHDL.
 
@@ -108,142 +109,8 @@ class Logic:
         TypeError: If the value is of a type that can't be constructed into a :class:`Logic`.
     """
 
-    _repr: int
+    # The nine values are interned by simulator.LogicBase, which also implements
+    # construction, the operators and the conversions with lookup tables.
+    __slots__ = ()
 
-    @classmethod
-    @lru_cache(maxsize=None)
-    def _get_object(cls: Type["Logic"], _repr: int) -> "Logic":
-        """Return the Logic object associated with the repr, enforcing singleton."""
-        self = object.__new__(cls)
-        self._repr = _repr
-        return self
-
-    @classmethod
-    @lru_cache(maxsize=None)
-    def _map_literal(
-        cls: Type["Logic"],
-        value: Optional[LogicLiteralT] = None,
-    ) -> "Logic":
-        """Convert and cache all literals."""
-        if value is None:
-            _repr = _X
-        else:
-            # convert literal
-            try:
-                _repr = _literal_repr[value]
-            except KeyError:
-                raise ValueError(
-                    f"{value!r} is not convertible to a {cls.__qualname__}"
-                ) from None
-        obj = cls._get_object(_repr)
-        return obj
-
-    def __new__(
-        cls: Type["Logic"],
-        value: Optional[LogicConstructibleT] = None,
-    ) -> "Logic":
-        if isinstance(value, Logic):
-            return value
-        elif value is not None and not isinstance(value, (str, int)):
-            raise TypeError(
-                f"Expected str, bool, or int, not {type(value).__qualname__}"
-            )
-        return cls._map_literal(value)
-
-    def __and__(self, other: "Logic") -> "Logic":
-        if not isinstance(other, Logic):
-            return NotImplemented
-        return Logic(
-            (
-                # -----------------------------------------------------
-                # U    X    0    1    Z    W    L    H    -       |   |
-                # -----------------------------------------------------
-                ("U", "U", "0", "U", "U", "U", "0", "U", "U"),  # | U |
-                ("U", "X", "0", "X", "X", "X", "0", "X", "X"),  # | X |
-                ("0", "0", "0", "0", "0", "0", "0", "0", "0"),  # | 0 |
-                ("U", "X", "0", "1", "X", "X", "0", "1", "X"),  # | 1 |
-                ("U", "X", "0", "X", "X", "X", "0", "X", "X"),  # | Z |
-                ("U", "X", "0", "X", "X", "X", "0", "X", "X"),  # | W |
-                ("0", "0", "0", "0", "0", "0", "0", "0", "0"),  # | L |
-                ("U", "X", "0", "1", "X", "X", "0", "1", "X"),  # | H |
-                ("U", "X", "0", "X", "X", "X", "0", "X", "X"),  # | - |
-            )[self._repr][other._repr]
-        )
-
-    def __or__(self: "Logic", other: "Logic") -> "Logic":
-        if not isinstance(other, Logic):
-            return NotImplemented
-        return Logic(
-            (
-                # -----------------------------------------------------
-                # U    X    0    1    Z    W    L    H    -       |   |
-                # -----------------------------------------------------
-                ("U", "U", "U", "1", "U", "U", "U", "1", "U"),  # | U |
-                ("U", "X", "X", "1", "X", "X", "X", "1", "X"),  # | X |
-                ("U", "X", "0", "1", "X", "X", "0", "1", "X"),  # | 0 |
-                ("1", "1", "1", "1", "1", "1", "1", "1", "1"),  # | 1 |
-                ("U", "X", "X", "1", "X", "X", "X", "1", "X"),  # | Z |
-                ("U", "X", "X", "1", "X", "X", "X", "1", "X"),  # | W |
-                ("U", "X", "0", "1", "X", "X", "0", "1", "X"),  # | L |
-                ("1", "1", "1", "1", "1", "1", "1", "1", "1"),  # | H |
-                ("U", "X", "X", "1", "X", "X", "X", "1", "X"),  # | - |
-            )[self._repr][other._repr]
-        )
-
-    def __xor__(self: "Logic", other: "Logic") -> "Logic":
-        if not isinstance(other, Logic):
-            return NotImplemented
-        return Logic(
-            (
-                # -----------------------------------------------------
-                # U    X    0    1    Z    W    L    H    -       |   |
-                # -----------------------------------------------------
-                ("U", "U", "U", "U", "U", "U", "U", "U", "U"),  # | U |
-                ("U", "X", "X", "X", "X", "X", "X", "X", "X"),  # | X |
-                ("U", "X", "0", "1", "X", "X", "0", "1", "X"),  # | 0 |
-                ("U", "X", "1", "0", "X", "X", "1", "0", "X"),  # | 1 |
-                ("U", "X", "X", "X", "X", "X", "X", "X", "X"),  # | Z |
-                ("U", "X", "X", "X", "X", "X", "X", "X", "X"),  # | W |
-                ("U", "X", "0", "1", "X", "X", "0", "1", "X"),  # | L |
-                ("U", "X", "1", "0", "X", "X", "1", "0", "X"),  # | H |
-                ("U", "X", "X", "X", "X", "X", "X", "X", "X"),  # | - |
-            )[self._repr][other._repr]
-        )
-
-    def __invert__(self: "Logic") -> "Logic":
-        return Logic(("U", "X", "1", "0", "X", "X", "1", "0", "X")[self._repr])
-
-    def __eq__(self, other: object) -> bool:
-        if isinstance(other, Logic):
-            return self is other
-        elif isinstance(other, (int, str, bool)):
-            try:
-                other = Logic(other)
-            except ValueError:
-                return False
-            return self == other
-        else:
-            return NotImplemented
-
-    def __repr__(self) -> str:
-        return f"{type(self).__qualname__}({str(self)!r})"
-
-    def __str__(self) -> str:
-        return ("U", "X", "0", "1", "Z", "W", "L", "H", "-")[self._repr]
-
-    def __bool__(self) -> bool:
-        if self._repr == _0:
-            return False
-        elif self._repr == _1:
-            return True
-        raise ValueError(f"Cannot convert {self!r} to bool")
-
-    def __int__(self) -> int:
-        if self._repr == _0:
-            return 0
-        elif self._repr == _1:
-            return 1
-        raise ValueError(f"Cannot convert {self!r} to int")
-
-    def __index__(self) -> int:
-        return int(self)
+    _repr: int
@@ -9,15 +9,15 @@ from typing import (
     TYPE_CHECKING,
     Iterable,
     Iterator,
-    List,
     Union,
     cast,
     overload,
 )
 
 from enum import Enum
+from mycocotb import simulator
 from mycocotb.types import ArrayLike
-from mycocotb.types.logic import Logic, LogicConstructibleT, _str_literals
+from mycocotb.types.logic import Logic, LogicConstructibleT
 from mycocotb.types.range import Range
 
 if TYPE_CHECKING:  # pragma: no cover
@@ -89,7 +89,7 @@ _resolve_tables = {
 }
 
 
-class LogicArray(ArrayLike[Logic]):
+class LogicArray(simulator.LogicArrayBase, ArrayLike[Logic]):
     r"""Fixed-sized, arbitrarily-indexed, array of :class:`cocotb.types.Logic`.
 
     .. currentmodule:: cocotb.types
@@ -226,14 +226,8 @@ class LogicArray(ArrayLike[Logic]):
         TypeError: When invalid argument types are used.
     """
 
-    # These three attribute contain the current value of the array in one or more of
-    # three different implementations. This is done for performance reasons, as certain
-    # implementations are faster for particular operations.
-    # Each implementation can be present, or None if the implementation has not been
-    # computed or has been invalidated by a mutating operation.
-    _value_as_array: Union[List[Logic], None]
-    _value_as_int: Union[int, None]
-    _value_as_str: Union[str, None]
+    # The value is stored by simulator.LogicArrayBase as 4-state bit planes with the
+    # layout of s_vpi_vecval, so it is copied to and from the simulator as is.
     _range: Range
 
     @overload
@@ -338,22 +332,17 @@ class LogicArray(ArrayLike[Logic]):
         *,
         width: Union[int, None] = None,
     ) -> None:
-        self._value_as_array = None
-        self._value_as_int = None
-        self._value_as_str = None
         range = _make_range(range, width)
         if isinstance(value, str):
-            if not (set(value) <= _str_literals):
-                raise ValueError("Invalid str literal")
-            self._value_as_str = value.upper()
+            self._set_str(value)
             if range is not None:
                 if len(value) != len(range):
                     raise OverflowError(
-                        f"Value of length {len(self._value_as_str)} will not fit in {range}"
+                        f"Value of length {len(value)} will not fit in {range}"
                     )
                 self._range = range
             else:
-                self._range = Range(len(self._value_as_str) - 1, "downto", 0)
+                self._range = Range(len(value) - 1, "downto", 0)
         elif isinstance(value, int):
             if value < 0:
                 raise ValueError("Invalid int literal")
@@ -364,61 +353,45 @@ class LogicArray(ArrayLike[Logic]):
                 raise OverflowError(
                     f"{value!r} will not fit in a LogicArray with bounds: {range!r}."
                 )
-            self._value_as_int = value
+            self._set_int(value, len(range))
             self._range = range
         elif value is None:
             if range is None:
                 raise TypeError("Missing required arguments: 'range' or 'width'")
-            self._value_as_str = "X" * len(range)
+            self._set_str("X" * len(range))
             self._range = range
         else:
-            self._value_as_array = [Logic(v) for v in value]
+            self._set_logics([Logic(v) for v in value])
             if range is not None:
-                if len(self._value_as_array) != len(range):
+                if len(self) != len(range):
                     raise OverflowError(
-                        f"Value of length {len(self._value_as_array)} will not fit in {range}"
+                        f"Value of length {len(self)} will not fit in {range}"
                     )
                 self._range = range
             else:
-                self._range = Range(len(self._value_as_array) - 1, "downto", 0)
-
-    def _get_array(self) -> List[Logic]:
-        if self._value_as_array is None:
-            # May convert int to str before to converting to array.
-            self._value_as_array = [Logic(v) for v in self._get_str()]
-        return self._value_as_array
-
-    def _get_str(self) -> str:
-        if self._value_as_str is None:
-            if self._value_as_int is not None:
-                self._value_as_str = format(self._value_as_int, f"0{len(self)}b")
-            else:
-                self._value_as_str = "".join(
-                    str(v) for v in cast(List[Logic], self._value_as_array)
-                )
-        return self._value_as_str
+                self._range = Range(len(self) - 1, "downto", 0)
 
     def _get_int(
         self,
         resolve: "ResolveX | Literal['error'] | Literal['zeros'] | Literal['ones'] | Literal['random'] | None",
+        signed: bool = False,
     ) -> int:
-        if self._value_as_int is None:
-            # May convert list to str before converting to int.
-            value_as_str = self._get_str()
-            # resolve L and H to 0 and 1
-            value_as_str = value_as_str.translate(_resolve_lh_table)
-            try:
-                self._value_as_int = int(value_as_str, 2)
-            except ValueError:
-                # value needs resolving
-                if resolve is None:
-                    resolve = RESOLVE_X
-
-                resolve_table = _resolve_tables[resolve]
-                value_as_str = value_as_str.translate(resolve_table)
-                return int(value_as_str, 2)
-
-        return self._value_as_int
+        # L and H are stored as 0 and 1, anything else that is not 0 or 1 needs resolving
+        value = self._to_int(0, signed)
+        if value is not None:
+            return value
+        if resolve is None:
+            resolve = RESOLVE_X
+        resolve = ResolveX(resolve)
+        if resolve is ResolveX.ZEROS:
+            return self._to_int(1, signed)
+        elif resolve is ResolveX.ONES:
+            return self._to_int(2, signed)
+        value_as_str = self._get_str().translate(_resolve_lh_table)
+        value = int(value_as_str.translate(_resolve_tables[resolve.value]), 2)
+        if signed and value >= (1 << (len(self) - 1)):
+            value -= 1 << len(self)
+        return value
 
     @overload
     @classmethod
@@ -573,19 +546,19 @@ class LogicArray(ArrayLike[Logic]):
             raise OverflowError(
                 f"Value of length {len(value)} will not fit in a LogicArray with bounds: {range!r}"
             )
-        return cls.from_unsigned(
-            int.from_bytes(value, byteorder=byteorder, signed=False), range
-        )
+        if byteorder not in ("big", "little"):
+            raise ValueError("byteorder must be either 'little' or 'big'")
+        self = super().__new__(cls)
+        self._set_bytes(value, byteorder == "big")
+        self._range = range
+        return self
 
     @classmethod
     def _from_handle(cls, value: str) -> "LogicArray":
         # Used by cocotb.handle classes to make LogicArray from values gotten from the
         # simulator which we expect to be well-formed.
-        # Values are required to be uppercase.
         self = super().__new__(cls)
-        self._value_as_array = None
-        self._value_as_int = None
-        self._value_as_str = value
+        self._set_str(value)
         self._range = Range(len(value) - 1, "downto", 0)
         return self
 
@@ -626,36 +599,7 @@ class LogicArray(ArrayLike[Logic]):
         elif isinstance(other, str):
             return str(self) == other.upper()
         elif isinstance(other, LogicArray):
-            if len(self) != len(other):
-                return False
-            # Complex, but efficient chain of checking logic.
-            # Avoid conversions if it can help it at first.
-            # Prefers checking against str vs any type since that is going to be the
-            #   most common type and also the "middle" type for conversions.
-            # Always converts away from ints to prevent issues with non-0/1 data.
-            if self._value_as_str is not None and other._value_as_str is not None:
-                # (STR, STR)
-                return self._value_as_str == other._value_as_str
-            elif self._value_as_array is not None and other._value_as_array is not None:
-                # (ARRAY, ARRAY)
-                return self._value_as_array == other._value_as_array
-            elif self._value_as_int is not None and other._value_as_int is not None:
-                # (INT, INT)
-                return self._value_as_int == other._value_as_int
-            elif self._value_as_str is not None:
-                # (STR, INT)
-                # (STR, ARRAY)
-                return self._value_as_str == other._get_str()
-            elif other._value_as_str is not None:
-                # (INT, STR)
-                # (ARRAY, STR)
-                return self._get_str() == other._value_as_str
-            elif self._value_as_array is not None:
-                # (ARRAY, INT)
-                return self._value_as_array == other._get_array()
-            else:
-                # (INT, ARRAY)
-                return self._get_array() == other._value_as_array
+            return self._same_value(other)
         elif isinstance(other, (list, tuple)):
             try:
                 other = LogicArray(other)
@@ -665,11 +609,6 @@ class LogicArray(ArrayLike[Logic]):
         else:
             return NotImplemented
 
-    @property
-    def is_resolvable(self) -> bool:
-        """``True`` if all elements are ``0`` or ``1``."""
-        return all(bit in (Logic(0), Logic(1)) for bit in self)
-
     def to_unsigned(
         self,
         resolve: "ResolveX | Literal['error'] | Literal['zeros'] | Literal['ones'] | Literal['random'] | None" = None,
@@ -716,10 +655,7 @@ class LogicArray(ArrayLike[Logic]):
         if len(self) == 0:
             warnings.warn("Converting a LogicArray of length 0 to integer")
             return 0
-        value = self._get_int(resolve)
-        if value >= (1 << (len(self) - 1)):
-            value -= 1 << len(self)
-        return value
+        return self._get_int(resolve, signed=True)
 
     def to_bytes(
         self,
@@ -737,6 +673,12 @@ class LogicArray(ArrayLike[Logic]):
         Returns:
             :class:`bytes` equivalent to the value.
         """
+        if byteorder not in ("big", "little"):
+            raise ValueError("byteorder must be either 'little' or 'big'")
+        if len(self) != 0:
+            value = self._to_bytes(byteorder == "big")
+            if value is not None:
+                return value
         return self.to_unsigned().to_bytes(ceil(len(self) / 8), byteorder=byteorder)
 
     @overload
@@ -746,10 +688,8 @@ class LogicArray(ArrayLike[Logic]):
     def __getitem__(self, item: slice) -> "LogicArray": ...
 
     def __getitem__(self, item: Union[int, slice]) -> Union[Logic, "LogicArray"]:
-        array = self._get_array()
         if isinstance(item, int):
-            idx = self._translate_index(item)
-            return array[idx]
+            return self._get_logic(self._translate_index(item))
         elif isinstance(item, slice):
             start = item.start if item.start is not None else self.left
             stop = item.stop if item.stop is not None else self.right
@@ -761,9 +701,9 @@ class LogicArray(ArrayLike[Logic]):
                 raise IndexError(
                     f"slice [{start}:{stop}] direction does not match array direction [{self.left}:{self.right}]"
                 )
-            value = array[start_i : stop_i + 1]
-            range = Range(start, self.direction, stop)
-            return LogicArray(value=value, range=range)
+            value = self._get_slice(start_i, stop_i)
+            value._range = Range(start, self.direction, stop)
+            return value
         raise TypeError(f"indexes must be ints or slices, not {type(item).__name__}")
 
     @overload
@@ -779,13 +719,9 @@ class LogicArray(ArrayLike[Logic]):
         item: Union[int, slice],
         value: Union[LogicConstructibleT, Iterable[LogicConstructibleT]],
     ) -> None:
-        array = self._get_array()
-        # invalid other impls
-        self._value_as_str = None
-        self._value_as_int = None
         if isinstance(item, int):
             idx = self._translate_index(item)
-            array[idx] = Logic(cast(LogicConstructibleT, value))
+            self._set_logic(idx, Logic(cast(LogicConstructibleT, value)))
         elif isinstance(item, slice):
             start = item.start if item.start is not None else self.left
             stop = item.stop if item.stop is not None else self.right
@@ -797,14 +733,15 @@ class LogicArray(ArrayLike[Logic]):
                 raise IndexError(
                     f"slice [{start}:{stop}] direction does not match array direction [{self.left}:{self.right}]"
                 )
-            value_as_logics = [
-                Logic(v) for v in cast(Iterable[LogicConstructibleT], value)
-            ]
-            if len(value_as_logics) != (stop_i - start_i + 1):
+            if not isinstance(value, LogicArray):
+                value = LogicArray(
+                    [Logic(v) for v in cast(Iterable[LogicConstructibleT], value)]
+                )
+            if len(value) != (stop_i - start_i + 1):
                 raise ValueError(
-                    f"value of length {len(value_as_logics)!r} will not fit in slice [{start}:{stop}]"
+                    f"value of length {len(value)!r} will not fit in slice [{start}:{stop}]"
                 )
-            array[start_i : stop_i + 1] = value_as_logics
+            self._set_slice(start_i, value)
         else:
             raise TypeError(
                 f"indexes must be ints or slices, not {type(item).__name__}"
@@ -819,6 +756,10 @@ class LogicArray(ArrayLike[Logic]):
     def __repr__(self) -> str:
         return f"{type(self).__qualname__}({str(self)!r}, {self.range!r})"
 
+    def __reduce__(self) -> object:
+        # the value lives in the native base, so copy and pickle go through the str
+        return (type(self), (self._get_str(), self.range))
+
     def __str__(self) -> str:
         return self._get_str()
 
@@ -837,7 +778,10 @@ class LogicArray(ArrayLike[Logic]):
                 f"between {type(self).__qualname__} of length {len(self)} "
                 f"and {type(other).__qualname__} of length {len(other)}"
             )
-        return LogicArray(a & b for a, b in zip(self, other))
+        result = self._and(other)
+        if result is None:
+            result = LogicArray(a & b for a, b in zip(self, other))
+        return result
 
     def __or__(self, other: "LogicArray") -> "LogicArray":
         if not isinstance(other, LogicArray):
@@ -848,7 +792,10 @@ class LogicArray(ArrayLike[Logic]):
                 f"between {type(self).__qualname__} of length {len(self)} "
                 f"and {type(other).__qualname__} of length {len(other)}"
             )
-        return LogicArray(a | b for a, b in zip(self, other))
+        result = self._or(other)
+        if result is None:
+            result = LogicArray(a | b for a, b in zip(self, other))
+        return result
 
     def __xor__(self, other: "LogicArray") -> "LogicArray":
         if not isinstance(other, LogicArray):
@@ -859,10 +806,16 @@ class LogicArray(ArrayLike[Logic]):
                 f"between {type(self).__qualname__} of length {len(self)} "
                 f"and {type(other).__qualname__} of length {len(other)}"
             )
-        return LogicArray(a ^ b for a, b in zip(self, other))
+        result = self._xor(other)
+        if result is None:
+            result = LogicArray(a ^ b for a, b in zip(self, other))
+        return result
 
     def __invert__(self) -> "LogicArray":
-        return LogicArray(~v for v in self)
+        result = self._invert()
+        if result is None:
+            result = LogicArray(~v for v in self)
+        return result
 
     def __bool__(self) -> bool:
         warnings.warn(
@@ -871,7 +824,7 @@ class LogicArray(ArrayLike[Logic]):
             FutureWarning,
             stacklevel=2,
         )
-        return any(v in (Logic("H"), Logic("1")) for v in self)
+        return self._count_ones() > 0
 
 
 def _make_range(
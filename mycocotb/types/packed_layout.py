@@ -0,0 +1,89 @@
+# Copyright cocotb contributors
+# Licensed under the Revised BSD License, see LICENSE for details.
+# SPDX-License-Identifier: BSD-3-Clause
+from typing import TYPE_CHECKING, Dict, Iterable, Optional, Tuple, Union
+
+from mycocotb import simulator
+
+if TYPE_CHECKING:
+    from mycocotb.types.logic_array import LogicArray
+
+
+class PackedLayout(simulator.PackedLayoutBase):
+    r"""
+    Field layout of a packed structure.
+
+    A packed structure is read and written as a single :class:`~cocotb.types.LogicArray`.
+    The layout gives the name, offset of the least significant bit, width and signedness of every field,
+    so that all fields can be extracted from a value at once and a value can be built from fields at once.
+
+    .. code-block:: python3
+
+        >>> hdr = PackedLayout(16, [("kind", 12, 4), ("len", 0, 12)])
+        >>> hdr.unpack(LogicArray(0x3_00A, 16))
+        {'kind': 3, 'len': 10}
+        >>> hdr.pack({"kind": 1, "len": 5})
+        LogicArray('0001000000000101', Range(15, 'downto', 0))
+
+    Fields containing ``X`` or ``Z`` bits unpack to ``None``.
+    Fields need not cover the whole structure; bits not in any field keep the value of *base* in :meth:`pack`.
+
+    Args:
+        width: Number of bits in the structure.
+        fields: ``(name, offset, width)`` or ``(name, offset, width, signed)`` of every field.
+
+    Raises:
+        ValueError: If a field does not fit in the structure or two fields have the same name.
+    """
+
+    __slots__ = ()
+
+    if TYPE_CHECKING:
+
+        def __new__(
+            cls,
+            width: int,
+            fields: Iterable[
+                Union[Tuple[str, int, int], Tuple[str, int, int, bool]]
+            ],
+        ) -> "PackedLayout": ...
+
+        @property
+        def width(self) -> int: ...
+
+        @property
+        def fields(self) -> Tuple[Tuple[str, int, int, bool], ...]: ...
+
+        def unpack(self, value: LogicArray) -> Dict[str, Optional[int]]: ...
+
+        def pack(
+            self,
+            values: Dict[str, Union[int, LogicArray]],
+            base: Optional[LogicArray] = None,
+        ) -> LogicArray: ...
+
+    @classmethod
+    def from_struct(
+        cls,
+        fields: Iterable[Union[Tuple[str, int], Tuple[str, int, bool]]],
+    ) -> "PackedLayout":
+        """Build a layout from ``(name, width[, signed])`` declared most significant field first.
+
+        This is the order of the members of a SystemVerilog ``struct packed``.
+
+        .. code-block:: python3
+
+            >>> PackedLayout.from_struct([("kind", 4), ("len", 12)]).fields
+            (('kind', 12, 4, False), ('len', 0, 12, False))
+        """
+        decls = list(fields)
+        width = sum(decl[1] for decl in decls)
+        offset = width
+        layout = []
+        for name, field_width, *signed in decls:
+            offset -= field_width
+            layout.append((name, offset, field_width, *signed))
+        return cls(width, layout)
+
+    def __repr__(self) -> str:
+        return f"{type(self).__qualname__}({self.width!r}, {list(self.fields)!r})"
@@ -1,13 +1,12 @@
 # Copyright cocotb contributors
 # Licensed under the Revised BSD License, see LICENSE for details.
 # SPDX-License-Identifier: BSD-3-Clause
-from functools import lru_cache
-from typing import Iterator, Sequence, Union, overload
+from typing import TYPE_CHECKING, Iterator, Sequence, Union, overload
 
-from cocotb._utils import cached_method
+from mycocotb import simulator
 
 
-class Range(Sequence[int]):
+class Range(simulator.RangeBase, Sequence[int]):
     r"""
     Variant of :class:`range` with inclusive right bound.
 
@@ -60,42 +59,61 @@ class Range(Sequence[int]):
 
     The typical use case of this type is in conjunction with :class:`~cocotb.types.Array`.
 
+    Ranges are immutable and hashable, so the same object can be shared by all values
+    which have it. The bounds are stored as integers in the native base type,
+    so indexing, ``in``, :meth:`index` and slicing take constant time.
+
     Args:
         left: leftmost bound of range
         direction: ``'to'`` if values are ascending, ``'downto'`` if descending
         right: rightmost bound of range (inclusive)
     """
 
-    @overload
-    def __init__(self, left: int, direction: int) -> None: ...
-
-    @overload
-    def __init__(self, left: int, direction: str, right: int) -> None: ...
-
-    @overload
-    def __init__(self, left: int, *, right: int) -> None: ...
-
-    def __init__(
-        self,
-        left: int,
-        direction: Union[int, str, None] = None,
-        right: Union[int, None] = None,
-    ) -> None:
-        start = left
-        stop: int
-        step: int
-        if isinstance(direction, int) and right is None:
-            step = _guess_step(left, direction)
-            stop = direction + step
-        elif isinstance(direction, str) and isinstance(right, int):
-            step = _direction_to_step(direction)
-            stop = right + step
-        elif direction is None and isinstance(right, int):
-            step = _guess_step(left, right)
-            stop = right + step
-        else:
-            raise TypeError("invalid arguments")
-        self._range = range(start, stop, step)
+    __slots__ = ()
+
+    if TYPE_CHECKING:  # pragma: no cover
+
+        @overload
+        def __init__(self, left: int, direction: int) -> None: ...
+
+        @overload
+        def __init__(self, left: int, direction: str, right: int) -> None: ...
+
+        @overload
+        def __init__(self, left: int, *, right: int) -> None: ...
+
+        def __init__(
+            self,
+            left: int,
+            direction: Union[int, str, None] = None,
+            right: Union[int, None] = None,
+        ) -> None: ...
+
+        @property
+        def left(self) -> int:
+            """Leftmost value in a Range."""
+
+        @property
+        def direction(self) -> str:
+            """``'to'`` if Range is ascending, ``'downto'`` otherwise."""
+
+        @property
+        def right(self) -> int:
+            """Rightmost value in a Range."""
+
+        def __len__(self) -> int: ...
+
+        @overload
+        def __getitem__(self, item: int) -> int: ...
+
+        @overload
+        def __getitem__(self, item: slice) -> "Range": ...
+
+        def __getitem__(self, item: Union[int, slice]) -> Union[int, "Range"]: ...
+
+        def __contains__(self, item: object) -> bool: ...
+
+        def __iter__(self) -> Iterator[int]: ...
 
     @classmethod
     def from_range(cls, range: range) -> "Range":
@@ -108,80 +126,11 @@ class Range(Sequence[int]):
 
     def to_range(self) -> range:
         """Convert Range to :class:`range`."""
-        return self._range
-
-    @property
-    def left(self) -> int:
-        """Leftmost value in a Range."""
-        return self._range.start
-
-    @property
-    def direction(self) -> str:
-        """``'to'`` if Range is ascending, ``'downto'`` otherwise."""
-        return _step_to_direction(self._range.step)
-
-    @property
-    def right(self) -> int:
-        """Rightmost value in a Range."""
-        return self._range.stop - self._range.step
-
-    def __len__(self) -> int:
-        return len(self._range)
-
-    @overload
-    def __getitem__(self, item: int) -> int:
-        pass  # pragma: no cover
-
-    @overload
-    def __getitem__(self, item: slice) -> "Range":
-        pass  # pragma: no cover
-
-    def __getitem__(self, item: Union[int, slice]) -> Union[int, "Range"]:
-        if isinstance(item, int):
-            return self._range[item]
-        elif isinstance(item, slice):
-            return type(self).from_range(self._range[item])
-        raise TypeError(
-            f"indices must be integers or slices, not {type(item).__name__}"
-        )
-
-    def __contains__(self, item: object) -> bool:
-        return item in self._range
-
-    def __iter__(self) -> Iterator[int]:
-        return iter(self._range)
+        step = 1 if self.direction == "to" else -1
+        return range(self.left, self.right + step, step)
 
     def __reversed__(self) -> Iterator[int]:
-        return reversed(self._range)
-
-    def __eq__(self, other: object) -> bool:
-        if isinstance(other, type(self)):
-            return self._range == other._range
-        return NotImplemented  # must not be in a type narrowing context to be ignored properly
-
-    def __hash__(self) -> int:
-        return hash(self._range)
-
-    def __repr__(self) -> str:
-        return f"{type(self).__qualname__}({self.left!r}, {self.direction!r}, {self.right!r})"
-
-    index = cached_method(Sequence.index)
-
-
-def _guess_step(left: int, right: int) -> int:
-    if left <= right:
-        return 1
-    return -1
-
-
-@lru_cache(maxsize=None)
-def _direction_to_step(direction: str) -> int:
-    direction = direction.lower()
-    if direction == "to":
-        return 1
-    elif direction == "downto":
-        return -1
-    raise ValueError("direction must be 'to' or 'downto'")
+        return reversed(self.to_range())
 
 
 def _step_to_direction(step: int) -> str:
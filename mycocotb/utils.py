@@ -93,7 +93,7 @@ def get_time_from_sim_steps(steps: int, units: str) -> int:
     Returns:
         The simulation time in the specified units.
     """
-    return _ldexp10(steps, _get_simulator_precision() - _get_log_time_scale(units))
+    return simulator.get_time_from_sim_steps(steps, units)
 
 
 def get_sim_steps(
@@ -131,6 +131,12 @@ def get_sim_steps(
     .. versionchanged:: 1.6
         Support rounding modes.
     """
+    # int and float are converted natively with precomputed integer factors,
+    # only Fraction, Decimal and other exact types go through the code below
+    steps = simulator.get_sim_steps(time, units, round_mode)
+    if steps is not NotImplemented:
+        return steps
+
     result: Union[float, Fraction, Decimal]
     if units != "step":
         result = _ldexp10(time, _get_log_time_scale(units) - _get_simulator_precision())
@@ -7,7 +7,11 @@ python_include = sysconfig.get_paths()['include']
 # 定义扩展模块
 simulator_module = Extension(
     'simulator',
-    sources=['simulatormodule.cpp'],
+    sources=['simulatormodule.cpp', 'SchedulerCore.cpp', 'TaskObject.cpp',
+             'TimeUnits.cpp', 'ThreadBridge.cpp', 'LogicArrayObject.cpp',
+             'LogicKernels.cpp', 'LogicObject.cpp', 'WordArrayObject.cpp',
+             'RangeObject.cpp', 'PackedLayoutObject.cpp', 'ValueMonitor.cpp',
+             'TaskProfiler.cpp'],
     include_dirs=[python_include, "/usr/include/iverilog/"],
     # 实际上这个库是有对myvpi.vpl有外部符号依赖的，但因为它总是先于本库被加载，所以可以不写
     libraries=[],
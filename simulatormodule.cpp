@@ -15,38 +15,29 @@
  #include <limits>
  #include <type_traits>
  
+ #include "GpiHistogram.h"
+ #include "GpiMeter.h"
+ #include "GpiTrace.h"
+ #include "LogicArrayObject.h"
+ #include "LogicObject.h"
+ #include "PackedLayoutObject.h"
+ #include "PythonCallback.h"
+ #include "RangeObject.h"
+ #include "SchedulerCore.h"
+ #include "TaskObject.h"
+ #include "TaskProfiler.h"
+ #include "ThreadBridge.h"
+ #include "TimeUnits.h"
+ #include "ValueMonitor.h"
  #include "VpiImpl.h"
+ #include "WordArrayObject.h"
 
  PyObject *pEventFn = NULL;
  
  // This file defines the routines available to Python
  
- #define COCOTB_ACTIVE_ID \
-     0xC0C07B  // User data flag to indicate callback is active
- #define COCOTB_INACTIVE_ID \
-     0xDEADB175  // User data flag set when callback has been de-registered
- 
  #define MODULE_NAME "simulator"
  
- // callback user data
- struct PythonCallback {
-     PythonCallback(PyObject *func, PyObject *_args, PyObject *_kwargs)
-         : function(func), args(_args), kwargs(_kwargs) {
-         // All PyObject references are stolen.
-         // Arguments may be NULL.
-     }
-     ~PythonCallback() {
-         Py_XDECREF(function);
-         Py_XDECREF(args);
-         Py_XDECREF(kwargs);
-     }
-     uint32_t id_value =
-         COCOTB_ACTIVE_ID;  // COCOTB_ACTIVE_ID or COCOTB_INACTIVE_ID
-     PyObject *function;    // Function to call when the callback fires
-     PyObject *args;        // The arguments to call the function with
-     PyObject *kwargs;      // Keyword arguments to call the function with
- };
- 
  class GpiClock;
  using gpi_clk_hdl = GpiClock *;
  
@@ -78,6 +69,20 @@
      return ret;
  }
  
+ // gpi_live_objects里每种Python句柄对象的种类
+ static gpi_obj_kind_e py_hdl_kind(gpi_sim_hdl) { return GPI_OBJ_PY_SIM_HDL; }
+ static gpi_obj_kind_e py_hdl_kind(gpi_iterator_hdl) {
+     return GPI_OBJ_PY_ITERATOR_HDL;
+ }
+ static gpi_obj_kind_e py_hdl_kind(gpi_cb_hdl) { return GPI_OBJ_PY_CB_HDL; }
+ 
+ // 只有信号的句柄按路径计数，用于泄漏报告
+ static void track_py_handle(gpi_sim_hdl hdl, int delta) {
+     gpi_track_py_handle(hdl, delta);
+ }
+ template <typename gpi_hdl>
+ static void track_py_handle(gpi_hdl, int) {}
+ 
  /**
   * Create a new python handle object from a pointer, returning None if the
   * pointer is NULL.
@@ -93,9 +98,18 @@
          return NULL;
      }
      obj->hdl = hdl;
+     ++gpi_live_objects.created[py_hdl_kind(hdl)];
+     track_py_handle(hdl, 1);
      return (PyObject *)obj;
  }
  
+ template <typename gpi_hdl>
+ static void gpi_hdl_dealloc(gpi_hdl_Object<gpi_hdl> *self) {
+     ++gpi_live_objects.freed[py_hdl_kind(self->hdl)];
+     track_py_handle(self->hdl, -1);
+     PyObject_Free(self);
+ }
+ 
  /** Comparison checks if the types match, and then compares pointers */
  template <typename gpi_hdl>
  static PyObject *gpi_hdl_richcompare(PyObject *self, PyObject *other, int op) {
@@ -123,6 +137,7 @@
      PyTypeObject type = {};
      type.ob_base = {PyObject_HEAD_INIT(NULL) 0};
      type.tp_basicsize = sizeof(gpi_hdl_Object<gpi_hdl>);
+     type.tp_dealloc = (destructor)gpi_hdl_dealloc<gpi_hdl>;
      type.tp_repr = (reprfunc)gpi_hdl_repr<gpi_hdl>;
      type.tp_hash = (hashfunc)gpi_hdl_hash<gpi_hdl>;
      type.tp_flags = Py_TPFLAGS_DEFAULT;
@@ -146,6 +161,22 @@
      uint32_t low;
  };
  
+ int current_sim_phase = SIM_PHASE_NORMAL;
+ 
+ // trace里Python这一段的名字：回调等待的trigger的repr
+ static std::string trace_trigger_name(PythonCallback *cb_data) {
+     if (cb_data->args == NULL || !PyTuple_Check(cb_data->args) ||
+         PyTuple_GET_SIZE(cb_data->args) == 0) {
+         return "python";
+     }
+     PyObject *repr = PyObject_Repr(PyTuple_GET_ITEM(cb_data->args, 0));
+     const char *name = repr ? PyUnicode_AsUTF8(repr) : NULL;
+     std::string result = name ? name : "python";
+     Py_XDECREF(repr);
+     PyErr_Clear();
+     return result;
+ }
+ 
  /**
   * @name    Callback Handling
   * @brief   Handle a callback coming from GPI
@@ -165,13 +196,22 @@
      to_python();
      DEFER(to_simulator());
  
+     uint64_t trace_start = gpi_trace_enabled ? gpi_trace_clock() : 0;
+     uint64_t hist_start = gpi_hist_enabled ? gpi_hist_clock() : 0;
+     uint64_t meter_start = gpi_meter_enabled ? gpi_meter_clock() : 0;
+ 
      PythonCallback *cb_data = (PythonCallback *)user_data;
  
      if (cb_data->id_value != COCOTB_ACTIVE_ID) {
          fprintf(stderr, "Userdata corrupted!\n");
          return 1;
      }
-     cb_data->id_value = COCOTB_INACTIVE_ID;
+     if (!cb_data->recurring) {
+         cb_data->id_value = COCOTB_INACTIVE_ID;
+     }
+     cb_data->firing = true;
+     current_sim_phase = cb_data->phase;
+     ++gpi_stats.python_entries;
  
      PyGILState_STATE gstate = PyGILState_Ensure();
      DEFER(PyGILState_Release(gstate));
@@ -183,9 +223,23 @@
          return 1;
      }
  
-     // Call the callback
-     PyObject *pValue =
-         PyObject_Call(cb_data->function, cb_data->args, cb_data->kwargs);
+     // Call the callback, callbacks primed by the native scheduler wake up
+     // the tasks attached to them directly
+     PyObject *pValue;
+     switch (scheduler_core_fire(cb_data)) {
+         case 0:
+             pValue = PyObject_Call(cb_data->function, cb_data->args,
+                                    cb_data->kwargs);
+             break;
+         case 1:
+             pValue = Py_None;
+             Py_INCREF(pValue);
+             break;
+         default:
+             pValue = NULL;
+     }
+ 
+     cb_data->firing = false;
  
      // If the return value is NULL a Python exception has occurred
      // The best thing to do here is shutdown as any subsequent
@@ -199,6 +253,20 @@
      // We don't care about the result
      Py_DECREF(pValue);
  
+     if (gpi_trace_enabled) {
+         gpi_trace_span("python", trace_trigger_name(cb_data), trace_start,
+                        gpi_trace_clock());
+     }
+ 
+     // 回调里才打开直方图时hist_start还是0，这一次不算
+     if (gpi_hist_enabled && hist_start != 0) {
+         gpi_hist_record(GPI_HIST_PYTHON, gpi_hist_current_kind,
+                         gpi_hist_clock() - hist_start);
+     }
+     if (gpi_meter_enabled && meter_start != 0) {
+         gpi_meter_python_ns += gpi_meter_clock() - meter_start;
+     }
+ 
      // Remove callback data if no longer active
      if (cb_data->id_value == COCOTB_INACTIVE_ID) {
          delete cb_data;
@@ -237,6 +305,7 @@
      }
  
      PythonCallback *cb_data = new PythonCallback(function, fArgs, NULL);
+     cb_data->phase = SIM_PHASE_READ_ONLY;
  
      gpi_cb_hdl hdl = gpi_register_readonly_callback(
          (gpi_function_t)handle_gpi_callback, cb_data);
@@ -246,6 +315,58 @@
      return rv;
  }
  
+ // Register a callback for the ReadOnly phase of the next time step in which
+ // a signal watched by a ValueMonitor or ChangeSet changes
+ // First argument is the ValueMonitor or ChangeSet, second the function to call
+ // Remaining arguments are passed to the callback
+ static PyObject *register_change_callback(PyObject *, PyObject *args) {
+     Py_ssize_t numargs = PyTuple_Size(args);
+ 
+     if (numargs < 2) {
+         PyErr_SetString(PyExc_TypeError,
+                         "Attempt to register change callback without enough "
+                         "arguments!\n");
+         return NULL;
+     }
+ 
+     gpi_cb_hdl wakeup = wakeup_from_object(PyTuple_GetItem(args, 0));
+     if (wakeup == NULL) {
+         PyErr_SetString(PyExc_TypeError,
+                         "First argument must be a ValueMonitor or ChangeSet");
+         return NULL;
+     }
+ 
+     PyObject *function = PyTuple_GetItem(args, 1);
+     if (!PyCallable_Check(function)) {
+         PyErr_SetString(
+             PyExc_TypeError,
+             "Attempt to register change callback without supplying a "
+             "callback!\n");
+         return NULL;
+     }
+     Py_INCREF(function);
+ 
+     PyObject *fArgs = PyTuple_GetSlice(args, 2, numargs);  // New reference
+     if (fArgs == NULL) {
+         Py_DECREF(function);
+         return NULL;
+     }
+ 
+     PythonCallback *cb_data = new PythonCallback(function, fArgs, NULL);
+     cb_data->phase = SIM_PHASE_READ_ONLY;
+ 
+     // 每个记录器只有一个唤醒回调，同时只能有一个等待者
+     if (gpi_prime_wakeup_callback(
+             wakeup, (gpi_function_t)handle_gpi_callback, cb_data)) {
+         delete cb_data;
+         PyErr_SetString(PyExc_RuntimeError,
+                         "Already waiting for changes of this recorder");
+         return NULL;
+     }
+ 
+     return gpi_hdl_New(wakeup);
+ }
+ 
  static PyObject *register_rwsynch_callback(PyObject *, PyObject *args) {
      Py_ssize_t numargs = PyTuple_Size(args);
  
@@ -273,6 +394,7 @@
      }
  
      PythonCallback *cb_data = new PythonCallback(function, fArgs, NULL);
+     cb_data->phase = SIM_PHASE_READ_WRITE;
  
      gpi_cb_hdl hdl = gpi_register_readwrite_callback(
          (gpi_function_t)handle_gpi_callback, cb_data);
@@ -309,6 +431,7 @@
      }
  
      PythonCallback *cb_data = new PythonCallback(function, fArgs, NULL);
+     cb_data->phase = SIM_PHASE_NEXT_TIME;
  
      gpi_cb_hdl hdl = gpi_register_nexttime_callback(
          (gpi_function_t)handle_gpi_callback, cb_data);
@@ -322,7 +445,7 @@
  // First argument should be the time in picoseconds
  // Second argument is the function to call
  // Remaining arguments and keyword arguments are to be passed to the callback
- static PyObject *register_timed_callback(PyObject *, PyObject *args) {
+ static PyObject *register_timed_callback_(PyObject *args, bool periodic) {
      Py_ssize_t numargs = PyTuple_Size(args);
  
      if (numargs < 2) {
@@ -364,9 +487,16 @@
      }
  
      PythonCallback *cb_data = new PythonCallback(function, fArgs, NULL);
- 
-     gpi_cb_hdl hdl = gpi_register_timed_callback(
-         (gpi_function_t)handle_gpi_callback, cb_data, time);
+     cb_data->recurring = periodic;
+ 
+     gpi_cb_hdl hdl;
+     if (periodic) {
+         hdl = gpi_register_periodic_callback(
+             (gpi_function_t)handle_gpi_callback, cb_data, time);
+     } else {
+         hdl = gpi_register_timed_callback((gpi_function_t)handle_gpi_callback,
+                                           cb_data, time);
+     }
  
      // Check success
      PyObject *rv = gpi_hdl_New(hdl);
@@ -374,6 +504,16 @@
      return rv;
  }
  
+ static PyObject *register_timed_callback(PyObject *, PyObject *args) {
+     return register_timed_callback_(args, false);
+ }
+ 
+ // Same as register_timed_callback, but the callback keeps firing every *time*
+ // steps, with the same handle and arguments, until it is deregistered
+ static PyObject *register_periodic_callback(PyObject *, PyObject *args) {
+     return register_timed_callback_(args, true);
+ }
+ 
  // Register signal change callback
  // First argument should be the signal handle
  // Second argument is the function to call
@@ -428,6 +568,68 @@
      return rv;
  }
  
+ static PyObject *get_signal_vals_vecval(PyObject *, PyObject *arg) {
+     PyObject *seq = PySequence_Fast(arg, "Expected a sequence of gpi_sim_hdl");
+     if (seq == NULL) {
+         return NULL;
+     }
+     Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+     PyObject **items = PySequence_Fast_ITEMS(seq);
+     WordArrayObject *result = NULL;
+     int width = 0;
+     for (Py_ssize_t i = 0; i < n; i++) {
+         if (Py_TYPE(items[i]) != &gpi_hdl_Object<gpi_sim_hdl>::py_type) {
+             PyErr_SetString(PyExc_TypeError,
+                             "Expected a sequence of gpi_sim_hdl");
+             Py_XDECREF(result);
+             Py_DECREF(seq);
+             return NULL;
+         }
+         gpi_sim_hdl hdl = ((gpi_hdl_Object<gpi_sim_hdl> *)items[i])->hdl;
+         int num_elems = gpi_get_num_elems(hdl);
+         if (result == NULL) {
+             width = num_elems;
+             if (width >= 1 && width <= 64) {
+                 result = word_array_new(n, width);
+             }
+             if (result == NULL) {
+                 Py_DECREF(seq);
+                 // 元素太宽时由调用者逐个读取
+                 if (PyErr_Occurred()) {
+                     return NULL;
+                 }
+                 Py_RETURN_NONE;
+             }
+         }
+         if (num_elems != width) {
+             Py_DECREF(result);
+             Py_DECREF(seq);
+             Py_RETURN_NONE;
+         }
+         const gpi_vecval *value = gpi_get_signal_value_vecval(hdl);
+         if (value == NULL) {
+             // LCOV_EXCL_START
+             PyErr_SetString(PyExc_RuntimeError,
+                             "Simulator yielded a null pointer instead of vecval");
+             Py_DECREF(result);
+             Py_DECREF(seq);
+             return NULL;
+             // LCOV_EXCL_STOP
+         }
+         if (word_array_set_words(
+                 result, i, reinterpret_cast<const LogicWord *>(value)) < 0) {
+             Py_DECREF(result);
+             Py_DECREF(seq);
+             return NULL;
+         }
+     }
+     Py_DECREF(seq);
+     if (result == NULL) {
+         Py_RETURN_NONE;
+     }
+     return (PyObject *)result;
+ }
+ 
  static PyObject *iterate(gpi_hdl_Object<gpi_sim_hdl> *self, PyObject *args) {
      int type;
  
@@ -481,6 +683,91 @@
      Py_RETURN_NONE;
  }
 
+ static PyObject *get_signal_val_logic(gpi_hdl_Object<gpi_sim_hdl> *self,
+                                       PyObject *) {
+     const char *result = gpi_get_signal_value_binstr(self->hdl);
+     if (result == NULL) {
+         // LCOV_EXCL_START
+         PyErr_SetString(PyExc_RuntimeError,
+                         "Simulator yielded a null pointer instead of binstr");
+         return NULL;
+         // LCOV_EXCL_STOP
+     }
+     // 直接返回唯一的Logic对象，不创建str
+     int code = logic_char_code((unsigned char)result[0]);
+     if (code < 0 || result[1] != '\0') {
+         PyErr_Format(PyExc_ValueError,
+                      "Simulator yielded %s instead of a single Logic value",
+                      result);
+         return NULL;
+     }
+     PyObject *logic = logic_object(code);
+     Py_XINCREF(logic);
+     return logic;
+ }
+ 
+ static PyObject *get_signal_val_vecval(gpi_hdl_Object<gpi_sim_hdl> *self,
+                                        PyObject *) {
+     const gpi_vecval *result = gpi_get_signal_value_vecval(self->hdl);
+     if (result == NULL) {
+         // LCOV_EXCL_START
+         PyErr_SetString(PyExc_RuntimeError,
+                         "Simulator yielded a null pointer instead of vecval");
+         return NULL;
+         // LCOV_EXCL_STOP
+     }
+     static_assert(sizeof(LogicWord) == sizeof(gpi_vecval),
+                   "LogicWord must have the layout of gpi_vecval");
+     return logic_array_from_words(reinterpret_cast<const LogicWord *>(result),
+                                   gpi_get_num_elems(self->hdl));
+ }
+ 
+ static PyObject *get_signal_fields(gpi_hdl_Object<gpi_sim_hdl> *self,
+                                    PyObject *layout) {
+     if (!PackedLayoutObject_Check(layout)) {
+         PyErr_Format(PyExc_TypeError, "Expected PackedLayout, not %s",
+                      Py_TYPE(layout)->tp_name);
+         return NULL;
+     }
+     const gpi_vecval *result = gpi_get_signal_value_vecval(self->hdl);
+     if (result == NULL) {
+         // LCOV_EXCL_START
+         PyErr_SetString(PyExc_RuntimeError,
+                         "Simulator yielded a null pointer instead of vecval");
+         return NULL;
+         // LCOV_EXCL_STOP
+     }
+     // 直接从仿真器的位平面里取出各个字段，不经过LogicArray
+     return packed_layout_unpack((PackedLayoutObject *)layout,
+                                 reinterpret_cast<const LogicWord *>(result),
+                                 gpi_get_num_elems(self->hdl));
+ }
+ 
+ static PyObject *set_signal_val_vecval(gpi_hdl_Object<gpi_sim_hdl> *self,
+                                        PyObject *args) {
+     LogicArrayObject *value;
+     gpi_set_action_t action;
+ 
+     if (!PyArg_ParseTuple(args, "iO!:set_signal_val_vecval", &action,
+                           &LogicArrayBase_type, &value)) {
+         return NULL;
+     }
+     if (value->n_bits != gpi_get_num_elems(self->hdl)) {
+         PyErr_Format(PyExc_ValueError,
+                      "Value has %zd bits, the signal has %d", value->n_bits,
+                      gpi_get_num_elems(self->hdl));
+         return NULL;
+     }
+     // 切片视图的位不是从字的开头开始的
+     if (logic_array_unshare(value) < 0) {
+         return NULL;
+     }
+ 
+     gpi_set_signal_value_vecval(
+         self->hdl, reinterpret_cast<const gpi_vecval *>(value->words), action);
+     Py_RETURN_NONE;
+ }
+ 
  static PyObject *set_signal_val_int(gpi_hdl_Object<gpi_sim_hdl> *self,
                                     PyObject *args) {
     long long value;
@@ -587,6 +874,10 @@ static PyObject *get_root_handle(PyObject *, PyObject *args) {
      return PyLong_FromLong(precision);
  }
  
+ static PyObject *get_sim_phase(PyObject *, PyObject *) {
+     return PyLong_FromLong(current_sim_phase);
+ }
+ 
  static PyObject *get_simulator_product(PyObject *, PyObject *) {
      return PyUnicode_FromString(gpi_get_simulator_product());
  }
@@ -600,15 +891,26 @@ static PyObject *get_root_handle(PyObject *, PyObject *args) {
      return PyLong_FromLong(elems);
  }
  
+ static PyObject *get_range(gpi_hdl_Object<gpi_sim_hdl> *self, PyObject *) {
+     return Py_BuildValue("(iii)", gpi_get_range_left(self->hdl),
+                          gpi_get_range_right(self->hdl),
+                          gpi_get_range_dir(self->hdl));
+ }
+ 
  static PyObject *stop_simulator(PyObject *, PyObject *) {
      gpi_sim_end();
      Py_RETURN_NONE;
  }
  
  static PyObject *deregister(gpi_hdl_Object<gpi_cb_hdl> *self, PyObject *) {
-     // cleanup uncalled callback
+     // cleanup uncalled callback, a callback deregistered from within its own
+     // call is freed by handle_gpi_callback when it returns
      auto cb = static_cast<PythonCallback *>(gpi_get_callback_data(self->hdl));
-     delete cb;
+     if (cb->firing) {
+         cb->id_value = COCOTB_INACTIVE_ID;
+     } else {
+         delete cb;
+     }
  
      // deregister from interface
      gpi_deregister_callback(self->hdl);
@@ -616,6 +918,286 @@ static PyObject *get_root_handle(PyObject *, PyObject *args) {
      Py_RETURN_NONE;
  }
  
+ PythonCallback *python_callback_from_handle(PyObject *obj) {
+     if (Py_TYPE(obj) != &gpi_hdl_Object<gpi_cb_hdl>::py_type) {
+         return nullptr;
+     }
+     auto hdl = reinterpret_cast<gpi_hdl_Object<gpi_cb_hdl> *>(obj)->hdl;
+     return static_cast<PythonCallback *>(gpi_get_callback_data(hdl));
+ }
+ 
+ gpi_sim_hdl sim_handle_from_object(PyObject *obj) {
+     if (Py_TYPE(obj) != &gpi_hdl_Object<gpi_sim_hdl>::py_type) {
+         return nullptr;
+     }
+     return reinterpret_cast<gpi_hdl_Object<gpi_sim_hdl> *>(obj)->hdl;
+ }
+ 
+ // 把计数器放进字典d[key]，失败时返回-1
+ static int set_stat(PyObject *d, const char *key, uint64_t value) {
+     PyObject *v = PyLong_FromUnsignedLongLong(value);
+     if (v == NULL) {
+         return -1;
+     }
+     int ret = PyDict_SetItemString(d, key, v);
+     Py_DECREF(v);
+     return ret;
+ }
+ 
+ // 把子字典sub放进d[key]并释放对sub的引用，失败时返回-1
+ static int set_sub_dict(PyObject *d, const char *key, PyObject *sub) {
+     if (sub == NULL) {
+         return -1;
+     }
+     int ret = PyDict_SetItemString(d, key, sub);
+     Py_DECREF(sub);
+     return ret;
+ }
+ 
+ static PyObject *get_stats(PyObject *, PyObject *) {
+     const gpi_stats_t &s = gpi_stats;
+     PyObject *stats = PyDict_New();
+     if (stats == NULL) {
+         return NULL;
+     }
+     DEFER(Py_DECREF(stats));
+ 
+     PyObject *callbacks = PyDict_New();
+     if (set_sub_dict(stats, "callbacks", callbacks) < 0) {
+         return NULL;
+     }
+     for (int kind = 0; kind < GPI_CB_KIND_COUNT; ++kind) {
+         PyObject *counts = PyDict_New();
+         if (set_sub_dict(callbacks, gpi_cb_kind_name(kind), counts) < 0 ||
+             set_stat(counts, "registered", s.cb_registered[kind]) < 0 ||
+             set_stat(counts, "fired", s.cb_fired[kind]) < 0 ||
+             set_stat(counts, "removed", s.cb_removed[kind]) < 0) {
+             return NULL;
+         }
+     }
+ 
+     PyObject *vpi_calls = PyDict_New();
+     if (set_sub_dict(stats, "vpi_calls", vpi_calls) < 0) {
+         return NULL;
+     }
+     for (int func = 0; func < GPI_VPI_FUNC_COUNT; ++func) {
+         if (set_stat(vpi_calls, gpi_vpi_func_name(func), s.vpi_calls[func]) <
+             0) {
+             return NULL;
+         }
+     }
+ 
+     PyObject *handles = PyDict_New();
+     PyObject *binstr = PyDict_New();
+     PyObject *writes = PyDict_New();
+     if (set_sub_dict(stats, "handles", handles) < 0 ||
+         set_stat(handles, "created", s.handles_created) < 0 ||
+         set_stat(handles, "cached", s.handles_cached) < 0 ||
+         set_sub_dict(stats, "binstr_bytes", binstr) < 0 ||
+         set_stat(binstr, "read", s.binstr_bytes_read) < 0 ||
+         set_stat(binstr, "written", s.binstr_bytes_written) < 0 ||
+         set_sub_dict(stats, "writes", writes) < 0 ||
+         set_stat(writes, "scheduled", s.writes_scheduled) < 0 ||
+         set_stat(writes, "applied", s.writes_applied) < 0 ||
+         set_stat(stats, "python_entries", s.python_entries) < 0) {
+         return NULL;
+     }
+ 
+     Py_INCREF(stats);
+     return stats;
+ }
+ 
+ static PyObject *reset_stats(PyObject *, PyObject *) {
+     gpi_reset_stats();
+     Py_RETURN_NONE;
+ }
+ 
+ static PyObject *log_stats(PyObject *, PyObject *) {
+     gpi_log_stats();
+     Py_RETURN_NONE;
+ }
+ 
+ static PyObject *count_scheduled_write(PyObject *, PyObject *) {
+     ++gpi_stats.writes_scheduled;
+     Py_RETURN_NONE;
+ }
+ 
+ static PyObject *count_cached_handle(PyObject *, PyObject *) {
+     ++gpi_stats.handles_cached;
+     Py_RETURN_NONE;
+ }
+ 
+ static PyObject *get_live_objects(PyObject *, PyObject *) {
+     const gpi_live_objects_t &l = gpi_live_objects;
+     PyObject *objects = PyDict_New();
+     if (objects == NULL) {
+         return NULL;
+     }
+     DEFER(Py_DECREF(objects));
+ 
+     for (int kind = 0; kind < GPI_OBJ_KIND_COUNT; ++kind) {
+         PyObject *counts = PyDict_New();
+         if (set_sub_dict(objects, gpi_obj_kind_name(kind), counts) < 0 ||
+             set_stat(counts, "created", l.created[kind]) < 0 ||
+             set_stat(counts, "freed", l.freed[kind]) < 0 ||
+             set_stat(counts, "alive", l.created[kind] - l.freed[kind]) < 0) {
+             return NULL;
+         }
+     }
+ 
+     Py_INCREF(objects);
+     return objects;
+ }
+ 
+ static PyObject *get_live_handle_paths(PyObject *, PyObject *args) {
+     Py_ssize_t top = 10;
+     if (!PyArg_ParseTuple(args, "|n:get_live_handle_paths", &top)) {
+         return NULL;
+     }
+     auto handles = gpi_top_py_handles(top < 0 ? 0 : (size_t)top);
+     PyObject *paths = PyList_New((Py_ssize_t)handles.size());
+     if (paths == NULL) {
+         return NULL;
+     }
+     for (size_t i = 0; i < handles.size(); ++i) {
+         PyObject *item =
+             Py_BuildValue("(sK)", handles[i].first.c_str(),
+                           (unsigned long long)handles[i].second);
+         if (item == NULL) {
+             Py_DECREF(paths);
+             return NULL;
+         }
+         PyList_SET_ITEM(paths, (Py_ssize_t)i, item);
+     }
+     return paths;
+ }
+ 
+ static PyObject *log_live_objects(PyObject *, PyObject *args) {
+     Py_ssize_t top = 10;
+     if (!PyArg_ParseTuple(args, "|n:log_live_objects", &top)) {
+         return NULL;
+     }
+     gpi_log_live_objects(top < 0 ? 0 : (size_t)top);
+     Py_RETURN_NONE;
+ }
+ 
+ static PyObject *set_latency_tracking(PyObject *, PyObject *arg) {
+     int enabled = PyObject_IsTrue(arg);
+     if (enabled < 0) {
+         return NULL;
+     }
+     gpi_hist_enable(enabled);
+     Py_RETURN_NONE;
+ }
+ 
+ static PyObject *get_latency_tracking(PyObject *, PyObject *) {
+     return PyBool_FromLong(gpi_hist_enabled);
+ }
+ 
+ // 一个直方图转成字典：次数、平均、最小最大、百分位和非空的桶
+ static PyObject *histogram_to_dict(const gpi_histogram_t *h) {
+     PyObject *d = PyDict_New();
+     if (d == NULL) {
+         return NULL;
+     }
+     DEFER(Py_DECREF(d));
+ 
+     PyObject *buckets = PyList_New(0);
+     if (set_sub_dict(d, "buckets", buckets) < 0) {
+         return NULL;
+     }
+     for (int i = 0; i < GPI_HIST_BUCKETS; ++i) {
+         if (h->counts[i] == 0) {
+             continue;
+         }
+         PyObject *item = Py_BuildValue(
+             "(KK)", (unsigned long long)gpi_hist_bucket_lower(i),
+             (unsigned long long)h->counts[i]);
+         if (item == NULL || PyList_Append(buckets, item) < 0) {
+             Py_XDECREF(item);
+             return NULL;
+         }
+         Py_DECREF(item);
+     }
+     if (set_stat(d, "count", h->total) < 0 ||
+         set_stat(d, "mean_ns", h->sum_ns / h->total) < 0 ||
+         set_stat(d, "min_ns", h->min_ns) < 0 ||
+         set_stat(d, "max_ns", h->max_ns) < 0 ||
+         set_stat(d, "p50_ns", gpi_hist_percentile(h, 0.5)) < 0 ||
+         set_stat(d, "p90_ns", gpi_hist_percentile(h, 0.9)) < 0 ||
+         set_stat(d, "p99_ns", gpi_hist_percentile(h, 0.99)) < 0 ||
+         set_stat(d, "p999_ns", gpi_hist_percentile(h, 0.999)) < 0) {
+         return NULL;
+     }
+ 
+     Py_INCREF(d);
+     return d;
+ }
+ 
+ static PyObject *get_latency_histograms(PyObject *, PyObject *) {
+     PyObject *result = PyDict_New();
+     if (result == NULL) {
+         return NULL;
+     }
+     DEFER(Py_DECREF(result));
+ 
+     for (int which = 0; which < GPI_HIST_COUNT; ++which) {
+         PyObject *per_kind = PyDict_New();
+         if (set_sub_dict(result, gpi_hist_name(which), per_kind) < 0) {
+             return NULL;
+         }
+         for (int kind = 0; kind < GPI_CB_KIND_COUNT; ++kind) {
+             const gpi_histogram_t *h = gpi_hist_get((gpi_hist_e)which, kind);
+             if (h->total == 0) {
+                 continue;
+             }
+             if (set_sub_dict(per_kind, gpi_cb_kind_name(kind),
+                              histogram_to_dict(h)) < 0) {
+                 return NULL;
+             }
+         }
+     }
+ 
+     Py_INCREF(result);
+     return result;
+ }
+ 
+ static PyObject *reset_latency_histograms(PyObject *, PyObject *) {
+     gpi_hist_reset();
+     Py_RETURN_NONE;
+ }
+ 
+ static PyObject *log_latency_histograms(PyObject *, PyObject *) {
+     gpi_hist_log();
+     Py_RETURN_NONE;
+ }
+ 
+ static PyObject *record_write_flush(PyObject *, PyObject *arg) {
+     unsigned long long ns = PyLong_AsUnsignedLongLong(arg);
+     if (ns == (unsigned long long)-1 && PyErr_Occurred()) {
+         return NULL;
+     }
+     gpi_hist_record(GPI_HIST_WRITE_FLUSH, GPI_CB_READWRITE, ns);
+     Py_RETURN_NONE;
+ }
+ 
+ static PyObject *get_tracing(PyObject *, PyObject *) {
+     return PyBool_FromLong(gpi_trace_enabled);
+ }
+ 
+ static PyObject *trace_clock(PyObject *, PyObject *) {
+     return PyLong_FromUnsignedLongLong(gpi_trace_clock());
+ }
+ 
+ static PyObject *record_scheduler_span(PyObject *, PyObject *arg) {
+     unsigned long long start = PyLong_AsUnsignedLongLong(arg);
+     if (start == (unsigned long long)-1 && PyErr_Occurred()) {
+         return NULL;
+     }
+     gpi_trace_span("scheduler", "event_loop", start, gpi_trace_clock());
+     Py_RETURN_NONE;
+ }
+ 
  static PyObject *set_sim_event_callback(PyObject *, PyObject *args) {
     if (pEventFn) {
          PyErr_SetString(PyExc_RuntimeError,
@@ -665,6 +1247,14 @@ static PyObject *get_root_handle(PyObject *, PyObject *args) {
          PyModule_AddIntConstant(simulator, "LOGIC", GPI_LOGIC) < 0 ||
          PyModule_AddIntConstant(simulator, "LOGIC_ARRAY", GPI_LOGIC_ARRAY) <
              0 ||
+         PyModule_AddIntConstant(simulator, "SIM_PHASE_NORMAL",
+                                 SIM_PHASE_NORMAL) < 0 ||
+         PyModule_AddIntConstant(simulator, "SIM_PHASE_READ_WRITE",
+                                 SIM_PHASE_READ_WRITE) < 0 ||
+         PyModule_AddIntConstant(simulator, "SIM_PHASE_READ_ONLY",
+                                 SIM_PHASE_READ_ONLY) < 0 ||
+         PyModule_AddIntConstant(simulator, "SIM_PHASE_NEXT_TIME",
+                                 SIM_PHASE_NEXT_TIME) < 0 ||
          false) {
          return -1;
      }
@@ -721,6 +1311,13 @@ static PyObject *get_root_handle(PyObject *, PyObject *args) {
                 "register_timed_callback(time: int, func: Callable[..., Any], "
                 "*args: Any) -> cocotb.simulator.gpi_cb_hdl\n"
                 "Register a timed callback.")},
+     {"register_periodic_callback", register_periodic_callback, METH_VARARGS,
+      PyDoc_STR("register_periodic_callback(period, func, /, *args)\n"
+                "--\n\n"
+                "register_periodic_callback(period: int, func: Callable[..., "
+                "Any], *args: Any) -> cocotb.simulator.gpi_cb_hdl\n"
+                "Register a timed callback which fires every *period* steps "
+                "until it is deregistered.")},
      {"register_value_change_callback", register_value_change_callback,
       METH_VARARGS,
       PyDoc_STR("register_value_change_callback(signal, func, edge, /, *args)\n"
@@ -735,6 +1332,15 @@ static PyObject *get_root_handle(PyObject *, PyObject *args) {
                 "register_readonly_callback(func: Callable[..., Any], *args: "
                 "Any) -> cocotb.simulator.gpi_cb_hdl\n"
                 "Register a callback for the read-only section.")},
+     {"register_change_callback", register_change_callback, METH_VARARGS,
+      PyDoc_STR("register_change_callback(recorder, func, /, *args)\n"
+                "--\n\n"
+                "register_change_callback(recorder: Union[ValueMonitor, "
+                "ChangeSet], func: Callable[..., Any], *args: Any) -> "
+                "cocotb.simulator.gpi_cb_hdl\n"
+                "Register a callback for the read-only section of the next "
+                "time step in which a signal watched by *recorder* changes, or "
+                "in which *recorder* is closed.")},
      {"register_nextstep_callback", register_nextstep_callback, METH_VARARGS,
       PyDoc_STR("register_nextstep_callback(func, /, *args)\n"
                 "--\n\n"
@@ -769,6 +1375,14 @@ static PyObject *get_root_handle(PyObject *, PyObject *args) {
                 "\n"
                 "For example, if ``-12`` is returned, the simulator's time "
                 "precision is 10**-12 or 1 ps.")},
+     {"get_sim_phase", get_sim_phase, METH_NOARGS,
+      PyDoc_STR("get_sim_phase()\n"
+                "--\n\n"
+                "get_sim_phase() -> int\n"
+                "Get the phase of the last callback fired by the simulator.\n"
+                "\n"
+                "One of :data:`SIM_PHASE_NORMAL`, :data:`SIM_PHASE_READ_WRITE`, "
+                ":data:`SIM_PHASE_READ_ONLY` or :data:`SIM_PHASE_NEXT_TIME`.")},
      {"get_simulator_product", get_simulator_product, METH_NOARGS,
       PyDoc_STR("get_simulator_product()\n"
                 "--\n\n"
@@ -785,6 +1399,143 @@ static PyObject *get_root_handle(PyObject *, PyObject *args) {
                 "set_sim_event_callback(sim_event_callback: Callable[[str], "
                 "None]) -> None\n"
                 "Set the callback for simulator events.")},
+     {"get_signal_vals_vecval", get_signal_vals_vecval, METH_O,
+      PyDoc_STR("get_signal_vals_vecval(handles, /)\n"
+                "--\n\n"
+                "get_signal_vals_vecval(handles: Sequence[cocotb.simulator."
+                "gpi_sim_hdl]) -> Optional[WordArray]\n"
+                "Read the values of logic vector signals of the same width of "
+                "at most 64 bits into a :class:`WordArray`, ``None`` if their "
+                "widths differ or are wider.")},
+     {"get_stats", get_stats, METH_NOARGS,
+      PyDoc_STR("get_stats()\n"
+                "--\n\n"
+                "get_stats() -> Dict[str, Any]\n"
+                "Get the counters kept since the start of the simulation or "
+                "the last :func:`reset_stats`.\n"
+                "\n"
+                "``callbacks`` maps each callback type to the number of "
+                "callbacks registered, fired and removed, ``vpi_calls`` maps "
+                "each VPI function to its number of calls. ``handles``, "
+                "``binstr_bytes`` and ``writes`` count the handles created "
+                "and found again in the handle cache of :mod:`mycocotb.handle`, "
+                "the bytes of binary strings read and written, and the writes "
+                "scheduled and applied. "
+                "``python_entries`` counts the callbacks that entered "
+                "Python.")},
+     {"reset_stats", reset_stats, METH_NOARGS,
+      PyDoc_STR("reset_stats()\n"
+                "--\n\n"
+                "reset_stats() -> None\n"
+                "Set all the counters of :func:`get_stats` to zero.")},
+     {"log_stats", log_stats, METH_NOARGS,
+      PyDoc_STR("log_stats()\n"
+                "--\n\n"
+                "log_stats() -> None\n"
+                "Print the non-zero counters of :func:`get_stats` through the "
+                "simulator. This is done at the end of the simulation when "
+                ":envvar:`COCOTB_STATS` is set.")},
+     {"count_scheduled_write", count_scheduled_write, METH_NOARGS,
+      PyDoc_STR("count_scheduled_write()\n"
+                "--\n\n"
+                "count_scheduled_write() -> None\n"
+                "Count a write requested through the write scheduler. Users "
+                "should not call this function.")},
+     {"count_cached_handle", count_cached_handle, METH_NOARGS,
+      PyDoc_STR("count_cached_handle()\n"
+                "--\n\n"
+                "count_cached_handle() -> None\n"
+                "Count a child handle found again in the handle cache. Users "
+                "should not call this function.")},
+     {"get_live_objects", get_live_objects, METH_NOARGS,
+      PyDoc_STR("get_live_objects()\n"
+                "--\n\n"
+                "get_live_objects() -> Dict[str, Dict[str, int]]\n"
+                "Get the number of native objects ``created``, ``freed`` and "
+                "still ``alive`` per type: the simulator handles, iterators "
+                "and VPI callbacks of the GPI, the Python callbacks, and the "
+                "Python objects wrapping a handle, an iterator or a "
+                "callback. Comparing two snapshots shows what leaks.")},
+     {"get_live_handle_paths", get_live_handle_paths, METH_VARARGS,
+      PyDoc_STR("get_live_handle_paths(top=10, /)\n"
+                "--\n\n"
+                "get_live_handle_paths(top: int = 10) -> List[Tuple[str, int]]"
+                "\n"
+                "Get the *top* signal paths with the most Python handle "
+                "objects alive, as ``(path, count)``, most first.")},
+     {"log_live_objects", log_live_objects, METH_VARARGS,
+      PyDoc_STR("log_live_objects(top=10, /)\n"
+                "--\n\n"
+                "log_live_objects(top: int = 10) -> None\n"
+                "Print the counts of :func:`get_live_objects` and the *top* "
+                "signal paths of :func:`get_live_handle_paths` through the "
+                "simulator. This is done at the end of the simulation when "
+                ":envvar:`COCOTB_LEAK_REPORT` is set.")},
+     {"set_latency_tracking", set_latency_tracking, METH_O,
+      PyDoc_STR("set_latency_tracking(enabled, /)\n"
+                "--\n\n"
+                "set_latency_tracking(enabled: bool) -> None\n"
+                "Start or stop recording the latencies of "
+                ":func:`get_latency_histograms`. Also enabled by "
+                ":envvar:`COCOTB_LATENCY_HISTOGRAMS`.")},
+     {"get_latency_tracking", get_latency_tracking, METH_NOARGS,
+      PyDoc_STR("get_latency_tracking()\n"
+                "--\n\n"
+                "get_latency_tracking() -> bool\n"
+                "Whether the latency histograms are being recorded.")},
+     {"get_latency_histograms", get_latency_histograms, METH_NOARGS,
+      PyDoc_STR("get_latency_histograms()\n"
+                "--\n\n"
+                "get_latency_histograms() -> Dict[str, Dict[str, Any]]\n"
+                "Get the latency histograms recorded since they were enabled "
+                "or the last :func:`reset_latency_histograms`.\n"
+                "\n"
+                "``callback`` holds the time from entering a VPI callback to "
+                "returning to the simulator and ``python`` the time spent in "
+                "Python, both per callback type. ``write_flush`` holds the "
+                "time taken to apply the scheduled writes, under "
+                "``readwrite``. Each histogram has its ``count``, "
+                "``mean_ns``, ``min_ns``, ``max_ns``, the percentiles "
+                "``p50_ns``, ``p90_ns``, ``p99_ns`` and ``p999_ns``, and its "
+                "non-empty ``buckets`` as ``(lower_ns, count)``.")},
+     {"reset_latency_histograms", reset_latency_histograms, METH_NOARGS,
+      PyDoc_STR("reset_latency_histograms()\n"
+                "--\n\n"
+                "reset_latency_histograms() -> None\n"
+                "Empty all the histograms of :func:`get_latency_histograms`.")},
+     {"log_latency_histograms", log_latency_histograms, METH_NOARGS,
+      PyDoc_STR("log_latency_histograms()\n"
+                "--\n\n"
+                "log_latency_histograms() -> None\n"
+                "Print the percentiles of the non-empty latency histograms "
+                "through the simulator. This is done at the end of the "
+                "simulation.")},
+     {"record_write_flush", record_write_flush, METH_O,
+      PyDoc_STR("record_write_flush(ns, /)\n"
+                "--\n\n"
+                "record_write_flush(ns: int) -> None\n"
+                "Record applying the scheduled writes taking *ns* "
+                "nanoseconds. Used by the Python scheduler, users should not "
+                "call this function.")},
+     {"get_tracing", get_tracing, METH_NOARGS,
+      PyDoc_STR("get_tracing()\n"
+                "--\n\n"
+                "get_tracing() -> bool\n"
+                "Whether a trace is being written to "
+                ":envvar:`COCOTB_TRACE_FILE`.")},
+     {"trace_clock", trace_clock, METH_NOARGS,
+      PyDoc_STR("trace_clock()\n"
+                "--\n\n"
+                "trace_clock() -> int\n"
+                "The wall-clock time in nanoseconds since the trace was "
+                "opened.")},
+     {"record_scheduler_span", record_scheduler_span, METH_O,
+      PyDoc_STR("record_scheduler_span(start, /)\n"
+                "--\n\n"
+                "record_scheduler_span(start: int) -> None\n"
+                "Record the scheduler resuming tasks from *start*, a "
+                ":func:`trace_clock` value, until now. Used by the Python "
+                "scheduler, users should not call this function.")},
      {NULL, NULL, 0, NULL} /* Sentinel */
  };
  
@@ -832,6 +1583,51 @@ static PyObject *get_root_handle(PyObject *, PyObject *args) {
          return NULL;
      }
  
+     if (add_time_unit_functions(simulator) < 0) {
+         Py_DECREF(simulator);
+         return NULL;
+     }
+     if (add_task_type(simulator) < 0) {
+         Py_DECREF(simulator);
+         return NULL;
+     }
+     if (add_scheduler_core_types(simulator) < 0) {
+         Py_DECREF(simulator);
+         return NULL;
+     }
+     if (add_thread_bridge_types(simulator) < 0) {
+         Py_DECREF(simulator);
+         return NULL;
+     }
+     if (add_range_type(simulator) < 0) {
+         Py_DECREF(simulator);
+         return NULL;
+     }
+     if (add_logic_type(simulator) < 0) {
+         Py_DECREF(simulator);
+         return NULL;
+     }
+     if (add_logic_array_type(simulator) < 0) {
+         Py_DECREF(simulator);
+         return NULL;
+     }
+     if (add_word_array_type(simulator) < 0) {
+         Py_DECREF(simulator);
+         return NULL;
+     }
+     if (add_packed_layout_type(simulator) < 0) {
+         Py_DECREF(simulator);
+         return NULL;
+     }
+     if (add_value_monitor_types(simulator) < 0) {
+         Py_DECREF(simulator);
+         return NULL;
+     }
+     if (add_task_profiler_functions(simulator) < 0) {
+         Py_DECREF(simulator);
+         return NULL;
+     }
+ 
      return simulator;
  }
  
@@ -857,6 +1653,32 @@ static PyObject *get_root_handle(PyObject *, PyObject *args) {
                 "set_signal_val_binstr(action: int, value: str) -> None\n"
                 "Set the value of a logic vector signal using a string of "
                 "(``0``, ``1``, ``X``, etc.), one element per character.")},
+     {"get_signal_val_logic", (PyCFunction)get_signal_val_logic, METH_NOARGS,
+      PyDoc_STR("get_signal_val_logic($self)\n"
+                "--\n\n"
+                "get_signal_val_logic() -> Logic\n"
+                "Get the value of a single-bit logic signal as a "
+                ":class:`~mycocotb.types.Logic`.")},
+     {"get_signal_val_vecval", (PyCFunction)get_signal_val_vecval, METH_NOARGS,
+      PyDoc_STR("get_signal_val_vecval($self)\n"
+                "--\n\n"
+                "get_signal_val_vecval() -> LogicArray\n"
+                "Get the value of a logic vector signal as a "
+                ":class:`~mycocotb.types.LogicArray`, copied from the 4-state "
+                "bit planes of the simulator.")},
+     {"get_signal_fields", (PyCFunction)get_signal_fields, METH_O,
+      PyDoc_STR("get_signal_fields($self, layout, /)\n"
+                "--\n\n"
+                "get_signal_fields(layout: PackedLayout) -> Dict[str, Optional[int]]\n"
+                "Get the value of every field of *layout* in a packed structure "
+                "signal, reading the value from the simulator once.")},
+     {"set_signal_val_vecval", (PyCFunction)set_signal_val_vecval, METH_VARARGS,
+      PyDoc_STR("set_signal_val_vecval($self, action, value, /)\n"
+                "--\n\n"
+                "set_signal_val_vecval(action: int, value: LogicArray) -> None\n"
+                "Set the value of a logic vector signal from the 4-state bit "
+                "planes of a :class:`~mycocotb.types.LogicArray` of the same "
+                "length.")},
      {"set_signal_val_int", (PyCFunction)set_signal_val_int, METH_VARARGS,
       PyDoc_STR("set_signal_val_int($self, action, value, /)\n"
                 "--\n\n"
@@ -898,6 +1720,13 @@ static PyObject *get_root_handle(PyObject *, PyObject *args) {
                 "--\n\n"
                 "get_num_elems() -> int\n"
                 "Get the number of elements contained in the handle.")},
+     {"get_range", (PyCFunction)get_range, METH_NOARGS,
+      PyDoc_STR("get_range($self)\n"
+                "--\n\n"
+                "get_range() -> Tuple[int, int, int]\n"
+                "Get the left and right bounds of the range of the handle and "
+                "its direction, one of :data:`RANGE_UP`, :data:`RANGE_DOWN` "
+                "or :data:`RANGE_NO_DIR`.")},
      {"iterate", (PyCFunction)iterate, METH_VARARGS,
       PyDoc_STR(
           "iterate($self, mode, /)\n"
@@ -0,0 +1,62 @@
+"""Check the trace file written by a run of tests.test_trace.
+
+Usage: python3 tests/check_trace.py TRACE_FILE
+"""
+
+import json
+import sys
+
+
+def inside(inner, outer):
+    # ts和dur是保留三位小数的微秒，相加时留一点误差
+    return (outer["ts"] <= inner["ts"] + 0.002
+            and inner["ts"] + inner["dur"] <= outer["ts"] + outer["dur"] + 0.002)
+
+
+def check_trace(path):
+    with open(path) as f:
+        trace = json.load(f)
+    events = trace["traceEvents"]
+    assert [e["name"] for e in events if e["ph"] == "M"] == ["process_name", "thread_name"]
+    spans = [e for e in events if e["ph"] != "M"]
+    assert spans and all(e["ph"] == "X" and e["dur"] >= 0 for e in spans)
+    by_cat = {}
+    for e in spans:
+        by_cat.setdefault(e["cat"], []).append(e)
+    assert set(by_cat) == {"simulator", "gpi", "python", "scheduler"}, set(by_cat)
+
+    # 每个仿真器回调按种类命名，带着仿真时间
+    gpi = by_cat["gpi"]
+    assert {"timed", "value_change", "readwrite", "readonly"} <= {e["name"] for e in gpi}
+    times = [e["args"]["sim_time"] for e in gpi]
+    assert times == sorted(times) and times[-1] > 0
+    # 仿真器和回调的时间首尾相接，不重叠
+    outer = sorted(by_cat["simulator"] + gpi, key=lambda e: e["ts"])
+    for a, b in zip(outer, outer[1:]):
+        assert a["ts"] + a["dur"] <= b["ts"] + 0.002, (a, b)
+
+    # Python的时间在回调里面，用等待的trigger命名
+    names = {e["name"] for e in by_cat["python"]}
+    for prefix in ("<Timer of", "RisingEdge(", "ReadWrite()", "ReadOnly()"):
+        assert any(n.startswith(prefix) for n in names), (prefix, names)
+    for e in by_cat["python"]:
+        assert any(inside(e, g) for g in gpi), e
+
+    # 调度器的时间是恢复tasks的那一段：测试开始时在启动回调里，之后在Python里面，
+    # 而且比Python的时间短
+    startup = gpi[0]
+    assert startup["name"] == "other", startup
+    shorter = False
+    for e in by_cat["scheduler"]:
+        assert e["name"] == "event_loop", e
+        if inside(e, startup):
+            continue
+        outer = [p for p in by_cat["python"] if inside(e, p)]
+        assert outer, e
+        shorter = shorter or e["dur"] < outer[0]["dur"]
+    assert shorter
+
+
+if __name__ == "__main__":
+    check_trace(sys.argv[1])
+    print("test_trace passed")
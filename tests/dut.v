@@ -2,6 +2,18 @@
 module dut;
     reg a;
     reg b;
+    // tests/test_*.py用到的信号
+    reg clk;
+    reg [7:0] d;
+    reg [7:0] q;
+    reg [31:0] count = 0;
+    reg [511:0] wide;
+    reg [63:0] hdr;
+    reg [31:0] mem [0:15];
+    always @(posedge clk) begin
+        q <= d;
+        count <= count + 1;
+    end
     always @(a) begin
         b = a;
         $display("b = %d, a = %d", b, a);
@@ -0,0 +1,134 @@
+import pickle
+
+import numpy
+
+import mycocotb
+from mycocotb import simulator
+from mycocotb.triggers import Timer
+from mycocotb.types import Array, LogicArray, Range
+
+
+def raises(exc, f, *args):
+    try:
+        f(*args)
+    except exc:
+        return True
+    return False
+
+
+def test_word_array():
+    WordArray = simulator.WordArray
+    w = WordArray(4, 8)
+    assert len(w) == 4 and w.width == 8 and w.mask is None
+    w[1] = LogicArray("1010XZ01")
+    w[2] = 200
+    assert str(w[1]) == "1010XZ01" and w[2].to_unsigned() == 200 and w[-1].to_unsigned() == 0
+    # X/Z位只在存进来以后才分配mask
+    assert w.mask is not None and list(memoryview(w.mask)) == [0, 0b1100, 0, 0]
+
+    m = memoryview(w)
+    assert m.format == "I" and m.itemsize == 4 and list(m) == [0, 0b10101001, 200, 0]
+    m[3] = 0x1FF
+    assert w[3].to_unsigned() == 0xFF
+
+    part = w[1:3]
+    assert len(part) == 2 and str(part[0]) == "1010XZ01"
+    w[1:3] = [1, LogicArray("11110000")]
+    assert w[1].to_unsigned() == 1 and str(part[0]) == "1010XZ01"
+
+    assert raises(ValueError, w.__setitem__, 0, LogicArray("101"))
+    assert raises(ValueError, w.__setitem__, 0, 256)
+    assert raises(TypeError, w.__setitem__, 0, LogicArray("UUUUUUUU"))
+    # 切片赋值要么全部成功要么不改
+    assert raises(TypeError, w.__setitem__, slice(0, 2), [1, "x"]) and w[0].to_unsigned() == 0
+    assert raises(TypeError, hash, w)
+
+    wide = WordArray(2, 40)
+    wide[0] = (1 << 40) - 1
+    wide[1] = LogicArray("X" + "0" * 39)
+    assert memoryview(wide).format == "Q" and wide[0].to_unsigned() == (1 << 40) - 1
+    assert str(wide[1]) == "X" + "0" * 39
+    assert WordArray(3, 8) == [LogicArray(0, 8)] * 3 and WordArray(3, 8) != WordArray(2, 8)
+
+    # Array复制WordArray，放不下的元素让它退回到list
+    a = Array(w, Range(3, "downto", 0))
+    assert a[3] == LogicArray(0, 8) and isinstance(a._value, WordArray) and a._value is not w
+    b = Array._from_words(w, Range(0, "to", 3))
+    view = b[1:2]
+    b[2] = "anything"
+    assert b[2] == "anything" and isinstance(b._value, list) and view[2] == LogicArray("11110000")
+
+    # numpy数组和Array共享缓冲区；切片以后导出的是只读的，
+    # 已经导出了可写的数组时切片复制自己的元素
+    a = Array._from_words(WordArray(4, 8), Range(0, "to", 3))
+    n = numpy.asarray(a)
+    n[0] = 5
+    assert n.flags.writeable and a[0].to_unsigned() == 5
+    part = a[0:1]
+    n[1] = 7
+    assert a[1].to_unsigned() == 7 and part[1].to_unsigned() == 0
+    b = Array._from_words(WordArray(4, 8), Range(0, "to", 3))
+    part = b[2:3]
+    assert not numpy.asarray(b).flags.writeable and not numpy.asarray(part).flags.writeable
+    assert numpy.array(b, copy=True).flags.writeable
+
+
+def test_range():
+    # 和同样方向的Python range比较
+    for left in range(-3, 4):
+        for right in range(-3, 4):
+            for direction in ("to", "downto", "TO"):
+                r = Range(left, direction, right)
+                step = 1 if direction.lower() == "to" else -1
+                ref = range(left, right + step, step)
+                assert r.to_range() == ref and len(r) == len(ref) and list(r) == list(ref)
+                assert list(reversed(r)) == list(reversed(ref))
+                for v in range(-5, 6):
+                    assert (v in r) == (v in ref) and r.count(v) == ref.count(v)
+                    if v in ref:
+                        assert r.index(v) == ref.index(v)
+                    else:
+                        assert raises(ValueError, r.index, v)
+                    if -len(ref) <= v < len(ref):
+                        assert r[v] == ref[v]
+                    else:
+                        assert raises(IndexError, r.__getitem__, v)
+                for sl in (slice(None), slice(1, None), slice(None, -1), slice(2, 0, -1), slice(-2, None)):
+                    assert r[sl].to_range() == ref[sl] and type(r[sl]) is Range
+                assert (r == Range.from_range(ref)) and hash(r) == hash(Range.from_range(ref))
+
+    r = Range(7, "downto", 0)
+    assert r.index(3) == 4 and r.index(3, 0, 5) == 4 and r[1:3] == Range(6, "downto", 5)
+    assert Range(3, 0) == r[4:]
+    assert pickle.loads(pickle.dumps(r)) == r and type(pickle.loads(pickle.dumps(r))) is Range
+    assert raises(AttributeError, setattr, r, "left", 3)
+    assert raises(ValueError, Range, 1, "sideways", 2)
+    assert raises(TypeError, Range, "a", 2)
+
+
+async def test_memory(dut):
+    for i in range(16):
+        dut.mem[i].value = i * 3
+    await Timer(1)
+    v = dut.mem.value
+    assert isinstance(v._value, simulator.WordArray) and v.range == Range(0, "to", 15)
+    assert [x.to_unsigned() for x in v] == [i * 3 for i in range(16)]
+    assert v == Array([dut.mem[i].value for i in range(16)], range=Range(0, "to", 15))
+    assert list(memoryview(v._value)) == [i * 3 for i in range(16)]
+    assert len(dut.mem) == 16 and dut.mem.left == 0 and dut.mem.right == 15
+
+    dut.mem[4].value = LogicArray("X" * 32)
+    await Timer(1)
+    assert str(dut.mem.value[4]) == "X" * 32 and v[4].to_unsigned() == 12
+    dut.mem.value = v
+    await Timer(1)
+    assert dut.mem[4].value.to_unsigned() == 12
+
+
+async def test(dut):
+    test_word_array()
+    test_range()
+    await test_memory(dut)
+    print("test_array passed")
+
+mycocotb.start_soon(test(mycocotb.top))
@@ -0,0 +1,137 @@
+import threading
+import time
+
+import mycocotb
+from mycocotb import simulator
+from mycocotb.triggers import Timer
+from mycocotb.utils import get_sim_time
+
+
+@mycocotb.resume
+async def wait_steps(n):
+    await Timer(n)
+    return get_sim_time()
+
+
+@mycocotb.resume
+def now():
+    return get_sim_time()
+
+
+@mycocotb.resume
+def boom():
+    raise ValueError("boom")
+
+
+@mycocotb.bridge
+def worker(k):
+    out = [now()]
+    # 工作线程阻塞时仿真时间不走
+    time.sleep(0.01)
+    out.append(now())
+    for _ in range(k):
+        out.append(wait_steps(3))
+    try:
+        boom()
+    except ValueError as e:
+        out.append(str(e))
+    return out
+
+
+@mycocotb.bridge
+def fails():
+    raise KeyError("x")
+
+
+async def test_call_resume(dut):
+    start = get_sim_time()
+    ticks = []
+
+    async def ticker():
+        for _ in range(5):
+            await Timer(2)
+            ticks.append(get_sim_time() - start)
+
+    mycocotb.start_soon(ticker())
+    result = await worker(3)
+    assert result == [start, start, start + 3, start + 6, start + 9, "boom"], result
+    # 工作线程等待时其它task照常运行
+    assert ticks == [2, 4, 6, 8], ticks
+
+    try:
+        await fails()
+        assert False, "exception of the bridged call was not raised"
+    except KeyError:
+        pass
+
+    try:
+        now()
+        assert False, "resume() outside a bridge() thread did not raise"
+    except RuntimeError:
+        pass
+
+    @mycocotb.bridge
+    def many():
+        return [now() for _ in range(1000)]
+
+    assert await many() == [get_sim_time()] * 1000
+
+
+async def test_cancel(dut):
+    errors = []
+    finished = threading.Event()
+
+    @mycocotb.bridge
+    def blocked():
+        try:
+            wait_steps(100)
+        except RuntimeError as e:
+            errors.append(str(e))
+        try:
+            wait_steps(1)
+        except RuntimeError as e:
+            errors.append(str(e))
+        finished.set()
+
+    # kill等待中的bridge调用，工作线程里的resume()得到异常，之后的调用也一样
+    task = mycocotb.start_soon(blocked())
+    await Timer(4)
+    task.kill()
+    assert finished.wait(5)
+    assert errors == ["Bridged call was cancelled", "ThreadBridge is closed"], errors
+
+
+def test_cancel_done():
+    # kill以后清空队列时，工作线程可能已经自己结束了请求，cancel()不能再报错
+    bridge_ = simulator.ThreadBridge()
+    results = []
+
+    def submit():
+        try:
+            results.append(bridge_.call(int, "1"))
+        except RuntimeError as e:
+            results.append(str(e))
+
+    for complete in (True, False):
+        worker = threading.Thread(target=submit)
+        worker.start()
+        request = bridge_.wait()
+        if complete:
+            request.set_result(request.func(*request.args))
+        assert request.cancel(RuntimeError("cancelled")) is not complete
+        worker.join(5)
+    assert results == [1, "cancelled"], results
+    try:
+        request.set_exception(RuntimeError("again"))
+        assert False, "set_exception() on a completed request did not raise"
+    except RuntimeError:
+        pass
+
+
+async def test(dut):
+    await test_call_resume(dut)
+    await test_cancel(dut)
+    test_cancel_done()
+    print("test_bridge passed")
+
+mycocotb.start_soon(test(mycocotb.top))
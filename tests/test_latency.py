@@ -0,0 +1,41 @@
+import mycocotb
+from mycocotb import simulator
+from mycocotb.triggers import ReadOnly, Timer
+
+# 用COCOTB_LATENCY_HISTOGRAMS=1运行
+
+
+def check_histogram(h, count):
+    assert h["count"] == count, h
+    # 百分位随百分比单调，都落在最小和最大之间
+    values = [h[k] for k in ("min_ns", "p50_ns", "p90_ns", "p99_ns", "p999_ns", "max_ns")]
+    assert values == sorted(values), h
+    assert h["min_ns"] <= h["mean_ns"] <= h["max_ns"], h
+    lowers = [lower for lower, _ in h["buckets"]]
+    assert lowers == sorted(set(lowers)) and sum(c for _, c in h["buckets"]) == count, h
+
+
+async def test(dut):
+    assert simulator.get_latency_tracking()
+    simulator.reset_latency_histograms()
+    for i in range(50):
+        await Timer(1)
+        dut.d.value = i
+        await ReadOnly()
+    histograms = simulator.get_latency_histograms()
+    assert set(histograms) == {"callback", "python", "write_flush"}, histograms
+    check_histogram(histograms["callback"]["timed"], 50)
+    check_histogram(histograms["python"]["timed"], 50)
+    # 现在还在最后一个ReadOnly回调里，它返回时才记录
+    check_histogram(histograms["callback"]["readonly"], 49)
+    check_histogram(histograms["write_flush"]["readwrite"], 50)
+
+    # 关掉以后不再记录
+    simulator.set_latency_tracking(False)
+    simulator.reset_latency_histograms()
+    await Timer(1)
+    assert all(v == {} for v in simulator.get_latency_histograms().values())
+    simulator.set_latency_tracking(True)
+    print("test_latency passed")
+
+mycocotb.start_soon(test(mycocotb.top))
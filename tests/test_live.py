@@ -0,0 +1,43 @@
+import gc
+
+import mycocotb
+from mycocotb import simulator
+from mycocotb.triggers import Timer
+
+# 用COCOTB_LEAK_REPORT=1运行，结束时还会输出一次报告
+
+
+def alive(kind):
+    return simulator.get_live_objects()[kind]["alive"]
+
+
+async def test(dut):
+    live = simulator.get_live_objects()
+    assert set(live) == {"sim_hdl", "iterator", "vpi_cb_hdl", "python_callback",
+                         "py_sim_hdl", "py_iterator_hdl", "py_cb_hdl"}, live
+    assert all(c["alive"] == c["created"] - c["freed"] for c in live.values()), live
+    assert live["sim_hdl"]["alive"] >= 1, live
+
+    # 丢掉句柄以后created和freed重新相等
+    before = simulator.get_live_objects()["py_sim_hdl"]
+    keep = [dut._handle.get_handle_by_name("d") for _ in range(5)]
+    after = simulator.get_live_objects()["py_sim_hdl"]
+    assert after["created"] - before["created"] == 5 and after["freed"] == before["freed"], after
+    paths = simulator.get_live_handle_paths(3)
+    assert paths[0][1] >= 5 and paths[0][0].endswith("d"), paths
+    del keep
+    gc.collect()
+    after = simulator.get_live_objects()["py_sim_hdl"]
+    assert after["alive"] == before["alive"], (before, after)
+    assert after["freed"] - before["freed"] == 5, (before, after)
+
+    # 等过的Timer回调用完就释放，两次都在一个Timer回调里数
+    await Timer(1)
+    before = alive("python_callback"), alive("py_cb_hdl")
+    for _ in range(20):
+        await Timer(1)
+    assert (alive("python_callback"), alive("py_cb_hdl")) == before
+    simulator.log_live_objects(3)
+    print("test_live passed")
+
+mycocotb.start_soon(test(mycocotb.top))
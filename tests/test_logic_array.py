@@ -0,0 +1,243 @@
+import copy
+import gc
+import pickle
+import random
+
+import mycocotb
+from mycocotb import simulator
+from mycocotb.triggers import ReadOnly, Timer
+from mycocotb.types import Array, Logic, LogicArray, Range
+
+
+# 宽度覆盖一个字以内、正好一个字和跨字的情况
+WIDTHS = (1, 2, 7, 8, 9, 31, 32, 33, 63, 64, 65, 100, 128, 129, 257, 513, 1000)
+
+
+def test_planes():
+    # 0/1/X/Z放在位平面里，其它值另外保存，都不能丢
+    for s in ("01XZ" * 20, "uwLH-01xz", "1" * 33, "Z"):
+        a = LogicArray(s)
+        assert str(a) == s.upper() and len(a) == len(s)
+        assert [str(x) for x in a] == list(s.upper())
+        assert a.is_resolvable == (set(s) <= set("01"))
+    a = LogicArray("10XZ" * 10)
+    assert a[39] == Logic(1) and a[0] == Logic("Z") and a == LogicArray("10XZ" * 10)
+    a[0] = "1"
+    a[39] = "H"
+    assert str(a) == "H" + ("10XZ" * 10)[1:-1] + "1"
+    assert LogicArray("1010").to_unsigned() == 10 and LogicArray("1010").to_signed() == -6
+
+
+def test_conversions():
+    rnd = random.Random(2)
+    for w in WIDTHS:
+        for _ in range(20):
+            v = rnd.getrandbits(w)
+            s = format(v, f"0{w}b")
+            sv = v - (1 << w) if v >> (w - 1) else v
+            a = LogicArray(s)
+            assert str(a) == s and a.to_unsigned() == v and a.to_signed() == sv, s
+            assert LogicArray(v, w) == a and str(LogicArray.from_signed(sv, w)) == s, s
+            for byteorder in ("big", "little"):
+                ref = v.to_bytes((w + 7) // 8, byteorder)
+                assert a.to_bytes(byteorder) == ref, (s, byteorder)
+                if w % 8 == 0:
+                    assert str(LogicArray.from_bytes(ref, byteorder=byteorder)) == s, (s, byteorder)
+
+            # X和Z按resolve的方式换成0或1，L和H总是0和1
+            xs = "".join(rnd.choice("01XZLH") for _ in range(w))
+            zeros = int(xs.translate(str.maketrans("XZLH", "0001")), 2)
+            ones = int(xs.translate(str.maketrans("XZLH", "1101")), 2)
+            x = LogicArray(xs)
+            assert str(x) == xs, xs
+            assert x.to_unsigned("zeros") == zeros and x.to_unsigned("ones") == ones, xs
+            assert x.to_signed("ones") == (ones - (1 << w) if ones >> (w - 1) else ones), xs
+
+    try:
+        LogicArray("1X").to_bytes()
+        assert False, "to_bytes() of X did not raise"
+    except ValueError:
+        pass
+    try:
+        LogicArray("10Q")
+        assert False, "bad character did not raise"
+    except ValueError:
+        pass
+    assert str(LogicArray("uwLH-")) == "UWLH-"
+    assert str(LogicArray(None, 3)) == "XXX"
+    assert LogicArray.from_bytes(b"\x01\x02", Range(0, "to", 15)).range == Range(0, "to", 15)
+
+
+# 9值逻辑的真值表，行和列都按"UX01ZWLH-"的顺序
+VALUES = "UX01ZWLH-"
+AND = ["UU0UUU0UU", "UX0XXX0XX", "000000000", "UX01XX01X", "UX0XXX0XX",
+       "UX0XXX0XX", "000000000", "UX01XX01X", "UX0XXX0XX"]
+OR = ["UUU1UUU1U", "UXX1XXX1X", "UX01XX01X", "111111111", "UXX1XXX1X",
+      "UXX1XXX1X", "UX01XX01X", "111111111", "UXX1XXX1X"]
+XOR = ["UUUUUUUUU", "UXXXXXXXX", "UX01XX01X", "UX10XX10X", "UXXXXXXXX",
+       "UXXXXXXXX", "UX01XX01X", "UX10XX10X", "UXXXXXXXX"]
+NOT = "UX10XX10X"
+
+
+def test_logic():
+    for i, a in enumerate(VALUES):
+        assert str(~Logic(a)) == NOT[i], a
+        for j, b in enumerate(VALUES):
+            assert str(Logic(a) & Logic(b)) == AND[i][j], (a, b)
+            assert str(Logic(a) | Logic(b)) == OR[i][j], (a, b)
+            assert str(Logic(a) ^ Logic(b)) == XOR[i][j], (a, b)
+
+    # 每个值只有一个对象
+    assert Logic("x") is Logic("X") is Logic() and Logic(True) is Logic(1) is Logic("1")
+    assert copy.copy(Logic("H")) is Logic("H") and pickle.loads(pickle.dumps(Logic("Z"))) is Logic("Z")
+    assert LogicArray("UX01")[0] is Logic(1)
+    assert len({Logic(0), Logic("0"), Logic(1)}) == 2
+    assert Logic(1) == 1 and Logic(0) == "0" and Logic(1) != "X" and Logic(0) != 5
+    assert repr(Logic("Z")) == "Logic('Z')" and int(Logic(1)) == 1 and not Logic(0)
+    assert [10, 20][Logic(1)] == 20
+    for bad, exc in (("Q", ValueError), ("01", ValueError), (2, ValueError), (1.0, TypeError)):
+        try:
+            Logic(bad)
+            assert False, f"Logic({bad!r}) did not raise"
+        except exc:
+            pass
+    try:
+        int(Logic("X"))
+        assert False, "int(Logic('X')) did not raise"
+    except ValueError:
+        pass
+    try:
+        Logic(0) & 1
+        assert False, "Logic & int did not raise"
+    except TypeError:
+        pass
+
+
+def test_operators():
+    # 和逐位用Logic算出的结果比较
+    assert simulator.LOGIC_KERNELS in ("avx2", "sse2", "scalar")
+    rnd = random.Random(1)
+    for w in WIDTHS:
+        for _ in range(10):
+            s1 = "".join(rnd.choice("01XZ") for _ in range(w))
+            s2 = "".join(rnd.choice("01XZ") for _ in range(w))
+            a, b = LogicArray(s1), LogicArray(s2)
+            la, lb = list(a), list(b)
+            assert str(a & b) == "".join(str(x & y) for x, y in zip(la, lb)), (s1, s2)
+            assert str(a | b) == "".join(str(x | y) for x, y in zip(la, lb)), (s1, s2)
+            assert str(a ^ b) == "".join(str(x ^ y) for x, y in zip(la, lb)), (s1, s2)
+            assert str(~a) == "".join(str(~x) for x in la), s1
+            assert a.is_resolvable == (set(s1) <= set("01")), s1
+            assert (a == LogicArray(s1)) is True and (a == b) == (s1 == s2), (s1, s2)
+
+    nine = LogicArray("UWLH-01")
+    assert str(nine & LogicArray("1111111")) == "".join(str(x & Logic(1)) for x in nine)
+    assert str(~nine) == "".join(str(~x) for x in nine)
+    assert LogicArray("H") != LogicArray("1")
+    assert LogicArray("0101") == 5 and LogicArray("0101") == "0101"
+
+
+def test_views():
+    rnd = random.Random(3)
+    for trial in range(200):
+        w = rnd.randint(66, 300)
+        s = "".join(rnd.choice("01XZ" if trial % 3 else "01XZUWLH-") for _ in range(w))
+        a = LogicArray(s)
+        i = rnd.randint(0, w - 66)
+        j = rnd.randint(i + 65, w - 1)
+        hi, lo = w - 1 - i, w - 1 - j
+        expected = s[i:j + 1]
+        view = a[hi:lo]
+        assert str(view) == expected and view.range == Range(hi, "downto", lo)
+        assert view == LogicArray(expected)
+        if set(expected) <= set("01"):
+            assert view.to_unsigned() == int(expected, 2)
+            assert view.to_bytes() == LogicArray(expected).to_bytes()
+        if set(expected) <= set("01XZ"):
+            other = LogicArray("".join(rnd.choice("01XZ") for _ in range(len(expected))))
+            assert str(view & other) == str(LogicArray(expected) & other)
+            assert str(~view) == str(~LogicArray(expected))
+        assert str(view[view.left - 1:view.left - 10]) == expected[1:11]
+
+        # 改原数组不影响视图，改视图也不影响原数组
+        a[hi] = "1" if expected[0] != "1" else "0"
+        a[lo] = "Z"
+        assert str(view) == expected
+        before = str(a)
+        view[view.left] = "X"
+        view[view.right] = "1"
+        assert str(a) == before
+        assert str(view) == "X" + expected[1:-1] + "1"
+
+        # 视图写回自己所在的数组
+        b = LogicArray(s)
+        b[w - 1:w - len(expected)] = b[hi:lo]
+        assert str(b) == expected + s[len(expected):]
+
+    a = LogicArray("1" * 100)
+    view = a[99:20]
+    del a
+    gc.collect()
+    assert str(view) == "1" * 80
+
+    a = LogicArray("10" * 60)
+    views = [a[119:i] for i in range(40)]
+    a[:] = LogicArray("0" * 120)
+    assert all(str(v) == ("10" * 60)[:120 - i] for i, v in enumerate(views))
+
+    # Array的切片也一样，先写的一方复制出自己的元素
+    arr = Array(list(range(10)), Range(0, "to", 9))
+    part = arr[2:5]
+    arr[3] = 99
+    assert list(part) == [2, 3, 4, 5] and part.range == Range(2, "to", 5)
+    part[2] = -1
+    assert arr[2] == 2 and list(part) == [-1, 3, 4, 5]
+    inner = part[3:4]
+    part[4] = "x"
+    assert list(inner) == [3, 4] and arr[4] == 4
+
+
+async def test_signals(dut):
+    dut.wide.value = (1 << 511) | 0xDEAD
+    dut.hdr.value = "1" * 32 + "XZ" * 16
+    await ReadOnly()
+    assert dut.wide.value.to_unsigned() == (1 << 511) | 0xDEAD
+    assert str(dut.hdr.value) == "1" * 32 + "XZ" * 16
+    assert dut.wide.value.range == Range(511, "downto", 0)
+    await Timer(1)
+    dut.clk.value = 1
+    await ReadOnly()
+    assert dut.clk.value is Logic(1)
+
+    # 写入时复制了值，之后改它不影响信号
+    await Timer(1)
+    value = LogicArray("01" * 256)
+    dut.wide.value = value
+    value[0] = 0
+    dut.hdr.value = -5
+    await ReadOnly()
+    assert str(dut.wide.value) == "01" * 256
+    assert dut.hdr.value.to_signed() == -5
+
+    # 视图可以直接写到信号上
+    await Timer(1)
+    view = LogicArray("1" * 512)[500:0]
+    dut.wide.value = LogicArray("0" * 11 + str(view))
+    await ReadOnly()
+    assert str(dut.wide.value) == "0" * 11 + "1" * 501
+    await Timer(1)
+    dut.hdr.value = dut.wide.value[63:0]
+    await ReadOnly()
+    assert str(dut.hdr.value) == "1" * 64
+
+
+async def test(dut):
+    test_planes()
+    test_conversions()
+    test_logic()
+    test_operators()
+    test_views()
+    await test_signals(dut)
+    print("test_logic_array passed")
+
+mycocotb.start_soon(test(mycocotb.top))
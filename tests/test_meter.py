@@ -0,0 +1,35 @@
+import os
+import time
+
+import mycocotb
+from mycocotb.triggers import Timer
+
+# 用COCOTB_METER_INTERVAL=0.05和COCOTB_METER_FILE=build/test_meter.txt运行，
+# 文件是追加写的，只看这次运行新加的行
+INTERVAL = float(os.environ["COCOTB_METER_INTERVAL"])
+PATH = os.environ["COCOTB_METER_FILE"]
+
+
+def read_lines():
+    with open(PATH) as f:
+        return f.read().splitlines()
+
+
+async def test(dut):
+    # 启动花的时间在第一个时间步报告
+    await Timer(1)
+    before = len(read_lines())
+    start = time.monotonic()
+    for _ in range(30):
+        time.sleep(0.01)
+        await Timer(1)
+    elapsed = time.monotonic() - start
+    lines = read_lines()[before:]
+    # 每个间隔一行，间隔只在新的时间步检查
+    expected = int(elapsed / INTERVAL)
+    assert expected - 2 <= len(lines) <= expected, (elapsed, lines)
+    assert all(line.startswith("meter interval: wall ") for line in lines), lines
+    assert all("/s, " in line and " cb/s, python " in line and " MiB" in line for line in lines), lines
+    print("test_meter passed")
+
+mycocotb.start_soon(test(mycocotb.top))
@@ -0,0 +1,174 @@
+import mycocotb
+from mycocotb import simulator
+from mycocotb.monitor import ChangeSet, ValueChangeMonitor
+from mycocotb.triggers import ReadOnly, ReadWrite, Timer
+from mycocotb.types import Logic, LogicArray
+from mycocotb.utils import get_sim_time
+
+
+async def clock(dut, n):
+    for _ in range(n):
+        dut.clk.value = 1
+        await Timer(5)
+        dut.clk.value = 0
+        await Timer(5)
+
+
+def readonly_fired():
+    return simulator.get_stats()["callbacks"]["readonly"]["fired"]
+
+
+async def test_value_monitor(dut):
+    count = dut.count.value.to_unsigned()
+    mon = ValueChangeMonitor([dut.clk, dut.count, dut.wide], capacity=1000)
+    await clock(dut, 10)
+    changes = mon.drain()
+    clk = [c for c in changes if c.handle is dut.clk]
+    cnt = [c for c in changes if c.handle is dut.count]
+    assert len(clk) == 20 and all(isinstance(c.value, Logic) for c in clk), clk
+    assert [c.value.to_unsigned() for c in cnt] == list(range(count + 1, count + 11)), cnt
+    assert all(a.time <= b.time for a, b in zip(changes, changes[1:]))
+    assert cnt[0].time == clk[0].time
+    assert len(mon) == 0 and mon.dropped == 0 and mon.stats["recorded"] == 30, mon.stats
+
+    dut.wide.value = LogicArray("X" * 100 + "1" * 412)
+    await Timer(1)
+    wide = mon.drain()
+    assert len(wide) == 1 and str(wide[0].value) == "X" * 100 + "1" * 412
+
+    # 缓冲区满了以后按overflow丢掉最老或最新的变化
+    count = dut.count.value.to_unsigned()
+    oldest = ValueChangeMonitor([dut.count], capacity=4)
+    newest = simulator.ValueMonitor([dut.count._handle], 4, "drop_newest")
+    await clock(dut, 6)
+    assert [c.value.to_unsigned() for c in oldest.drain()] == [count + i for i in (3, 4, 5, 6)]
+    assert oldest.dropped == 2 and oldest.stats["high_water"] == 4
+    assert [v.to_unsigned() for t, i, v in newest.drain(2)] == [count + 1, count + 2]
+    assert len(newest) == 2 and newest.dropped == 2 and newest.overflow == "drop_newest"
+    oldest.close()
+    newest.close()
+    await clock(dut, 2)
+    assert len(oldest) == 0 and oldest.stats["recorded"] == 6
+
+    # batches()只在有变化的时间步里醒来，close()以后结束
+    count = dut.count.value.to_unsigned()
+    batches = []
+
+    async def consume():
+        async for batch in mon.batches():
+            batches.append([c.value.to_unsigned() for c in batch if c.handle is dut.count])
+
+    mon.drain()
+    task = mycocotb.start_soon(consume())
+    # 没有变化的时间步不注册ReadOnly
+    await Timer(1)
+    before = readonly_fired()
+    for _ in range(5):
+        await Timer(1)
+    assert readonly_fired() == before, readonly_fired() - before
+    await clock(dut, 3)
+    await Timer(1)
+    mon.close()
+    await Timer(20)
+    assert [b for b in batches if b] == [[count + 1], [count + 2], [count + 3]], batches
+    assert len(batches) == 6 and task.done(), batches
+
+    for bad in ([[dut.count._handle], 0, "drop_oldest"], [[dut.count._handle], 4, "x"],
+                [[], 4], [[1], 4], [[dut.mem._handle], 4]):
+        try:
+            simulator.ValueMonitor(*bad)
+            assert False, f"ValueMonitor{tuple(bad)} did not raise"
+        except (ValueError, TypeError):
+            pass
+
+
+async def test_change_set(dut):
+    signals = [dut.d, dut.q, dut.count, dut.wide, dut.hdr]
+    changes = ChangeSet(signals)
+    await Timer(1)
+    assert len(changes) == 0 and changes.changed() == [] and changes.bitmap == 0
+    dut.d.value = 7
+    dut.hdr.value = 3
+    await ReadOnly()
+    assert changes.changed() == [dut.d, dut.hdr] and changes.bitmap == 0b10001
+    values = changes.values()
+    assert len(values) == 2
+    assert values[dut.d].to_unsigned() == 7 and values[dut.hdr].to_unsigned() == 3
+
+    # 下一个时间步里没有变化时是空的
+    await Timer(1)
+    assert len(changes) == 0 and changes.values() == {}
+
+    # 同一个时间步里几个delta的变化合在一起，值是最后的值
+    dut.d.value = 1
+    dut.count.value = 5
+    await ReadWrite()
+    dut.count.value = 6
+    await ReadOnly()
+    values = changes.values()
+    assert list(values) == [dut.d, dut.count] and values[dut.count].to_unsigned() == 6
+
+    # 写入相同的值不算变化
+    await Timer(1)
+    dut.count.value = 6
+    await ReadOnly()
+    assert len(changes) == 0
+
+    # steps()按时间步给出变化，close()以后结束
+    await Timer(1)
+    steps = []
+
+    async def consume():
+        async for time, values in changes.steps():
+            steps.append(sorted(h._name for h in values))
+
+    task = mycocotb.start_soon(consume())
+    await Timer(1)
+    dut.d.value = 2
+    await Timer(3)
+    dut.wide.value = 1
+    dut.hdr.value = 0
+    await Timer(3)
+    changes.close()
+    await Timer(3)
+    assert steps == [["d"], ["hdr", "wide"]] and task.done(), steps
+    dut.d.value = 3
+    await ReadOnly()
+    assert len(changes) == 0
+
+    big = ChangeSet([dut.mem[i] for i in range(16)] + [dut.clk])
+    await Timer(1)
+    dut.clk.value = 0 if dut.clk.value == 1 else 1
+    dut.mem[9].value = 1
+    await ReadOnly()
+    assert big.bitmap == (1 << 16) | (1 << 9)
+    big.close()
+
+    # 没有变化的时间步不进入Python
+    await Timer(1)
+    quiet = ChangeSet([dut.q])
+    woken = []
+
+    async def consume_quiet():
+        async for time, values in quiet.steps():
+            woken.append(time)
+
+    mycocotb.start_soon(consume_quiet())
+    await Timer(1)
+    start, before = get_sim_time(), readonly_fired()
+    for i in range(10):
+        if i in (3, 7):
+            dut.q.value = 0x40 + i
+        await Timer(1)
+    assert readonly_fired() - before == 2, readonly_fired() - before
+    assert woken == [start + 3, start + 7], woken
+    quiet.close()
+    await Timer(1)
+
+
+async def test(dut):
+    await test_value_monitor(dut)
+    await test_change_set(dut)
+    print("test_monitor passed")
+
+mycocotb.start_soon(test(mycocotb.top))
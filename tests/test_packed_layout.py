@@ -0,0 +1,75 @@
+import mycocotb
+from mycocotb.triggers import ReadOnly, Timer
+from mycocotb.types import LogicArray, PackedLayout
+
+# dut.hdr的布局，高位在前
+HDR = PackedLayout.from_struct([("kind", 4), ("len", 12), ("tag", 16), ("addr", 32)])
+
+
+def ref_unpack(layout, value):
+    """Unpack by slicing the binary string, to check the native unpack."""
+    bits = str(value)[::-1]
+    fields = {}
+    for name, offset, width, signed in layout.fields:
+        field = bits[offset:offset + width][::-1]
+        if any(c not in "01" for c in field):
+            fields[name] = None
+            continue
+        v = int(field, 2)
+        if signed and v >> (width - 1):
+            v -= 1 << width
+        fields[name] = v
+    return fields
+
+
+def test_pack_unpack():
+    hdr = PackedLayout(16, [("kind", 12, 4), ("len", 0, 12)])
+    assert hdr.unpack(LogicArray(0x300A, 16)) == {"kind": 3, "len": 10}
+    assert str(hdr.pack({"kind": 1, "len": 5})) == "0001000000000101"
+    assert hdr.pack({"len": 5}, LogicArray(0xF000, 16)) == LogicArray(0xF005, 16)
+
+    signed = PackedLayout(8, [("lo", 0, 4, True), ("hi", 4, 4, False)])
+    value = signed.pack({"lo": -2, "hi": 9})
+    assert str(value) == "10011110"
+    assert signed.unpack(value) == ref_unpack(signed, value) == {"lo": -2, "hi": 9}
+    assert signed.unpack(LogicArray("1001X110")) == {"lo": None, "hi": 9}
+
+    # 切片视图和普通值一样解包
+    big = LogicArray("111" + str(value) + "00000")
+    view = big[12:5]
+    assert signed.unpack(view) == signed.unpack(value)
+
+
+async def test_set_fields(dut):
+    dut.hdr.value = HDR.pack({"kind": 3, "len": 100, "tag": 0xBEEF, "addr": 0x1234})
+    await ReadOnly()
+    assert dut.hdr.get_fields(HDR) == {"kind": 3, "len": 100, "tag": 0xBEEF, "addr": 0x1234}
+
+    # 只改给出的字段，其它字段保持仿真器里的值
+    await Timer(1, "ns")
+    dut.hdr.set_fields(HDR, {"kind": 1, "addr": 0xFFFFFFFF})
+    await ReadOnly()
+    assert dut.hdr.get_fields(HDR) == {"kind": 1, "len": 100, "tag": 0xBEEF, "addr": 0xFFFFFFFF}
+    assert dut.hdr.value.to_unsigned() == HDR.pack(dut.hdr.get_fields(HDR)).to_unsigned()
+
+    # 同一个delta里的两次set_fields叠加，而不是后一次覆盖前一次
+    await Timer(1, "ns")
+    dut.hdr.set_fields(HDR, {"kind": 2})
+    dut.hdr.set_fields(HDR, {"len": 2})
+    await ReadOnly()
+    assert dut.hdr.get_fields(HDR) == {"kind": 2, "len": 2, "tag": 0xBEEF, "addr": 0xFFFFFFFF}
+
+    # 在已经安排好的整体写入上改字段
+    await Timer(1, "ns")
+    dut.hdr.value = 0
+    dut.hdr.set_fields(HDR, {"tag": 7})
+    await ReadOnly()
+    assert dut.hdr.get_fields(HDR) == {"kind": 0, "len": 0, "tag": 7, "addr": 0}
+
+
+async def test(dut):
+    test_pack_unpack()
+    await test_set_fields(dut)
+    print("test_packed_layout passed")
+
+mycocotb.start_soon(test(mycocotb.top))
@@ -0,0 +1,57 @@
+import mycocotb
+from mycocotb import simulator
+from mycocotb.triggers import Timer
+
+# 用COCOTB_PROFILE_TASKS=1运行，从第一个task开始就在计时
+
+
+async def heavy(n):
+    for _ in range(n):
+        sum(range(200000))
+        await Timer(1)
+
+
+async def light(n):
+    for _ in range(n):
+        await Timer(1)
+    return n
+
+
+async def test(dut):
+    assert simulator.get_task_profiling()
+
+    # 时间记在task和它的协程函数上，按花的时间排序
+    simulator.reset_task_profile()
+    mycocotb.start_soon(heavy(5))
+    light_task = mycocotb.start_soon(light(5))
+    await Timer(10)
+    assert light_task.result() == 5
+    profile = simulator.get_task_profile()
+    functions = {f[0]: f for f in profile["functions"]}
+    assert profile["functions"][0][0] == "heavy", profile
+    # 第一次运行加上每个Timer之后的一次
+    assert functions["heavy"][1] == 6 and functions["light"][1] == 6, functions
+    assert functions["heavy"][2] > functions["light"][2]
+    assert all(a[2] >= b[2] for a, b in zip(profile["functions"], profile["functions"][1:]))
+    tasks = [t for t in profile["tasks"] if t[1] == "light"]
+    assert len(tasks) == 1 and tasks[0][2] == 6, tasks
+
+    simulator.reset_task_profile()
+    profile = simulator.get_task_profile()
+    assert profile["tasks"] == [] and profile["functions"] == []
+    for _ in range(300):
+        mycocotb.start_soon(light(1))
+    await Timer(2)
+    functions = {f[0]: f for f in simulator.get_task_profile()["functions"]}
+    assert functions["light"][1] == 600, functions
+
+    # 关掉以后不再计时
+    simulator.set_task_profiling(False)
+    simulator.reset_task_profile()
+    await mycocotb.start_soon(light(3))
+    functions = [f[0] for f in simulator.get_task_profile()["functions"]]
+    assert "light" not in functions, functions
+    simulator.set_task_profiling(True)
+    print("test_profile passed")
+
+mycocotb.start_soon(test(mycocotb.top))
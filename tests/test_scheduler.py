@@ -0,0 +1,377 @@
+import gc
+import logging
+import warnings
+import weakref
+
+import mycocotb
+from mycocotb import _scheduler, simulator
+from mycocotb.queue import Queue, QueueEmpty, QueueFull
+from mycocotb.triggers import (
+    Edge,
+    Event,
+    FallingEdge,
+    Lock,
+    NextTimeStep,
+    NullTrigger,
+    ReadOnly,
+    ReadWrite,
+    RisingEdge,
+    Timer,
+)
+from mycocotb.utils import get_sim_time
+
+# 同一个模块分别用COCOTB_SCHEDULER_NATIVE=1和0运行，两个调度器得到的顺序必须
+# 和下面的期望一样
+
+
+async def clock_gen(dut):
+    while True:
+        dut.clk.value = 0
+        await Timer(5)
+        dut.clk.value = 1
+        await Timer(5)
+
+
+async def waiter(trigger, name, log):
+    await trigger
+    log.append(("woke", name, get_sim_time()))
+    return name
+
+
+async def test_triggers(dut):
+    start = get_sim_time()
+    log = []
+
+    def now():
+        return get_sim_time() - start
+
+    clock = mycocotb.start_soon(clock_gen(dut))
+    dut.d.value = 5
+    await RisingEdge(dut.clk)
+    log.append(("rise", now()))
+    await RisingEdge(dut.clk)
+    await ReadOnly()
+    log.append(("q", int(dut.q.value), now()))
+    await FallingEdge(dut.clk)
+    log.append(("fall", now()))
+
+    # 同一个Event上的等待者按等待的顺序醒来
+    e = Event()
+    t1 = mycocotb.start_soon(waiter(e.wait(), "w1", log))
+    t2 = mycocotb.start_soon(waiter(e.wait(), "w2", log))
+    await Timer(2)
+    e.set()
+    log.append(("results", await t1, await t2, now()))
+
+    await ReadWrite()
+    dut.d.value = 9
+    await Edge(dut.q)
+    log.append(("edge_q", int(dut.q.value), now()))
+    await NextTimeStep()
+    log.append(("nts", now()))
+    clock.kill()
+
+    assert log == [
+        ("rise", 5),
+        ("q", 5, 15),
+        ("fall", 20),
+        ("woke", "w1", start + 22),
+        ("woke", "w2", start + 22),
+        ("results", "w1", "w2", 22),
+        ("edge_q", 9, 25),
+        ("nts", 30),
+    ], log
+
+
+async def child(n):
+    await Timer(n)
+    return n * 10
+
+
+async def raiser():
+    await Timer(1)
+    raise ValueError("boom")
+
+
+async def test_tasks(dut):
+    start = get_sim_time()
+    assert await child(3) == 30 and get_sim_time() == start + 3
+    assert await mycocotb.start_soon(child(2)) == 20 and get_sim_time() == start + 5
+    try:
+        await mycocotb.start_soon(raiser())
+        assert False, "exception of the task was not raised"
+    except ValueError as e:
+        assert str(e) == "boom"
+
+    # 结束的task的内存被下一个task重用，结果不能混在一起
+    for _ in range(3):
+        tasks = [mycocotb.start_soon(child(i % 4 + 1)) for i in range(100)]
+        assert [await t for t in tasks] == [(i % 4 + 1) * 10 for i in range(100)]
+        assert all(t.done() for t in tasks)
+
+    task = mycocotb.start_soon(child(1))
+    await task.complete
+    assert task.done() and task.result() == 10
+
+
+async def test_coalesce(dut):
+    # 已经在队列里的task又被trigger唤醒时，两次唤醒合并成一次恢复
+    log = []
+    e = Event()
+    task = mycocotb.start_soon(waiter(e.wait(), "w", log))
+    await Timer(1)
+    scheduler = mycocotb._scheduler_inst
+    before = scheduler._wakeup_stats()
+    scheduler._schedule_task(task)
+    e.set()
+    await Timer(1)
+    after = scheduler._wakeup_stats()
+    assert len(log) == 1 and task.done(), log
+    assert after["coalesced"] - before["coalesced"] == 1, (before, after)
+
+    # Python实现打开调试日志时记下合并掉的唤醒
+    if scheduler._core is None:
+        records = []
+        handler = logging.Handler(logging.DEBUG)
+        handler.emit = records.append
+        scheduler.log.addHandler(handler)
+        level, propagate = scheduler.log.level, scheduler.log.propagate
+        scheduler.log.setLevel(logging.DEBUG)
+        scheduler.log.propagate = False
+        _scheduler._debug = True
+        try:
+            again = Event()
+            task = mycocotb.start_soon(waiter(again.wait(), "again", []))
+            await Timer(1)
+            scheduler._schedule_task(task)
+            again.set()
+            await Timer(1)
+        finally:
+            _scheduler._debug = False
+            scheduler.log.removeHandler(handler)
+            scheduler.log.setLevel(level)
+            scheduler.log.propagate = propagate
+        assert any(r.getMessage().startswith("Coalesced wakeup") for r in records)
+
+    # 没有排队的task照常被唤醒
+    e.clear()
+    for i in range(3):
+        mycocotb.start_soon(waiter(e.wait(), i, log))
+    await Timer(1)
+    before = scheduler._wakeup_stats()
+    e.set()
+    await Timer(1)
+    after = scheduler._wakeup_stats()
+    # 三个等待者，加上这个task自己的Timer
+    assert after["wakeups"] - before["wakeups"] == 4, (before, after)
+    assert after["coalesced"] == before["coalesced"] and len(log) == 4, log
+
+
+async def test_sim_phase(dut):
+    phases = []
+
+    def record():
+        phases.append((simulator.get_sim_phase(), mycocotb.sim_phase))
+
+    await Timer(1)
+    record()
+    await ReadWrite()
+    record()
+    await ReadOnly()
+    record()
+    # ReadOnly里不能再等ReadWrite，也不能写信号
+    try:
+        await ReadWrite()
+        assert False, "ReadWrite in ReadOnly did not raise"
+    except RuntimeError:
+        pass
+    # 要有下一个时间步NextTimeStep才会触发
+    mycocotb.start_soon(child(1))
+    await NextTimeStep()
+    record()
+    await Timer(1)
+    record()
+
+    assert phases == [
+        (simulator.SIM_PHASE_NORMAL, mycocotb.SimPhase.NORMAL),
+        (simulator.SIM_PHASE_READ_WRITE, mycocotb.SimPhase.READ_WRITE),
+        (simulator.SIM_PHASE_READ_ONLY, mycocotb.SimPhase.READ_ONLY),
+        (simulator.SIM_PHASE_NEXT_TIME, mycocotb.SimPhase.NORMAL),
+        (simulator.SIM_PHASE_NORMAL, mycocotb.SimPhase.NORMAL),
+    ], phases
+
+
+class Marker:
+    pass
+
+
+async def holder(core, marker):
+    await Timer(1)
+
+
+def test_core_gc():
+    # 只剩core的就绪队列和等待队列引用着的循环也能被GC回收
+    scheduler = mycocotb._scheduler_inst
+    if scheduler._core is None:
+        return
+    core = simulator.SchedulerCore(scheduler)
+    ready, waiting = Marker(), Marker()
+    refs = [weakref.ref(ready), weakref.ref(waiting)]
+    core.schedule_task(mycocotb.create_task(holder(core, ready)))
+    trigger = simulator.WaitTrigger()
+    core.schedule_task_upon(mycocotb.create_task(holder(core, waiting)), trigger)
+    del core, ready, waiting
+    with warnings.catch_warnings():
+        # 从没运行过的协程被回收时会警告
+        warnings.simplefilter("ignore", RuntimeWarning)
+        gc.collect()
+    assert [r() for r in refs] == [None, None]
+    # 回收core时WaitTrigger上的等待队列一起清空
+    assert trigger.fire() is False
+
+
+async def test_killed(dut):
+    start = get_sim_time()
+    log = []
+
+    def now():
+        return get_sim_time() - start
+
+    # 被kill的task不再等待，同一个trigger上的其它task照常被唤醒
+    clock = mycocotb.start_soon(clock_gen(dut))
+    never = mycocotb.start_soon(waiter(Event().wait(), "never", log))
+    await Timer(1)
+    never.kill()
+    log.append(("killed", never.done()))
+    rising = RisingEdge(dut.clk)
+    a = mycocotb.start_soon(waiter(rising, "a", log))
+    b = mycocotb.start_soon(waiter(rising, "b", log))
+    c = mycocotb.start_soon(waiter(Timer(100), "c", log))
+    await Timer(1)
+    a.kill()
+    c.kill()
+    await Timer(20)
+    log.append(("after", b.done(), now()))
+    clock.kill()
+
+    assert log == [
+        ("killed", True),
+        ("woke", "b", start + 5),
+        ("after", True, 22),
+    ], log
+
+
+async def test_sync(dut):
+    start = get_sim_time()
+    log = []
+
+    def now():
+        return get_sim_time() - start
+
+    async def producer(q, n, name):
+        for i in range(n):
+            await q.put((name, i))
+            log.append(("put", name, i, now()))
+            await Timer(1)
+
+    async def consumer(q, n, name):
+        got = []
+        for _ in range(n):
+            got.append(await q.get())
+        log.append(("consumer", name, got, now()))
+
+    async def locker(lock, name, hold):
+        async with lock:
+            log.append(("lock", name, now()))
+            await Timer(hold)
+        log.append(("unlock", name, now()))
+
+    async def ev_waiter(e, name):
+        await e.wait()
+        log.append(("ev", name, now()))
+
+    # 两个消费者按等待的先后轮流拿到数据，满了的队列让生产者等待
+    q = Queue(maxsize=2)
+    c1 = mycocotb.start_soon(consumer(q, 3, "c1"))
+    c2 = mycocotb.start_soon(consumer(q, 3, "c2"))
+    mycocotb.start_soon(producer(q, 6, "p1"))
+    await c1
+    await c2
+
+    q2 = Queue(1)
+    q2.put_nowait(1)
+    try:
+        q2.put_nowait(2)
+    except QueueFull:
+        log.append(("full",))
+    q2.get_nowait()
+    try:
+        q2.get_nowait()
+    except QueueEmpty:
+        log.append(("empty",))
+    # 被kill的get不会拿走数据
+    dead = mycocotb.start_soon(consumer(q2, 1, "dead"))
+    mycocotb.start_soon(consumer(q2, 1, "alive"))
+    await Timer(1)
+    dead.kill()
+    q2.put_nowait(7)
+    await Timer(1)
+
+    # 被kill的等锁者被跳过
+    lock = Lock()
+    lockers = [mycocotb.start_soon(locker(lock, n, 3)) for n in "abc"]
+    await Timer(1)
+    lockers[1].kill()
+    for t in lockers:
+        await t.complete
+    log.append(("locked", lock.locked()))
+
+    # 被kill的等待者不被唤醒，其余的按等待的顺序唤醒
+    e = Event()
+    waiters = [mycocotb.start_soon(ev_waiter(e, i)) for i in range(4)]
+    await Timer(1)
+    waiters[2].kill()
+    e.set()
+    await Timer(1)
+    e.clear()
+    mycocotb.start_soon(ev_waiter(e, "again"))
+    await Timer(2)
+    e.set()
+    await NullTrigger()
+    await NullTrigger()
+
+    assert log == [
+        ("put", "p1", 0, 0),
+        ("put", "p1", 1, 1),
+        ("put", "p1", 2, 2),
+        ("put", "p1", 3, 3),
+        ("put", "p1", 4, 4),
+        ("consumer", "c1", [("p1", 0), ("p1", 2), ("p1", 4)], 4),
+        ("put", "p1", 5, 5),
+        ("consumer", "c2", [("p1", 1), ("p1", 3), ("p1", 5)], 5),
+        ("full",),
+        ("empty",),
+        ("consumer", "alive", [7], 6),
+        ("lock", "a", 7),
+        ("unlock", "a", 10),
+        ("lock", "c", 10),
+        ("unlock", "c", 13),
+        ("locked", False),
+        ("ev", 0, 14),
+        ("ev", 1, 14),
+        ("ev", 3, 14),
+        ("ev", "again", 17),
+    ], log
+
+
+async def test(dut):
+    await test_triggers(dut)
+    await test_tasks(dut)
+    await test_coalesce(dut)
+    test_core_gc()
+    await test_killed(dut)
+    await test_sim_phase(dut)
+    await test_sync(dut)
+    print("test_scheduler passed")
+
+mycocotb.start_soon(test(mycocotb.top))
@@ -0,0 +1,74 @@
+import mycocotb
+from mycocotb import simulator
+from mycocotb.triggers import ReadOnly, RisingEdge, Timer
+
+
+async def rising(signal):
+    await RisingEdge(signal)
+
+
+async def test_counters(dut):
+    stats = simulator.get_stats()
+    assert set(stats) == {"callbacks", "vpi_calls", "handles", "binstr_bytes", "writes", "python_entries"}
+    assert set(stats["callbacks"]) == {"timed", "value_change", "readwrite", "readonly", "nexttime", "other"}
+    assert stats["handles"]["created"] >= 1, stats
+
+    # reset_stats()以后所有计数从0开始
+    simulator.reset_stats()
+    stats = simulator.get_stats()
+    assert stats["python_entries"] == 0 and not any(stats["vpi_calls"].values()), stats
+    assert all(not any(c.values()) for c in stats["callbacks"].values()), stats
+    for _ in range(3):
+        await Timer(1)
+    stats = simulator.get_stats()
+    assert stats["callbacks"]["timed"] == {"registered": 3, "fired": 3, "removed": 0}, stats
+    assert stats["python_entries"] == 3, stats
+
+    # 两次写同一个信号只有最后一次交给仿真器
+    simulator.reset_stats()
+    dut.d.value = 5
+    dut.d.value = 6
+    dut.a.value = 1
+    await ReadOnly()
+    stats = simulator.get_stats()
+    assert stats["writes"] == {"scheduled": 3, "applied": 2}, stats
+    assert stats["vpi_calls"]["vpi_put_value"] == 2, stats
+    assert stats["callbacks"]["readwrite"]["fired"] == 1, stats
+    assert stats["callbacks"]["readonly"]["fired"] == 1, stats
+    dut.d._handle.get_signal_val_binstr()
+    assert simulator.get_stats()["binstr_bytes"]["read"] == 8
+
+    # 被kill的task等待的边沿回调被移除
+    await Timer(1)
+    simulator.reset_stats()
+    task = mycocotb.start_soon(rising(dut.a))
+    await Timer(1)
+    task.kill()
+    await Timer(1)
+    stats = simulator.get_stats()
+    assert stats["callbacks"]["value_change"] == {"registered": 1, "fired": 0, "removed": 1}, stats
+
+
+async def test_handles(dut):
+    simulator.reset_stats()
+    first = dut._handle.get_handle_by_name("count")
+    second = dut._handle.get_handle_by_name("count")
+    stats = simulator.get_stats()
+    # 每次查找都新建一个GpiObjHdl
+    assert first != second and stats["handles"] == {"created": 2, "cached": 0}, stats
+
+    # 再次访问同一个子对象时用handle.py里缓存的句柄
+    simulator.reset_stats()
+    for _ in range(3):
+        dut.q
+        dut.mem[2]
+    # q、mem和mem[2]各新建一次，之后的两次都是缓存里的
+    assert simulator.get_stats()["handles"] == {"created": 3, "cached": 6}
+
+
+async def test(dut):
+    await test_counters(dut)
+    await test_handles(dut)
+    print("test_stats passed")
+
+mycocotb.start_soon(test(mycocotb.top))
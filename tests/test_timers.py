@@ -0,0 +1,118 @@
+import itertools
+import math
+from decimal import Decimal
+from fractions import Fraction
+
+import mycocotb
+from mycocotb import utils
+from mycocotb.triggers import PeriodicTimer, Timer
+from mycocotb.utils import get_sim_time
+
+
+def outcome(f, *args):
+    try:
+        r = f(*args)
+        return (type(r).__name__, r)
+    except Exception as e:
+        return (type(e).__name__, str(e))
+
+
+def fraction_steps(time, units, round_mode):
+    """get_sim_steps() through the Python path that Fraction and Decimal take."""
+    if units != "step":
+        result = utils._ldexp10(
+            time, utils._get_log_time_scale(units) - utils._get_simulator_precision()
+        )
+    else:
+        result = time
+    if round_mode == "error":
+        rounded = math.floor(result)
+        if rounded != result:
+            raise ValueError(
+                f"Unable to accurately represent {time}({units}) with the simulator precision of 1e{utils._get_simulator_precision()}"
+            )
+        return rounded
+    rounding = {"ceil": math.ceil, "round": round, "floor": math.floor}.get(round_mode)
+    if rounding is None:
+        raise ValueError(f"Invalid round_mode specifier: {round_mode}")
+    return rounding(result)
+
+
+def test_sim_steps():
+    # int和float走原生的转换，结果（包括异常）要和Python路径一致
+    times = [0, 1, 3, 7, 10, 1000, 12345, 2**53 + 1, 10**30, -5,
+             0.5, 1.25, 2.5, 3.5, 1e-3, 0.1, 7.0, 1e300,
+             float("inf"), float("nan"), -2.5]
+    units = ["step", "fs", "ps", "ns", "us", "ms", "sec", "NS", "min"]
+    modes = ["error", "ceil", "round", "floor", "bogus"]
+    for time, unit, mode in itertools.product(times, units, modes):
+        native = outcome(lambda: utils.get_sim_steps(time, unit, round_mode=mode))
+        python = outcome(fraction_steps, time, unit, mode)
+        assert native == python, (time, unit, mode, native, python)
+
+    for steps, unit in itertools.product([0, 1, 5, 10**20, 2.5], ["fs", "ps", "ns", "sec", "step"]):
+        native = outcome(utils.get_time_from_sim_steps, steps, unit)
+        python = outcome(
+            lambda: utils._ldexp10(
+                steps, utils._get_simulator_precision() - utils._get_log_time_scale(unit)
+            )
+        )
+        assert native == python, (steps, unit, native, python)
+
+    assert utils.get_sim_steps(Fraction(1, 2), "sec") == fraction_steps(Fraction(1, 2), "sec", "error")
+    assert utils.get_sim_steps(Decimal("1.5"), "sec") == fraction_steps(Decimal("1.5"), "sec", "error")
+
+
+async def test_periodic_timer(dut):
+    start = get_sim_time()
+
+    def now():
+        return get_sim_time() - start
+
+    async def clock(period, n):
+        for _ in range(n):
+            dut.clk.value = 0
+            await period
+            dut.clk.value = 1
+            await period
+
+    async def waiter(period, log, tag):
+        while True:
+            await period
+            log.append((tag, now()))
+
+    # 一直有人等待时，同一个定时回调自己重新挂起，不再注册新的
+    period = PeriodicTimer(5)
+    task = mycocotb.start_soon(clock(period, 3))
+    await Timer(2)
+    cbhdl = period._cbhdl
+    await task
+    assert now() == 30 and period._cbhdl is cbhdl
+
+    # 没有等待者以后停下来
+    await Timer(20)
+    assert period._cbhdl is None and not period._primed
+
+    # 两个等待者每个周期都被唤醒，被kill的不再被唤醒
+    log = []
+    a = mycocotb.start_soon(waiter(period, log, "a"))
+    b = mycocotb.start_soon(waiter(period, log, "b"))
+    await Timer(12)
+    b.kill()
+    await Timer(10)
+    a.kill()
+    assert log == [("a", 55), ("b", 55), ("a", 60), ("b", 60), ("a", 65), ("a", 70)], log
+    assert period._cbhdl is None and not period._primed
+
+    # 停下来以后再等待，从那时起重新计时
+    await Timer(30)
+    await period
+    assert now() == 107
+
+
+async def test(dut):
+    test_sim_steps()
+    await test_periodic_timer(dut)
+    print("test_timers passed")
+
+mycocotb.start_soon(test(mycocotb.top))
@@ -0,0 +1,26 @@
+import mycocotb
+from mycocotb.triggers import ReadOnly, ReadWrite, RisingEdge, Timer
+
+# 用COCOTB_TRACE_FILE运行，产生各种回调；trace文件在仿真结束时才写完，
+# 由tests/check_trace.py检查
+
+
+async def clock(dut, n):
+    for _ in range(n):
+        dut.clk.value = 0
+        await Timer(5)
+        dut.clk.value = 1
+        await Timer(5)
+
+
+async def test(dut):
+    mycocotb.start_soon(clock(dut, 12))
+    for i in range(10):
+        await RisingEdge(dut.clk)
+        await ReadWrite()
+        dut.d.value = i
+        await ReadOnly()
+        assert dut.d.value == i
+    await Timer(20)
+
+mycocotb.start_soon(test(mycocotb.top))